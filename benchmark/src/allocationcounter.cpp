@@ -0,0 +1,76 @@
+#include "allocationcounter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace zasm::benchmarks
+{
+    static std::atomic<std::size_t> gAllocationCount{};
+
+    std::size_t getAllocationCount() noexcept
+    {
+        return gAllocationCount.load(std::memory_order_relaxed);
+    }
+
+    static void* countedAlloc(std::size_t size) noexcept
+    {
+        gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size != 0 ? size : 1);
+    }
+
+} // namespace zasm::benchmarks
+
+void* operator new(std::size_t size)
+{
+    if (auto* ptr = zasm::benchmarks::countedAlloc(size); ptr != nullptr)
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return zasm::benchmarks::countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return zasm::benchmarks::countedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+
+namespace zasm::benchmarks
+{
+    // Returns the total amount of allocations done via the global operator new.
+    std::size_t getAllocationCount() noexcept;
+
+} // namespace zasm::benchmarks
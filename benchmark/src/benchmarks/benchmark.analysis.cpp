@@ -0,0 +1,330 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include <zasm/testdata/x86/instructions.hpp>
+#include <zasm/zasm.hpp>
+
+namespace zasm::benchmarks
+{
+    // Creates a program with roughly 1 million nodes split into small blocks that branch to each other.
+    static void createBranchyProgram(Program& program)
+    {
+        constexpr std::size_t kBlockCount = 1'000'000 / 8;
+
+        x86::Assembler assembler(program);
+
+        std::vector<Label> labels;
+        labels.reserve(kBlockCount);
+        for (std::size_t i = 0; i < kBlockCount; i++)
+        {
+            labels.push_back(assembler.createLabel());
+        }
+
+        for (std::size_t i = 0; i < kBlockCount; i++)
+        {
+            assembler.bind(labels[i]);
+            assembler.mov(x86::eax, Imm(i));
+            assembler.add(x86::ecx, x86::eax);
+            assembler.lea(x86::rdx, x86::qword_ptr(x86::rcx, x86::rax, 2));
+            assembler.cmp(x86::ecx, Imm(0x1000));
+            assembler.jz(labels[(i * 7919) % kBlockCount]);
+            assembler.xor_(x86::edx, x86::edx);
+            if (i % 4 == 3)
+            {
+                assembler.jmp(labels[(i * 104729) % kBlockCount]);
+            }
+            else
+            {
+                assembler.nop();
+            }
+        }
+        assembler.ret();
+    }
+
+    static void BM_ControlFlowGraph_Build(benchmark::State& state)
+    {
+        Program program(MachineMode::AMD64);
+        createBranchyProgram(program);
+
+        ControlFlowGraph cfg(program);
+
+        size_t numNodes = 0;
+        for (auto _ : state)
+        {
+            auto err = cfg.build();
+            benchmark::DoNotOptimize(err);
+
+            numNodes += program.size();
+        }
+
+        state.counters["Blocks"] = static_cast<double>(cfg.getValidBlockCount());
+        state.counters["NodesPerSecond"] = benchmark::Counter(
+            static_cast<double>(numNodes), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1000);
+    }
+    BENCHMARK(BM_ControlFlowGraph_Build)->Unit(benchmark::kMillisecond);
+
+    // Measures the cost of keeping the graph up to date while the program is modified, every iteration
+    // splits and merges blocks all over the program.
+    static void BM_ControlFlowGraph_Incremental(benchmark::State& state)
+    {
+        Program program(MachineMode::AMD64);
+        createBranchyProgram(program);
+
+        ControlFlowGraph cfg(program);
+
+        std::vector<Node*> positions;
+        std::size_t index = 0;
+        for (auto* node = program.getHead(); node != nullptr; node = node->getNext(), index++)
+        {
+            if (index % 64 == 0)
+            {
+                positions.push_back(node);
+            }
+        }
+
+        size_t numUpdates = 0;
+        for (auto _ : state)
+        {
+            for (auto* pos : positions)
+            {
+                auto* node = program.insertAfter(pos, program.createNode(Instruction().setMnemonic(x86::Mnemonic::Ret)));
+                cfg.update();
+                program.destroy(node);
+                cfg.update();
+            }
+            numUpdates += positions.size() * 2;
+        }
+
+        state.counters["UpdatesPerSecond"] = benchmark::Counter(
+            static_cast<double>(numUpdates), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1000);
+    }
+    BENCHMARK(BM_ControlFlowGraph_Incremental)->Unit(benchmark::kMillisecond);
+
+    static void BM_Liveness_Run(benchmark::State& state)
+    {
+        Program program(MachineMode::AMD64);
+        createBranchyProgram(program);
+
+        ControlFlowGraph cfg(program);
+        LivenessAnalysis liveness(program, cfg);
+
+        // Decodes all instructions once, the iterations only solve the dataflow.
+        liveness.run();
+
+        size_t numNodes = 0;
+        size_t numVisits = 0;
+        for (auto _ : state)
+        {
+            liveness.run();
+
+            numNodes += program.size();
+            numVisits += liveness.getBlockVisitCount();
+        }
+
+        state.counters["VisitsPerBlock"] = static_cast<double>(numVisits)
+            / static_cast<double>(cfg.getValidBlockCount() * static_cast<std::size_t>(state.iterations()));
+        state.counters["NodesPerSecond"] = benchmark::Counter(
+            static_cast<double>(numNodes), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1000);
+    }
+    BENCHMARK(BM_Liveness_Run)->Unit(benchmark::kMillisecond);
+
+    static void BM_Liveness_RunUncached(benchmark::State& state)
+    {
+        Program program(MachineMode::AMD64);
+        createBranchyProgram(program);
+
+        ControlFlowGraph cfg(program);
+
+        size_t numNodes = 0;
+        for (auto _ : state)
+        {
+            LivenessAnalysis liveness(program, cfg);
+            liveness.run();
+
+            numNodes += program.size();
+        }
+
+        state.counters["NodesPerSecond"] = benchmark::Counter(
+            static_cast<double>(numNodes), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1000);
+    }
+    BENCHMARK(BM_Liveness_RunUncached)->Unit(benchmark::kMillisecond);
+
+    // Code generator output with redundant sequences every few instructions.
+    static void createRedundantProgram(Program& program, std::size_t count)
+    {
+        x86::Assembler assembler(program);
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            auto label = assembler.createLabel();
+            assembler.mov(x86::rax, x86::rcx);
+            assembler.mov(x86::rcx, x86::rcx);
+            assembler.push(x86::rbx);
+            assembler.pop(x86::rbx);
+            assembler.add(x86::rdx, Imm(0));
+            assembler.add(x86::rdx, x86::rax);
+            assembler.jmp(label);
+            assembler.bind(label);
+        }
+        assembler.ret();
+    }
+
+    static void BM_Peephole_Run(benchmark::State& state)
+    {
+        const auto count = static_cast<std::size_t>(state.range(0));
+
+        size_t numNodes = 0;
+        PeepholeStats stats;
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            Program program(MachineMode::AMD64);
+            createRedundantProgram(program, count);
+            numNodes += program.size();
+            state.ResumeTiming();
+
+            PeepholeOptimizer optimizer(program);
+            optimizer.addDefaultRules();
+            optimizer.run();
+
+            stats = optimizer.getStats();
+        }
+
+        state.counters["Rounds"] = static_cast<double>(stats.rounds);
+        state.counters["Removed"] = static_cast<double>(stats.instructionsRemoved);
+        state.counters["BytesSaved"] = static_cast<double>(stats.bytesSaved);
+        state.counters["NodesPerSecond"] = benchmark::Counter(
+            static_cast<double>(numNodes), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1000);
+    }
+    BENCHMARK(BM_Peephole_Run)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMillisecond);
+
+    // Each block branches over a cold block to the hot one, the weights favor the branch.
+    static void createProfiledProgram(Program& program, BlockReordering& pass, std::size_t count)
+    {
+        x86::Assembler a(program);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            auto labelHead = a.createLabel();
+            auto labelCold = a.createLabel();
+            auto labelHot = a.createLabel();
+            a.bind(labelHead);
+            a.test(x86::eax, x86::eax);
+            a.jz(labelHot);
+            a.bind(labelCold);
+            a.dec(x86::ecx);
+            a.ret();
+            a.bind(labelHot);
+            a.inc(x86::eax);
+
+            pass.setWeight(labelHead, 100);
+            pass.setWeight(labelCold, 1);
+            pass.setWeight(labelHot, 99);
+        }
+        a.ret();
+    }
+
+    static void BM_BlockReordering_Run(benchmark::State& state)
+    {
+        const auto count = static_cast<std::size_t>(state.range(0));
+
+        size_t numNodes = 0;
+        BlockReorderStats stats;
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            Program program(MachineMode::AMD64);
+            BlockReordering pass(program);
+            createProfiledProgram(program, pass, count);
+            numNodes += program.size();
+            state.ResumeTiming();
+
+            pass.run();
+
+            stats = pass.getStats();
+        }
+
+        state.counters["BlocksMoved"] = static_cast<double>(stats.blocksMoved);
+        state.counters["FallthroughBefore"] = static_cast<double>(stats.fallthroughWeightBefore);
+        state.counters["FallthroughAfter"] = static_cast<double>(stats.fallthroughWeightAfter);
+        state.counters["NodesPerSecond"] = benchmark::Counter(
+            static_cast<double>(numNodes), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1000);
+    }
+    BENCHMARK(BM_BlockReordering_Run)->Arg(1'000)->Arg(10'000)->Unit(benchmark::kMillisecond);
+
+    // Every other block is only reachable through a label that is never referenced.
+    static void createDeadCodeProgram(Program& program, std::size_t count)
+    {
+        x86::Assembler a(program);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            auto labelNext = a.createLabel();
+            auto labelDead = a.createLabel();
+            a.inc(x86::eax);
+            a.jmp(labelNext);
+            a.bind(labelDead);
+            a.dec(x86::ecx);
+            a.dd(0xCCCCCCCC);
+            a.bind(labelNext);
+        }
+        a.ret();
+    }
+
+    static void BM_DeadCode_Run(benchmark::State& state)
+    {
+        const auto count = static_cast<std::size_t>(state.range(0));
+
+        size_t numNodes = 0;
+        DeadCodeStats stats;
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            Program program(MachineMode::AMD64);
+            createDeadCodeProgram(program, count);
+            numNodes += program.size();
+            state.ResumeTiming();
+
+            DeadCodeElimination pass(program);
+            pass.setCompactLabels(true);
+            pass.run();
+
+            stats = pass.getStats();
+        }
+
+        state.counters["NodesRemoved"] = static_cast<double>(stats.nodesRemoved);
+        state.counters["LabelsCompacted"] = static_cast<double>(stats.labelsCompacted);
+        state.counters["NodesPerSecond"] = benchmark::Counter(
+            static_cast<double>(numNodes), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1000);
+    }
+    BENCHMARK(BM_DeadCode_Run)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMillisecond);
+
+    static void BM_Scheduler_Run(benchmark::State& state)
+    {
+        size_t numNodes = 0;
+        SchedulerStats stats;
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            Program program(MachineMode::AMD64);
+            x86::Assembler assembler(program);
+            for (const auto& instr : tests::data::Instructions)
+            {
+                instr.emitter(assembler);
+            }
+            numNodes += program.size();
+            state.ResumeTiming();
+
+            InstructionScheduler scheduler(program);
+            scheduler.run();
+
+            stats = scheduler.getStats();
+        }
+
+        state.counters["Regions"] = static_cast<double>(stats.regions);
+        state.counters["Moved"] = static_cast<double>(stats.instructionsMoved);
+        state.counters["CyclesBefore"] = static_cast<double>(stats.cyclesBefore);
+        state.counters["CyclesAfter"] = static_cast<double>(stats.cyclesAfter);
+        state.counters["NodesPerSecond"] = benchmark::Counter(
+            static_cast<double>(numNodes), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1000);
+    }
+    BENCHMARK(BM_Scheduler_Run)->Unit(benchmark::kMillisecond);
+
+} // namespace zasm::benchmarks
@@ -135,4 +135,43 @@ namespace zasm::benchmarks
     }
     BENCHMARK(BM_Assembler_EmitAll)->Unit(benchmark::kMillisecond);
 
+    static void BM_Assembler_EmitRate(benchmark::State& state)
+    {
+        using namespace zasm::x86;
+
+        Program program(MachineMode::AMD64);
+        Assembler assembler(program);
+
+        // Pausing the timer per instruction dominates the cost of a single emit, a batch
+        // measures the raw rate including the returned Error values.
+        constexpr int kBatchSize = 4096;
+
+        size_t numInstructions = 0;
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            program.clear();
+            assembler.setCursor(nullptr);
+            state.ResumeTiming();
+
+            for (int i = 0; i < kBatchSize; i++)
+            {
+                auto err = assembler.mov(rax, rcx);
+                benchmark::DoNotOptimize(err);
+                err = assembler.add(rdx, Imm(i));
+                benchmark::DoNotOptimize(err);
+                err = assembler.push(rbx);
+                benchmark::DoNotOptimize(err);
+                err = assembler.nop();
+                benchmark::DoNotOptimize(err);
+            }
+
+            numInstructions += kBatchSize * 4;
+        }
+
+        state.counters["Instructions"] = benchmark::Counter(
+            static_cast<double>(numInstructions), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1000);
+    }
+    BENCHMARK(BM_Assembler_EmitRate)->Unit(benchmark::kMicrosecond);
+
 } // namespace zasm::benchmarks
@@ -1,17 +1,16 @@
 #include <benchmark/benchmark.h>
 #include <functional>
+#include <string>
+#include <zasm/core/memorystream.hpp>
 #include <zasm/formatter/formatter.hpp>
 #include <zasm/testdata/x86/instructions.hpp>
 #include <zasm/zasm.hpp>
 
 namespace zasm::benchmarks
 {
-    static void BM_Formatter_Program(benchmark::State& state)
+    static void createLargeProgram(Program& program)
     {
-        using namespace zasm::x86;
-
-        Program program(MachineMode::AMD64);
-        Assembler assembler(program);
+        x86::Assembler assembler(program);
 
         // Create large enough program to contain 1~ million nodes.
         for (size_t i = 0; i < 1'000'000 / std::size(zasm::tests::data::Instructions); i++)
@@ -21,8 +20,15 @@ namespace zasm::benchmarks
                 instr.emitter(assembler);
             }
         }
+    }
+
+    static void BM_Formatter_Program(benchmark::State& state)
+    {
+        Program program(MachineMode::AMD64);
+        createLargeProgram(program);
 
         size_t numNodes = 0;
+        size_t numBytes = 0;
 
         for (auto _ : state)
         {
@@ -30,11 +36,123 @@ namespace zasm::benchmarks
             benchmark::DoNotOptimize(res);
 
             numNodes += program.size();
+            numBytes += res.size();
         }
 
+        state.SetBytesProcessed(static_cast<int64_t>(numBytes));
         state.counters["PrintedNodes"] = benchmark::Counter(
             static_cast<double>(numNodes), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1000);
     }
     BENCHMARK(BM_Formatter_Program)->Unit(benchmark::kMillisecond);
 
+    static void BM_Formatter_ProgramToBuffer(benchmark::State& state)
+    {
+        Program program(MachineMode::AMD64);
+        createLargeProgram(program);
+
+        size_t numNodes = 0;
+        size_t numBytes = 0;
+
+        // Reused across iterations, only the first iteration has to grow it.
+        std::string buffer;
+
+        for (auto _ : state)
+        {
+            buffer.clear();
+            formatter::format(buffer, program);
+            benchmark::DoNotOptimize(buffer.data());
+
+            numNodes += program.size();
+            numBytes += buffer.size();
+        }
+
+        state.SetBytesProcessed(static_cast<int64_t>(numBytes));
+        state.counters["PrintedNodes"] = benchmark::Counter(
+            static_cast<double>(numNodes), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1000);
+    }
+    BENCHMARK(BM_Formatter_ProgramToBuffer)->Unit(benchmark::kMillisecond);
+
+    static void BM_Formatter_ProgramToStream(benchmark::State& state)
+    {
+        Program program(MachineMode::AMD64);
+        createLargeProgram(program);
+
+        size_t numNodes = 0;
+        size_t numBytes = 0;
+
+        MemoryStream stream;
+
+        for (auto _ : state)
+        {
+            stream.clear();
+            auto err = formatter::format(stream, program);
+            benchmark::DoNotOptimize(err);
+
+            numNodes += program.size();
+            numBytes += stream.size();
+        }
+
+        state.SetBytesProcessed(static_cast<int64_t>(numBytes));
+        state.counters["PrintedNodes"] = benchmark::Counter(
+            static_cast<double>(numNodes), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1000);
+    }
+    BENCHMARK(BM_Formatter_ProgramToStream)->Unit(benchmark::kMillisecond);
+
+    static void BM_Formatter_SerializedListing(benchmark::State& state)
+    {
+        Program program(MachineMode::AMD64);
+        createLargeProgram(program);
+
+        Serializer serializer;
+        serializer.serialize(program, 0x00400000);
+
+        size_t numNodes = 0;
+        size_t numBytes = 0;
+
+        std::string buffer;
+
+        for (auto _ : state)
+        {
+            buffer.clear();
+            formatter::format(buffer, program, serializer);
+            benchmark::DoNotOptimize(buffer.data());
+
+            numNodes += program.size();
+            numBytes += buffer.size();
+        }
+
+        state.SetBytesProcessed(static_cast<int64_t>(numBytes));
+        state.counters["PrintedNodes"] = benchmark::Counter(
+            static_cast<double>(numNodes), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1000);
+    }
+    BENCHMARK(BM_Formatter_SerializedListing)->Unit(benchmark::kMillisecond);
+
+    static void BM_Formatter_ProgramParallel(benchmark::State& state)
+    {
+        Program program(MachineMode::AMD64);
+        createLargeProgram(program);
+
+        const auto numThreads = static_cast<std::size_t>(state.range(0));
+
+        size_t numNodes = 0;
+        size_t numBytes = 0;
+
+        std::string buffer;
+
+        for (auto _ : state)
+        {
+            buffer.clear();
+            formatter::formatParallel(buffer, program, formatter::kDefaultOptions, numThreads);
+            benchmark::DoNotOptimize(buffer.data());
+
+            numNodes += program.size();
+            numBytes += buffer.size();
+        }
+
+        state.SetBytesProcessed(static_cast<int64_t>(numBytes));
+        state.counters["PrintedNodes"] = benchmark::Counter(
+            static_cast<double>(numNodes), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1000);
+    }
+    BENCHMARK(BM_Formatter_ProgramParallel)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
 } // namespace zasm::benchmarks
@@ -0,0 +1,84 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include <zasm/zasm.hpp>
+
+namespace zasm::benchmarks
+{
+    static std::vector<Reg> makeRegisters()
+    {
+        std::vector<Reg> regs;
+        for (int regId = ZYDIS_REGISTER_AL; regId <= ZYDIS_REGISTER_MAX_VALUE; ++regId)
+        {
+            regs.emplace_back(static_cast<Reg::Id>(regId));
+        }
+        return regs;
+    }
+
+    static void BM_Register_GetBitSize(benchmark::State& state)
+    {
+        const auto regs = makeRegisters();
+
+        for (auto _ : state)
+        {
+            for (const auto& reg : regs)
+            {
+                benchmark::DoNotOptimize(reg.getBitSize(MachineMode::AMD64));
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * regs.size());
+    }
+    BENCHMARK(BM_Register_GetBitSize);
+
+    static void BM_Register_GetRoot(benchmark::State& state)
+    {
+        const auto regs = makeRegisters();
+
+        for (auto _ : state)
+        {
+            for (const auto& reg : regs)
+            {
+                benchmark::DoNotOptimize(reg.getRoot(MachineMode::AMD64));
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * regs.size());
+    }
+    BENCHMARK(BM_Register_GetRoot);
+
+    static void BM_Register_Classify(benchmark::State& state)
+    {
+        const auto regs = makeRegisters();
+
+        for (auto _ : state)
+        {
+            for (const auto& reg : regs)
+            {
+                benchmark::DoNotOptimize(reg.isGp());
+                benchmark::DoNotOptimize(reg.isXmm());
+                benchmark::DoNotOptimize(reg.getPhysicalIndex());
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * regs.size());
+    }
+    BENCHMARK(BM_Register_Classify);
+
+    static void BM_Register_ZydisGetWidth(benchmark::State& state)
+    {
+        const auto regs = makeRegisters();
+
+        for (auto _ : state)
+        {
+            for (const auto& reg : regs)
+            {
+                const auto regId = static_cast<ZydisRegister>(reg.getId());
+                benchmark::DoNotOptimize(ZydisRegisterGetWidth(ZYDIS_MACHINE_MODE_LONG_64, regId));
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * regs.size());
+    }
+    BENCHMARK(BM_Register_ZydisGetWidth);
+
+} // namespace zasm::benchmarks
@@ -1,5 +1,9 @@
+#include "../allocationcounter.hpp"
+
 #include <benchmark/benchmark.h>
 #include <functional>
+#include <utility>
+#include <vector>
 #include <zasm/testdata/x86/instructions.hpp>
 #include <zasm/zasm.hpp>
 
@@ -101,6 +105,8 @@ namespace zasm::benchmarks
             numInstructions += count;
         }
 
+        state.counters["Passes"] = static_cast<double>(serializer.getPassCount());
+
         state.counters["BytesEncoded"] = benchmark::Counter(
             static_cast<double>(numBytesEncoded), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1024);
 
@@ -113,4 +119,399 @@ namespace zasm::benchmarks
 
     BENCHMARK_TEMPLATE(BM_SerializationWithLabels, 32)->Unit(benchmark::kMillisecond);
 
+    static void buildRelocationHeavyProgram(Program& program)
+    {
+        using namespace zasm::x86;
+
+        Assembler assembler(program);
+
+        // Every label is referenced by absolute 64 bit moves and embedded labels.
+        zasm::Label label = assembler.createLabel();
+        assembler.bind(label);
+
+        const auto count = std::size(tests::data::Instructions);
+        for (int64_t i = 0; i < count; ++i)
+        {
+            const auto& instr = tests::data::Instructions[i];
+            instr.emitter(assembler);
+
+            if (i % 16 == 0)
+            {
+                assembler.mov(rax, label);
+                assembler.embedLabel(label);
+                label = assembler.createLabel();
+                assembler.bind(label);
+            }
+        }
+    }
+
+    static void BM_Relocate(benchmark::State& state)
+    {
+        Program program(MachineMode::AMD64);
+        buildRelocationHeavyProgram(program);
+
+        Serializer serializer;
+        serializer.serialize(program, 0x00400000);
+
+        std::int64_t base = 0x00400000;
+        for (auto _ : state)
+        {
+            base += 0x1000;
+            serializer.relocate(base);
+        }
+
+        state.counters["Relocations"] = benchmark::Counter(
+            static_cast<double>(serializer.getRelocationCount()), benchmark::Counter::kIsIterationInvariantRate,
+            benchmark::Counter::OneK::kIs1000);
+    }
+    BENCHMARK(BM_Relocate)->Unit(benchmark::kMicrosecond);
+
+    static void BM_RelocateTo(benchmark::State& state)
+    {
+        Program program(MachineMode::AMD64);
+        buildRelocationHeavyProgram(program);
+
+        Serializer serializer;
+        serializer.serialize(program, 0x00400000);
+
+        std::vector<std::uint8_t> buffer(serializer.getCodeSize());
+
+        std::int64_t base = 0x00400000;
+        for (auto _ : state)
+        {
+            base += 0x1000;
+            serializer.relocateTo(base, buffer.data(), buffer.size());
+            benchmark::DoNotOptimize(buffer.data());
+        }
+
+        state.counters["Relocations"] = benchmark::Counter(
+            static_cast<double>(serializer.getRelocationCount()), benchmark::Counter::kIsIterationInvariantRate,
+            benchmark::Counter::OneK::kIs1000);
+        state.counters["BytesCopied"] = benchmark::Counter(
+            static_cast<double>(buffer.size()), benchmark::Counter::kIsIterationInvariantRate,
+            benchmark::Counter::OneK::kIs1024);
+    }
+    BENCHMARK(BM_RelocateTo)->Unit(benchmark::kMicrosecond);
+
+    static void BM_SerializeDataRepeat(benchmark::State& state)
+    {
+        const auto repeatCount = static_cast<std::size_t>(state.range(0));
+
+        Program program(MachineMode::AMD64);
+        {
+            x86::Assembler assembler(program);
+            for (int i = 0; i < 64; ++i)
+            {
+                assembler.dq(0x0123456789ABCDEF, repeatCount);
+                assembler.db(0xCC, repeatCount);
+            }
+        }
+
+        Serializer serializer;
+        for (auto _ : state)
+        {
+            serializer.serialize(program, 0x00400000);
+        }
+
+        state.counters["BytesEncoded"] = benchmark::Counter(
+            static_cast<double>(serializer.getCodeSize()), benchmark::Counter::kIsIterationInvariantRate,
+            benchmark::Counter::OneK::kIs1024);
+    }
+    BENCHMARK(BM_SerializeDataRepeat)->Arg(16)->Arg(1024)->Arg(65536)->Unit(benchmark::kMicrosecond);
+
+    template<bool TShared> static void BM_EmbedLargeData(benchmark::State& state)
+    {
+        std::vector<std::uint8_t> blob(1024 * 1024);
+        for (std::size_t i = 0; i < blob.size(); ++i)
+        {
+            blob[i] = static_cast<std::uint8_t>(i * 7);
+        }
+
+        const auto shared = Data::shared(blob.data(), blob.size()).value();
+
+        for (auto _ : state)
+        {
+            // Embed the same blob into multiple programs.
+            for (int i = 0; i < 8; ++i)
+            {
+                Program program(MachineMode::AMD64);
+                x86::Assembler assembler(program);
+                if constexpr (TShared)
+                {
+                    assembler.embed(shared);
+                }
+                else
+                {
+                    assembler.embed(blob.data(), blob.size());
+                }
+                benchmark::DoNotOptimize(program.getHead());
+            }
+        }
+    }
+    BENCHMARK_TEMPLATE(BM_EmbedLargeData, false)->Unit(benchmark::kMicrosecond);
+    BENCHMARK_TEMPLATE(BM_EmbedLargeData, true)->Unit(benchmark::kMicrosecond);
+
+    template<bool TReuse> static void BM_SerializationAllocations(benchmark::State& state)
+    {
+        using namespace zasm::x86;
+
+        Program program(MachineMode::AMD64);
+        Assembler assembler(program);
+
+        zasm::Label label;
+
+        const auto count = std::size(tests::data::Instructions);
+        for (int64_t i = 0; i < count; ++i)
+        {
+            const auto& instr = tests::data::Instructions[i];
+            instr.emitter(assembler);
+
+            if (i % 128 == 0)
+            {
+                if (label.isValid())
+                {
+                    assembler.lea(rax, qword_ptr(label));
+                }
+                label = assembler.createLabel();
+                assembler.bind(label);
+            }
+        }
+
+        Serializer reusedSerializer;
+
+        // Warm up so the reused serializer already holds its buffers.
+        reusedSerializer.serialize(program, 0x00400000);
+
+        std::size_t numAllocations = 0;
+        for (auto _ : state)
+        {
+            const auto allocCountBefore = getAllocationCount();
+
+            if constexpr (TReuse)
+            {
+                reusedSerializer.serialize(program, 0x00400000);
+            }
+            else
+            {
+                Serializer serializer;
+                serializer.serialize(program, 0x00400000);
+            }
+
+            numAllocations += getAllocationCount() - allocCountBefore;
+        }
+
+        state.counters["Allocations"] = benchmark::Counter(
+            static_cast<double>(numAllocations), benchmark::Counter::kAvgIterations);
+    }
+    BENCHMARK_TEMPLATE(BM_SerializationAllocations, false)->Unit(benchmark::kMillisecond);
+
+    BENCHMARK_TEMPLATE(BM_SerializationAllocations, true)->Unit(benchmark::kMillisecond);
+
+    static void BM_SerializationAligned(benchmark::State& state)
+    {
+        using namespace zasm::x86;
+
+        Program program(MachineMode::AMD64);
+        Assembler assembler(program);
+
+        // Small functions each aligned to a page.
+        const auto count = std::size(tests::data::Instructions);
+        for (int64_t i = 0; i < count; ++i)
+        {
+            const auto& instr = tests::data::Instructions[i];
+            instr.emitter(assembler);
+
+            if (i % 64 == 0)
+            {
+                assembler.align(Align::Type::Code, static_cast<std::uint32_t>(state.range(0)));
+            }
+        }
+
+        Serializer serializer;
+        serializer.setNopStyle(static_cast<NopStyle>(state.range(1)));
+
+        size_t numBytesEncoded = 0;
+        for (auto _ : state)
+        {
+            serializer.serialize(program, 0x00400000);
+
+            numBytesEncoded += serializer.getCodeSize();
+        }
+
+        state.counters["BytesEncoded"] = benchmark::Counter(
+            static_cast<double>(numBytesEncoded), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1024);
+    }
+    BENCHMARK(BM_SerializationAligned)
+        ->ArgsProduct({ { 64, 0x1000 },
+                        { static_cast<int64_t>(NopStyle::Generic), static_cast<int64_t>(NopStyle::AMD),
+                          static_cast<int64_t>(NopStyle::Legacy) } })
+        ->Unit(benchmark::kMillisecond);
+
+    // Every few instructions a conditional branch goes through a chain of trampolines at the end of the program.
+    static void buildBranchChainProgram(Program& program)
+    {
+        using namespace zasm::x86;
+
+        Assembler assembler(program);
+
+        std::vector<std::pair<zasm::Label, zasm::Label>> trampolines;
+
+        const auto count = std::size(tests::data::Instructions);
+        for (int64_t i = 0; i < count; ++i)
+        {
+            const auto& instr = tests::data::Instructions[i];
+            instr.emitter(assembler);
+
+            if (i % 16 == 0)
+            {
+                auto labelTrampoline = assembler.createLabel();
+                auto labelBack = assembler.createLabel();
+                assembler.jnz(labelTrampoline);
+                assembler.bind(labelBack);
+                trampolines.emplace_back(labelTrampoline, labelBack);
+            }
+        }
+
+        assembler.ret();
+        for (const auto& [labelTrampoline, labelBack] : trampolines)
+        {
+            auto labelChain = assembler.createLabel();
+            assembler.bind(labelTrampoline);
+            assembler.jmp(labelChain);
+            assembler.bind(labelChain);
+            assembler.jmp(labelBack);
+        }
+    }
+
+    template<bool TThreadJumps> static void BM_SerializationBranchChains(benchmark::State& state)
+    {
+        Program program(MachineMode::AMD64);
+        buildBranchChainProgram(program);
+
+        Serializer serializer;
+        serializer.serialize(program, 0x00400000);
+        const auto baseSize = serializer.getCodeSize();
+
+        if constexpr (TThreadJumps)
+        {
+            JumpThreading pass(program);
+            pass.run();
+
+            state.counters["Retargeted"] = static_cast<double>(pass.getStats().branchesRetargeted);
+            state.counters["Removed"] = static_cast<double>(pass.getStats().trampolinesRemoved);
+        }
+
+        size_t numBytesEncoded = 0;
+        for (auto _ : state)
+        {
+            serializer.serialize(program, 0x00400000);
+
+            numBytesEncoded += serializer.getCodeSize();
+        }
+
+        state.counters["CodeSize"] = static_cast<double>(serializer.getCodeSize());
+        state.counters["CodeSizeDelta"] = static_cast<double>(serializer.getCodeSize()) - static_cast<double>(baseSize);
+        state.counters["BytesEncoded"] = benchmark::Counter(
+            static_cast<double>(numBytesEncoded), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1024);
+    }
+    BENCHMARK_TEMPLATE(BM_SerializationBranchChains, false)->Unit(benchmark::kMillisecond);
+
+    BENCHMARK_TEMPLATE(BM_SerializationBranchChains, true)->Unit(benchmark::kMillisecond);
+
+    template<bool TShrink> static void BM_SerializationShrink(benchmark::State& state)
+    {
+        using namespace zasm::x86;
+
+        Program program(MachineMode::AMD64);
+        Assembler assembler(program);
+
+        const auto count = std::size(tests::data::Instructions);
+        for (int64_t i = 0; i < count; ++i)
+        {
+            const auto& instr = tests::data::Instructions[i];
+            instr.emitter(assembler);
+
+            // Typical code generator output with 64 bit operands and small immediates.
+            if (i % 8 == 0)
+            {
+                assembler.mov(rax, Imm(i));
+                assembler.and_(rcx, Imm(0xFF));
+                assembler.xor_(rdx, rdx);
+            }
+        }
+
+        Serializer serializer;
+        serializer.setShrinkInstructions(TShrink);
+
+        size_t numBytesEncoded = 0;
+        for (auto _ : state)
+        {
+            serializer.serialize(program, 0x00400000);
+
+            numBytesEncoded += serializer.getCodeSize();
+        }
+
+        state.counters["CodeSize"] = static_cast<double>(serializer.getCodeSize());
+        state.counters["BytesSaved"] = static_cast<double>(serializer.getBytesSaved());
+        state.counters["BytesEncoded"] = benchmark::Counter(
+            static_cast<double>(numBytesEncoded), benchmark::Counter::kIsRate, benchmark::Counter::OneK::kIs1024);
+    }
+    BENCHMARK_TEMPLATE(BM_SerializationShrink, false)->Unit(benchmark::kMillisecond);
+
+    BENCHMARK_TEMPLATE(BM_SerializationShrink, true)->Unit(benchmark::kMillisecond);
+
+    // Small loops between the instructions, every loop ends with a macro-fused compare and branch.
+    static void buildLoopProgram(Program& program)
+    {
+        using namespace zasm::x86;
+
+        Assembler assembler(program);
+
+        zasm::Label labelLoop = assembler.createLabel();
+        assembler.bind(labelLoop);
+
+        const auto count = std::size(tests::data::Instructions);
+        for (int64_t i = 0; i < count; ++i)
+        {
+            const auto& instr = tests::data::Instructions[i];
+            instr.emitter(assembler);
+
+            if (i % 24 == 0)
+            {
+                assembler.cmp(ecx, edx);
+                assembler.jnz(labelLoop);
+                labelLoop = assembler.createLabel();
+                assembler.bind(labelLoop);
+            }
+        }
+    }
+
+    template<bool TAvoidJccErratum> static void BM_LayoutOptimizer(benchmark::State& state)
+    {
+        Serializer serializer;
+        LayoutStats stats;
+
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            Program program(MachineMode::AMD64);
+            buildLoopProgram(program);
+            state.ResumeTiming();
+
+            LayoutOptimizer layout(program);
+            layout.setAvoidJccErratum(TAvoidJccErratum);
+            layout.run(serializer, 0x00400000);
+
+            stats = layout.getStats();
+        }
+
+        state.counters["LoopsAligned"] = static_cast<double>(stats.loopsAligned);
+        state.counters["BranchesPadded"] = static_cast<double>(stats.branchesPadded);
+        state.counters["CodeSize"] = static_cast<double>(stats.codeSizeAfter);
+        state.counters["CodeSizeDelta"] = static_cast<double>(stats.codeSizeAfter) - static_cast<double>(stats.codeSizeBefore);
+    }
+    BENCHMARK_TEMPLATE(BM_LayoutOptimizer, false)->Unit(benchmark::kMillisecond);
+
+    BENCHMARK_TEMPLATE(BM_LayoutOptimizer, true)->Unit(benchmark::kMillisecond);
+
 } // namespace zasm::benchmarks
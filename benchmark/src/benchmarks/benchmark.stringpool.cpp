@@ -1,5 +1,8 @@
 #include <benchmark/benchmark.h>
+#include <memory>
 #include <random>
+#include <zasm/core/concurrentstringpool.hpp>
+#include <zasm/core/memorystream.hpp>
 #include <zasm/core/stringpool.hpp>
 
 namespace zasm::benchmarks
@@ -133,4 +136,268 @@ namespace zasm::benchmarks
     }
     BENCHMARK(BM_StringPool_GetLength)->Range(0, kTestSize)->Unit(benchmark::kMillisecond);
 
+    // Produces unique symbol like names for large counts without keeping all of them in memory.
+    static std::size_t makeSymbolName(char* buf, std::size_t index)
+    {
+        constexpr std::size_t kNumChars = sizeof(kChars) - 1;
+
+        std::size_t len = 0;
+        buf[len++] = 's';
+        buf[len++] = 'y';
+        buf[len++] = 'm';
+        buf[len++] = '_';
+
+        // Scramble the index so consecutive names do not share their suffix.
+        auto value = static_cast<std::uint64_t>(index) * 0x9E3779B97F4A7C15ULL;
+        value = (value >> 32) ^ value;
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            buf[len++] = kChars[value % kNumChars];
+            value /= kNumChars;
+        }
+
+        // Encoding the index keeps the names unique.
+        do
+        {
+            buf[len++] = kChars[index % kNumChars];
+            index /= kNumChars;
+        } while (index != 0);
+
+        buf[len] = '\0';
+        return len;
+    }
+
+    static void BM_StringPool_Intern(benchmark::State& state)
+    {
+        const auto count = static_cast<std::size_t>(state.range(0));
+
+        char buf[32];
+        for (auto _ : state)
+        {
+            StringPool pool;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const auto len = makeSymbolName(buf, i);
+
+                auto stringId = pool.acquire(buf, len);
+                benchmark::DoNotOptimize(stringId);
+            }
+
+            state.PauseTiming();
+            pool = StringPool{};
+            state.ResumeTiming();
+        }
+
+        state.SetItemsProcessed(state.iterations() * count);
+    }
+    BENCHMARK(BM_StringPool_Intern)->Arg(1'000)->Arg(100'000)->Arg(10'000'000)->Unit(benchmark::kMillisecond);
+
+    static void BM_StringPool_Find(benchmark::State& state)
+    {
+        const auto count = static_cast<std::size_t>(state.range(0));
+
+        char buf[32];
+
+        StringPool pool;
+        pool.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const auto len = makeSymbolName(buf, i);
+            pool.acquire(buf, len);
+        }
+
+        for (auto _ : state)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                // Every other lookup misses.
+                makeSymbolName(buf, (i & 1) == 0 ? i : count + i);
+
+                auto stringId = pool.find(buf);
+                benchmark::DoNotOptimize(stringId);
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * count);
+    }
+    BENCHMARK(BM_StringPool_Find)->Arg(1'000)->Arg(100'000)->Arg(10'000'000)->Unit(benchmark::kMillisecond);
+
+    static std::vector<std::string> makeStrings(std::size_t count, std::size_t minLen, std::size_t maxLen)
+    {
+        std::vector<std::string> strings;
+        strings.reserve(count);
+
+        std::mt19937 prng(42);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const auto len = minLen + (prng() % (maxLen - minLen + 1));
+
+            std::string str;
+            for (std::size_t n = 0; n < len; ++n)
+            {
+                str.push_back(kChars[prng() % (sizeof(kChars) - 1)]);
+            }
+            strings.push_back(std::move(str));
+        }
+        return strings;
+    }
+
+    static constexpr std::size_t kLengthTestSize = 100'000;
+
+    static void BM_StringPool_AcquireLength(benchmark::State& state)
+    {
+        const auto strings = makeStrings(kLengthTestSize, state.range(0), state.range(1));
+
+        std::size_t bytes = 0;
+        for (const auto& str : strings)
+        {
+            bytes += str.size();
+        }
+
+        for (auto _ : state)
+        {
+            StringPool pool;
+            for (const auto& str : strings)
+            {
+                auto stringId = pool.acquire(str);
+                benchmark::DoNotOptimize(stringId);
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * strings.size());
+        state.SetBytesProcessed(state.iterations() * bytes);
+    }
+    BENCHMARK(BM_StringPool_AcquireLength)
+        ->Args({ 1, 8 })
+        ->Args({ 8, 16 })
+        ->Args({ 16, 32 })
+        ->Args({ 32, 64 })
+        ->Args({ 64, 256 })
+        ->Unit(benchmark::kMillisecond);
+
+    static void BM_StringPool_FindLength(benchmark::State& state)
+    {
+        const auto strings = makeStrings(kLengthTestSize, state.range(0), state.range(1));
+
+        std::size_t bytes = 0;
+
+        StringPool pool;
+        for (const auto& str : strings)
+        {
+            pool.acquire(str);
+            bytes += str.size();
+        }
+
+        for (auto _ : state)
+        {
+            for (const auto& str : strings)
+            {
+                auto stringId = pool.find(str.c_str());
+                benchmark::DoNotOptimize(stringId);
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * strings.size());
+        state.SetBytesProcessed(state.iterations() * bytes);
+    }
+    BENCHMARK(BM_StringPool_FindLength)
+        ->Args({ 1, 8 })
+        ->Args({ 8, 16 })
+        ->Args({ 16, 32 })
+        ->Args({ 32, 64 })
+        ->Args({ 64, 256 })
+        ->Unit(benchmark::kMillisecond);
+
+    static void BM_StringPool_Save(benchmark::State& state)
+    {
+        StringPool pool;
+        for (const auto& str : kInputStrings)
+        {
+            pool.acquire(str);
+        }
+
+        MemoryStream stream;
+        for (auto _ : state)
+        {
+            stream.clear();
+
+            auto err = pool.save(stream);
+            benchmark::DoNotOptimize(err);
+        }
+
+        state.counters["Bytes"] = static_cast<double>(stream.size());
+    }
+    BENCHMARK(BM_StringPool_Save)->Unit(benchmark::kMillisecond);
+
+    template<bool TMapped> static void BM_StringPool_Load(benchmark::State& state)
+    {
+        MemoryStream stream;
+        {
+            StringPool pool;
+            for (const auto& str : kInputStrings)
+            {
+                pool.acquire(str);
+            }
+            pool.save(stream);
+        }
+
+        for (auto _ : state)
+        {
+            StringPool pool;
+            if constexpr (TMapped)
+            {
+                auto err = pool.loadMapped(stream.data(), stream.size());
+                benchmark::DoNotOptimize(err);
+            }
+            else
+            {
+                stream.seek(0, SeekType::Begin);
+
+                auto err = pool.load(stream);
+                benchmark::DoNotOptimize(err);
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * kInputStrings.size());
+    }
+    BENCHMARK_TEMPLATE(BM_StringPool_Load, false)->Unit(benchmark::kMillisecond);
+    BENCHMARK_TEMPLATE(BM_StringPool_Load, true)->Unit(benchmark::kMillisecond);
+
+    static std::unique_ptr<ConcurrentStringPool> gSharedPool;
+
+    // All threads intern the same names, like workers resolving the same imports.
+    static void BM_ConcurrentStringPool_Acquire(benchmark::State& state)
+    {
+        if (state.thread_index() == 0)
+        {
+            gSharedPool = std::make_unique<ConcurrentStringPool>();
+        }
+
+        const auto count = static_cast<std::size_t>(state.range(0));
+
+        char buf[32];
+        for (auto _ : state)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const auto len = makeSymbolName(buf, i);
+
+                auto stringId = gSharedPool->acquire(buf, len);
+                benchmark::DoNotOptimize(stringId);
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * count);
+
+        if (state.thread_index() == 0)
+        {
+            gSharedPool.reset();
+        }
+    }
+    BENCHMARK(BM_ConcurrentStringPool_Acquire)
+        ->Arg(100'000)
+        ->ThreadRange(1, 8)
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+
 } // namespace zasm::benchmarks
@@ -0,0 +1,257 @@
+#include "../testutils.hpp"
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <zasm/zasm.hpp>
+
+namespace zasm::tests
+{
+    // Entry branches to the hot block, the fall through is cold.
+    static void buildHotBranch(Program& program, BlockReordering& pass)
+    {
+        x86::Assembler a(program);
+        auto labelEntry = a.createLabel();
+        auto labelHot = a.createLabel();
+        ASSERT_EQ(a.bind(labelEntry), ErrorCode::None);
+        ASSERT_EQ(a.cmp(x86::eax, x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.jz(labelHot), ErrorCode::None);
+        ASSERT_EQ(a.mov(x86::eax, Imm(1)), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelHot), ErrorCode::None);
+        ASSERT_EQ(a.mov(x86::eax, Imm(2)), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        pass.setWeight(labelEntry, 100);
+        pass.setWeight(labelHot, 100);
+    }
+
+    TEST(BlockReorderTests, InvertBranch)
+    {
+        Program program(MachineMode::AMD64);
+        BlockReordering pass(program);
+        buildHotBranch(program, pass);
+
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+
+        const std::vector<InstrMnemonic> expected = {
+            x86::Mnemonic::Cmp, x86::Mnemonic::Jnz, x86::Mnemonic::Mov,
+            x86::Mnemonic::Ret, x86::Mnemonic::Mov, x86::Mnemonic::Ret,
+        };
+        ASSERT_EQ(getMnemonics(program), expected);
+
+        // The hot block follows the branch.
+        const auto* hotMov = program.getHead()->getNext()->getNext()->getNext()->getNext();
+        ASSERT_EQ(hotMov->get<Instruction>().getOperand<Imm>(1).value<int>(), 2);
+
+        const auto& stats = pass.getStats();
+        ASSERT_EQ(stats.blocks, 3);
+        ASSERT_EQ(stats.branchesInverted, 1);
+        ASSERT_EQ(stats.jumpsInserted, 0);
+        ASSERT_EQ(stats.fallthroughWeightBefore, 0);
+        ASSERT_EQ(stats.fallthroughWeightAfter, 100);
+    }
+
+    TEST(BlockReorderTests, ColdSection)
+    {
+        Program program(MachineMode::AMD64);
+        BlockReordering pass(program);
+        buildHotBranch(program, pass);
+
+        pass.setSplitColdBlocks(true);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+        ASSERT_EQ(pass.getStats().coldBlocks, 1);
+
+        const Node* sectionNode = nullptr;
+        for (const auto* node = program.getHead(); node != nullptr; node = node->getNext())
+        {
+            if (node->holds<Section>())
+            {
+                sectionNode = node;
+            }
+        }
+        ASSERT_NE(sectionNode, nullptr);
+        ASSERT_STREQ(program.getSectionName(sectionNode->get<Section>()), ".text.cold");
+
+        // Only the cold block is in the section.
+        ASSERT_TRUE(sectionNode->getNext()->holds<Label>());
+        ASSERT_EQ(sectionNode->getNext()->getNext()->get<Instruction>().getOperand<Imm>(1).value<int>(), 1);
+
+        Serializer serializer;
+        ASSERT_EQ(serializer.serialize(program, 0x0000000000401000), ErrorCode::None);
+        ASSERT_EQ(serializer.getSectionCount(), 2);
+    }
+
+    TEST(BlockReorderTests, InsertAndRemoveJumps)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto labelEntry = a.createLabel();
+        auto labelA = a.createLabel();
+        auto labelB = a.createLabel();
+        auto labelC = a.createLabel();
+        ASSERT_EQ(a.bind(labelEntry), ErrorCode::None);
+        ASSERT_EQ(a.test(x86::eax, x86::eax), ErrorCode::None);
+        ASSERT_EQ(a.jz(labelA), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelB), ErrorCode::None);
+        ASSERT_EQ(a.inc(x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelC), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelA), ErrorCode::None);
+        ASSERT_EQ(a.dec(x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.jmp(labelC), ErrorCode::None);
+
+        BlockReordering pass(program);
+        pass.setWeight(labelEntry, 100);
+        pass.setWeight(labelA, 90);
+        pass.setWeight(labelB, 10);
+        pass.setWeight(labelC, 100);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+
+        const std::vector<InstrMnemonic> expected = {
+            x86::Mnemonic::Test, x86::Mnemonic::Jnz, x86::Mnemonic::Dec,
+            x86::Mnemonic::Ret,  x86::Mnemonic::Inc, x86::Mnemonic::Jmp,
+        };
+        ASSERT_EQ(getMnemonics(program), expected);
+
+        const auto& stats = pass.getStats();
+        ASSERT_EQ(stats.branchesInverted, 1);
+        ASSERT_EQ(stats.jumpsRemoved, 1);
+        ASSERT_EQ(stats.jumpsInserted, 1);
+        ASSERT_EQ(stats.fallthroughWeightBefore, 20);
+        ASSERT_EQ(stats.fallthroughWeightAfter, 180);
+    }
+
+    TEST(BlockReorderTests, EntryJumpToNextBlock)
+    {
+        Program program(MachineMode::AMD64);
+        BlockReordering pass(program);
+
+        x86::Assembler a(program);
+        auto labelCold = a.createLabel();
+        auto labelHot = a.createLabel();
+        ASSERT_EQ(a.jmp(labelHot), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelCold), ErrorCode::None);
+        ASSERT_EQ(a.inc(x86::eax), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelHot), ErrorCode::None);
+        ASSERT_EQ(a.dec(x86::eax), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        pass.setWeight(labelHot, 100);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+
+        // The entry block is only the jump, it has no label to remove it.
+        const std::vector<InstrMnemonic> expected = {
+            x86::Mnemonic::Jmp, x86::Mnemonic::Dec, x86::Mnemonic::Ret, x86::Mnemonic::Inc, x86::Mnemonic::Ret,
+        };
+        ASSERT_EQ(getMnemonics(program), expected);
+        ASSERT_EQ(program.getHead()->get<Instruction>().getOperand<Label>(0), labelHot);
+
+        const auto& stats = pass.getStats();
+        ASSERT_EQ(stats.blocks, 3);
+        ASSERT_EQ(stats.jumpsRemoved, 0);
+        ASSERT_EQ(stats.jumpsInserted, 0);
+    }
+
+    TEST(BlockReorderTests, KeepTrampolineInPlace)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto labelTrampoline = a.createLabel();
+        auto labelTarget = a.createLabel();
+        ASSERT_EQ(a.inc(x86::eax), ErrorCode::None);
+        ASSERT_EQ(a.jmp(labelTrampoline), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelTrampoline), ErrorCode::None);
+        ASSERT_EQ(a.jmp(labelTarget), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelTarget), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        BlockReordering pass(program);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+
+        // Removing the jump of the trampoline would merge both labels into one block.
+        const std::vector<InstrMnemonic> expected = {
+            x86::Mnemonic::Inc,
+            x86::Mnemonic::Jmp,
+            x86::Mnemonic::Ret,
+        };
+        ASSERT_EQ(getMnemonics(program), expected);
+
+        const auto& stats = pass.getStats();
+        ASSERT_EQ(stats.blocks, 3);
+        ASSERT_EQ(stats.jumpsRemoved, 1);
+        ASSERT_EQ(stats.jumpsInserted, 0);
+    }
+
+    TEST(BlockReorderTests, KeepTrampolineAfterReorder)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto labelEntry = a.createLabel();
+        auto labelCold = a.createLabel();
+        auto labelTrampoline = a.createLabel();
+        auto labelTarget = a.createLabel();
+        ASSERT_EQ(a.bind(labelEntry), ErrorCode::None);
+        ASSERT_EQ(a.test(x86::eax, x86::eax), ErrorCode::None);
+        ASSERT_EQ(a.jz(labelTrampoline), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelCold), ErrorCode::None);
+        ASSERT_EQ(a.dec(x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelTarget), ErrorCode::None);
+        ASSERT_EQ(a.inc(x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelTrampoline), ErrorCode::None);
+        ASSERT_EQ(a.jmp(labelTarget), ErrorCode::None);
+
+        BlockReordering pass(program);
+        pass.setWeight(labelEntry, 100);
+        pass.setWeight(labelCold, 10);
+        pass.setWeight(labelTrampoline, 90);
+        pass.setWeight(labelTarget, 90);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+
+        // The trampoline is placed in front of its target and keeps the jump.
+        const std::vector<InstrMnemonic> expected = {
+            x86::Mnemonic::Test, x86::Mnemonic::Jnz, x86::Mnemonic::Jmp, x86::Mnemonic::Inc,
+            x86::Mnemonic::Ret,  x86::Mnemonic::Dec, x86::Mnemonic::Ret,
+        };
+        ASSERT_EQ(getMnemonics(program), expected);
+
+        const auto& stats = pass.getStats();
+        ASSERT_EQ(stats.blocks, 4);
+        ASSERT_EQ(stats.branchesInverted, 1);
+        ASSERT_EQ(stats.jumpsRemoved, 0);
+        ASSERT_EQ(stats.jumpsInserted, 0);
+    }
+
+    TEST(BlockReorderTests, KeepLayoutWithoutWeights)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto labelLoop = a.createLabel();
+        auto labelSkip = a.createLabel();
+        ASSERT_EQ(a.mov(x86::ecx, Imm(10)), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelLoop), ErrorCode::None);
+        ASSERT_EQ(a.test(x86::eax, x86::eax), ErrorCode::None);
+        ASSERT_EQ(a.jz(labelSkip), ErrorCode::None);
+        ASSERT_EQ(a.inc(x86::eax), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelSkip), ErrorCode::None);
+        ASSERT_EQ(a.dec(x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.jnz(labelLoop), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        const auto before = getMnemonics(program);
+
+        BlockReordering pass(program);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+
+        ASSERT_EQ(getMnemonics(program), before);
+        ASSERT_EQ(pass.getStats().blocksMoved, 0);
+        ASSERT_EQ(pass.getStats().jumpsInserted, 0);
+    }
+
+} // namespace zasm::tests
@@ -0,0 +1,335 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <zasm/zasm.hpp>
+
+namespace zasm::tests
+{
+    using BlockLayout = std::vector<std::pair<Node::Id, Node::Id>>;
+    using EdgeList = std::vector<std::tuple<Node::Id, Node::Id, EdgeKind>>;
+
+    // Returns the head of the block for each node, this does not depend on the block ids.
+    static BlockLayout getBlockLayout(const Program& program, const ControlFlowGraph& cfg)
+    {
+        BlockLayout res;
+        for (const auto* node = program.getHead(); node != nullptr; node = node->getNext())
+        {
+            const auto* block = cfg.getBlock(cfg.getBlockOf(node));
+            if (block == nullptr)
+            {
+                res.emplace_back(node->getId(), Node::Id::Invalid);
+                continue;
+            }
+            res.emplace_back(node->getId(), block->head->getId());
+        }
+        return res;
+    }
+
+    // Returns all edges as pairs of block heads, sorted.
+    static EdgeList getEdgeList(const ControlFlowGraph& cfg)
+    {
+        EdgeList res;
+        for (std::size_t i = 0; i < cfg.getBlockCount(); ++i)
+        {
+            const auto id = static_cast<BlockId>(i);
+            const auto* block = cfg.getBlock(id);
+            if (block == nullptr)
+            {
+                continue;
+            }
+
+            std::size_t succCount = 0;
+            cfg.forEachSuccessor(id, [&](const CFGEdge& edge) {
+                res.emplace_back(block->head->getId(), cfg.getBlock(edge.to)->head->getId(), edge.kind);
+                succCount++;
+            });
+            EXPECT_EQ(succCount, block->succCount);
+
+            std::size_t predCount = 0;
+            cfg.forEachPredecessor(id, [&](const CFGEdge& edge) {
+                EXPECT_EQ(edge.to, id);
+                predCount++;
+            });
+            EXPECT_EQ(predCount, block->predCount);
+        }
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+
+    TEST(ControlFlowGraphTests, BuildSimple)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+
+        auto labelLoop = a.createLabel();
+        auto labelExit = a.createLabel();
+
+        ASSERT_EQ(a.bind(labelLoop), ErrorCode::None);
+        ASSERT_EQ(a.mov(x86::eax, Imm(1)), ErrorCode::None);
+        ASSERT_EQ(a.cmp(x86::eax, Imm(2)), ErrorCode::None);
+        ASSERT_EQ(a.jz(labelExit), ErrorCode::None);
+        ASSERT_EQ(a.add(x86::eax, Imm(1)), ErrorCode::None);
+        ASSERT_EQ(a.jmp(labelLoop), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelExit), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        ControlFlowGraph cfg(program);
+        ASSERT_EQ(cfg.getValidBlockCount(), 3);
+
+        const auto entry = cfg.getEntryBlock();
+        const auto middle = cfg.getNextBlock(entry);
+        const auto exit = cfg.getBlockOf(labelExit);
+        ASSERT_EQ(cfg.getBlockOf(labelLoop), entry);
+        ASSERT_EQ(cfg.getNextBlock(middle), exit);
+        ASSERT_EQ(cfg.getNextBlock(exit), BlockId::Invalid);
+
+        ASSERT_EQ(cfg.getBlock(entry)->head, program.getHead());
+        ASSERT_TRUE(cfg.getBlock(entry)->tail->get<Instruction>().getMnemonic() == x86::Mnemonic::Jz);
+        ASSERT_EQ(cfg.getBlock(exit)->tail, program.getTail());
+
+        std::vector<std::pair<BlockId, EdgeKind>> succs;
+        cfg.forEachSuccessor(entry, [&](const CFGEdge& edge) { succs.emplace_back(edge.to, edge.kind); });
+        std::sort(succs.begin(), succs.end());
+        ASSERT_EQ(succs.size(), 2);
+        ASSERT_TRUE(std::find(succs.begin(), succs.end(), std::make_pair(middle, EdgeKind::Fallthrough)) != succs.end());
+        ASSERT_TRUE(std::find(succs.begin(), succs.end(), std::make_pair(exit, EdgeKind::Branch)) != succs.end());
+
+        ASSERT_EQ(cfg.getBlock(middle)->succCount, 1);
+        ASSERT_EQ(cfg.getEdge(cfg.getBlock(middle)->firstSucc)->to, entry);
+        ASSERT_EQ(cfg.getEdge(cfg.getBlock(middle)->firstSucc)->kind, EdgeKind::Jump);
+
+        ASSERT_EQ(cfg.getBlock(exit)->succCount, 0);
+        ASSERT_EQ(cfg.getBlock(exit)->predCount, 1);
+        ASSERT_EQ(cfg.getBlock(entry)->predCount, 1);
+    }
+
+    TEST(ControlFlowGraphTests, BuildRange)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+
+        auto label = a.createLabel();
+        ASSERT_EQ(a.mov(x86::eax, Imm(1)), ErrorCode::None);
+        auto* first = a.getCursor();
+        ASSERT_EQ(a.jmp(label), ErrorCode::None);
+        ASSERT_EQ(a.bind(label), ErrorCode::None);
+        ASSERT_EQ(a.nop(), ErrorCode::None);
+        auto* last = a.getCursor();
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        ControlFlowGraph cfg(program, first->getNext(), last);
+        ASSERT_EQ(cfg.getValidBlockCount(), 2);
+        ASSERT_EQ(cfg.getBlockOf(program.getHead()), BlockId::Invalid);
+        ASSERT_EQ(cfg.getBlockOf(program.getTail()), BlockId::Invalid);
+        ASSERT_EQ(cfg.getBlock(cfg.getEntryBlock())->succCount, 1);
+        ASSERT_EQ(cfg.getBlock(cfg.getBlockOf(label))->succCount, 0);
+
+        // Appending after the range does not extend it.
+        ASSERT_EQ(a.nop(), ErrorCode::None);
+        ASSERT_EQ(cfg.getBlockOf(program.getTail()), BlockId::Invalid);
+
+        // Inserting within the range does.
+        program.insertAfter(first->getNext(), program.createNode(Instruction().setMnemonic(x86::Mnemonic::Ret)));
+        ASSERT_EQ(cfg.getValidBlockCount(), 3);
+        ASSERT_EQ(cfg.getBlock(cfg.getEntryBlock())->succCount, 1);
+
+        ASSERT_EQ(ControlFlowGraph(program, last, first).build(), ErrorCode::InvalidParameter);
+    }
+
+    TEST(ControlFlowGraphTests, IncrementalUpdate)
+    {
+        Program program(MachineMode::AMD64);
+
+        std::vector<Label> labels;
+        for (int i = 0; i < 8; i++)
+        {
+            labels.push_back(program.createLabel());
+        }
+
+        ControlFlowGraph cfg(program);
+        ASSERT_EQ(cfg.getValidBlockCount(), 0);
+
+        std::mt19937 prng(1337);
+        std::vector<Node*> detached;
+
+        const auto createNode = [&]() -> Node* {
+            const auto& label = labels[prng() % labels.size()];
+            switch (prng() % 8)
+            {
+                case 0:
+                    if (auto* node = program.getNodeForLabel(label); node == nullptr)
+                    {
+                        return *program.bindLabel(label);
+                    }
+                    return program.createNode(Instruction().setMnemonic(x86::Mnemonic::Nop));
+                case 1:
+                    return program.createNode(Instruction().setMnemonic(x86::Mnemonic::Jmp).addOperand(label));
+                case 2:
+                    return program.createNode(Instruction().setMnemonic(x86::Mnemonic::Jz).addOperand(label));
+                case 3:
+                    return program.createNode(Instruction().setMnemonic(x86::Mnemonic::Ret));
+                case 4:
+                    return program.createNode(Data(std::uint32_t{ 0 }));
+                default:
+                    return program.createNode(Instruction().setMnemonic(x86::Mnemonic::Nop));
+            }
+        };
+
+        const auto pickNode = [&]() -> Node* {
+            const auto count = program.size();
+            if (count == 0)
+            {
+                return nullptr;
+            }
+            auto* node = program.getHead();
+            for (auto n = prng() % count; n > 0; n--)
+            {
+                node = node->getNext();
+            }
+            return node;
+        };
+
+        for (int i = 0; i < 4000; i++)
+        {
+            const auto op = prng() % 10;
+            if (op < 5)
+            {
+                Node* node{};
+                if (!detached.empty() && prng() % 3 == 0)
+                {
+                    node = detached.back();
+                    detached.pop_back();
+                }
+                else
+                {
+                    node = createNode();
+                }
+
+                auto* pos = pickNode();
+                if (pos == nullptr)
+                {
+                    program.append(node);
+                }
+                else if (prng() % 2 == 0)
+                {
+                    program.insertBefore(pos, node);
+                }
+                else
+                {
+                    program.insertAfter(pos, node);
+                }
+            }
+            else if (op < 7)
+            {
+                if (auto* node = pickNode(); node != nullptr)
+                {
+                    program.detach(node);
+                    detached.push_back(node);
+                }
+            }
+            else if (op < 9)
+            {
+                if (auto* node = pickNode(); node != nullptr)
+                {
+                    program.destroy(node);
+                }
+            }
+            else if (!detached.empty())
+            {
+                program.destroy(detached.back());
+                detached.pop_back();
+            }
+
+            if (i % 16 != 0)
+            {
+                continue;
+            }
+
+            ControlFlowGraph expected(program);
+            ASSERT_EQ(cfg.getValidBlockCount(), expected.getValidBlockCount()) << "Iteration " << i;
+            ASSERT_EQ(getBlockLayout(program, cfg), getBlockLayout(program, expected)) << "Iteration " << i;
+            ASSERT_EQ(getEdgeList(cfg), getEdgeList(expected)) << "Iteration " << i;
+        }
+
+        program.clear();
+        ASSERT_EQ(cfg.getValidBlockCount(), 0);
+        ASSERT_EQ(cfg.getEntryBlock(), BlockId::Invalid);
+    }
+
+    TEST(ControlFlowGraphTests, DestroyRange)
+    {
+        Program program(MachineMode::AMD64);
+
+        std::vector<Label> labels;
+        for (int i = 0; i < 16; i++)
+        {
+            labels.push_back(program.createLabel());
+        }
+
+        ControlFlowGraph cfg(program);
+
+        std::mt19937 prng(1337);
+
+        const auto appendNode = [&]() {
+            const auto& label = labels[prng() % labels.size()];
+            switch (prng() % 8)
+            {
+                case 0:
+                    if (auto* node = program.getNodeForLabel(label); node == nullptr)
+                    {
+                        program.append(*program.bindLabel(label));
+                        return;
+                    }
+                    break;
+                case 1:
+                    program.append(program.createNode(Instruction().setMnemonic(x86::Mnemonic::Jmp).addOperand(label)));
+                    return;
+                case 2:
+                    program.append(program.createNode(Instruction().setMnemonic(x86::Mnemonic::Jz).addOperand(label)));
+                    return;
+                case 3:
+                    program.append(program.createNode(Instruction().setMnemonic(x86::Mnemonic::Ret)));
+                    return;
+                default:
+                    break;
+            }
+            program.append(program.createNode(Instruction().setMnemonic(x86::Mnemonic::Nop)));
+        };
+
+        for (int i = 0; i < 500; i++)
+        {
+            while (program.size() < 64)
+            {
+                appendNode();
+            }
+
+            auto* first = program.getHead();
+            for (auto n = prng() % program.size(); n > 0; n--)
+            {
+                first = first->getNext();
+            }
+            auto* last = first;
+            for (auto n = prng() % 8; n > 0 && last->getNext() != nullptr; n--)
+            {
+                last = last->getNext();
+            }
+
+            program.destroy(first, last);
+
+            ControlFlowGraph expected(program);
+            ASSERT_EQ(cfg.getValidBlockCount(), expected.getValidBlockCount()) << "Iteration " << i;
+            ASSERT_EQ(getBlockLayout(program, cfg), getBlockLayout(program, expected)) << "Iteration " << i;
+            ASSERT_EQ(getEdgeList(cfg), getEdgeList(expected)) << "Iteration " << i;
+        }
+
+        program.destroy(program.getHead(), program.getTail());
+        ASSERT_EQ(program.size(), 0);
+        ASSERT_EQ(cfg.getValidBlockCount(), 0);
+    }
+
+} // namespace zasm::tests
@@ -0,0 +1,175 @@
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zasm/core/concurrentstringpool.hpp>
+#include <zasm/core/memorystream.hpp>
+#include <zasm/program/saverestore.hpp>
+#include <zasm/zasm.hpp>
+
+namespace zasm::tests
+{
+    TEST(ConcurrentStringPoolTests, TestBasic)
+    {
+        ConcurrentStringPool pool;
+
+        const auto id0 = pool.acquire("hello");
+        ASSERT_NE(id0, StringPool::Id::Invalid);
+        ASSERT_EQ(pool.getLength(id0), 5);
+        ASSERT_EQ(strcmp(pool.get(id0), "hello"), 0);
+
+        const auto id1 = pool.acquire("Hello");
+        ASSERT_NE(id1, id0);
+
+        ASSERT_EQ(pool.acquire(std::string("hello")), id0);
+        ASSERT_EQ(pool.find("hello"), id0);
+        ASSERT_EQ(pool.find("world"), StringPool::Id::Invalid);
+        ASSERT_EQ(pool.size(), 2);
+
+        ASSERT_FALSE(pool.isValid(StringPool::Id{ 2 }));
+        ASSERT_EQ(pool.get(StringPool::Id::Invalid), nullptr);
+    }
+
+    TEST(ConcurrentStringPoolTests, TestManyStrings)
+    {
+        ConcurrentStringPool pool;
+
+        constexpr size_t kCount = 100'000;
+
+        std::vector<StringPool::Id> ids;
+        for (size_t i = 0; i < kCount; i++)
+        {
+            ids.push_back(pool.acquire("str_" + std::to_string(i)));
+        }
+
+        ASSERT_EQ(pool.size(), kCount);
+        for (size_t i = 0; i < kCount; i++)
+        {
+            const auto str = "str_" + std::to_string(i);
+            ASSERT_EQ(pool.find(str.c_str()), ids[i]);
+            ASSERT_EQ(strcmp(pool.get(ids[i]), str.c_str()), 0);
+        }
+    }
+
+    TEST(ConcurrentStringPoolTests, TestConcurrentAcquire)
+    {
+        ConcurrentStringPool pool;
+
+        constexpr size_t kNumThreads = 8;
+        constexpr size_t kCount = 20'000;
+
+        // Every thread acquires the same strings starting at a different offset.
+        std::vector<std::vector<StringPool::Id>> ids(kNumThreads);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < kNumThreads; t++)
+        {
+            threads.emplace_back([&, t]() {
+                ids[t].resize(kCount);
+                for (size_t n = 0; n < kCount; n++)
+                {
+                    const auto i = (n + t * 2'503) % kCount;
+                    ids[t][i] = pool.acquire("sym_" + std::to_string(i));
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        ASSERT_EQ(pool.size(), kCount);
+        for (size_t i = 0; i < kCount; i++)
+        {
+            const auto str = "sym_" + std::to_string(i);
+            for (size_t t = 0; t < kNumThreads; t++)
+            {
+                ASSERT_EQ(ids[t][i], ids[0][i]);
+            }
+            ASSERT_EQ(strcmp(pool.get(ids[0][i]), str.c_str()), 0);
+        }
+    }
+
+    TEST(ConcurrentStringPoolTests, TestSaveLoad)
+    {
+        ConcurrentStringPool pool;
+
+        const auto id0 = pool.acquire("hello");
+        const auto id1 = pool.acquire("world");
+
+        MemoryStream stream;
+        ASSERT_EQ(pool.save(stream), ErrorCode::None);
+
+        stream.seek(0, SeekType::Begin);
+
+        StringPool loaded;
+        ASSERT_EQ(loaded.load(stream), ErrorCode::None);
+        ASSERT_EQ(loaded.size(), 2);
+        ASSERT_EQ(loaded.find("hello"), id0);
+        ASSERT_EQ(loaded.find("world"), id1);
+    }
+
+    TEST(ConcurrentStringPoolTests, TestSharedProgramSymbols)
+    {
+        ConcurrentStringPool pool;
+
+        Program program1(MachineMode::AMD64);
+        Program program2(MachineMode::AMD64);
+        ASSERT_EQ(program1.setSymbolPool(&pool), ErrorCode::None);
+        ASSERT_EQ(program2.setSymbolPool(&pool), ErrorCode::None);
+        ASSERT_EQ(program1.getSymbolPool(), &pool);
+
+        auto label1 = program1.createExternalLabel("CreateFileW");
+        auto label2 = program2.createExternalLabel("CreateFileW");
+
+        // Both programs reference the same memory.
+        ASSERT_EQ(program1.getLabelName(label1), program2.getLabelName(label2));
+        ASSERT_EQ(pool.size(), 1);
+
+        // Releasing names in one program does not affect the other.
+        program1.setLabelName(label1, "ReadFile");
+        ASSERT_EQ(strcmp(program2.getLabelName(label2), "CreateFileW"), 0);
+
+        // Can not change the pool once there are labels.
+        ASSERT_EQ(program1.setSymbolPool(nullptr), ErrorCode::InvalidOperation);
+
+        program1.clear();
+        ASSERT_EQ(program1.setSymbolPool(nullptr), ErrorCode::None);
+        ASSERT_EQ(program1.getSymbolPool(), nullptr);
+    }
+
+    TEST(ConcurrentStringPoolTests, TestSharedProgramSaveRestore)
+    {
+        ConcurrentStringPool pool;
+        pool.acquire("unrelated");
+
+        Program outputProgram(MachineMode::AMD64);
+        ASSERT_EQ(outputProgram.setSymbolPool(&pool), ErrorCode::None);
+
+        auto label = outputProgram.createLabel("hello world");
+        auto nodeRes = outputProgram.bindLabel(label);
+        ASSERT_EQ(nodeRes.hasValue(), true);
+        outputProgram.append(nodeRes.value());
+
+        MemoryStream buf;
+        ASSERT_EQ(save(outputProgram, buf), ErrorCode::None);
+
+        buf.seek(0, SeekType::Begin);
+        auto inputProgram = load(buf);
+        ASSERT_EQ(inputProgram.hasValue(), true);
+        ASSERT_EQ(inputProgram->getSymbolPool(), nullptr);
+        ASSERT_EQ(strcmp(inputProgram->getLabelName(label), "hello world"), 0);
+
+        // Names of other programs in the shared pool are not saved.
+        Program localProgram(MachineMode::AMD64);
+        auto localLabel = localProgram.createLabel("hello world");
+        auto localNodeRes = localProgram.bindLabel(localLabel);
+        ASSERT_EQ(localNodeRes.hasValue(), true);
+        localProgram.append(localNodeRes.value());
+
+        MemoryStream localBuf;
+        ASSERT_EQ(save(localProgram, localBuf), ErrorCode::None);
+        ASSERT_EQ(buf.size(), localBuf.size());
+    }
+
+} // namespace zasm::tests
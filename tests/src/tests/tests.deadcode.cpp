@@ -0,0 +1,192 @@
+#include "../testutils.hpp"
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <zasm/zasm.hpp>
+
+namespace zasm::tests
+{
+    TEST(DeadCodeTests, RemoveUnreachable)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto labelDead = a.createLabel();
+        auto labelExit = a.createLabel();
+        ASSERT_EQ(a.mov(x86::eax, Imm(1)), ErrorCode::None);
+        ASSERT_EQ(a.jmp(labelExit), ErrorCode::None);
+        ASSERT_EQ(a.inc(x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+        ASSERT_EQ(a.db(0xCC), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelDead), ErrorCode::None);
+        ASSERT_EQ(a.dec(x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.jmp(labelExit), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelExit), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        ControlFlowGraph cfg(program);
+
+        DeadCodeElimination pass(program);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+
+        const std::vector<InstrMnemonic> expected = {
+            x86::Mnemonic::Mov,
+            x86::Mnemonic::Jmp,
+            x86::Mnemonic::Ret,
+        };
+        ASSERT_EQ(getMnemonics(program), expected);
+        ASSERT_EQ(program.size(), 4);
+        ASSERT_EQ(program.getNodeForLabel(labelDead), nullptr);
+
+        const auto& stats = pass.getStats();
+        ASSERT_EQ(stats.nodesRemoved, 6);
+        ASSERT_EQ(stats.instructionsRemoved, 4);
+        ASSERT_EQ(stats.dataRemoved, 1);
+        ASSERT_EQ(stats.labelsRemoved, 1);
+
+        // The graph followed the removal.
+        ASSERT_EQ(cfg.getValidBlockCount(), 2);
+
+        // The assembler cursor was part of the kept nodes.
+        ASSERT_EQ(a.getCursor(), program.getTail());
+    }
+
+    TEST(DeadCodeTests, KeepReferenced)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto labelEntry = a.createLabel();
+        auto labelUnused = a.createLabel();
+        auto labelTable = a.createLabel();
+        auto labelCase = a.createLabel();
+        ASSERT_EQ(a.bind(labelEntry), ErrorCode::None);
+        ASSERT_EQ(a.lea(x86::rax, x86::qword_ptr(x86::rip, labelTable)), ErrorCode::None);
+        ASSERT_EQ(a.jmp(x86::qword_ptr(x86::rax)), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelUnused), ErrorCode::None);
+        ASSERT_EQ(a.nop(), ErrorCode::None);
+        ASSERT_EQ(a.align(Align::Type::Code, 16), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelTable), ErrorCode::None);
+        ASSERT_EQ(a.embedLabel(labelCase), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelCase), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        program.setEntryPoint(labelEntry);
+
+        DeadCodeElimination pass(program);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+
+        ASSERT_EQ(program.size(), 8);
+        ASSERT_NE(program.getNodeForLabel(labelEntry), nullptr);
+        ASSERT_EQ(program.getNodeForLabel(labelUnused), nullptr);
+        ASSERT_NE(program.getNodeForLabel(labelCase), nullptr);
+
+        // The alignment belongs to the table.
+        ASSERT_TRUE(program.getNodeForLabel(labelTable)->getPrev()->holds<Align>());
+
+        const auto& stats = pass.getStats();
+        ASSERT_EQ(stats.instructionsRemoved, 1);
+        ASSERT_EQ(stats.labelsRemoved, 1);
+        ASSERT_EQ(stats.dataRemoved, 0);
+    }
+
+    TEST(DeadCodeTests, Roots)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto labelNamed = a.createLabel("exported");
+        auto labelRoot = a.createLabel();
+        auto labelDead = a.createLabel();
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelNamed), ErrorCode::None);
+        ASSERT_EQ(a.inc(x86::eax), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelRoot), ErrorCode::None);
+        ASSERT_EQ(a.dec(x86::eax), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelDead), ErrorCode::None);
+        ASSERT_EQ(a.nop(), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        DeadCodeElimination pass(program);
+        pass.addRoot(labelRoot);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+
+        const std::vector<InstrMnemonic> expected = {
+            x86::Mnemonic::Ret, x86::Mnemonic::Inc, x86::Mnemonic::Ret, x86::Mnemonic::Dec, x86::Mnemonic::Ret,
+        };
+        ASSERT_EQ(getMnemonics(program), expected);
+        ASSERT_EQ(pass.getStats().instructionsRemoved, 2);
+
+        pass.clearRoots();
+        pass.setKeepNamedLabels(false);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+
+        ASSERT_EQ(getMnemonics(program), std::vector<InstrMnemonic>{ x86::Mnemonic::Ret });
+        ASSERT_EQ(program.size(), 1);
+    }
+
+    TEST(DeadCodeTests, SectionAtHead)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        ASSERT_EQ(a.section(".text"), ErrorCode::None);
+        ASSERT_EQ(a.mov(x86::eax, Imm(1)), ErrorCode::None);
+        ASSERT_EQ(a.inc(x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.section(".text2"), ErrorCode::None);
+        ASSERT_EQ(a.dec(x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        DeadCodeElimination pass(program);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+
+        // The head section is walked, control flow does not fall into the second one.
+        const std::vector<InstrMnemonic> expected = {
+            x86::Mnemonic::Mov,
+            x86::Mnemonic::Inc,
+        };
+        ASSERT_EQ(getMnemonics(program), expected);
+        ASSERT_EQ(program.size(), 4);
+        ASSERT_EQ(pass.getStats().instructionsRemoved, 2);
+    }
+
+    TEST(DeadCodeTests, CompactLabels)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        for (int i = 0; i < 3; i++)
+        {
+            a.createLabel();
+        }
+        auto labelEntry = a.createLabel();
+        auto labelDead = a.createLabel();
+        auto labelExit = a.createLabel();
+        ASSERT_EQ(a.bind(labelEntry), ErrorCode::None);
+        ASSERT_EQ(a.jmp(labelExit), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelDead), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelExit), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        program.setEntryPoint(labelEntry);
+
+        DeadCodeElimination pass(program);
+        pass.setCompactLabels(true);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+
+        ASSERT_EQ(pass.getStats().labelsCompacted, 4);
+        ASSERT_EQ(program.getEntryPoint(), Label{ static_cast<Label::Id>(0) });
+        ASSERT_FALSE(program.getLabelData(Label{ static_cast<Label::Id>(2) }).hasValue());
+
+        // The branch and the label node use the new id.
+        const auto newExit = Label{ static_cast<Label::Id>(1) };
+        const auto& jmp = program.getHead()->getNext()->get<Instruction>();
+        ASSERT_EQ(jmp.getOperand<Label>(0), newExit);
+        ASSERT_EQ(program.getNodeForLabel(newExit)->get<Label>(), newExit);
+        ASSERT_EQ(program.getNodeForLabel(newExit)->getNext(), program.getTail());
+    }
+
+} // namespace zasm::tests
@@ -1,4 +1,9 @@
+#include <array>
+#include <cstring>
 #include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <zasm/core/memorystream.hpp>
 #include <zasm/formatter/formatter.hpp>
 #include <zasm/zasm.hpp>
 
@@ -243,4 +248,155 @@ namespace zasm::tests
         ASSERT_EQ(nodeStr, std::string("times 15 dq 0xf3fcf199f3fcf199"));
     }
 
+    TEST(FormatterTests, FormatAppendsToBuffer)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler assembler(program);
+
+        auto label01 = assembler.createLabel();
+
+        ASSERT_EQ(assembler.bind(label01), ErrorCode::None);
+        ASSERT_EQ(assembler.mov(x86::rax, x86::qword_ptr(x86::rbx, x86::rcx, 8, -0x20)), ErrorCode::None);
+        ASSERT_EQ(assembler.mov(x86::eax, Imm(-1)), ErrorCode::None);
+        ASSERT_EQ(assembler.jmp(label01), ErrorCode::None);
+
+        std::string buffer = "; listing\n";
+        formatter::format(buffer, program);
+        ASSERT_EQ(buffer, std::string("; listing\nL0:\nmov rax, qword ptr ds:[rbx+rcx*8-0x20]\nmov eax, -1\njmp L0"));
+
+        buffer.clear();
+        formatter::format(buffer, program, program.getTail());
+        ASSERT_EQ(buffer, formatter::toString(program, program.getTail()));
+    }
+
+    TEST(FormatterTests, FormatToStream)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler assembler(program);
+
+        // Large enough to be written in multiple chunks.
+        for (int i = 0; i < 10'000; i++)
+        {
+            ASSERT_EQ(assembler.add(x86::rax, Imm(i)), ErrorCode::None);
+            ASSERT_EQ(assembler.db(static_cast<std::uint8_t>(i), 3), ErrorCode::None);
+        }
+
+        MemoryStream stream;
+        ASSERT_EQ(formatter::format(stream, program), ErrorCode::None);
+
+        const auto expected = formatter::toString(program);
+        ASSERT_EQ(stream.size(), expected.size());
+        ASSERT_EQ(std::memcmp(stream.data(), expected.data(), expected.size()), 0);
+    }
+
+    TEST(FormatterTests, FormatSerializedListing)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler assembler(program);
+
+        auto label01 = assembler.createLabel();
+
+        std::array<std::uint8_t, 18> data{};
+        for (std::size_t i = 0; i < data.size(); i++)
+        {
+            data[i] = static_cast<std::uint8_t>(i);
+        }
+
+        ASSERT_EQ(assembler.bind(label01), ErrorCode::None);
+        ASSERT_EQ(assembler.mov(x86::eax, Imm(1)), ErrorCode::None);
+        ASSERT_EQ(assembler.ret(), ErrorCode::None);
+        ASSERT_EQ(assembler.embed(data.data(), data.size()), ErrorCode::None);
+        ASSERT_EQ(assembler.jmp(label01), ErrorCode::None);
+
+        Serializer serializer;
+        ASSERT_EQ(serializer.serialize(program, 0x140001000), ErrorCode::None);
+        ASSERT_EQ(serializer.getNodeCount(), program.size());
+        ASSERT_EQ(serializer.getFirstNode(), program.getHead());
+
+        const auto line = [](const char* address, std::string bytes, const char* text) {
+            bytes.resize(30, ' ');
+            return std::string(address) + "  " + bytes + " " + text;
+        };
+        const auto indent = std::string(49, ' ');
+
+        const auto expected = line("0000000140001000", "", "L0:") + "\n"
+            + line("0000000140001000", "b8 01 00 00 00 ", "mov eax, 1") + "\n" + line("0000000140001005", "c3 ", "ret")
+            + "\n"
+            + line(
+                  "0000000140001006", "00 01 02 03 04 05 06 07 08 .. ",
+                  "db 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f")
+            + "\n" + indent + "db 0x10, 0x11\n" + line("0000000140001018", "eb e6 ", "jmp L0");
+
+        ASSERT_EQ(formatter::toString(program, serializer), expected);
+
+        // Addresses follow the relocation.
+        ASSERT_EQ(serializer.relocate(0x1000), ErrorCode::None);
+        ASSERT_EQ(serializer.getNodeInfo(2).address, 0x1005);
+        ASSERT_EQ(serializer.getNodeInfo(2).offset, 5);
+        ASSERT_EQ(serializer.getNodeInfo(2).length, 1);
+        ASSERT_EQ(serializer.getNodeInfo(program.size()).offset, -1);
+
+        std::string buffer = "; listing\n";
+        formatter::format(buffer, program, serializer);
+        ASSERT_EQ(buffer.rfind(line("0000000000001018", "eb e6 ", "jmp L0")), buffer.size() - 55);
+
+        serializer.clear();
+        ASSERT_EQ(serializer.getNodeCount(), 0);
+        ASSERT_EQ(formatter::toString(program, serializer), std::string());
+    }
+
+    TEST(FormatterTests, FormatParallelMatchesSerial)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler assembler(program);
+
+        // Spans multiple chunks and windows, labels are referenced across chunk boundaries.
+        std::vector<Label> labels;
+        for (int i = 0; i < 1'000; i++)
+        {
+            if (i % 2 == 0)
+            {
+                labels.push_back(assembler.createLabel());
+            }
+            else
+            {
+                labels.push_back(assembler.createLabel(("label_" + std::to_string(i)).c_str()));
+            }
+        }
+        for (int i = 0; i < 100'000; i++)
+        {
+            if (i % 100 == 0)
+            {
+                ASSERT_EQ(assembler.bind(labels[i / 100]), ErrorCode::None);
+            }
+            ASSERT_EQ(assembler.mov(x86::rax, x86::qword_ptr(x86::rbx, i)), ErrorCode::None);
+            ASSERT_EQ(assembler.jmp(labels[(i * 7) % labels.size()]), ErrorCode::None);
+        }
+
+        const auto expected = formatter::toString(program);
+
+        for (std::size_t numThreads : { 1, 2, 4, 8 })
+        {
+            std::string buffer;
+            formatter::formatParallel(buffer, program, formatter::kDefaultOptions, numThreads);
+            ASSERT_EQ(buffer, expected);
+
+            MemoryStream stream;
+            ASSERT_EQ(formatter::formatParallel(stream, program, formatter::kDefaultOptions, numThreads), ErrorCode::None);
+            ASSERT_EQ(stream.size(), expected.size());
+            ASSERT_EQ(std::memcmp(stream.data(), expected.data(), expected.size()), 0);
+        }
+
+        const auto* nodeFrom = program.getHead()->getNext();
+        const auto* nodeTo = program.getTail();
+
+        std::string buffer;
+        formatter::formatParallel(buffer, program, nodeFrom, nodeTo, formatter::kDefaultOptions, 4);
+        ASSERT_EQ(buffer, formatter::toString(program, nodeFrom, nodeTo));
+    }
+
 } // namespace zasm::tests
@@ -0,0 +1,150 @@
+#include "../testutils.hpp"
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include <zasm/zasm.hpp>
+
+namespace zasm::tests
+{
+    TEST(SerializedImageTests, EmptySerializer)
+    {
+        Serializer serializer;
+
+        auto res = SerializedImage::create(serializer);
+        ASSERT_FALSE(res.hasValue());
+        ASSERT_EQ(res.error(), ErrorCode::EmptyState);
+
+        SerializedImage image;
+        ASSERT_FALSE(image.isValid());
+        ASSERT_EQ(image.getCode(), nullptr);
+        ASSERT_EQ(image.getCodeSize(), 0);
+
+        std::array<uint8_t, 4> buffer{};
+        ASSERT_EQ(image.relocateTo(0x00401000, buffer.data(), buffer.size()), ErrorCode::EmptyState);
+    }
+
+    TEST(SerializedImageTests, CreateFromSerializer)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+
+        auto labelA = a.createLabel();
+        auto labelB = a.createLabel();
+        auto labelUnused = a.createLabel();
+        ASSERT_TRUE(labelUnused.isValid());
+
+        ASSERT_EQ(a.section(".text"), ErrorCode::None);
+        {
+            ASSERT_EQ(a.bind(labelA), ErrorCode::None);
+            ASSERT_EQ(a.mov(x86::rax, labelB), ErrorCode::None);
+        }
+        ASSERT_EQ(a.section(".data", Section::Attribs::Data), ErrorCode::None);
+        {
+            ASSERT_EQ(a.bind(labelB), ErrorCode::None);
+            ASSERT_EQ(a.embedLabel(labelA), ErrorCode::None);
+        }
+
+        SerializedImage image;
+        {
+            Serializer serializer;
+            ASSERT_EQ(serializer.serialize(program, 0x00400000), ErrorCode::None);
+
+            auto res = SerializedImage::create(serializer);
+            ASSERT_TRUE(res.hasValue());
+            image = res.value();
+
+            // Modifying the serializer must not affect the image.
+            ASSERT_EQ(serializer.relocate(0x00800000), ErrorCode::None);
+        }
+
+        ASSERT_TRUE(image.isValid());
+        ASSERT_EQ(image.getBase(), 0x00400000);
+        ASSERT_EQ(image.getCodeSize(), 18);
+        ASSERT_EQ(hexEncode(image.getCode(), image.getCodeSize()), std::string("48B800104000000000000000400000000000"));
+
+        ASSERT_EQ(image.getSectionCount(), 2);
+        const auto* sect01 = image.getSectionInfo(0);
+        ASSERT_NE(sect01, nullptr);
+        ASSERT_EQ(std::string(sect01->name), ".text");
+        ASSERT_EQ(sect01->address, 0x00400000);
+        const auto* sect02 = image.getSectionInfo(1);
+        ASSERT_NE(sect02, nullptr);
+        ASSERT_EQ(std::string(sect02->name), ".data");
+        ASSERT_EQ(sect02->address, 0x00401000);
+        ASSERT_EQ(sect02->offset, 10);
+        ASSERT_EQ(image.getSectionInfo(2), nullptr);
+
+        ASSERT_EQ(image.getLabelOffset(labelA.getId()), 0);
+        ASSERT_EQ(image.getLabelOffset(labelB.getId()), 10);
+        ASSERT_EQ(image.getLabelAddress(labelA.getId(), 0x00400000), 0x00400000);
+        ASSERT_EQ(image.getLabelAddress(labelB.getId(), 0x00400000), 0x00401000);
+        ASSERT_EQ(image.getLabelAddress(labelB.getId(), 0x10000000), 0x10001000);
+        ASSERT_EQ(image.getLabelAddress(labelUnused.getId(), 0x00400000), -1);
+
+        ASSERT_EQ(image.getRelocationCount(), 2);
+        ASSERT_EQ(image.getRelocation(0)->offset, 2);
+        ASSERT_EQ(image.getRelocation(1)->offset, 10);
+        ASSERT_EQ(image.getRelocation(2), nullptr);
+        ASSERT_EQ(image.getExternalRelocationCount(), 0);
+    }
+
+    TEST(SerializedImageTests, RelocateParallel)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+
+        auto label = a.createLabel();
+        ASSERT_EQ(a.bind(label), ErrorCode::None);
+        ASSERT_EQ(a.mov(x86::rax, label), ErrorCode::None);
+        ASSERT_EQ(a.embedLabel(label), ErrorCode::None);
+
+        Serializer serializer;
+        ASSERT_EQ(serializer.serialize(program, 0x00400000), ErrorCode::None);
+
+        auto res = SerializedImage::create(serializer);
+        ASSERT_TRUE(res.hasValue());
+
+        const auto image = res.value();
+
+        constexpr std::size_t kNumThreads = 8;
+
+        std::vector<std::vector<uint8_t>> results(kNumThreads);
+        std::vector<Error> errors(kNumThreads);
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < kNumThreads; ++i)
+        {
+            threads.emplace_back([&, i, image]() {
+                const auto base = static_cast<std::int64_t>(0x10000000 * (i + 1));
+                results[i].resize(image.getCodeSize());
+                errors[i] = image.relocateTo(base, results[i].data(), results[i].size());
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (std::size_t i = 0; i < kNumThreads; ++i)
+        {
+            ASSERT_EQ(errors[i], ErrorCode::None);
+
+            const auto base = static_cast<std::uint64_t>(0x10000000 * (i + 1));
+
+            std::uint64_t value01{};
+            std::memcpy(&value01, results[i].data() + 2, sizeof(value01));
+            ASSERT_EQ(value01, base);
+
+            std::uint64_t value02{};
+            std::memcpy(&value02, results[i].data() + 10, sizeof(value02));
+            ASSERT_EQ(value02, base);
+        }
+
+        // Original code remains untouched.
+        ASSERT_EQ(hexEncode(image.getCode(), image.getCodeSize()), std::string("48B800004000000000000000400000000000"));
+    }
+
+} // namespace zasm::tests
@@ -0,0 +1,147 @@
+#include "../testutils.hpp"
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <zasm/zasm.hpp>
+
+namespace zasm::tests
+{
+    TEST(JumpThreadingTests, Chain)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto label1 = a.createLabel();
+        auto label2 = a.createLabel();
+        auto label3 = a.createLabel();
+        ASSERT_EQ(a.test(x86::eax, x86::eax), ErrorCode::None);
+        ASSERT_EQ(a.jz(label1), ErrorCode::None);
+        auto* jz = a.getCursor();
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+        ASSERT_EQ(a.bind(label1), ErrorCode::None);
+        ASSERT_EQ(a.jmp(label2), ErrorCode::None);
+        ASSERT_EQ(a.bind(label2), ErrorCode::None);
+        ASSERT_EQ(a.jmp(label3), ErrorCode::None);
+        ASSERT_EQ(a.bind(label3), ErrorCode::None);
+        ASSERT_EQ(a.mov(x86::eax, Imm(1)), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        JumpThreading pass(program);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+
+        ASSERT_EQ(jz->get<Instruction>().getOperand<Label>(0), label3);
+
+        const std::vector<InstrMnemonic> expected = {
+            x86::Mnemonic::Test,
+            x86::Mnemonic::Jz,
+            x86::Mnemonic::Ret,
+            x86::Mnemonic::Mov,
+            x86::Mnemonic::Ret,
+        };
+        ASSERT_EQ(getMnemonics(program), expected);
+
+        // The labels stay bound.
+        ASSERT_NE(program.getNodeForLabel(label1), nullptr);
+        ASSERT_NE(program.getNodeForLabel(label2), nullptr);
+
+        const auto& stats = pass.getStats();
+        ASSERT_EQ(stats.branchesRetargeted, 2);
+        ASSERT_EQ(stats.trampolinesRemoved, 2);
+    }
+
+    TEST(JumpThreadingTests, KeepReachable)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto labelNamed = a.createLabel("named");
+        auto labelFallthrough = a.createLabel();
+        auto labelEntry = a.createLabel();
+        auto labelExit = a.createLabel();
+        ASSERT_EQ(a.jz(labelFallthrough), ErrorCode::None);
+        // Reached by falling through.
+        ASSERT_EQ(a.jmp(labelExit), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelNamed), ErrorCode::None);
+        ASSERT_EQ(a.jmp(labelExit), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelEntry), ErrorCode::None);
+        ASSERT_EQ(a.jmp(labelExit), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelFallthrough), ErrorCode::None);
+        ASSERT_EQ(a.nop(), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelExit), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        program.setEntryPoint(labelEntry);
+
+        JumpThreading pass(program);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+
+        ASSERT_EQ(program.size(), 10);
+        ASSERT_EQ(pass.getStats().branchesRetargeted, 0);
+        ASSERT_EQ(pass.getStats().trampolinesRemoved, 0);
+    }
+
+    TEST(JumpThreadingTests, Cycle)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto labelA = a.createLabel();
+        auto labelB = a.createLabel();
+        ASSERT_EQ(a.jmp(labelA), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelA), ErrorCode::None);
+        ASSERT_EQ(a.jmp(labelB), ErrorCode::None);
+        auto* jmpA = a.getCursor();
+        ASSERT_EQ(a.bind(labelB), ErrorCode::None);
+        ASSERT_EQ(a.jmp(labelA), ErrorCode::None);
+
+        JumpThreading pass(program);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+
+        // Both paths end up in the loop at A.
+        ASSERT_EQ(jmpA->get<Instruction>().getOperand<Label>(0), labelA);
+
+        const std::vector<InstrMnemonic> expected = {
+            x86::Mnemonic::Jmp,
+            x86::Mnemonic::Jmp,
+        };
+        ASSERT_EQ(getMnemonics(program), expected);
+    }
+
+    TEST(JumpThreadingTests, ShortBranches)
+    {
+        const auto buildProgram = [](Program& program) {
+            x86::Assembler a(program);
+            auto labelNear = a.createLabel();
+            auto labelTrampoline = a.createLabel();
+            ASSERT_EQ(a.jz(labelTrampoline), ErrorCode::None);
+            ASSERT_EQ(a.bind(labelNear), ErrorCode::None);
+            ASSERT_EQ(a.mov(x86::eax, Imm(1)), ErrorCode::None);
+            ASSERT_EQ(a.ret(), ErrorCode::None);
+            for (int i = 0; i < 200; i++)
+            {
+                ASSERT_EQ(a.nop(), ErrorCode::None);
+            }
+            ASSERT_EQ(a.ret(), ErrorCode::None);
+            ASSERT_EQ(a.bind(labelTrampoline), ErrorCode::None);
+            ASSERT_EQ(a.jmp(labelNear), ErrorCode::None);
+        };
+
+        Program program(MachineMode::AMD64);
+        buildProgram(program);
+
+        Serializer serializer;
+        ASSERT_EQ(serializer.serialize(program, 0x400000), ErrorCode::None);
+        const auto sizeBefore = serializer.getCodeSize();
+
+        JumpThreading pass(program);
+        ASSERT_EQ(pass.run(), ErrorCode::None);
+        ASSERT_EQ(pass.getStats().trampolinesRemoved, 1);
+
+        ASSERT_EQ(serializer.serialize(program, 0x400000), ErrorCode::None);
+        const auto sizeAfter = serializer.getCodeSize();
+
+        // The conditional branch uses the 8 bit displacement and the jump is gone.
+        ASSERT_EQ(sizeBefore - sizeAfter, 4 + 5);
+    }
+
+} // namespace zasm::tests
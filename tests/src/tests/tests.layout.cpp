@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <zasm/zasm.hpp>
+
+namespace zasm::tests
+{
+    static constexpr std::int64_t kBase = 0x0000000000401000;
+
+    TEST(LayoutTests, AlignLoopHead)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto labelLoop = a.createLabel();
+        ASSERT_EQ(a.mov(x86::ecx, Imm(10)), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelLoop), ErrorCode::None);
+        ASSERT_EQ(a.add(x86::eax, x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.dec(x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.jnz(labelLoop), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        Serializer serializer;
+        LayoutOptimizer layout(program);
+        ASSERT_EQ(layout.run(serializer, kBase), ErrorCode::None);
+
+        ASSERT_EQ(serializer.getLabelAddress(labelLoop.getId()) % 32, 0);
+
+        const auto* alignNode = program.getNodeForLabel(labelLoop)->getPrev();
+        ASSERT_NE(alignNode, nullptr);
+        ASSERT_TRUE(alignNode->holds<Align>());
+        ASSERT_EQ(alignNode->get<Align>().getAlign(), 32);
+
+        const auto& stats = layout.getStats();
+        ASSERT_EQ(stats.loopHeads, 1);
+        ASSERT_EQ(stats.loopsAligned, 1);
+        ASSERT_GT(stats.codeSizeAfter, stats.codeSizeBefore);
+
+        // Running again keeps the existing alignment.
+        const auto size = program.size();
+        ASSERT_EQ(layout.run(serializer, kBase), ErrorCode::None);
+        ASSERT_EQ(layout.getStats().loopHeads, 1);
+        ASSERT_EQ(layout.getStats().loopsAligned, 0);
+        ASSERT_EQ(program.size(), size);
+    }
+
+    TEST(LayoutTests, MaxLoopPadding)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto labelLoop = a.createLabel();
+        ASSERT_EQ(a.nop(), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelLoop), ErrorCode::None);
+        ASSERT_EQ(a.dec(x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.jnz(labelLoop), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        Serializer serializer;
+        LayoutOptimizer layout(program);
+        layout.setMaxLoopPadding(15);
+        ASSERT_EQ(layout.run(serializer, kBase), ErrorCode::None);
+
+        // Requires 31 bytes of padding.
+        ASSERT_EQ(layout.getStats().loopsAligned, 0);
+        ASSERT_EQ(serializer.getLabelAddress(labelLoop.getId()), kBase + 1);
+    }
+
+    TEST(LayoutTests, ShortBranchRange)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto labelLoop = a.createLabel();
+        auto labelExit = a.createLabel();
+        ASSERT_EQ(a.nop(), ErrorCode::None);
+        ASSERT_EQ(a.jecxz(labelExit), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelLoop), ErrorCode::None);
+        ASSERT_EQ(a.dec(x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.jnz(labelLoop), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelExit), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        Serializer serializer;
+        LayoutOptimizer layout(program);
+        ASSERT_EQ(layout.setLoopAlignment(24), ErrorCode::InvalidParameter);
+        ASSERT_EQ(layout.setLoopAlignment(64), ErrorCode::None);
+        ASSERT_EQ(layout.run(serializer, kBase), ErrorCode::None);
+
+        // The padding would be between jecxz and its target.
+        ASSERT_EQ(layout.getStats().loopHeads, 1);
+        ASSERT_EQ(layout.getStats().loopsAligned, 0);
+        ASSERT_EQ(layout.getStats().loopsSkipped, 1);
+        ASSERT_EQ(serializer.getLabelAddress(labelLoop.getId()), kBase + 4);
+    }
+
+    TEST(LayoutTests, JccErratum)
+    {
+        const auto buildProgram = [](Program& program, Label& labelCmp) {
+            x86::Assembler a(program);
+            auto labelExit = a.createLabel();
+            labelCmp = a.createLabel();
+            for (int i = 0; i < 29; i++)
+            {
+                ASSERT_EQ(a.nop(), ErrorCode::None);
+            }
+            // Macro-fused pair from 29 to 33.
+            ASSERT_EQ(a.bind(labelCmp), ErrorCode::None);
+            ASSERT_EQ(a.cmp(x86::eax, x86::ecx), ErrorCode::None);
+            ASSERT_EQ(a.jz(labelExit), ErrorCode::None);
+            ASSERT_EQ(a.nop(), ErrorCode::None);
+            ASSERT_EQ(a.bind(labelExit), ErrorCode::None);
+            ASSERT_EQ(a.ret(), ErrorCode::None);
+        };
+
+        {
+            Program program(MachineMode::AMD64);
+            Label labelCmp;
+            buildProgram(program, labelCmp);
+
+            Serializer serializer;
+            LayoutOptimizer layout(program);
+            layout.setAvoidJccErratum(true);
+            ASSERT_EQ(layout.run(serializer, kBase), ErrorCode::None);
+
+            ASSERT_EQ(serializer.getLabelAddress(labelCmp.getId()), kBase + 32);
+            ASSERT_EQ(layout.getStats().branchesPadded, 1);
+            ASSERT_EQ(layout.getStats().branchesSkipped, 0);
+            ASSERT_EQ(layout.getStats().codeSizeAfter, layout.getStats().codeSizeBefore + 3);
+        }
+
+        {
+            Program program(MachineMode::AMD64);
+            Label labelCmp;
+            buildProgram(program, labelCmp);
+
+            Serializer serializer;
+            LayoutOptimizer layout(program);
+            layout.setAvoidJccErratum(true);
+            layout.setPaddingBudget(2);
+            ASSERT_EQ(layout.run(serializer, kBase), ErrorCode::None);
+
+            ASSERT_EQ(serializer.getLabelAddress(labelCmp.getId()), kBase + 29);
+            ASSERT_EQ(layout.getStats().branchesPadded, 0);
+            ASSERT_EQ(layout.getStats().branchesSkipped, 1);
+        }
+    }
+
+} // namespace zasm::tests
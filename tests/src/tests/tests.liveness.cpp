@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+#include <zasm/zasm.hpp>
+
+namespace zasm::tests
+{
+    static constexpr auto kMode = MachineMode::AMD64;
+
+    static bool isLive(const LiveSet& live, const Reg& reg)
+    {
+        return live.regs.contains(reg, kMode);
+    }
+
+    static bool isLive(const LiveSet& live, InstrCPUFlags flags)
+    {
+        return (live.flags & flags) != InstrCPUFlags{};
+    }
+
+    TEST(LivenessTests, StraightLine)
+    {
+        Program program(kMode);
+
+        x86::Assembler a(program);
+        ASSERT_EQ(a.mov(x86::eax, Imm(1)), ErrorCode::None);
+        auto* movEax = a.getCursor();
+        ASSERT_EQ(a.mov(x86::ecx, x86::eax), ErrorCode::None);
+        auto* movEcx = a.getCursor();
+        ASSERT_EQ(a.add(x86::ecx, Imm(2)), ErrorCode::None);
+        auto* add = a.getCursor();
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        ControlFlowGraph cfg(program);
+        LivenessAnalysis liveness(program, cfg);
+        liveness.setExitLiveSet(LiveSet{ RegSet{}.add(x86::rcx, kMode) });
+        liveness.run();
+
+        ASSERT_FALSE(isLive(liveness.getLiveIn(movEax), x86::rax));
+        ASSERT_TRUE(isLive(liveness.getLiveOut(movEax), x86::rax));
+        ASSERT_FALSE(isLive(liveness.getLiveOut(movEcx), x86::rax));
+        ASSERT_TRUE(isLive(liveness.getLiveOut(movEcx), x86::rcx));
+        ASSERT_TRUE(isLive(liveness.getLiveOut(add), x86::rcx));
+        // Ret reads the stack pointer.
+        ASSERT_TRUE(isLive(liveness.getLiveOut(add), x86::rsp));
+        ASSERT_FALSE(isLive(liveness.getLiveOut(add), x86::CPUFlags::ZF));
+
+        const auto block = cfg.getEntryBlock();
+        ASSERT_EQ(liveness.getLiveIn(block), liveness.getLiveIn(program.getHead()));
+        ASSERT_TRUE(isLive(liveness.getLiveOut(block), x86::rcx));
+        ASSERT_FALSE(isLive(liveness.getLiveIn(block), x86::rcx));
+    }
+
+    TEST(LivenessTests, FlagsAcrossBlocks)
+    {
+        Program program(kMode);
+
+        x86::Assembler a(program);
+        auto label = a.createLabel();
+        ASSERT_EQ(a.cmp(x86::eax, x86::ecx), ErrorCode::None);
+        auto* cmp = a.getCursor();
+        ASSERT_EQ(a.mov(x86::edx, Imm(0)), ErrorCode::None);
+        ASSERT_EQ(a.jz(label), ErrorCode::None);
+        ASSERT_EQ(a.mov(x86::edx, Imm(1)), ErrorCode::None);
+        ASSERT_EQ(a.bind(label), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        ControlFlowGraph cfg(program);
+        LivenessAnalysis liveness(program, cfg);
+        liveness.setExitLiveSet(LiveSet{ RegSet{}.add(x86::rdx, kMode) });
+        liveness.run();
+
+        ASSERT_TRUE(isLive(liveness.getLiveOut(cmp), x86::CPUFlags::ZF));
+        ASSERT_FALSE(isLive(liveness.getLiveOut(cmp), x86::CPUFlags::CF));
+        ASSERT_FALSE(isLive(liveness.getLiveIn(cmp), x86::CPUFlags::ZF));
+        ASSERT_TRUE(isLive(liveness.getLiveIn(cmp), x86::rax));
+        ASSERT_TRUE(isLive(liveness.getLiveIn(cmp), x86::rcx));
+        // Overwritten on both paths before it is read.
+        ASSERT_FALSE(isLive(liveness.getLiveIn(cmp), x86::rdx));
+        ASSERT_TRUE(isLive(liveness.getLiveIn(cfg.getBlockOf(label)), x86::rdx));
+    }
+
+    TEST(LivenessTests, Loop)
+    {
+        Program program(kMode);
+
+        x86::Assembler a(program);
+        auto labelLoop = a.createLabel();
+        ASSERT_EQ(a.mov(x86::edx, Imm(5)), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelLoop), ErrorCode::None);
+        ASSERT_EQ(a.add(x86::eax, x86::edx), ErrorCode::None);
+        ASSERT_EQ(a.dec(x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.jnz(labelLoop), ErrorCode::None);
+        ASSERT_EQ(a.mov(x86::ecx, x86::eax), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        ControlFlowGraph cfg(program);
+        LivenessAnalysis liveness(program, cfg);
+        liveness.setExitLiveSet(LiveSet{ RegSet{}.add(x86::rcx, kMode) });
+        liveness.run();
+
+        const auto loop = cfg.getBlockOf(labelLoop);
+        ASSERT_TRUE(isLive(liveness.getLiveIn(loop), x86::rdx));
+        ASSERT_TRUE(isLive(liveness.getLiveIn(loop), x86::rcx));
+        ASSERT_TRUE(isLive(liveness.getLiveOut(loop), x86::rdx));
+        ASSERT_TRUE(isLive(liveness.getLiveOut(loop), x86::rax));
+        ASSERT_FALSE(isLive(liveness.getLiveIn(cfg.getEntryBlock()), x86::rdx));
+        ASSERT_TRUE(isLive(liveness.getLiveIn(cfg.getEntryBlock()), x86::rax));
+        ASSERT_FALSE(isLive(liveness.getLiveOut(loop), x86::CPUFlags::ZF));
+
+        // Each block is visited at most twice for a single loop.
+        ASSERT_LE(liveness.getBlockVisitCount(), cfg.getValidBlockCount() * 2);
+    }
+
+    TEST(LivenessTests, ReturnLiveSet)
+    {
+        Program program(kMode);
+
+        x86::Assembler a(program);
+        auto labelRet = a.createLabel();
+        ASSERT_EQ(a.cmp(x86::eax, x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.jz(labelRet), ErrorCode::None);
+        ASSERT_EQ(a.jmp(x86::rdx), ErrorCode::None);
+        auto* jmp = a.getCursor();
+        ASSERT_EQ(a.bind(labelRet), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        ControlFlowGraph cfg(program);
+        LivenessAnalysis liveness(program, cfg);
+        liveness.setExitLiveSet(LiveSet{ RegSet{}.add(x86::rsi, kMode), ~InstrCPUFlags{} });
+        ASSERT_EQ(liveness.getReturnLiveSet(), liveness.getExitLiveSet());
+
+        liveness.setReturnLiveSet(LiveSet{ RegSet{}.add(x86::rdi, kMode) });
+        liveness.run();
+
+        // The indirect branch leaves the graph with the exit set.
+        ASSERT_TRUE(isLive(liveness.getLiveOut(jmp), x86::rsi));
+        ASSERT_TRUE(isLive(liveness.getLiveOut(jmp), x86::CPUFlags::ZF));
+        ASSERT_FALSE(isLive(liveness.getLiveOut(jmp), x86::rdi));
+
+        const auto blockRet = cfg.getBlockOf(labelRet);
+        ASSERT_TRUE(isLive(liveness.getLiveOut(blockRet), x86::rdi));
+        ASSERT_FALSE(isLive(liveness.getLiveOut(blockRet), x86::rsi));
+        ASSERT_FALSE(isLive(liveness.getLiveOut(blockRet), x86::CPUFlags::ZF));
+    }
+
+    TEST(LivenessTests, CachedAccess)
+    {
+        Program program(kMode);
+
+        x86::Assembler a(program);
+        for (int i = 0; i < 16; i++)
+        {
+            ASSERT_EQ(a.mov(x86::eax, x86::ecx), ErrorCode::None);
+        }
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        ControlFlowGraph cfg(program);
+        LivenessAnalysis liveness(program, cfg);
+
+        liveness.run();
+        ASSERT_EQ(liveness.getDecodeCount(), 17);
+
+        liveness.run();
+        ASSERT_EQ(liveness.getDecodeCount(), 0);
+
+        program.insertBefore(
+            program.getHead(),
+            program.createNode(Instruction().setMnemonic(x86::Mnemonic::Mov).addOperand(x86::ecx).addOperand(Imm(0))));
+        liveness.run();
+        ASSERT_EQ(liveness.getDecodeCount(), 1);
+        ASSERT_TRUE(isLive(liveness.getLiveOut(program.getHead()), x86::rcx));
+        ASSERT_FALSE(isLive(liveness.getLiveIn(program.getHead()), x86::rcx));
+
+        // The default exit set keeps all registers but no flags live.
+        ASSERT_TRUE(isLive(liveness.getLiveOut(program.getTail()), x86::rax));
+        ASSERT_FALSE(isLive(liveness.getLiveOut(program.getHead()), x86::CPUFlags::ZF));
+
+        // In place modification requires invalidating the node.
+        auto* second = program.getHead()->getNext();
+        second->get<Instruction>().setOperand(1, x86::edx);
+        liveness.invalidate(second);
+        liveness.run();
+        ASSERT_EQ(liveness.getDecodeCount(), 1);
+        ASSERT_TRUE(isLive(liveness.getLiveIn(program.getHead()), x86::rdx));
+    }
+
+} // namespace zasm::tests
@@ -130,4 +130,35 @@ namespace zasm::tests
         ASSERT_EQ(observer.nodesDetached, 1);
     }
 
+    TEST(ObserverTests, TestNodesDestroy)
+    {
+        Program program(MachineMode::AMD64);
+
+        TestObserver observer;
+        program.addObserver(observer);
+
+        x86::Assembler assembler(program);
+        assembler.mov(x86::rax, x86::rbx);
+        auto* nodeA = assembler.getCursor();
+        assembler.mov(x86::rax, x86::rbx);
+        auto* nodeB = assembler.getCursor();
+        assembler.mov(x86::rax, x86::rbx);
+        assembler.mov(x86::rax, x86::rbx);
+        auto* nodeD = assembler.getCursor();
+
+        program.destroy(nodeB, nodeD);
+
+        ASSERT_EQ(observer.nodesCreated, 4);
+        ASSERT_EQ(observer.nodesInserted, 4);
+        ASSERT_EQ(observer.nodesDestroyed, 3);
+        ASSERT_EQ(observer.nodesDetached, 0);
+        ASSERT_EQ(program.size(), 1);
+        ASSERT_EQ(program.getTail(), nodeA);
+
+        // The cursor moved in front of the range.
+        ASSERT_EQ(assembler.getCursor(), nodeA);
+        assembler.ret();
+        ASSERT_EQ(nodeA->getNext(), assembler.getCursor());
+    }
+
 } // namespace zasm::tests
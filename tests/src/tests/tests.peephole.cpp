@@ -0,0 +1,164 @@
+#include "../testutils.hpp"
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <zasm/zasm.hpp>
+
+namespace zasm::tests
+{
+    TEST(PeepholeTests, DefaultRules)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto label = a.createLabel();
+        ASSERT_EQ(a.mov(x86::rax, x86::rax), ErrorCode::None);
+        // Clears the upper 32 bits.
+        ASSERT_EQ(a.mov(x86::eax, x86::eax), ErrorCode::None);
+        ASSERT_EQ(a.push(x86::rbx), ErrorCode::None);
+        ASSERT_EQ(a.pop(x86::rbx), ErrorCode::None);
+        ASSERT_EQ(a.push(x86::rbx), ErrorCode::None);
+        ASSERT_EQ(a.pop(x86::rcx), ErrorCode::None);
+        ASSERT_EQ(a.jmp(label), ErrorCode::None);
+        ASSERT_EQ(a.bind(label), ErrorCode::None);
+        ASSERT_EQ(a.add(x86::rcx, Imm(0)), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        PeepholeOptimizer optimizer(program);
+        optimizer.addDefaultRules();
+        ASSERT_EQ(optimizer.run(), ErrorCode::None);
+
+        const std::vector<InstrMnemonic> expected = {
+            x86::Mnemonic::Mov, x86::Mnemonic::Push, x86::Mnemonic::Pop, x86::Mnemonic::Ret,
+        };
+        ASSERT_EQ(getMnemonics(program), expected);
+
+        const auto& stats = optimizer.getStats();
+        ASSERT_EQ(stats.instructionsRemoved, 5);
+        ASSERT_EQ(stats.instructionsInserted, 0);
+        ASSERT_GT(stats.bytesSaved, 0);
+        ASSERT_EQ(stats.rounds, 2);
+        ASSERT_EQ(stats.ruleHits.size(), optimizer.getRuleCount());
+    }
+
+    TEST(PeepholeTests, KeepLiveFlags)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto label = a.createLabel();
+        ASSERT_EQ(a.add(x86::rax, Imm(0)), ErrorCode::None);
+        ASSERT_EQ(a.jz(label), ErrorCode::None);
+        ASSERT_EQ(a.sub(x86::rcx, Imm(0)), ErrorCode::None);
+        ASSERT_EQ(a.bind(label), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        PeepholeOptimizer optimizer(program);
+        optimizer.addDefaultRules();
+        ASSERT_EQ(optimizer.run(), ErrorCode::None);
+
+        const std::vector<InstrMnemonic> expected = {
+            x86::Mnemonic::Add,
+            x86::Mnemonic::Jz,
+            x86::Mnemonic::Ret,
+        };
+        ASSERT_EQ(getMnemonics(program), expected);
+        ASSERT_EQ(optimizer.getStats().instructionsRemoved, 1);
+    }
+
+    TEST(PeepholeTests, KeepFlagsAtExits)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        ASSERT_EQ(a.sub(x86::rax, Imm(0)), ErrorCode::None);
+        ASSERT_EQ(a.jmp(x86::rcx), ErrorCode::None);
+        ASSERT_EQ(a.add(x86::rdx, Imm(0)), ErrorCode::None);
+        ASSERT_EQ(a.call(x86::rdx), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        PeepholeOptimizer optimizer(program);
+        optimizer.addDefaultRules();
+        ASSERT_EQ(optimizer.run(), ErrorCode::None);
+
+        // The flags may be read by the branch target or the callee.
+        const std::vector<InstrMnemonic> expected = {
+            x86::Mnemonic::Sub,
+            x86::Mnemonic::Jmp,
+            x86::Mnemonic::Add,
+            x86::Mnemonic::Call,
+            x86::Mnemonic::Ret,
+        };
+        ASSERT_EQ(getMnemonics(program), expected);
+        ASSERT_EQ(optimizer.getStats().instructionsRemoved, 0);
+    }
+
+    TEST(PeepholeTests, FixedPoint)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        ASSERT_EQ(a.push(x86::rbx), ErrorCode::None);
+        ASSERT_EQ(a.push(x86::rcx), ErrorCode::None);
+        ASSERT_EQ(a.push(x86::rdx), ErrorCode::None);
+        ASSERT_EQ(a.pop(x86::rdx), ErrorCode::None);
+        ASSERT_EQ(a.pop(x86::rcx), ErrorCode::None);
+        ASSERT_EQ(a.pop(x86::rbx), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        PeepholeOptimizer optimizer(program);
+        optimizer.addDefaultRules();
+
+        optimizer.setMaxRounds(2);
+        ASSERT_EQ(optimizer.run(), ErrorCode::None);
+        ASSERT_EQ(optimizer.getStats().rounds, 2);
+        ASSERT_EQ(program.size(), 3);
+
+        optimizer.setMaxRounds(16);
+        ASSERT_EQ(optimizer.run(), ErrorCode::None);
+        ASSERT_EQ(optimizer.getStats().rounds, 2);
+        ASSERT_EQ(program.size(), 1);
+    }
+
+    TEST(PeepholeTests, CustomRule)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        ASSERT_EQ(a.mov(x86::eax, Imm(0)), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        PeepholeOptimizer optimizer(program);
+        optimizer.addRule({ "mov-zero", x86::Mnemonic::Mov, [](PeepholeContext& ctx, Node* node) {
+                               const auto& instr = node->get<Instruction>();
+                               const auto* reg = instr.getOperandIf<Reg>(0);
+                               const auto* imm = instr.getOperandIf<Imm>(1);
+                               if (reg == nullptr || imm == nullptr || imm->value<std::int64_t>() != 0)
+                               {
+                                   return false;
+                               }
+                               if (ctx.getLiveFlags(node) != InstrCPUFlags{})
+                               {
+                                   return false;
+                               }
+                               ctx.replace(
+                                   node,
+                                   Instruction().setMnemonic(x86::Mnemonic::Xor).addOperand(*reg).addOperand(*reg));
+                               return true;
+                           } });
+        ASSERT_EQ(optimizer.run(), ErrorCode::None);
+
+        const std::vector<InstrMnemonic> expected = {
+            x86::Mnemonic::Xor,
+            x86::Mnemonic::Ret,
+        };
+        ASSERT_EQ(getMnemonics(program), expected);
+
+        const auto& stats = optimizer.getStats();
+        ASSERT_EQ(stats.instructionsRemoved, 1);
+        ASSERT_EQ(stats.instructionsInserted, 1);
+        ASSERT_EQ(stats.ruleHits[0], 1);
+        ASSERT_GT(stats.bytesSaved, 0);
+    }
+
+} // namespace zasm::tests
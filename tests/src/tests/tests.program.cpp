@@ -1,3 +1,5 @@
+#include <array>
+#include <cstring>
 #include <gtest/gtest.h>
 #include <zasm/zasm.hpp>
 
@@ -369,4 +371,57 @@ namespace zasm::tests
         ASSERT_EQ(data, nullptr);
     }
 
+    TEST(ProgramTests, TestDataStorage)
+    {
+        std::array<std::uint8_t, 64> blob{};
+        for (std::size_t i = 0; i < blob.size(); i++)
+        {
+            blob[i] = static_cast<std::uint8_t>(i * 3);
+        }
+
+        const auto owned = Data(blob.data(), blob.size());
+        ASSERT_FALSE(owned.isExternal());
+        ASSERT_FALSE(owned.isShared());
+        ASSERT_NE(owned.getData(), blob.data());
+
+        const auto external = Data::external(blob.data(), blob.size());
+        ASSERT_TRUE(external.isExternal());
+        ASSERT_EQ(external.getData(), blob.data());
+        ASSERT_EQ(external.getSize(), blob.size());
+        ASSERT_EQ(external, owned);
+
+        // Copies of external data keep referencing the memory.
+        const auto externalCopy = external;
+        ASSERT_EQ(externalCopy.getData(), blob.data());
+
+        auto sharedRes = Data::shared(blob.data(), blob.size());
+        ASSERT_TRUE(sharedRes.hasValue());
+
+        auto shared = std::move(sharedRes.value());
+        ASSERT_TRUE(shared.isShared());
+        ASSERT_NE(shared.getData(), blob.data());
+        ASSERT_EQ(shared, owned);
+
+        Program programA(MachineMode::AMD64);
+        Program programB(MachineMode::AMD64);
+
+        auto* nodeA = programA.createNode(shared);
+        auto* nodeB = programB.createNode(shared);
+        ASSERT_EQ(nodeA->get<Data>().getData(), shared.getData());
+        ASSERT_EQ(nodeB->get<Data>().getData(), shared.getData());
+
+        // The buffer stays alive as long as any copy references it.
+        const auto* sharedBytes = shared.getData();
+        shared = Data();
+        programA.destroy(nodeA);
+        ASSERT_EQ(nodeB->get<Data>().getData(), sharedBytes);
+        ASSERT_EQ(std::memcmp(nodeB->get<Data>().getData(), blob.data(), blob.size()), 0);
+
+        // Small data is stored inline.
+        const auto small = Data::shared(blob.data(), 4);
+        ASSERT_TRUE(small.hasValue());
+        ASSERT_FALSE(small->isShared());
+        ASSERT_EQ(small->getSize(), 4);
+    }
+
 } // namespace zasm::tests
@@ -435,4 +435,60 @@ namespace zasm::tests
         ASSERT_EQ(r15.r64(), r15);
     }
 
-} // namespace zasm::tests
\ No newline at end of file
+    TEST(RegisterTests, TestMetadataMatchesZydis)
+    {
+        for (int regId = ZYDIS_REGISTER_NONE; regId <= ZYDIS_REGISTER_MAX_VALUE; ++regId)
+        {
+            const auto zyReg = static_cast<ZydisRegister>(regId);
+            const Reg reg{ static_cast<Reg::Id>(regId) };
+
+            ASSERT_EQ(reg.getClass(), static_cast<Reg::Class>(ZydisRegisterGetClass(zyReg))) << regId;
+            ASSERT_EQ(reg.getIndex(), ZydisRegisterGetId(zyReg)) << regId;
+
+            if (reg.isTmm())
+            {
+                // 8192 bits has no BitSize representation.
+                continue;
+            }
+
+            ASSERT_EQ(
+                getBitSize(reg.getBitSize(MachineMode::I386)), ZydisRegisterGetWidth(ZYDIS_MACHINE_MODE_LONG_COMPAT_32, zyReg))
+                << regId;
+            ASSERT_EQ(getBitSize(reg.getBitSize(MachineMode::AMD64)), ZydisRegisterGetWidth(ZYDIS_MACHINE_MODE_LONG_64, zyReg))
+                << regId;
+
+            ASSERT_EQ(
+                reg.getRoot(MachineMode::I386).getId(),
+                static_cast<Reg::Id>(ZydisRegisterGetLargestEnclosing(ZYDIS_MACHINE_MODE_LONG_COMPAT_32, zyReg)))
+                << regId;
+            ASSERT_EQ(
+                reg.getRoot(MachineMode::AMD64).getId(),
+                static_cast<Reg::Id>(ZydisRegisterGetLargestEnclosing(ZYDIS_MACHINE_MODE_LONG_64, zyReg)))
+                << regId;
+        }
+    }
+
+    TEST(RegisterTests, TestMetadataConstexpr)
+    {
+        using namespace zasm::x86;
+
+        static_assert(rax.getBitSize(MachineMode::AMD64) == BitSize::_64);
+        static_assert(rax.getBitSize(MachineMode::I386) == BitSize::_0);
+        static_assert(ah.getPhysicalIndex() == 0);
+        static_assert(ah.getOffset() == 1);
+        static_assert(ah.isGp8Hi());
+        static_assert(spl.isGp8Lo());
+        static_assert(spl.getPhysicalIndex() == 4);
+        static_assert(r15b.getRoot(MachineMode::AMD64) == r15);
+        static_assert(ax.getRoot(MachineMode::I386) == eax);
+        static_assert(xmm17.getRoot(MachineMode::AMD64) == zmm17);
+        static_assert(cr8.getBitSize(MachineMode::AMD64) == BitSize::_64);
+        static_assert(k3.isMask());
+        static_assert(!Reg{}.isGp());
+
+        ASSERT_EQ(Reg{ Reg::Id::Invalid }.getIndex(), -1);
+        ASSERT_EQ(Reg{ Reg::Id::Invalid }.getClass(), Reg::Class::Invalid);
+        ASSERT_EQ(Reg{ Reg::Id::Invalid }.getRoot(MachineMode::AMD64), Reg{});
+    }
+
+} // namespace zasm::tests
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <vector>
+#include <zasm/zasm.hpp>
+
+namespace zasm::tests
+{
+    TEST(RegSetTests, TestNormalize)
+    {
+        using namespace zasm::x86;
+
+        RegSet regs;
+        regs.add(al, MachineMode::AMD64);
+        regs.add(ah, MachineMode::AMD64);
+        regs.add(eax, MachineMode::AMD64);
+
+        ASSERT_EQ(regs.count(), 1);
+        ASSERT_TRUE(regs.contains(rax, MachineMode::AMD64));
+        ASSERT_TRUE(regs.contains(ax, MachineMode::AMD64));
+        ASSERT_FALSE(regs.contains(rcx, MachineMode::AMD64));
+
+        regs.add(xmm3, MachineMode::AMD64);
+        ASSERT_TRUE(regs.contains(zmm3, MachineMode::AMD64));
+        ASSERT_TRUE(regs.contains(ymm3, MachineMode::AMD64));
+
+        regs.remove(ax, MachineMode::AMD64);
+        ASSERT_FALSE(regs.contains(rax, MachineMode::AMD64));
+        ASSERT_EQ(regs.count(), 1);
+
+        regs.add(Reg{}, MachineMode::AMD64);
+        regs.add(Reg{ Reg::Id::Invalid }, MachineMode::AMD64);
+        ASSERT_EQ(regs.count(), 1);
+    }
+
+    TEST(RegSetTests, TestSetOperations)
+    {
+        using namespace zasm::x86;
+
+        constexpr auto mode = MachineMode::AMD64;
+        constexpr auto a = RegSet{}.add(rax, mode).add(rcx, mode).add(r15, mode);
+        constexpr auto b = RegSet{}.add(rcx, mode).add(k1, mode);
+
+        static_assert((a | b).count() == 4);
+        static_assert((a & b).count() == 1);
+        static_assert((a - b).count() == 2);
+        static_assert(a.intersects(b));
+        static_assert(!(a - b).intersects(b));
+        static_assert(RegSet{}.empty());
+
+        ASSERT_EQ(a & b, RegSet{}.add(ecx, mode));
+        ASSERT_NE(a, b);
+
+        auto c = a;
+        c -= a;
+        ASSERT_TRUE(c.empty());
+    }
+
+    TEST(RegSetTests, TestIterate)
+    {
+        using namespace zasm::x86;
+
+        constexpr auto mode = MachineMode::AMD64;
+
+        RegSet regs;
+        ASSERT_EQ(regs.begin(), regs.end());
+
+        const std::vector<Reg> expected = { rdx, r9, xmm0.getRoot(mode), k7, Reg{ static_cast<Reg::Id>(ZYDIS_REGISTER_UIF) } };
+        for (const auto& reg : expected)
+        {
+            regs.add(reg, mode);
+        }
+
+        std::vector<Reg> found;
+        for (const auto reg : regs)
+        {
+            found.push_back(reg);
+        }
+
+        auto sorted = expected;
+        std::sort(sorted.begin(), sorted.end());
+        ASSERT_EQ(found, sorted);
+    }
+
+    TEST(RegSetTests, TestInstructionAccess)
+    {
+        using namespace zasm::x86;
+
+        constexpr auto mode = MachineMode::AMD64;
+
+        const auto add = Instruction().setMnemonic(Mnemonic::Add).addOperand(eax).addOperand(ecx).getDetail(mode);
+        ASSERT_TRUE(add.hasValue());
+
+        const auto addAccess = getRegAccess(*add, mode);
+        ASSERT_TRUE(addAccess.read.contains(rax, mode));
+        ASSERT_TRUE(addAccess.read.contains(rcx, mode));
+        ASSERT_TRUE(addAccess.write.contains(rax, mode));
+        ASSERT_FALSE(addAccess.write.contains(rcx, mode));
+        ASSERT_TRUE(addAccess.kill.contains(rax, mode));
+        ASSERT_NE(addAccess.flagsWrite & CPUFlags::ZF, CPUFlags::None);
+        ASSERT_EQ(addAccess.flagsRead & CPUFlags::CF, CPUFlags::None);
+
+        const auto mov = Instruction()
+                             .setMnemonic(Mnemonic::Mov)
+                             .addOperand(al)
+                             .addOperand(byte_ptr(rbx, rsi, 4))
+                             .getDetail(mode);
+        ASSERT_TRUE(mov.hasValue());
+
+        const auto movAccess = getRegAccess(*mov, mode);
+        ASSERT_TRUE(movAccess.read.contains(rbx, mode));
+        ASSERT_TRUE(movAccess.read.contains(rsi, mode));
+        ASSERT_FALSE(movAccess.read.contains(rax, mode));
+        ASSERT_TRUE(movAccess.write.contains(rax, mode));
+        // Partial write of al keeps the upper bits of rax.
+        ASSERT_FALSE(movAccess.kill.contains(rax, mode));
+
+        const auto adc = Instruction().setMnemonic(Mnemonic::Adc).addOperand(rax).addOperand(Imm(1)).getDetail(mode);
+        ASSERT_TRUE(adc.hasValue());
+        ASSERT_NE(getRegAccess(*adc, mode).flagsRead & CPUFlags::CF, CPUFlags::None);
+
+        ASSERT_EQ(getRegsRead(*add, mode), addAccess.read);
+        ASSERT_EQ(getRegsWritten(*add, mode), addAccess.write);
+    }
+
+} // namespace zasm::tests
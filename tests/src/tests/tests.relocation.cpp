@@ -394,4 +394,81 @@ namespace zasm::tests
         }
     }
 
+    TEST(RelocationTests, RelocateToBufferX86)
+    {
+        Program program(MachineMode::I386);
+
+        x86::Assembler assembler(program);
+
+        auto label = assembler.createLabel();
+        ASSERT_EQ(assembler.bind(label), ErrorCode::None);
+        ASSERT_EQ(assembler.mov(x86::eax, x86::dword_ptr(label)), ErrorCode::None);
+        ASSERT_EQ(assembler.embedLabel(label), ErrorCode::None);
+
+        Serializer serializer;
+        ASSERT_EQ(serializer.serialize(program, 0x0000000000401000), ErrorCode::None);
+        ASSERT_EQ(hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("A10010400000104000"));
+
+        std::array<uint8_t, 9> buffer{};
+        ASSERT_EQ(serializer.relocateTo(0x0000000000501000, buffer.data(), buffer.size()), ErrorCode::None);
+        ASSERT_EQ(hexEncode(buffer.data(), buffer.size()), std::string("A10010500000105000"));
+
+        ASSERT_EQ(serializer.relocateTo(0x0000000000601000, buffer.data(), buffer.size()), ErrorCode::None);
+        ASSERT_EQ(hexEncode(buffer.data(), buffer.size()), std::string("A10010600000106000"));
+
+        // Serializer state remains untouched.
+        ASSERT_EQ(serializer.getBase(), 0x0000000000401000);
+        ASSERT_EQ(hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("A10010400000104000"));
+        ASSERT_EQ(serializer.getRelocation(0)->address, 0x0000000000401001);
+    }
+
+    TEST(RelocationTests, RelocateToBufferTooSmall)
+    {
+        Program program(MachineMode::I386);
+
+        x86::Assembler assembler(program);
+
+        auto label = assembler.createLabel();
+        ASSERT_EQ(assembler.bind(label), ErrorCode::None);
+        ASSERT_EQ(assembler.mov(x86::eax, label), ErrorCode::None);
+
+        Serializer serializer;
+        ASSERT_EQ(serializer.relocateTo(0x0000000000501000, nullptr, 0), ErrorCode::EmptyState);
+        ASSERT_EQ(serializer.serialize(program, 0x0000000000401000), ErrorCode::None);
+
+        std::array<uint8_t, 4> buffer{};
+        ASSERT_EQ(serializer.relocateTo(0x0000000000501000, buffer.data(), buffer.size()), ErrorCode::InvalidParameter);
+        ASSERT_EQ(serializer.relocateTo(0x0000000000501000, nullptr, 5), ErrorCode::InvalidParameter);
+    }
+
+    TEST(RelocationTests, RelocateOutOfRangeX86)
+    {
+        Program program(MachineMode::I386);
+
+        x86::Assembler assembler(program);
+
+        auto label = assembler.createLabel();
+        ASSERT_EQ(assembler.bind(label), ErrorCode::None);
+        ASSERT_EQ(assembler.mov(x86::eax, label), ErrorCode::None);
+
+        Serializer serializer;
+        ASSERT_EQ(serializer.serialize(program, 0x0000000000401000), ErrorCode::None);
+
+        std::array<uint8_t, 5> buffer{};
+        ASSERT_EQ(
+            serializer.relocateTo(0x0000000100000000, buffer.data(), buffer.size()), ErrorCode::ImpossibleRelocation);
+        ASSERT_EQ(serializer.relocate(0x0000000100000000), ErrorCode::ImpossibleRelocation);
+
+        // Failed relocation must not modify the state.
+        ASSERT_EQ(serializer.getBase(), 0x0000000000401000);
+        ASSERT_EQ(hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("B800104000"));
+
+        ASSERT_EQ(serializer.relocate(0x0000000000501000), ErrorCode::None);
+        ASSERT_EQ(hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("B800105000"));
+
+        // Relocating back must work with the updated state.
+        ASSERT_EQ(serializer.relocate(0x0000000000001000), ErrorCode::None);
+        ASSERT_EQ(hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("B800100000"));
+    }
+
 } // namespace zasm::tests
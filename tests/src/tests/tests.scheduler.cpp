@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <zasm/zasm.hpp>
+
+namespace zasm::tests
+{
+    static std::vector<const Node*> getNodes(const Program& program)
+    {
+        std::vector<const Node*> res;
+        for (const auto* node = program.getHead(); node != nullptr; node = node->getNext())
+        {
+            res.push_back(node);
+        }
+        return res;
+    }
+
+    TEST(SchedulerTests, HideLatency)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        ASSERT_EQ(a.imul(x86::eax, x86::ecx), ErrorCode::None);
+        auto* nodeMul = a.getCursor();
+        ASSERT_EQ(a.add(x86::eax, Imm(1)), ErrorCode::None);
+        auto* nodeAdd = a.getCursor();
+        ASSERT_EQ(a.mov(x86::edx, Imm(5)), ErrorCode::None);
+        auto* nodeMovA = a.getCursor();
+        ASSERT_EQ(a.mov(x86::ebx, Imm(6)), ErrorCode::None);
+        auto* nodeMovB = a.getCursor();
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+        auto* nodeRet = a.getCursor();
+
+        InstructionScheduler scheduler(program);
+        ASSERT_EQ(scheduler.run(), ErrorCode::None);
+
+        // The independent moves fill the latency of the multiplication.
+        const std::vector<const Node*> expected = { nodeMul, nodeMovA, nodeMovB, nodeAdd, nodeRet };
+        ASSERT_EQ(getNodes(program), expected);
+
+        const auto& stats = scheduler.getStats();
+        ASSERT_EQ(stats.regions, 1);
+        ASSERT_EQ(stats.regionsScheduled, 1);
+        ASSERT_EQ(stats.instructionsMoved, 3);
+        ASSERT_EQ(stats.cyclesBefore, 6);
+        ASSERT_EQ(stats.cyclesAfter, 4);
+
+        // Scheduling again keeps the order.
+        ASSERT_EQ(scheduler.run(), ErrorCode::None);
+        ASSERT_EQ(getNodes(program), expected);
+        ASSERT_EQ(scheduler.getStats().instructionsMoved, 0);
+    }
+
+    TEST(SchedulerTests, MemoryOrder)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        ASSERT_EQ(a.imul(x86::eax, x86::eax), ErrorCode::None);
+        auto* nodeMul = a.getCursor();
+        ASSERT_EQ(a.mov(x86::dword_ptr(x86::rcx), x86::eax), ErrorCode::None);
+        auto* nodeStore = a.getCursor();
+        ASSERT_EQ(a.mov(x86::esi, Imm(1)), ErrorCode::None);
+        auto* nodeMovA = a.getCursor();
+        ASSERT_EQ(a.mov(x86::edi, Imm(2)), ErrorCode::None);
+        auto* nodeMovB = a.getCursor();
+        ASSERT_EQ(a.mov(x86::edx, x86::dword_ptr(x86::rbx)), ErrorCode::None);
+        auto* nodeLoad = a.getCursor();
+        ASSERT_EQ(a.add(x86::edx, Imm(1)), ErrorCode::None);
+        auto* nodeAdd = a.getCursor();
+
+        InstructionScheduler scheduler(program);
+        ASSERT_EQ(scheduler.run(), ErrorCode::None);
+
+        // The load may alias the store and stays behind it.
+        const std::vector<const Node*> expected = { nodeMul, nodeMovA, nodeMovB, nodeStore, nodeLoad, nodeAdd };
+        ASSERT_EQ(getNodes(program), expected);
+        ASSERT_EQ(scheduler.getStats().cyclesBefore, 12);
+        ASSERT_EQ(scheduler.getStats().cyclesAfter, 10);
+    }
+
+    TEST(SchedulerTests, KeepBarriers)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        auto labelLoop = a.createLabel();
+        ASSERT_EQ(a.imul(x86::eax, x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.bind(labelLoop), ErrorCode::None);
+        ASSERT_EQ(a.mov(x86::edx, Imm(5)), ErrorCode::None);
+        ASSERT_EQ(a.dec(x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.jnz(labelLoop), ErrorCode::None);
+        ASSERT_EQ(a.mov(x86::ebx, Imm(6)), ErrorCode::None);
+        ASSERT_EQ(a.ret(), ErrorCode::None);
+
+        const auto before = getNodes(program);
+
+        InstructionScheduler scheduler(program);
+        ASSERT_EQ(scheduler.run(), ErrorCode::None);
+
+        // Nothing can move across the label or the branch.
+        ASSERT_EQ(getNodes(program), before);
+
+        const auto& stats = scheduler.getStats();
+        ASSERT_EQ(stats.regions, 3);
+        ASSERT_EQ(stats.regionsScheduled, 0);
+        ASSERT_EQ(stats.cyclesAfter, stats.cyclesBefore);
+    }
+
+    TEST(SchedulerTests, KeepTraps)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler a(program);
+        ASSERT_EQ(a.imul(x86::eax, x86::ecx), ErrorCode::None);
+        ASSERT_EQ(a.add(x86::eax, Imm(1)), ErrorCode::None);
+        ASSERT_EQ(a.ud2(), ErrorCode::None);
+        ASSERT_EQ(a.mov(x86::dword_ptr(x86::rcx), x86::edx), ErrorCode::None);
+        ASSERT_EQ(a.int3(), ErrorCode::None);
+        ASSERT_EQ(a.mov(x86::ebx, Imm(6)), ErrorCode::None);
+
+        const auto before = getNodes(program);
+
+        InstructionScheduler scheduler(program);
+        ASSERT_EQ(scheduler.run(), ErrorCode::None);
+
+        // The store and the move would fill the latency of the multiplication but must stay after the traps.
+        ASSERT_EQ(getNodes(program), before);
+        ASSERT_EQ(scheduler.getStats().instructionsMoved, 0);
+    }
+
+} // namespace zasm::tests
@@ -1,5 +1,9 @@
+#include "../testutils.hpp"
+
 #include <cstddef>
+#include <cstring>
 #include <gtest/gtest.h>
+#include <vector>
 #include <zasm/zasm.hpp>
 
 namespace zasm::tests
@@ -1038,6 +1042,71 @@ namespace zasm::tests
         ASSERT_EQ(serializer.getLabelAddress(label01.getId()), 0x0000000000401020);
     }
 
+    TEST(SerializationTests, AlignCodeNopStyles)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler assembler(program);
+
+        ASSERT_EQ(assembler.inc(x86::eax), ErrorCode::None);
+        ASSERT_EQ(assembler.align(Align::Type::Code, 16), ErrorCode::None);
+
+        Serializer serializer;
+        ASSERT_EQ(serializer.getNopStyle(), NopStyle::Generic);
+
+        ASSERT_EQ(serializer.serialize(program, 0x0000000000401000), ErrorCode::None);
+        ASSERT_EQ(
+            hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("FFC00F1F840000000000660F1F440000"));
+
+        serializer.setNopStyle(NopStyle::Intel);
+        ASSERT_EQ(serializer.serialize(program, 0x0000000000401000), ErrorCode::None);
+        ASSERT_EQ(
+            hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("FFC0660F1F8400000000000F1F440000"));
+
+        serializer.setNopStyle(NopStyle::AMD);
+        ASSERT_EQ(serializer.serialize(program, 0x0000000000401000), ErrorCode::None);
+        ASSERT_EQ(
+            hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("FFC066662E0F1F8400000000000F1F00"));
+
+        serializer.setNopStyle(NopStyle::Legacy);
+        ASSERT_EQ(serializer.serialize(program, 0x0000000000401000), ErrorCode::None);
+        ASSERT_EQ(
+            hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("FFC09090909090909090909090909090"));
+    }
+
+    TEST(SerializationTests, AlignCodePage)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler assembler(program);
+
+        auto label01 = assembler.createLabel();
+
+        ASSERT_EQ(assembler.inc(x86::eax), ErrorCode::None);
+        ASSERT_EQ(assembler.align(Align::Type::Code, 0x1000), ErrorCode::None);
+        ASSERT_EQ(assembler.bind(label01), ErrorCode::None);
+        ASSERT_EQ(assembler.align(Align::Type::Data, 0x2000), ErrorCode::None);
+
+        Serializer serializer;
+        ASSERT_EQ(serializer.serialize(program, 0x0000000000400000), ErrorCode::None);
+        ASSERT_EQ(serializer.getCodeSize(), 0x2000);
+        ASSERT_EQ(serializer.getLabelAddress(label01.getId()), 0x0000000000401000);
+
+        const auto* data = serializer.getCode();
+
+        // 0xFFE bytes of padding, 511 NOPs of 8 bytes and a 6 byte NOP.
+        for (std::size_t i = 2; i < 0xFF8; i += 8)
+        {
+            ASSERT_EQ(hexEncode(data + i, 8), std::string("0F1F840000000000"));
+        }
+        ASSERT_EQ(hexEncode(data + 0xFFA, 6), std::string("660F1F440000"));
+
+        for (std::size_t i = 0x1000; i < 0x2000; i++)
+        {
+            ASSERT_EQ(data[i], 0xCC);
+        }
+    }
+
     TEST(SerializationTests, SerializeDecodedSwapNodes)
     {
         Program program(MachineMode::I386);
@@ -1388,4 +1457,203 @@ namespace zasm::tests
         }
     }
 
+    TEST(SerializationTests, PassInfoForwardLabel)
+    {
+        Program program(MachineMode::AMD64);
+        x86::Assembler assembler(program);
+
+        auto label = assembler.createLabel();
+        ASSERT_EQ(assembler.jmp(label), ErrorCode::None);
+        ASSERT_EQ(assembler.nop(), ErrorCode::None);
+        ASSERT_EQ(assembler.bind(label), ErrorCode::None);
+        ASSERT_EQ(assembler.jmp(label), ErrorCode::None);
+
+        Serializer serializer;
+        ASSERT_EQ(serializer.serialize(program, 0x0000000000401000), ErrorCode::None);
+        ASSERT_EQ(hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("EB0190EBFE"));
+
+        ASSERT_GE(serializer.getPassCount(), 2);
+        ASSERT_EQ(serializer.getPassInfo(serializer.getPassCount()), nullptr);
+
+        const auto* firstPass = serializer.getPassInfo(0);
+        ASSERT_NE(firstPass, nullptr);
+        ASSERT_EQ(firstPass->pass, 1);
+        ASSERT_GE(firstPass->labelLookups, 2);
+        ASSERT_GE(firstPass->unresolvedLabelLookups, 1);
+
+        const auto* lastPass = serializer.getPassInfo(serializer.getPassCount() - 1);
+        ASSERT_NE(lastPass, nullptr);
+        ASSERT_GE(lastPass->labelLookups, 2);
+        ASSERT_EQ(lastPass->unresolvedLabelLookups, 0);
+        ASSERT_EQ(lastPass->codeSize, 5);
+    }
+
+    TEST(SerializationTests, UnreferencedUnboundLabel)
+    {
+        Program program(MachineMode::AMD64);
+        x86::Assembler assembler(program);
+
+        // Unbound labels that are never referenced must not cause an error.
+        auto labelUnused = assembler.createLabel();
+        ASSERT_TRUE(labelUnused.isValid());
+
+        auto label = assembler.createLabel();
+        ASSERT_EQ(assembler.bind(label), ErrorCode::None);
+        ASSERT_EQ(assembler.jmp(label), ErrorCode::None);
+
+        Serializer serializer;
+        ASSERT_EQ(serializer.serialize(program, 0x0000000000401000), ErrorCode::None);
+        ASSERT_EQ(hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("EBFE"));
+        ASSERT_EQ(serializer.getLabelOffset(labelUnused.getId()), -1);
+        ASSERT_EQ(serializer.getLabelAddress(labelUnused.getId()), -1);
+        ASSERT_EQ(serializer.getLabelOffset(label.getId()), 0);
+    }
+
+    TEST(SerializationTests, ReuseSerializer)
+    {
+        Program programA(MachineMode::AMD64);
+        {
+            x86::Assembler assembler(programA);
+
+            auto label = assembler.createLabel();
+            ASSERT_EQ(assembler.bind(label), ErrorCode::None);
+            ASSERT_EQ(assembler.nop(), ErrorCode::None);
+            ASSERT_EQ(assembler.jmp(label), ErrorCode::None);
+        }
+
+        Program programB(MachineMode::AMD64);
+        {
+            x86::Assembler assembler(programB);
+
+            auto labelUnused = assembler.createLabel();
+            ASSERT_TRUE(labelUnused.isValid());
+            auto label = assembler.createLabel();
+            ASSERT_EQ(assembler.mov(x86::rax, label), ErrorCode::None);
+            ASSERT_EQ(assembler.bind(label), ErrorCode::None);
+            ASSERT_EQ(assembler.ret(), ErrorCode::None);
+        }
+
+        Serializer serializer;
+        for (int i = 0; i < 3; ++i)
+        {
+            ASSERT_EQ(serializer.serialize(programA, 0x0000000000401000), ErrorCode::None);
+            ASSERT_EQ(hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("90EBFD"));
+            ASSERT_EQ(serializer.getRelocationCount(), 0);
+            ASSERT_EQ(serializer.getLabelOffset(Label::Id{ 0 }), 0);
+
+            ASSERT_EQ(serializer.serialize(programB, 0x0000000000401000), ErrorCode::None);
+            ASSERT_EQ(hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("48B80A10400000000000C3"));
+            ASSERT_EQ(serializer.getRelocationCount(), 1);
+            ASSERT_EQ(serializer.getLabelOffset(Label::Id{ 0 }), -1);
+            ASSERT_EQ(serializer.getLabelOffset(Label::Id{ 1 }), 10);
+        }
+
+        // Shrinking must keep the serialized state intact.
+        serializer.shrink();
+        ASSERT_EQ(hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("48B80A10400000000000C3"));
+        ASSERT_EQ(serializer.getRelocationCount(), 1);
+
+        ASSERT_EQ(serializer.serialize(programA, 0x0000000000401000), ErrorCode::None);
+        ASSERT_EQ(hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("90EBFD"));
+    }
+
+    TEST(SerializationTests, DataRepeatFill)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler assembler(program);
+        ASSERT_EQ(assembler.db(0xCC, 5), ErrorCode::None);
+        ASSERT_EQ(assembler.dw(0x1234, 3), ErrorCode::None);
+        ASSERT_EQ(assembler.dd(0xAABBCCDD, 7), ErrorCode::None);
+
+        Serializer serializer;
+        ASSERT_EQ(serializer.serialize(program, 0x0000000000401000), ErrorCode::None);
+        ASSERT_EQ(
+            hexEncode(serializer.getCode(), serializer.getCodeSize()),
+            std::string("CCCCCCCCCC341234123412DDCCBBAADDCCBBAADDCCBBAADDCCBBAADDCCBBAADDCCBBAADDCCBBAA"));
+    }
+
+    TEST(SerializationTests, EmbedSharedData)
+    {
+        std::vector<std::uint8_t> blob(4096);
+        for (std::size_t i = 0; i < blob.size(); i++)
+        {
+            blob[i] = static_cast<std::uint8_t>(i ^ (i >> 8));
+        }
+
+        const auto sharedRes = Data::shared(blob.data(), blob.size());
+        ASSERT_TRUE(sharedRes.hasValue());
+
+        const auto& shared = sharedRes.value();
+
+        Program programA(MachineMode::AMD64);
+        Program programB(MachineMode::I386);
+
+        for (auto* program : { &programA, &programB })
+        {
+            x86::Assembler assembler(*program);
+            ASSERT_EQ(assembler.ret(), ErrorCode::None);
+            ASSERT_EQ(assembler.embed(shared), ErrorCode::None);
+            ASSERT_EQ(assembler.embed(Data::external(blob.data(), blob.size())), ErrorCode::None);
+        }
+
+        Serializer serializer;
+        for (auto* program : { &programA, &programB })
+        {
+            ASSERT_EQ(serializer.serialize(*program, 0x0000000000401000), ErrorCode::None);
+            ASSERT_EQ(serializer.getCodeSize(), 1 + blob.size() * 2);
+
+            const auto* code = serializer.getCode();
+            ASSERT_EQ(code[0], 0xC3);
+            ASSERT_EQ(std::memcmp(code + 1, blob.data(), blob.size()), 0);
+            ASSERT_EQ(std::memcmp(code + 1 + blob.size(), blob.data(), blob.size()), 0);
+        }
+    }
+
+    TEST(SerializationTests, ShrinkInstructions)
+    {
+        Program program(MachineMode::AMD64);
+
+        x86::Assembler assembler(program);
+        ASSERT_EQ(assembler.mov(x86::rax, Imm(1)), ErrorCode::None);
+        ASSERT_EQ(assembler.and_(x86::rcx, Imm(0xFF)), ErrorCode::None);
+        ASSERT_EQ(assembler.test(x86::edx, Imm(1)), ErrorCode::None);
+        ASSERT_EQ(assembler.xor_(x86::rax, x86::rax), ErrorCode::None);
+        // Sign extended, not equivalent to the 32 bit form.
+        ASSERT_EQ(assembler.mov(x86::rax, Imm(-1)), ErrorCode::None);
+
+        Serializer serializer;
+        ASSERT_FALSE(serializer.getShrinkInstructions());
+        ASSERT_EQ(serializer.serialize(program, 0x0000000000401000), ErrorCode::None);
+        ASSERT_EQ(serializer.getBytesSaved(), 0);
+        const auto exactSize = serializer.getCodeSize();
+
+        serializer.setShrinkInstructions(true);
+        ASSERT_EQ(serializer.serialize(program, 0x0000000000401000), ErrorCode::None);
+        ASSERT_EQ(serializer.getBytesSaved(), 7);
+        ASSERT_EQ(serializer.getCodeSize(), exactSize - 7);
+        ASSERT_EQ(
+            hexEncode(serializer.getCode(), serializer.getCodeSize()),
+            std::string("B80100000081E1FF000000F6C20131C048C7C0FFFFFFFF"));
+
+        // The program keeps the original instructions.
+        ASSERT_EQ(program.getHead()->get<Instruction>().getOperand<Reg>(0), x86::rax);
+    }
+
+    TEST(SerializationTests, ShrinkInstructionsX86)
+    {
+        Program program(MachineMode::I386);
+
+        x86::Assembler assembler(program);
+        ASSERT_EQ(assembler.test(x86::ecx, Imm(1)), ErrorCode::None);
+        // There is no encoding for sil in 32 bit mode.
+        ASSERT_EQ(assembler.test(x86::esi, Imm(1)), ErrorCode::None);
+
+        Serializer serializer;
+        serializer.setShrinkInstructions(true);
+        ASSERT_EQ(serializer.serialize(program, 0x00401000), ErrorCode::None);
+        ASSERT_EQ(serializer.getBytesSaved(), 3);
+        ASSERT_EQ(hexEncode(serializer.getCode(), serializer.getCodeSize()), std::string("F6C101F7C601000000"));
+    }
+
 } // namespace zasm::tests
@@ -2,6 +2,7 @@
 #include <random>
 
 #define IN_TESTS
+#include <zasm/core/memorystream.hpp>
 #include <zasm/core/stringpool.hpp>
 
 namespace zasm::tests
@@ -267,4 +268,263 @@ namespace zasm::tests
         }
     }
 
+    TEST(StringPoolTests, TestFindAfterRelease)
+    {
+        StringPool pool;
+        std::vector<StringPool::Id> ids;
+
+        fillPool(pool, ids);
+
+        // Release every other string.
+        for (size_t i = 0; i < kTestSize; i += 2)
+        {
+            ASSERT_EQ(pool.release(ids[i]), 0);
+        }
+
+        for (size_t i = 0; i < kTestSize; i++)
+        {
+            const auto& str = kInputStrings[i];
+            if ((i % 2) == 0)
+            {
+                ASSERT_EQ(pool.find(str.c_str()), StringPool::Id::Invalid) << "i = " << i;
+            }
+            else
+            {
+                ASSERT_EQ(pool.find(str.c_str()), ids[i]) << "i = " << i;
+            }
+        }
+    }
+
+    TEST(StringPoolTests, TestReserve)
+    {
+        StringPool pool;
+        pool.reserve(kTestSize);
+
+        std::vector<StringPool::Id> ids;
+        fillPool(pool, ids);
+
+        ASSERT_EQ(pool.size(), kTestSize);
+        for (size_t i = 0; i < kTestSize; i++)
+        {
+            ASSERT_EQ(pool.find(kInputStrings[i].c_str()), ids[i]);
+        }
+
+        pool.clear();
+        ASSERT_EQ(pool.size(), 0);
+        ASSERT_EQ(pool.find(kInputStrings[0].c_str()), StringPool::Id::Invalid);
+    }
+
+    TEST(StringPoolTests, TestSaveLoad)
+    {
+        StringPool pool;
+        std::vector<StringPool::Id> ids;
+
+        fillPool(pool, ids);
+
+        // Release a few to have free entries.
+        for (size_t i = 0; i < kTestSize; i += 3)
+        {
+            ASSERT_EQ(pool.release(ids[i]), 0);
+        }
+
+        MemoryStream stream;
+        ASSERT_EQ(pool.save(stream), ErrorCode::None);
+
+        stream.seek(0, SeekType::Begin);
+
+        StringPool loaded;
+        ASSERT_EQ(loaded.load(stream), ErrorCode::None);
+        ASSERT_EQ(loaded.size(), pool.size());
+
+        for (size_t i = 0; i < kTestSize; i++)
+        {
+            const auto& str = kInputStrings[i];
+            ASSERT_EQ(loaded.find(str.c_str()), pool.find(str.c_str())) << "i = " << i;
+        }
+
+        // Released entries must be reused after loading.
+        const auto id = loaded.acquire(kInputStrings[0]);
+        ASSERT_NE(id, StringPool::Id::Invalid);
+        ASSERT_EQ(loaded.size(), pool.size() + 1);
+    }
+
+    TEST(StringPoolTests, TestSimilarStrings)
+    {
+        StringPool pool;
+
+        // Strings of all lengths that only differ in a single character.
+        std::vector<std::string> strings;
+        for (size_t len = 1; len < 80; len++)
+        {
+            for (size_t pos = 0; pos < len; pos++)
+            {
+                std::string str(len, 'a');
+                str[pos] = 'b';
+                strings.push_back(std::move(str));
+            }
+            strings.emplace_back(len, 'a');
+        }
+
+        std::vector<StringPool::Id> ids;
+        for (const auto& str : strings)
+        {
+            const auto id = pool.acquire(str);
+            ASSERT_NE(id, StringPool::Id::Invalid);
+            ids.push_back(id);
+        }
+        ASSERT_EQ(pool.size(), strings.size());
+
+        for (size_t i = 0; i < strings.size(); i++)
+        {
+            ASSERT_EQ(pool.find(strings[i].c_str()), ids[i]) << strings[i];
+            ASSERT_EQ(strcmp(pool.get(ids[i]), strings[i].c_str()), 0);
+        }
+    }
+
+    TEST(StringPoolTests, TestSaveCompact)
+    {
+        StringPool pool;
+
+        const auto id0 = pool.acquire("hello");
+        const auto id1 = pool.acquire("world");
+        const auto id2 = pool.acquire("zasm");
+        ASSERT_EQ(pool.acquire("zasm"), id2);
+        ASSERT_EQ(pool.release(id1), 0);
+
+        MemoryStream stream;
+        ASSERT_EQ(pool.save(stream), ErrorCode::None);
+
+        // Header, two length prefixed strings including the null terminator.
+        ASSERT_EQ(stream.size(), 12 + (12 + 6) + (12 + 5));
+
+        stream.seek(0, SeekType::Begin);
+
+        StringPool loaded;
+        ASSERT_EQ(loaded.load(stream), ErrorCode::None);
+        ASSERT_EQ(loaded.size(), 2);
+        ASSERT_EQ(loaded.find("hello"), id0);
+        ASSERT_EQ(loaded.find("world"), StringPool::Id::Invalid);
+        ASSERT_EQ(loaded.find("zasm"), id2);
+        ASSERT_EQ(loaded.getRefCount(id0), 1);
+        ASSERT_EQ(loaded.getRefCount(id2), 2);
+
+        // The gap is reused for the next string.
+        ASSERT_EQ(loaded.acquire("another"), id1);
+        ASSERT_EQ(strcmp(loaded.get(id1), "another"), 0);
+    }
+
+    TEST(StringPoolTests, TestLoadMapped)
+    {
+        StringPool pool;
+        std::vector<StringPool::Id> ids;
+
+        fillPool(pool, ids);
+
+        for (size_t i = 0; i < kTestSize; i += 3)
+        {
+            ASSERT_EQ(pool.release(ids[i]), 0);
+        }
+
+        MemoryStream stream;
+        ASSERT_EQ(pool.save(stream), ErrorCode::None);
+
+        const auto* bufferStart = reinterpret_cast<const char*>(stream.data());
+        const auto* bufferEnd = bufferStart + stream.size();
+
+        StringPool mapped;
+        ASSERT_EQ(mapped.loadMapped(stream.data(), stream.size()), ErrorCode::None);
+        ASSERT_EQ(mapped.size(), pool.size());
+
+        for (size_t i = 0; i < kTestSize; i++)
+        {
+            const auto& str = kInputStrings[i];
+            if ((i % 3) == 0)
+            {
+                ASSERT_EQ(mapped.find(str.c_str()), StringPool::Id::Invalid);
+                continue;
+            }
+
+            ASSERT_EQ(mapped.find(str.c_str()), ids[i]);
+
+            // Strings are referenced from the buffer.
+            const auto* cstr = mapped.get(ids[i]);
+            ASSERT_GE(cstr, bufferStart);
+            ASSERT_LT(cstr, bufferEnd);
+            ASSERT_EQ(strcmp(cstr, str.c_str()), 0);
+        }
+
+        // Releasing and acquiring must not write into the buffer.
+        const auto released = ids[1];
+        ASSERT_EQ(mapped.release(released), 0);
+        const auto reused = mapped.acquire("new string");
+        ASSERT_NE(reused, StringPool::Id::Invalid);
+
+        const auto* cstr = mapped.get(reused);
+        ASSERT_TRUE(cstr < bufferStart || cstr >= bufferEnd);
+        ASSERT_EQ(strcmp(cstr, "new string"), 0);
+        ASSERT_EQ(strcmp(pool.get(ids[1]), kInputStrings[1].c_str()), 0);
+    }
+
+    TEST(StringPoolTests, TestLoadMappedInvalid)
+    {
+        StringPool pool;
+        pool.acquire("hello");
+
+        MemoryStream stream;
+        ASSERT_EQ(pool.save(stream), ErrorCode::None);
+
+        StringPool mapped;
+        ASSERT_EQ(mapped.loadMapped(nullptr, 0), ErrorCode::InvalidParameter);
+        ASSERT_EQ(mapped.loadMapped(stream.data(), stream.size() - 1), ErrorCode::InvalidParameter);
+
+        std::vector<std::byte> corrupt(stream.data(), stream.data() + stream.size());
+        corrupt.back() = std::byte{ 'x' };
+        ASSERT_EQ(mapped.loadMapped(corrupt.data(), corrupt.size()), ErrorCode::InvalidParameter);
+    }
+
+    TEST(StringPoolTests, TestLoadLegacy)
+    {
+        // Build a pool with the layout written by previous versions.
+        constexpr const char str0[] = "hello";
+        constexpr const char str1[] = "world";
+        constexpr std::size_t kLegacyBuckets = 39119;
+
+        MemoryStream buffer;
+        IStream& stream = buffer;
+        stream.write(std::uint32_t{ 2 });
+        const auto writeEntry = [&](std::uint32_t offset, std::uint16_t len, std::int32_t refCount, std::int32_t nextFree) {
+            stream.write(std::uint64_t{ 0 });
+            stream.write(std::uint32_t{ 0 });
+            stream.write(offset);
+            stream.write(len);
+            stream.write(std::uint16_t{ 16 });
+            stream.write(refCount);
+            stream.write(nextFree);
+        };
+        writeEntry(0, 5, 3, -1);
+        writeEntry(16, 5, 0, -1);
+        stream.write(std::int32_t{ 1 });
+        for (std::size_t i = 0; i < kLegacyBuckets; i++)
+        {
+            stream.write(std::uint32_t{ 0 });
+        }
+        stream.write(std::uint32_t{ 1 });
+        stream.write(std::uint32_t{ 0 });
+        stream.write(std::uint32_t{ 32 });
+        char blockData[32]{};
+        std::memcpy(blockData, str0, sizeof(str0));
+        std::memcpy(blockData + 16, str1, sizeof(str1));
+        stream.write(blockData, sizeof(blockData));
+
+        stream.seek(0, SeekType::Begin);
+
+        StringPool pool;
+        ASSERT_EQ(pool.load(stream), ErrorCode::None);
+        ASSERT_EQ(pool.size(), 1);
+        ASSERT_EQ(pool.find(str0), StringPool::Id{ 0 });
+        ASSERT_EQ(pool.getRefCount(StringPool::Id{ 0 }), 3);
+        ASSERT_EQ(pool.find(str1), StringPool::Id::Invalid);
+        ASSERT_EQ(pool.acquire("abc"), StringPool::Id{ 1 });
+    }
+
 } // namespace zasm::tests
@@ -1,5 +1,7 @@
 #include "testutils.hpp"
 
+#include <zasm/program/program.hpp>
+
 namespace zasm::tests
 {
 
@@ -46,4 +48,17 @@ namespace zasm::tests
     {
         return os << err.getErrorName();
     }
+
+    std::vector<InstrMnemonic> getMnemonics(const Program& program)
+    {
+        std::vector<InstrMnemonic> res;
+        for (const auto* node = program.getHead(); node != nullptr; node = node->getNext())
+        {
+            if (const auto* instr = node->getIf<Instruction>(); instr != nullptr)
+            {
+                res.push_back(instr->getMnemonic());
+            }
+        }
+        return res;
+    }
 }
@@ -4,9 +4,15 @@
 #include <ostream>
 #include <string>
 #include <vector>
+#include <zasm/base/meta.hpp>
 #include <zasm/core/bitsize.hpp>
 #include <zasm/core/errors.hpp>
 
+namespace zasm
+{
+    class Program;
+}
+
 namespace zasm::tests
 {
     std::vector<uint8_t> hexDecode(std::string_view input);
@@ -16,4 +22,7 @@ namespace zasm::tests
     std::ostream& operator<<(std::ostream& os, const BitSize& s);
     std::ostream& operator<<(std::ostream& os, const Error& err);
 
+    // Returns the mnemonics of all instructions in the program in order.
+    std::vector<InstrMnemonic> getMnemonics(const Program& program);
+
 } // namespace zasm::tests
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <zasm/base/label.hpp>
+#include <zasm/core/errors.hpp>
+#include <zasm/program/observer.hpp>
+
+namespace zasm
+{
+    class Node;
+    class Program;
+
+    namespace detail
+    {
+        struct ControlFlowGraphState;
+    }
+
+    enum class BlockId : std::uint32_t
+    {
+        Invalid = std::numeric_limits<std::uint32_t>::max(),
+    };
+
+    enum class EdgeId : std::uint32_t
+    {
+        Invalid = std::numeric_limits<std::uint32_t>::max(),
+    };
+
+    enum class EdgeKind : std::uint8_t
+    {
+        // Execution continues with the block that follows in the program.
+        Fallthrough = 0,
+        // Target of an unconditional jump.
+        Jump,
+        // Taken target of a conditional branch.
+        Branch,
+    };
+
+    /// <summary>
+    /// A sequence of nodes that is only entered at the first node and only left after the last node.
+    /// Blocks start at labels, sections and after control flow instructions.
+    /// </summary>
+    struct BasicBlock
+    {
+        // First node of the block, nullptr if the block id is not in use.
+        Node* head{};
+        // Last node of the block, this node is part of the block.
+        Node* tail{};
+        // Intrusive lists of the edges, see CFGEdge::nextSucc and CFGEdge::nextPred.
+        EdgeId firstSucc{ EdgeId::Invalid };
+        EdgeId firstPred{ EdgeId::Invalid };
+        std::uint32_t succCount{};
+        std::uint32_t predCount{};
+
+        constexpr bool isValid() const noexcept
+        {
+            return head != nullptr;
+        }
+    };
+
+    struct CFGEdge
+    {
+        BlockId from{ BlockId::Invalid };
+        BlockId to{ BlockId::Invalid };
+        EdgeKind kind{};
+        EdgeId prevSucc{ EdgeId::Invalid };
+        EdgeId nextSucc{ EdgeId::Invalid };
+        EdgeId prevPred{ EdgeId::Invalid };
+        EdgeId nextPred{ EdgeId::Invalid };
+
+        constexpr bool isValid() const noexcept
+        {
+            return from != BlockId::Invalid;
+        }
+    };
+
+    /// <summary>
+    /// Control flow graph over the nodes of a Program. Blocks and edges are stored in flat arrays indexed
+    /// by their id, ids of removed blocks and edges are reused.
+    /// The graph observes the program and updates the affected blocks when nodes are inserted, detached
+    /// or destroyed instead of rebuilding everything. Program::moveAfter and Program::moveBefore do not
+    /// notify observers, call build after moving nodes.
+    /// Only direct branches to labels create edges, indirect branches and returns have no successors.
+    /// The graph must be destroyed before the program.
+    /// </summary>
+    class ControlFlowGraph final : public Observer
+    {
+        detail::ControlFlowGraphState* _state{};
+
+    public:
+        /// <summary>
+        /// Creates the graph for the entire program, nodes inserted anywhere become part of the graph.
+        /// </summary>
+        explicit ControlFlowGraph(Program& program);
+
+        /// <summary>
+        /// Creates the graph for the specified range. Nodes inserted directly before the first node or
+        /// after the last node are not part of the graph.
+        /// </summary>
+        /// <param name="program">The program</param>
+        /// <param name="first">First node of the range</param>
+        /// <param name="last">Last node of the range, inclusive</param>
+        ControlFlowGraph(Program& program, Node* first, Node* last);
+
+        ControlFlowGraph(const ControlFlowGraph&) = delete;
+        ControlFlowGraph(ControlFlowGraph&&) = delete;
+        ~ControlFlowGraph() override;
+
+        ControlFlowGraph& operator=(const ControlFlowGraph&) = delete;
+        ControlFlowGraph& operator=(ControlFlowGraph&&) = delete;
+
+        /// <summary>
+        /// Rebuilds the entire graph from the nodes of the range.
+        /// </summary>
+        /// <returns>ErrorCode::None on success</returns>
+        Error build();
+
+        /// <summary>
+        /// Recomputes the edges of the blocks that were modified since the last update. getBlock, getEdge,
+        /// getEdgeCount and leavesGraph call this implicitly, so they can modify the graph and allocate
+        /// memory even though they are const.
+        /// </summary>
+        void update();
+
+        /// <summary>
+        /// Returns the size of the block array, this includes ids of removed blocks.
+        /// </summary>
+        std::size_t getBlockCount() const noexcept;
+
+        /// <summary>
+        /// Returns the amount of blocks in use.
+        /// </summary>
+        std::size_t getValidBlockCount() const noexcept;
+
+        /// <summary>
+        /// Returns the block for the given id.
+        /// </summary>
+        /// <returns>Pointer to the block or nullptr if the id is not in use</returns>
+        const BasicBlock* getBlock(BlockId id) const;
+
+        /// <summary>
+        /// Returns the size of the edge array, this includes ids of removed edges.
+        /// </summary>
+        std::size_t getEdgeCount() const;
+
+        /// <summary>
+        /// Returns the edge for the given id.
+        /// </summary>
+        /// <returns>Pointer to the edge or nullptr if the id is not in use</returns>
+        const CFGEdge* getEdge(EdgeId id) const;
+
+        /// <summary>
+        /// Returns the block of the first node.
+        /// </summary>
+        BlockId getEntryBlock() const noexcept;
+
+        /// <summary>
+        /// Returns the block that contains the node or BlockId::Invalid if the node is not part of the graph.
+        /// </summary>
+        BlockId getBlockOf(const Node* node) const noexcept;
+
+        /// <summary>
+        /// Returns the block that starts with the label or BlockId::Invalid if the label is not bound
+        /// within the graph.
+        /// </summary>
+        BlockId getBlockOf(const Label& label) const noexcept;
+
+        /// <summary>
+        /// Returns the block that follows the given block in the program.
+        /// </summary>
+        /// <returns>Next block or BlockId::Invalid if this is the last block</returns>
+        BlockId getNextBlock(BlockId id) const noexcept;
+
+        /// <summary>
+        /// Returns true if control flow can leave the graph at the end of the block, this is the case for
+        /// returns, indirect branches, branches to labels outside of the graph and falling through the last
+        /// node of the graph.
+        /// </summary>
+        bool leavesGraph(BlockId id) const;
+
+        /// <summary>
+        /// Calls the function for each successor edge of the block.
+        /// </summary>
+        template<typename TFunc> void forEachSuccessor(BlockId id, TFunc&& func) const
+        {
+            const auto* block = getBlock(id);
+            if (block == nullptr)
+            {
+                return;
+            }
+            for (auto edgeId = block->firstSucc; edgeId != EdgeId::Invalid;)
+            {
+                const auto& edge = *getEdge(edgeId);
+                func(edge);
+                edgeId = edge.nextSucc;
+            }
+        }
+
+        /// <summary>
+        /// Calls the function for each predecessor edge of the block.
+        /// </summary>
+        template<typename TFunc> void forEachPredecessor(BlockId id, TFunc&& func) const
+        {
+            const auto* block = getBlock(id);
+            if (block == nullptr)
+            {
+                return;
+            }
+            for (auto edgeId = block->firstPred; edgeId != EdgeId::Invalid;)
+            {
+                const auto& edge = *getEdge(edgeId);
+                func(edge);
+                edgeId = edge.nextPred;
+            }
+        }
+
+    public:
+        void onNodeDestroy(Node* node) override;
+        void onNodesDestroy(Node* first, Node* last) override;
+        void onNodeDetach(Node* node) override;
+        void onNodeInserted(Node* node) override;
+    };
+
+} // namespace zasm
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <zasm/analysis/cfg.hpp>
+#include <zasm/base/meta.hpp>
+#include <zasm/base/mode.hpp>
+#include <zasm/base/regset.hpp>
+#include <zasm/program/observer.hpp>
+
+namespace zasm
+{
+    class Node;
+    class Program;
+
+    namespace detail
+    {
+        struct LivenessState;
+    }
+
+    /// <summary>
+    /// Set of live registers and flags, registers are normalized to their root.
+    /// </summary>
+    struct LiveSet
+    {
+        RegSet regs;
+        InstrCPUFlags flags{};
+
+        constexpr bool empty() const noexcept
+        {
+            return regs.empty() && flags == InstrCPUFlags{};
+        }
+
+        constexpr LiveSet& operator|=(const LiveSet& other) noexcept
+        {
+            regs |= other.regs;
+            flags = flags | other.flags;
+            return *this;
+        }
+
+        constexpr LiveSet& operator-=(const LiveSet& other) noexcept
+        {
+            regs -= other.regs;
+            flags = flags & ~other.flags;
+            return *this;
+        }
+
+        constexpr bool operator==(const LiveSet& other) const noexcept
+        {
+            return regs == other.regs && flags == other.flags;
+        }
+
+        constexpr bool operator!=(const LiveSet& other) const noexcept
+        {
+            return !(*this == other);
+        }
+    };
+
+    /// <summary>
+    /// Backward liveness of registers and flags over a ControlFlowGraph.
+    /// The register and flag access of every instruction is computed once with Instruction::getDetail
+    /// and cached by node, run can be called again after the program was modified and only new
+    /// instructions are decoded. Modifying an instruction in place requires calling invalidate.
+    /// Whenever control leaves the graph or reaches a call the exit set is considered live, by default
+    /// this is every register and no flags. Returns use the exit set as well unless a separate return
+    /// set is specified. Instructions that can not be analyzed are treated as
+    /// reading every register and flag.
+    /// </summary>
+    class LivenessAnalysis final : public Observer
+    {
+        detail::LivenessState* _state{};
+
+    public:
+        LivenessAnalysis(Program& program, const ControlFlowGraph& cfg);
+        LivenessAnalysis(const LivenessAnalysis&) = delete;
+        LivenessAnalysis(LivenessAnalysis&&) = delete;
+        ~LivenessAnalysis() override;
+
+        LivenessAnalysis& operator=(const LivenessAnalysis&) = delete;
+        LivenessAnalysis& operator=(LivenessAnalysis&&) = delete;
+
+        /// <summary>
+        /// Sets the registers and flags that are live when control leaves the graph or at calls.
+        /// </summary>
+        void setExitLiveSet(const LiveSet& live) noexcept;
+
+        /// <summary>
+        /// Returns the registers and flags that are live when control leaves the graph or at calls.
+        /// </summary>
+        const LiveSet& getExitLiveSet() const noexcept;
+
+        /// <summary>
+        /// Sets the registers and flags that are live when control leaves the graph with a return, this
+        /// replaces the exit set for returns.
+        /// </summary>
+        void setReturnLiveSet(const LiveSet& live) noexcept;
+
+        /// <summary>
+        /// Returns the registers and flags that are live when control leaves the graph with a return.
+        /// </summary>
+        const LiveSet& getReturnLiveSet() const noexcept;
+
+        /// <summary>
+        /// Solves the dataflow for the current state of the graph, the results of previous runs are
+        /// discarded.
+        /// </summary>
+        void run();
+
+        /// <summary>
+        /// Drops the cached access of the node, required when the instruction was modified in place.
+        /// </summary>
+        void invalidate(const Node* node) noexcept;
+
+        /// <summary>
+        /// Returns the registers and flags live at the start of the block.
+        /// </summary>
+        const LiveSet& getLiveIn(BlockId id) const;
+
+        /// <summary>
+        /// Returns the registers and flags live at the end of the block.
+        /// </summary>
+        const LiveSet& getLiveOut(BlockId id) const;
+
+        /// <summary>
+        /// Returns the registers and flags live before the node executes. The sets of all nodes in the
+        /// block of the node are computed and kept until a node of a different block is queried.
+        /// </summary>
+        const LiveSet& getLiveIn(const Node* node) const;
+
+        /// <summary>
+        /// Returns the registers and flags live after the node executes.
+        /// </summary>
+        const LiveSet& getLiveOut(const Node* node) const;
+
+        /// <summary>
+        /// Returns how many times a block was taken from the worklist during the last run.
+        /// </summary>
+        std::size_t getBlockVisitCount() const noexcept;
+
+        /// <summary>
+        /// Returns the amount of instructions that had to be decoded during the last run, instructions
+        /// with a cached access are not counted.
+        /// </summary>
+        std::size_t getDecodeCount() const noexcept;
+
+    public:
+        void onNodeDestroy(Node* node) override;
+    };
+
+} // namespace zasm
@@ -1,11 +1,154 @@
 #pragma once
 
+#include <Zydis/Zydis.h>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <zasm/base/mode.hpp>
 #include <zasm/core/bitsize.hpp>
 
 namespace zasm
 {
+    namespace detail
+    {
+        /// <summary>
+        /// Static register metadata, the tables are built at compile time from the register
+        /// ranges so the common queries do not have to call into Zydis.
+        /// </summary>
+        struct RegInfo
+        {
+            // ZydisRegisterClass
+            std::uint8_t regClass{ ZYDIS_REGCLASS_INVALID };
+            std::int8_t index{ -1 };
+            std::int8_t physIndex{ -1 };
+            std::int8_t offset{};
+            // Registers which do not follow the regular class layout (flags, ip, tables, misc), the
+            // width, class, index and root of those are queried from Zydis.
+            bool irregular{};
+            // Indexed by MachineMode.
+            std::array<BitSize, 3> width{};
+            std::array<std::int16_t, 3> root{};
+        };
+
+        inline constexpr std::size_t kRegInfoCount = static_cast<std::size_t>(ZYDIS_REGISTER_MAX_VALUE) + 1;
+
+        constexpr void setRegInfoRange(
+            std::array<RegInfo, kRegInfoCount>& infos, ZydisRegister first, ZydisRegister last, ZydisRegisterClass regClass,
+            unsigned width32, unsigned width64) noexcept
+        {
+            for (int regId = first; regId <= last; ++regId)
+            {
+                auto& info = infos[regId];
+                const auto index = static_cast<std::int8_t>(regId - first);
+
+                info.regClass = static_cast<std::uint8_t>(regClass);
+                info.index = index;
+                info.physIndex = index;
+                info.width[static_cast<std::size_t>(MachineMode::I386)] = toBitSize(width32);
+                info.width[static_cast<std::size_t>(MachineMode::AMD64)] = toBitSize(width64);
+                info.root[static_cast<std::size_t>(MachineMode::I386)] = static_cast<std::int16_t>(regId);
+                info.root[static_cast<std::size_t>(MachineMode::AMD64)] = static_cast<std::int16_t>(regId);
+            }
+        }
+
+        constexpr void setRegInfoGpRoots(
+            std::array<RegInfo, kRegInfoCount>& infos, ZydisRegister first, ZydisRegister last) noexcept
+        {
+            for (int regId = first; regId <= last; ++regId)
+            {
+                auto& info = infos[regId];
+                info.root[static_cast<std::size_t>(MachineMode::I386)] = info.regClass == ZYDIS_REGCLASS_GPR64
+                    ? static_cast<std::int16_t>(ZYDIS_REGISTER_NONE)
+                    : static_cast<std::int16_t>(ZYDIS_REGISTER_EAX + info.physIndex);
+                info.root[static_cast<std::size_t>(MachineMode::AMD64)] = static_cast<std::int16_t>(
+                    ZYDIS_REGISTER_RAX + info.physIndex);
+            }
+        }
+
+        constexpr void setRegInfoIrregular(
+            std::array<RegInfo, kRegInfoCount>& infos, ZydisRegister first, ZydisRegister last,
+            ZydisRegisterClass regClass) noexcept
+        {
+            for (int regId = first; regId <= last; ++regId)
+            {
+                auto& info = infos[regId];
+                info.regClass = static_cast<std::uint8_t>(regClass);
+                info.irregular = true;
+            }
+        }
+
+        constexpr std::array<RegInfo, kRegInfoCount> buildRegInfo() noexcept
+        {
+            std::array<RegInfo, kRegInfoCount> infos{};
+
+            setRegInfoRange(infos, ZYDIS_REGISTER_AL, ZYDIS_REGISTER_R15B, ZYDIS_REGCLASS_GPR8, 8, 8);
+            setRegInfoRange(infos, ZYDIS_REGISTER_AX, ZYDIS_REGISTER_R15W, ZYDIS_REGCLASS_GPR16, 16, 16);
+            setRegInfoRange(infos, ZYDIS_REGISTER_EAX, ZYDIS_REGISTER_R15D, ZYDIS_REGCLASS_GPR32, 32, 32);
+            setRegInfoRange(infos, ZYDIS_REGISTER_RAX, ZYDIS_REGISTER_R15, ZYDIS_REGCLASS_GPR64, 0, 64);
+            setRegInfoRange(infos, ZYDIS_REGISTER_ST0, ZYDIS_REGISTER_ST7, ZYDIS_REGCLASS_X87, 80, 80);
+            setRegInfoRange(infos, ZYDIS_REGISTER_MM0, ZYDIS_REGISTER_MM7, ZYDIS_REGCLASS_MMX, 64, 64);
+            setRegInfoRange(infos, ZYDIS_REGISTER_XMM0, ZYDIS_REGISTER_XMM31, ZYDIS_REGCLASS_XMM, 128, 128);
+            setRegInfoRange(infos, ZYDIS_REGISTER_YMM0, ZYDIS_REGISTER_YMM31, ZYDIS_REGCLASS_YMM, 256, 256);
+            setRegInfoRange(infos, ZYDIS_REGISTER_ZMM0, ZYDIS_REGISTER_ZMM31, ZYDIS_REGCLASS_ZMM, 512, 512);
+            setRegInfoRange(infos, ZYDIS_REGISTER_ES, ZYDIS_REGISTER_GS, ZYDIS_REGCLASS_SEGMENT, 16, 16);
+            setRegInfoRange(infos, ZYDIS_REGISTER_TR0, ZYDIS_REGISTER_TR7, ZYDIS_REGCLASS_TEST, 32, 32);
+            setRegInfoRange(infos, ZYDIS_REGISTER_CR0, ZYDIS_REGISTER_CR15, ZYDIS_REGCLASS_CONTROL, 32, 64);
+            setRegInfoRange(infos, ZYDIS_REGISTER_DR0, ZYDIS_REGISTER_DR15, ZYDIS_REGCLASS_DEBUG, 32, 64);
+            setRegInfoRange(infos, ZYDIS_REGISTER_K0, ZYDIS_REGISTER_K7, ZYDIS_REGCLASS_MASK, 64, 64);
+            setRegInfoRange(infos, ZYDIS_REGISTER_BND0, ZYDIS_REGISTER_BND3, ZYDIS_REGCLASS_BOUND, 128, 128);
+
+            // Gp8 has the hi registers in the middle of the class, physically they are the first 4.
+            for (int regId = ZYDIS_REGISTER_AH; regId <= ZYDIS_REGISTER_R15B; ++regId)
+            {
+                auto& info = infos[regId];
+                info.physIndex = static_cast<std::int8_t>(info.index - (ZYDIS_REGISTER_AH - ZYDIS_REGISTER_AL));
+                if (regId <= ZYDIS_REGISTER_BH)
+                {
+                    info.offset = 1;
+                }
+            }
+            setRegInfoGpRoots(infos, ZYDIS_REGISTER_AL, ZYDIS_REGISTER_R15);
+
+            // Xmm and Ymm are the lower parts of Zmm.
+            for (int regId = ZYDIS_REGISTER_XMM0; regId <= ZYDIS_REGISTER_ZMM31; ++regId)
+            {
+                auto& info = infos[regId];
+                info.root[static_cast<std::size_t>(MachineMode::I386)] = static_cast<std::int16_t>(
+                    ZYDIS_REGISTER_ZMM0 + info.index);
+                info.root[static_cast<std::size_t>(MachineMode::AMD64)] = static_cast<std::int16_t>(
+                    ZYDIS_REGISTER_ZMM0 + info.index);
+            }
+
+            setRegInfoIrregular(infos, ZYDIS_REGISTER_TMM0, ZYDIS_REGISTER_TMM7, ZYDIS_REGCLASS_TMM);
+            setRegInfoIrregular(infos, ZYDIS_REGISTER_X87CONTROL, ZYDIS_REGISTER_X87TAG, ZYDIS_REGCLASS_INVALID);
+            setRegInfoIrregular(infos, ZYDIS_REGISTER_FLAGS, ZYDIS_REGISTER_RFLAGS, ZYDIS_REGCLASS_FLAGS);
+            setRegInfoIrregular(infos, ZYDIS_REGISTER_IP, ZYDIS_REGISTER_RIP, ZYDIS_REGCLASS_IP);
+            setRegInfoIrregular(infos, ZYDIS_REGISTER_GDTR, ZYDIS_REGISTER_TR, ZYDIS_REGCLASS_INVALID);
+            setRegInfoIrregular(infos, ZYDIS_REGISTER_BNDCFG, ZYDIS_REGISTER_UIF, ZYDIS_REGCLASS_INVALID);
+
+            return infos;
+        }
+
+        inline constexpr std::array<RegInfo, kRegInfoCount> kRegInfo = buildRegInfo();
+        inline constexpr RegInfo kInvalidRegInfo{};
+
+        constexpr const RegInfo& getRegInfo(std::int16_t regId) noexcept
+        {
+            if (static_cast<std::uint16_t>(regId) >= kRegInfoCount)
+            {
+                return kInvalidRegInfo;
+            }
+            return kRegInfo[static_cast<std::size_t>(regId)];
+        }
+
+        // Fallbacks for irregular registers.
+        BitSize getRegBitSizeSlow(std::int16_t regId, MachineMode mode) noexcept;
+        std::uint8_t getRegClassSlow(std::int16_t regId) noexcept;
+        std::int8_t getRegIndexSlow(std::int16_t regId) noexcept;
+        std::int16_t getRegRootSlow(std::int16_t regId, MachineMode mode) noexcept;
+
+    } // namespace detail
+
     class Reg
     {
     public:
@@ -32,54 +175,168 @@ namespace zasm
         {
         }
 
-        BitSize getBitSize(MachineMode mode) const noexcept;
+        constexpr BitSize getBitSize(MachineMode mode) const noexcept
+        {
+            const auto& info = getInfo();
+            if (info.irregular)
+            {
+                return detail::getRegBitSizeSlow(static_cast<std::int16_t>(_reg), mode);
+            }
+            return info.width[static_cast<std::size_t>(mode)];
+        }
 
-        Class getClass() const noexcept;
+        constexpr Class getClass() const noexcept
+        {
+            const auto& info = getInfo();
+            if (info.irregular)
+            {
+                return static_cast<Class>(detail::getRegClassSlow(static_cast<std::int16_t>(_reg)));
+            }
+            return static_cast<Class>(info.regClass);
+        }
 
         /// <summary>
         /// Returns the index per register class
         /// NOTE: For Gp8 there are 20 registers, hi/lo regs are in the same class.
         /// </summary>
-        std::int8_t getIndex() const noexcept;
+        constexpr std::int8_t getIndex() const noexcept
+        {
+            const auto& info = getInfo();
+            if (info.irregular)
+            {
+                return detail::getRegIndexSlow(static_cast<std::int16_t>(_reg));
+            }
+            return info.index;
+        }
 
         /// <summary>
         /// Returns the physical index which is also used for the encoding.
         /// </summary>
         /// <returns>Physical index, typically 0 to 31. Returns -1 if it has no index.</returns>
-        std::int8_t getPhysicalIndex() const noexcept;
+        constexpr std::int8_t getPhysicalIndex() const noexcept
+        {
+            const auto& info = getInfo();
+            if (info.irregular)
+            {
+                return detail::getRegIndexSlow(static_cast<std::int16_t>(_reg));
+            }
+            return info.physIndex;
+        }
 
         /// <summary>
         /// Returns the root register for registers that are lower size, ex.: root of ax
         /// would be eax on 32 bit mode and rax on 64 bit.
         /// In case the register has no root it will return Reg::None.
         /// </summary>
-        Reg getRoot(MachineMode mode) const noexcept;
+        constexpr Reg getRoot(MachineMode mode) const noexcept
+        {
+            const auto& info = getInfo();
+            if (info.irregular)
+            {
+                return Reg{ static_cast<Id>(detail::getRegRootSlow(static_cast<std::int16_t>(_reg), mode)) };
+            }
+            return Reg{ static_cast<Id>(info.root[static_cast<std::size_t>(mode)]) };
+        }
 
         /// <summary>
         /// Returns the offset in the space of the root register as bytes.
         /// This is typically 0 except for Gp8Hi registers.
         /// </summary>
-        std::int8_t getOffset() const noexcept;
-
-        bool isIP() const noexcept;
-        bool isGp8() const noexcept;
-        bool isGp8Lo() const noexcept;
-        bool isGp8Hi() const noexcept;
-        bool isGp16() const noexcept;
-        bool isGp32() const noexcept;
-        bool isGp64() const noexcept;
-        bool isGp() const noexcept;
-        bool isSeg() const noexcept;
-        bool isXmm() const noexcept;
-        bool isYmm() const noexcept;
-        bool isZmm() const noexcept;
-        bool isBnd() const noexcept;
-        bool isControl() const noexcept;
-        bool isDebug() const noexcept;
-        bool isMask() const noexcept;
-        bool isMmx() const noexcept;
-        bool isTmm() const noexcept;
-        
+        constexpr std::int8_t getOffset() const noexcept
+        {
+            return getInfo().offset;
+        }
+
+        constexpr bool isIP() const noexcept
+        {
+            return isClass(ZYDIS_REGCLASS_IP);
+        }
+
+        constexpr bool isGp8() const noexcept
+        {
+            return isClass(ZYDIS_REGCLASS_GPR8);
+        }
+
+        constexpr bool isGp8Lo() const noexcept
+        {
+            return isGp8() && getOffset() == 0;
+        }
+
+        constexpr bool isGp8Hi() const noexcept
+        {
+            return isGp8() && getOffset() != 0;
+        }
+
+        constexpr bool isGp16() const noexcept
+        {
+            return isClass(ZYDIS_REGCLASS_GPR16);
+        }
+
+        constexpr bool isGp32() const noexcept
+        {
+            return isClass(ZYDIS_REGCLASS_GPR32);
+        }
+
+        constexpr bool isGp64() const noexcept
+        {
+            return isClass(ZYDIS_REGCLASS_GPR64);
+        }
+
+        constexpr bool isGp() const noexcept
+        {
+            return isGp8() || isGp16() || isGp32() || isGp64();
+        }
+
+        constexpr bool isSeg() const noexcept
+        {
+            return isClass(ZYDIS_REGCLASS_SEGMENT);
+        }
+
+        constexpr bool isXmm() const noexcept
+        {
+            return isClass(ZYDIS_REGCLASS_XMM);
+        }
+
+        constexpr bool isYmm() const noexcept
+        {
+            return isClass(ZYDIS_REGCLASS_YMM);
+        }
+
+        constexpr bool isZmm() const noexcept
+        {
+            return isClass(ZYDIS_REGCLASS_ZMM);
+        }
+
+        constexpr bool isBnd() const noexcept
+        {
+            return isClass(ZYDIS_REGCLASS_BOUND);
+        }
+
+        constexpr bool isControl() const noexcept
+        {
+            return isClass(ZYDIS_REGCLASS_CONTROL);
+        }
+
+        constexpr bool isDebug() const noexcept
+        {
+            return isClass(ZYDIS_REGCLASS_DEBUG);
+        }
+
+        constexpr bool isMask() const noexcept
+        {
+            return isClass(ZYDIS_REGCLASS_MASK);
+        }
+
+        constexpr bool isMmx() const noexcept
+        {
+            return isClass(ZYDIS_REGCLASS_MMX);
+        }
+
+        constexpr bool isTmm() const noexcept
+        {
+            return isClass(ZYDIS_REGCLASS_TMM);
+        }
+
         constexpr Id getId() const noexcept
         {
             return _reg;
@@ -119,6 +376,17 @@ namespace zasm
         {
             return static_cast<T&>(*this);
         }
+
+    private:
+        constexpr const detail::RegInfo& getInfo() const noexcept
+        {
+            return detail::getRegInfo(static_cast<std::int16_t>(_reg));
+        }
+
+        constexpr bool isClass(ZydisRegisterClass regClass) const noexcept
+        {
+            return getInfo().regClass == static_cast<std::uint8_t>(regClass);
+        }
     };
 
 } // namespace zasm
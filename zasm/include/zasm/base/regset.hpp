@@ -0,0 +1,299 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <zasm/base/mode.hpp>
+#include <zasm/base/register.hpp>
+#include <zasm/core/math.hpp>
+
+namespace zasm
+{
+    /// <summary>
+    /// Fixed size bit set over all register ids. Registers are stored by their root register
+    /// for the given mode so that ex.: al, ax, eax and rax all refer to the same bit.
+    /// </summary>
+    class RegSet
+    {
+    public:
+        using Word = std::uint64_t;
+
+        static constexpr std::size_t kBitsPerWord = 64;
+        static constexpr std::size_t kWordCount = (detail::kRegInfoCount + kBitsPerWord - 1) / kBitsPerWord;
+
+        class Iterator
+        {
+            const RegSet* _set{};
+            std::size_t _wordIndex{};
+            Word _bits{};
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Reg;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Reg*;
+            using reference = Reg;
+
+            constexpr Iterator() noexcept = default;
+            constexpr Iterator(const RegSet* set, std::size_t wordIndex) noexcept
+                : _set{ set }
+                , _wordIndex{ wordIndex }
+            {
+                if (_wordIndex < kWordCount)
+                {
+                    _bits = _set->_words[_wordIndex];
+                    skipEmpty();
+                }
+            }
+
+            constexpr Reg operator*() const noexcept
+            {
+                const auto bitIndex = _wordIndex * kBitsPerWord + math::countTrailingZeros(_bits);
+                return Reg{ static_cast<Reg::Id>(bitIndex) };
+            }
+
+            constexpr Iterator& operator++() noexcept
+            {
+                // Clear the lowest bit.
+                _bits &= _bits - 1;
+                skipEmpty();
+                return *this;
+            }
+
+            constexpr Iterator operator++(int) noexcept
+            {
+                auto res = *this;
+                ++(*this);
+                return res;
+            }
+
+            constexpr bool operator==(const Iterator& other) const noexcept
+            {
+                return _wordIndex == other._wordIndex && _bits == other._bits;
+            }
+
+            constexpr bool operator!=(const Iterator& other) const noexcept
+            {
+                return !(*this == other);
+            }
+
+        private:
+            constexpr void skipEmpty() noexcept
+            {
+                while (_bits == 0 && ++_wordIndex < kWordCount)
+                {
+                    _bits = _set->_words[_wordIndex];
+                }
+                if (_bits == 0)
+                {
+                    _wordIndex = kWordCount;
+                }
+            }
+        };
+
+    private:
+        std::array<Word, kWordCount> _words{};
+
+    public:
+        constexpr RegSet() noexcept = default;
+
+        /// <summary>
+        /// Returns the register that is used to represent the given register in the set.
+        /// This is the root register for the mode, registers without a root represent themselves.
+        /// </summary>
+        static constexpr Reg normalize(const Reg& reg, MachineMode mode) noexcept
+        {
+            const auto root = reg.getRoot(mode);
+            if (root.isValid())
+            {
+                return root;
+            }
+            return reg;
+        }
+
+        /// <summary>
+        /// Adds the root of the register, invalid registers are ignored.
+        /// </summary>
+        constexpr RegSet& add(const Reg& reg, MachineMode mode) noexcept
+        {
+            const auto bitIndex = getBitIndex(normalize(reg, mode));
+            if (bitIndex < kWordCount * kBitsPerWord)
+            {
+                _words[bitIndex / kBitsPerWord] |= Word{ 1 } << (bitIndex % kBitsPerWord);
+            }
+            return *this;
+        }
+
+        /// <summary>
+        /// Removes the root of the register.
+        /// </summary>
+        constexpr RegSet& remove(const Reg& reg, MachineMode mode) noexcept
+        {
+            const auto bitIndex = getBitIndex(normalize(reg, mode));
+            if (bitIndex < kWordCount * kBitsPerWord)
+            {
+                _words[bitIndex / kBitsPerWord] &= ~(Word{ 1 } << (bitIndex % kBitsPerWord));
+            }
+            return *this;
+        }
+
+        /// <summary>
+        /// Returns true if the root of the register is in the set.
+        /// </summary>
+        constexpr bool contains(const Reg& reg, MachineMode mode) const noexcept
+        {
+            const auto bitIndex = getBitIndex(normalize(reg, mode));
+            if (bitIndex >= kWordCount * kBitsPerWord)
+            {
+                return false;
+            }
+            return (_words[bitIndex / kBitsPerWord] & (Word{ 1 } << (bitIndex % kBitsPerWord))) != 0;
+        }
+
+        /// <summary>
+        /// Returns the amount of registers in the set.
+        /// </summary>
+        constexpr std::size_t count() const noexcept
+        {
+            std::size_t res = 0;
+            for (std::size_t i = 0; i < kWordCount; ++i)
+            {
+                res += static_cast<std::size_t>(math::popCount(_words[i]));
+            }
+            return res;
+        }
+
+        constexpr bool empty() const noexcept
+        {
+            Word res = 0;
+            for (std::size_t i = 0; i < kWordCount; ++i)
+            {
+                res |= _words[i];
+            }
+            return res == 0;
+        }
+
+        /// <summary>
+        /// Returns true if both sets have at least one register in common.
+        /// </summary>
+        constexpr bool intersects(const RegSet& other) const noexcept
+        {
+            Word res = 0;
+            for (std::size_t i = 0; i < kWordCount; ++i)
+            {
+                res |= _words[i] & other._words[i];
+            }
+            return res != 0;
+        }
+
+        constexpr void clear() noexcept
+        {
+            for (std::size_t i = 0; i < kWordCount; ++i)
+            {
+                _words[i] = 0;
+            }
+        }
+
+        constexpr RegSet& operator|=(const RegSet& other) noexcept
+        {
+            for (std::size_t i = 0; i < kWordCount; ++i)
+            {
+                _words[i] |= other._words[i];
+            }
+            return *this;
+        }
+
+        constexpr RegSet& operator&=(const RegSet& other) noexcept
+        {
+            for (std::size_t i = 0; i < kWordCount; ++i)
+            {
+                _words[i] &= other._words[i];
+            }
+            return *this;
+        }
+
+        /// <summary>
+        /// Removes all registers that are in the other set.
+        /// </summary>
+        constexpr RegSet& operator-=(const RegSet& other) noexcept
+        {
+            for (std::size_t i = 0; i < kWordCount; ++i)
+            {
+                _words[i] &= ~other._words[i];
+            }
+            return *this;
+        }
+
+        constexpr RegSet operator|(const RegSet& other) const noexcept
+        {
+            auto res = *this;
+            res |= other;
+            return res;
+        }
+
+        constexpr RegSet operator&(const RegSet& other) const noexcept
+        {
+            auto res = *this;
+            res &= other;
+            return res;
+        }
+
+        constexpr RegSet operator-(const RegSet& other) const noexcept
+        {
+            auto res = *this;
+            res -= other;
+            return res;
+        }
+
+        constexpr bool operator==(const RegSet& other) const noexcept
+        {
+            for (std::size_t i = 0; i < kWordCount; ++i)
+            {
+                if (_words[i] != other._words[i])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        constexpr bool operator!=(const RegSet& other) const noexcept
+        {
+            return !(*this == other);
+        }
+
+        /// <summary>
+        /// Returns the raw words of the set, bit N corresponds to the register id N.
+        /// </summary>
+        constexpr const std::array<Word, kWordCount>& getWords() const noexcept
+        {
+            return _words;
+        }
+
+        /// <summary>
+        /// Iterates the registers in ascending id order.
+        /// </summary>
+        constexpr Iterator begin() const noexcept
+        {
+            return Iterator{ this, 0 };
+        }
+
+        constexpr Iterator end() const noexcept
+        {
+            return Iterator{ this, kWordCount };
+        }
+
+    private:
+        static constexpr std::size_t getBitIndex(const Reg& reg) noexcept
+        {
+            // Reg::Id::None and Reg::Id::Invalid map outside of the set.
+            if (!reg.isValid())
+            {
+                return kWordCount * kBitsPerWord;
+            }
+            return static_cast<std::uint16_t>(reg.getId());
+        }
+    };
+
+} // namespace zasm
@@ -0,0 +1,440 @@
+#pragma once
+
+#include "stringpool.hpp"
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <zasm/core/errors.hpp>
+#include <zasm/core/stream.hpp>
+
+namespace zasm
+{
+    /// <summary>
+    /// Thread-safe string pool for names that are shared between many programs. Lookups and get are lock-free,
+    /// inserts lock only the shard the string hashes to. Strings are never removed, an Id stays valid and keeps
+    /// pointing to the same string for the lifetime of the pool. Ids are compatible with StringPool::Id so a
+    /// Program can use this pool as backing store of its symbol names, see Program::setSymbolPool.
+    /// </summary>
+    class ConcurrentStringPool
+    {
+    public:
+        using Id = StringPool::Id;
+
+        static constexpr std::size_t kMaxStringSize = StringPool::kMaxStringSize;
+        static constexpr std::size_t kNumShards = 64;
+
+    private:
+        static constexpr std::size_t kShardBits = 6;
+        static_assert((std::size_t{ 1 } << kShardBits) == kNumShards);
+
+        static constexpr std::size_t kMinTableSize = 64;
+        static constexpr std::size_t kArenaBlockSize = 64 * 1024;
+
+        // Entries are stored in chunks that double in size, the first chunk holds 1 << kFirstChunkBits entries.
+        static constexpr std::uint32_t kFirstChunkBits = 10;
+        static constexpr std::size_t kMaxChunks = 32 - kFirstChunkBits;
+        static constexpr std::uint32_t kMaxId = 0x7FFFFFFF;
+
+        struct Entry
+        {
+            // Published last, a non-null string means the entry is complete.
+            std::atomic<const char*> str{};
+            std::uint32_t len{};
+        };
+
+        // Slots hold the hash fragment in the upper 32 bits and id + 1 in the lower 32 bits, zero is empty.
+        struct Table
+        {
+            std::size_t mask{};
+            std::uint32_t shift{};
+            std::unique_ptr<std::atomic<std::uint64_t>[]> slots;
+        };
+
+        struct alignas(64) Shard
+        {
+            std::atomic<const Table*> table{};
+
+            // Guarded by mutex.
+            std::mutex mutex;
+            std::size_t count{};
+            std::vector<std::unique_ptr<Table>> tables;
+            std::vector<std::unique_ptr<char[]>> arena;
+            std::size_t arenaUsed{ kArenaBlockSize };
+        };
+
+        std::array<Shard, kNumShards> _shards;
+        std::array<std::atomic<Entry*>, kMaxChunks> _chunks{};
+        std::atomic<std::uint32_t> _nextId{};
+
+    public:
+        ConcurrentStringPool() = default;
+        ConcurrentStringPool(const ConcurrentStringPool&) = delete;
+        ConcurrentStringPool& operator=(const ConcurrentStringPool&) = delete;
+
+        ~ConcurrentStringPool()
+        {
+            for (auto& chunk : _chunks)
+            {
+                delete[] chunk.load(std::memory_order_relaxed);
+            }
+        }
+
+        Id acquire(const char* value, std::size_t size = StringPool::kUnspecifiedSize)
+        {
+            if (size == StringPool::kUnspecifiedSize)
+            {
+                size = std::strlen(value);
+            }
+            return acquire_(value, size);
+        }
+
+        Id acquire(std::string_view str)
+        {
+            return acquire_(str.data(), str.size());
+        }
+
+        Id acquire(const std::string& val)
+        {
+            return acquire_(val.c_str(), val.size());
+        }
+
+        Id find(const char* str) const noexcept
+        {
+            const auto len = std::strlen(str);
+            return find_(str, len, StringPool::getHash(str, len));
+        }
+
+        bool isValid(Id stringId) const noexcept
+        {
+            return getEntry(stringId) != nullptr;
+        }
+
+        const char* get(Id stringId) const noexcept
+        {
+            const auto* entry = getEntry(stringId);
+            if (entry == nullptr)
+            {
+                return nullptr;
+            }
+            return entry->str.load(std::memory_order_acquire);
+        }
+
+        std::size_t getLength(Id stringId) const noexcept
+        {
+            const auto* entry = getEntry(stringId);
+            if (entry == nullptr)
+            {
+                return 0;
+            }
+            return entry->len;
+        }
+
+        /// <summary>
+        /// Returns the amount of ids handed out so far.
+        /// </summary>
+        std::size_t size() const noexcept
+        {
+            return _nextId.load(std::memory_order_acquire);
+        }
+
+        /// <summary>
+        /// Writes all strings in the compact format of StringPool::save, each string with a reference count
+        /// of one. The result can be loaded into a StringPool and the ids remain the same. Strings added
+        /// concurrently may or may not be included.
+        /// </summary>
+        Error save(IStream& stream) const
+        {
+            std::vector<char> buffer;
+
+            const auto append = [&](const void* data, std::size_t len) {
+                const auto* bytes = static_cast<const char*>(data);
+                buffer.insert(buffer.end(), bytes, bytes + len);
+            };
+
+            StringPool::CompactHeader header{};
+            header.signature = StringPool::kCompactSignature;
+            header.entryCount = static_cast<std::uint32_t>(size());
+            append(&header, sizeof(header));
+
+            for (std::uint32_t i = 0; i < header.entryCount; ++i)
+            {
+                const auto id = static_cast<Id>(i);
+                const auto* str = get(id);
+                if (str == nullptr)
+                {
+                    continue;
+                }
+
+                StringPool::CompactString compactStr{};
+                compactStr.id = i;
+                compactStr.refCount = 1;
+                compactStr.len = static_cast<std::uint32_t>(getLength(id));
+                append(&compactStr, sizeof(compactStr));
+                append(str, compactStr.len + 1);
+
+                header.stringCount++;
+            }
+
+            std::memcpy(buffer.data(), &header, sizeof(header));
+
+            if (auto len = stream.write(buffer.data(), buffer.size()); len != buffer.size())
+            {
+                return ErrorCode::InvalidParameter;
+            }
+
+            return ErrorCode::None;
+        }
+
+    private:
+        static constexpr std::uint32_t getHighestBit(std::uint32_t value) noexcept
+        {
+            std::uint32_t res = 0;
+            for (std::uint32_t bits = 16; bits != 0; bits >>= 1)
+            {
+                if (value >= (std::uint32_t{ 1 } << bits))
+                {
+                    value >>= bits;
+                    res += bits;
+                }
+            }
+            return res;
+        }
+
+        static constexpr std::size_t getChunkSize(std::size_t chunkIndex) noexcept
+        {
+            return std::size_t{ 1 } << (chunkIndex + kFirstChunkBits);
+        }
+
+        const Entry* getEntry(Id stringId) const noexcept
+        {
+            const auto id = static_cast<std::uint32_t>(stringId);
+            if (id > kMaxId)
+            {
+                return nullptr;
+            }
+
+            const auto pos = id + (std::uint32_t{ 1 } << kFirstChunkBits);
+            const auto highestBit = getHighestBit(pos);
+
+            const auto* chunk = _chunks[highestBit - kFirstChunkBits].load(std::memory_order_acquire);
+            if (chunk == nullptr)
+            {
+                return nullptr;
+            }
+
+            const auto* entry = &chunk[pos - (std::uint32_t{ 1 } << highestBit)];
+            if (entry->str.load(std::memory_order_acquire) == nullptr)
+            {
+                return nullptr;
+            }
+
+            return entry;
+        }
+
+        Entry& getOrCreateEntry(std::uint32_t id)
+        {
+            const auto pos = id + (std::uint32_t{ 1 } << kFirstChunkBits);
+            const auto highestBit = getHighestBit(pos);
+            const auto chunkIndex = highestBit - kFirstChunkBits;
+
+            auto* chunk = _chunks[chunkIndex].load(std::memory_order_acquire);
+            if (chunk == nullptr)
+            {
+                // Multiple shards may race for the same chunk, only one of them wins.
+                auto* newChunk = new Entry[getChunkSize(chunkIndex)];
+                if (_chunks[chunkIndex].compare_exchange_strong(
+                        chunk, newChunk, std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    chunk = newChunk;
+                }
+                else
+                {
+                    delete[] newChunk;
+                }
+            }
+
+            return chunk[pos - (std::uint32_t{ 1 } << highestBit)];
+        }
+
+        static constexpr std::size_t getShardIndex(std::uint64_t hash) noexcept
+        {
+            return static_cast<std::size_t>(hash >> (64 - kShardBits));
+        }
+
+        static constexpr std::uint32_t getHashFragment(std::uint64_t hash) noexcept
+        {
+            return static_cast<std::uint32_t>(hash);
+        }
+
+        static std::size_t getSlotIndex(const Table& table, std::uint32_t fragment) noexcept
+        {
+            return static_cast<std::uint32_t>(fragment * 0x9E3779B9U) >> table.shift;
+        }
+
+        Id findInTable(const Table& table, const char* buf, std::size_t len, std::uint32_t fragment) const noexcept
+        {
+            auto index = getSlotIndex(table, fragment);
+            for (;;)
+            {
+                const auto slot = table.slots[index].load(std::memory_order_acquire);
+                if (slot == 0)
+                {
+                    return Id::Invalid;
+                }
+
+                if (static_cast<std::uint32_t>(slot >> 32) == fragment)
+                {
+                    const auto id = static_cast<Id>(static_cast<std::uint32_t>(slot) - 1);
+                    const auto* entry = getEntry(id);
+                    if (entry != nullptr && entry->len == len)
+                    {
+                        const auto* str = entry->str.load(std::memory_order_acquire);
+                        if (StringPool::isEqual(str, buf, len))
+                        {
+                            return id;
+                        }
+                    }
+                }
+
+                index = (index + 1) & table.mask;
+            }
+        }
+
+        Id find_(const char* buf, std::size_t len, std::uint64_t hash) const noexcept
+        {
+            const auto& shard = _shards[getShardIndex(hash)];
+
+            const auto* table = shard.table.load(std::memory_order_acquire);
+            if (table == nullptr)
+            {
+                return Id::Invalid;
+            }
+
+            return findInTable(*table, buf, len, getHashFragment(hash));
+        }
+
+        static void insertSlot(const Table& table, std::uint64_t slotValue) noexcept
+        {
+            auto index = getSlotIndex(table, static_cast<std::uint32_t>(slotValue >> 32));
+            while (table.slots[index].load(std::memory_order_relaxed) != 0)
+            {
+                index = (index + 1) & table.mask;
+            }
+            table.slots[index].store(slotValue, std::memory_order_release);
+        }
+
+        // Creates a bigger table for the shard, readers keep using the previous table until the
+        // new one is published so previous tables stay alive until the pool is destroyed.
+        static const Table& growTable(Shard& shard, const Table* oldTable)
+        {
+            const auto oldSize = oldTable != nullptr ? oldTable->mask + 1 : 0;
+            const auto newSize = oldSize != 0 ? oldSize * 2 : kMinTableSize;
+
+            auto table = std::make_unique<Table>();
+            table->mask = newSize - 1;
+            table->shift = 32 - getHighestBit(static_cast<std::uint32_t>(newSize));
+            table->slots = std::make_unique<std::atomic<std::uint64_t>[]>(newSize);
+
+            if (oldTable != nullptr)
+            {
+                for (std::size_t i = 0; i < oldSize; ++i)
+                {
+                    const auto slot = oldTable->slots[i].load(std::memory_order_relaxed);
+                    if (slot != 0)
+                    {
+                        insertSlot(*table, slot);
+                    }
+                }
+            }
+
+            const auto& res = *table;
+            shard.tables.push_back(std::move(table));
+            shard.table.store(&res, std::memory_order_release);
+
+            return res;
+        }
+
+        static char* allocateString(Shard& shard, std::size_t size)
+        {
+            if (shard.arenaUsed + size > kArenaBlockSize)
+            {
+                shard.arena.push_back(std::make_unique<char[]>(kArenaBlockSize));
+                shard.arenaUsed = 0;
+            }
+
+            auto* res = shard.arena.back().get() + shard.arenaUsed;
+            shard.arenaUsed += size;
+
+            return res;
+        }
+
+        Id acquire_(const char* buf, std::size_t len)
+        {
+            // Strings can not be larger than kMaxStringSize.
+            if (len >= kMaxStringSize)
+            {
+                assert(len < kMaxStringSize);
+                return Id::Invalid;
+            }
+
+            const auto hash = StringPool::getHash(buf, len);
+
+            // Fast path without locking.
+            if (auto stringId = find_(buf, len, hash); stringId != Id::Invalid)
+            {
+                return stringId;
+            }
+
+            auto& shard = _shards[getShardIndex(hash)];
+            const auto fragment = getHashFragment(hash);
+
+            std::lock_guard<std::mutex> lock(shard.mutex);
+
+            // Check again, another thread may have added it in the meantime.
+            const auto* table = shard.table.load(std::memory_order_relaxed);
+            if (table != nullptr)
+            {
+                if (auto stringId = findInTable(*table, buf, len, fragment); stringId != Id::Invalid)
+                {
+                    return stringId;
+                }
+            }
+
+            // Grow at 50% load, tables are never shrunk.
+            if (table == nullptr || (shard.count + 1) * 2 > table->mask + 1)
+            {
+                table = &growTable(shard, table);
+            }
+
+            const auto id = _nextId.fetch_add(1, std::memory_order_acq_rel);
+            if (id > kMaxId)
+            {
+                _nextId.store(kMaxId + 1, std::memory_order_relaxed);
+                return Id::Invalid;
+            }
+
+            auto* str = allocateString(shard, len + 1);
+            std::memcpy(str, buf, len);
+            str[len] = '\0';
+
+            auto& entry = getOrCreateEntry(id);
+            entry.len = static_cast<std::uint32_t>(len);
+            entry.str.store(str, std::memory_order_release);
+
+            insertSlot(*table, (std::uint64_t{ fragment } << 32) | (id + 1));
+            shard.count++;
+
+            return static_cast<Id>(id);
+        }
+    };
+
+} // namespace zasm
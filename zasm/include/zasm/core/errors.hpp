@@ -2,6 +2,8 @@
 
 #include <cassert>
 #include <cstdint>
+#include <limits>
+#include <type_traits>
 
 namespace zasm
 {
@@ -40,22 +42,46 @@ namespace zasm
     /// <summary>
     /// The Error class represents an error code and can have additionally a message attached.
     /// If the object is constructed with an error message additional memory will be allocated.
-    /// If the object is constructed only with an error code there will be no extra allocation.
+    /// If the object is constructed only with an error code there will be no extra allocation,
+    /// this path is fully inline so returning ErrorCode::None costs no more than an integer.
     /// </summary>
     class Error
     {
+        static constexpr std::uintptr_t kExtBit = std::uintptr_t{ 1 }
+            << (std::numeric_limits<std::uintptr_t>::digits - 1);
+
+        // Either the error code or the pointer to the external data with kExtBit set.
         std::uintptr_t _data{};
 
+        static_assert(
+            static_cast<std::uintptr_t>(ErrorCode::ImpossibleRelocation) < kExtBit, "Error codes must not use the top bit");
+
     public:
         constexpr Error() noexcept = default;
-        Error(const Error& other);
-        Error(Error&& other) noexcept;
+
+        Error(const Error& other)
+            : _data{ other._data }
+        {
+            if (isExt())
+            {
+                copyExt(other);
+            }
+        }
+
+        constexpr Error(Error&& other) noexcept
+            : _data{ other._data }
+        {
+            other._data = 0;
+        }
 
         /// <summary>
         /// Construct an Error object with the given error code.
         /// </summary>
         /// <param name="code">Error Code</param>
-        Error(ErrorCode code) noexcept;
+        constexpr Error(ErrorCode code) noexcept
+            : _data{ static_cast<std::uintptr_t>(code) }
+        {
+        }
 
         /// <summary>
         /// Construct an Error object with the given error code and an additional message.
@@ -65,13 +91,26 @@ namespace zasm
         /// <param name="message">Additional information</param>
         Error(ErrorCode code, const char* message);
 
-        ~Error() noexcept;
+        ~Error() noexcept
+        {
+            if (isExt())
+            {
+                destroyExt();
+            }
+        }
 
         /// <summary>
         /// Returns the assigned error code.
         /// </summary>
         /// <returns>Error code</returns>
-        ErrorCode getCode() const noexcept;
+        ErrorCode getCode() const noexcept
+        {
+            if (isExt())
+            {
+                return getExtCode();
+            }
+            return static_cast<ErrorCode>(_data);
+        }
 
         /// <summary>
         /// Returns the error code name as a string.
@@ -92,17 +131,74 @@ namespace zasm
         /// Clears the error object which means that the error code will be set to ErrorCode::None.
         /// If the object has an additional message it will be deallocated.
         /// </summary>
-        void clear();
+        void clear() noexcept
+        {
+            if (isExt())
+            {
+                destroyExt();
+            }
+            _data = 0;
+        }
 
         /// <summary>
         /// Returns true if the error object is empty.
         /// </summary>
-        bool empty() const noexcept;
+        constexpr bool empty() const noexcept
+        {
+            return _data == 0;
+        }
+
+        bool operator==(ErrorCode code) const noexcept
+        {
+            return getCode() == code;
+        }
 
-        bool operator==(ErrorCode code) const noexcept;
-        bool operator!=(ErrorCode code) const noexcept;
-        Error& operator=(Error&& other) noexcept;
-        Error& operator=(const Error& other) noexcept;
+        bool operator!=(ErrorCode code) const noexcept
+        {
+            return !(*this == code);
+        }
+
+        Error& operator=(Error&& other) noexcept
+        {
+            if (this != &other)
+            {
+                clear();
+                _data = other._data;
+                other._data = 0;
+            }
+            return *this;
+        }
+
+        Error& operator=(const Error& other) noexcept
+        {
+            if (this != &other)
+            {
+                clear();
+                _data = other._data;
+                if (isExt())
+                {
+                    copyExt(other);
+                }
+            }
+            return *this;
+        }
+
+    private:
+        constexpr bool isExt() const noexcept
+        {
+            return (_data & kExtBit) != 0;
+        }
+
+        // Out of line, only used when a message is attached.
+        void copyExt(const Error& other);
+        void destroyExt() noexcept;
+        ErrorCode getExtCode() const noexcept;
     };
 
+    // Returning an Error is returning a single word, the copy and destruction of attached messages
+    // makes it non-trivial which is why the ErrorCode-only path is kept inline.
+    static_assert(sizeof(Error) == sizeof(std::uintptr_t));
+    static_assert(alignof(Error) == alignof(std::uintptr_t));
+    static_assert(std::is_nothrow_move_constructible_v<Error> && !std::is_trivially_copyable_v<Error>);
+
 } // namespace zasm
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <type_traits>
 
 namespace zasm::math
@@ -36,4 +37,37 @@ namespace zasm::math
         }
     }
 
+    /// <summary>
+    /// Returns the number of bits set in the value.
+    /// </summary>
+    static constexpr int popCount(std::uint64_t value) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(value);
+#else
+        value = value - ((value >> 1) & 0x5555555555555555ULL);
+        value = (value & 0x3333333333333333ULL) + ((value >> 2) & 0x3333333333333333ULL);
+        value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return static_cast<int>((value * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    /// <summary>
+    /// Returns the index of the lowest bit set, the value must not be zero.
+    /// </summary>
+    static constexpr int countTrailingZeros(std::uint64_t value) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(value);
+#else
+        int count = 0;
+        while ((value & 1U) == 0)
+        {
+            value >>= 1;
+            ++count;
+        }
+        return count;
+#endif
+    }
+
 } // namespace zasm::math
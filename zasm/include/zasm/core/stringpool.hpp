@@ -1,9 +1,11 @@
 #pragma once
 
 #include <algorithm>
-#include <array>
+#include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <limits>
 #include <memory>
 #include <string.h>
 #include <string>
@@ -12,11 +14,21 @@
 #include <zasm/core/errors.hpp>
 #include <zasm/core/stream.hpp>
 
+// Set to 1 to hash strings with the FNV-1a hash of previous versions.
+#ifndef ZASM_STRINGPOOL_LEGACY_HASH
+#    define ZASM_STRINGPOOL_LEGACY_HASH 0
+#endif
+
 namespace zasm
 {
 
+    class ConcurrentStringPool;
+
     class StringPool
     {
+        // Shares the hash function and the compact format.
+        friend class ConcurrentStringPool;
+
     public:
         enum class Id : std::int32_t
         {
@@ -32,10 +44,31 @@ namespace zasm
 
         static_assert(kBlockSize >= kMaxStringSize, "Block size must be bigger than max string size.");
 
-        // 16 bit prime number.
-        static constexpr std::size_t kMaxHashBuckets = 39119;
+        // Minimum amount of slots of the hash table once the first string is added, always a power of two.
+        static constexpr std::size_t kMinHashSlots = 16;
 
     private:
+        // Amount of hash buckets stored by the legacy format.
+        static constexpr std::size_t kSavedHashBuckets = 39119;
+
+        // Signature of the compact format, the legacy format starts with the entry count instead.
+        static constexpr std::uint32_t kCompactSignature = 0x3150535A;
+
+        struct CompactHeader
+        {
+            std::uint32_t signature{};
+            std::uint32_t entryCount{};
+            std::uint32_t stringCount{};
+        };
+
+        // Followed by len bytes of the string and the null terminator.
+        struct CompactString
+        {
+            std::uint32_t id{};
+            std::int32_t refCount{};
+            std::uint32_t len{};
+        };
+
         using StringSize = std::conditional_t<
             kMaxStringSize <= std::numeric_limits<std::uint16_t>::max(), std::uint16_t, std::uint32_t>;
 
@@ -55,8 +88,17 @@ namespace zasm
             Id nextFreeId{ Id::Invalid };
         };
 
+        // Open addressing slot, the fragment is derived from the full hash and determines the
+        // ideal slot index, this allows to compute the probe distance without touching the entry.
+        struct HashSlot
+        {
+            std::uint32_t fragment{};
+            Id id{ Id::Invalid };
+        };
+
         std::vector<Entry> _entries;
-        std::vector<std::vector<Id>> _hashBuckets;
+        std::vector<HashSlot> _hashSlots;
+        std::uint32_t _hashShift{};
         Id _nextFreeId{ Id::Invalid };
         std::size_t _numFree{};
 
@@ -64,17 +106,14 @@ namespace zasm
         {
             BlockIndex index{};
             std::uint32_t used{};
-            std::array<char, kBlockSize> data{};
+            // Owned storage of kBlockSize bytes, null if the block references external memory.
+            std::unique_ptr<char[]> storage;
+            const char* data{};
         };
 
         std::vector<std::unique_ptr<Block>> _blocks;
 
     public:
-        StringPool()
-        {
-            _hashBuckets.resize(kMaxHashBuckets);
-        }
-
         Id acquire(const char* value, std::size_t size = kUnspecifiedSize)
         {
             if (size == kUnspecifiedSize)
@@ -111,10 +150,7 @@ namespace zasm
                 _nextFreeId = stringId;
                 _numFree++;
 
-                const auto bucketIndex = entry->hash % kMaxHashBuckets;
-                auto& bucket = _hashBuckets[bucketIndex];
-
-                bucket.erase(std::remove(bucket.begin(), bucket.end(), stringId), bucket.end());
+                eraseHashSlot(getHashFragment(entry->hash), stringId);
             }
 
             return newRefCount;
@@ -141,7 +177,7 @@ namespace zasm
                 return nullptr;
             }
 
-            return _blocks[entry->blockIndex]->data.data() + entry->offsetInBlock;
+            return getString(*entry);
         }
 
         std::size_t getLength(Id stringId) const noexcept
@@ -165,25 +201,42 @@ namespace zasm
             return entry->refCount;
         }
 
+        /// <summary>
+        /// Reserves space for the specified amount of strings, this avoids growing the
+        /// hash table while adding strings.
+        /// </summary>
+        void reserve(std::size_t count)
+        {
+            _entries.reserve(count);
+            if (count > getHashCapacity(_hashSlots.size()))
+            {
+                rehash(getHashSlotCount(count));
+            }
+        }
+
         void clear() noexcept
         {
             if (_entries.empty())
             {
-                // Because clearing the buckets is expensive do nothing if already empty.
                 return;
             }
             _entries.clear();
-            if (_blocks.size() > 1)
+            if (!_blocks.empty())
             {
-                _blocks.resize(1);
-                _blocks[0]->used = 0;
+                // Keep the first block unless it references external memory.
+                if (_blocks[0]->storage == nullptr)
+                {
+                    _blocks.clear();
+                }
+                else
+                {
+                    _blocks.resize(1);
+                    _blocks[0]->used = 0;
+                }
             }
             _nextFreeId = Id::Invalid;
             _numFree = 0;
-            for (auto& bucket : _hashBuckets)
-            {
-                bucket.clear();
-            }
+            std::fill(_hashSlots.begin(), _hashSlots.end(), HashSlot{});
         }
 
         std::size_t size() const noexcept
@@ -191,106 +244,225 @@ namespace zasm
             return _entries.size() - _numFree;
         }
 
+        /// <summary>
+        /// Writes the live strings in id order, each string is length prefixed and null terminated.
+        /// The hash table is not stored, it is rebuilt when loading.
+        /// </summary>
         Error save(IStream& stream) const
         {
-            // Serialize entries.
-            const auto entryCount = static_cast<std::uint32_t>(_entries.size());
-            if (auto len = stream.write(&entryCount, sizeof(entryCount)); len == 0)
+            std::vector<char> buffer;
+            buffer.reserve(sizeof(CompactHeader) + size() * (sizeof(CompactString) + kAverageStringSize));
+
+            const auto append = [&](const void* data, std::size_t len) {
+                const auto* bytes = static_cast<const char*>(data);
+                buffer.insert(buffer.end(), bytes, bytes + len);
+            };
+
+            CompactHeader header{};
+            header.signature = kCompactSignature;
+            header.entryCount = static_cast<std::uint32_t>(_entries.size());
+            header.stringCount = static_cast<std::uint32_t>(size());
+            append(&header, sizeof(header));
+
+            for (std::size_t i = 0; i < _entries.size(); ++i)
+            {
+                const auto& entry = _entries[i];
+                if (entry.refCount <= 0)
+                {
+                    continue;
+                }
+
+                CompactString str{};
+                str.id = static_cast<std::uint32_t>(i);
+                str.refCount = entry.refCount;
+                str.len = entry.len;
+                append(&str, sizeof(str));
+
+                // Strings are stored null terminated.
+                append(getString(entry), entry.len + 1);
+            }
+
+            if (auto len = stream.write(buffer.data(), buffer.size()); len != buffer.size())
             {
                 return ErrorCode::InvalidParameter;
             }
 
-            for (const auto& entry : _entries)
+            return ErrorCode::None;
+        }
+
+        /// <summary>
+        /// Loads the strings from the stream, replaces the current contents on success.
+        /// Both the compact format and the legacy format of previous versions are supported.
+        /// </summary>
+        Error load(IStream& stream)
+        {
+            std::uint32_t signature{};
+            if (auto len = stream.read(&signature, sizeof(signature)); len == 0)
             {
-                if (auto len = stream.write(entry.hash); len == 0)
-                {
-                    return ErrorCode::InvalidParameter;
-                }
-                if (auto len = stream.write(entry.blockIndex); len == 0)
-                {
-                    return ErrorCode::InvalidParameter;
-                }
-                if (auto len = stream.write(entry.offsetInBlock); len == 0)
-                {
-                    return ErrorCode::InvalidParameter;
-                }
-                if (auto len = stream.write(entry.len); len == 0)
-                {
-                    return ErrorCode::InvalidParameter;
-                }
-                if (auto len = stream.write(entry.capacity); len == 0)
+                return ErrorCode::InvalidParameter;
+            }
+
+            if (signature != kCompactSignature)
+            {
+                // Legacy format, the first field is the entry count.
+                return loadLegacy(stream, signature);
+            }
+
+            CompactHeader header{};
+            header.signature = signature;
+            if (auto len = stream.read(&header.entryCount, sizeof(header.entryCount)); len == 0)
+            {
+                return ErrorCode::InvalidParameter;
+            }
+            if (auto len = stream.read(&header.stringCount, sizeof(header.stringCount)); len == 0)
+            {
+                return ErrorCode::InvalidParameter;
+            }
+            if (header.stringCount > header.entryCount)
+            {
+                return ErrorCode::InvalidParameter;
+            }
+
+            StringPool loaded;
+            loaded._entries.resize(header.entryCount);
+
+            std::uint32_t minId = 0;
+            for (std::uint32_t i = 0; i < header.stringCount; ++i)
+            {
+                CompactString str{};
+                if (auto len = stream.read(&str, sizeof(str)); len != sizeof(str))
                 {
                     return ErrorCode::InvalidParameter;
                 }
-                if (auto len = stream.write(entry.refCount); len == 0)
+                if (!isValidCompactString(str, minId, header.entryCount))
                 {
                     return ErrorCode::InvalidParameter;
                 }
-                if (auto len = stream.write(entry.nextFreeId); len == 0)
+                minId = str.id + 1;
+
+                auto& entry = loaded._entries[str.id];
+                auto* data = loaded.allocateString(entry, str.len + 1);
+                if (auto len = stream.read(data, str.len + 1); len != str.len + 1 || data[str.len] != '\0')
                 {
                     return ErrorCode::InvalidParameter;
                 }
+
+                entry.len = static_cast<StringSize>(str.len);
+                entry.refCount = str.refCount;
             }
 
-            // Serialize free entries.
-            if (auto len = stream.write(&_nextFreeId, sizeof(_nextFreeId)); len == 0)
+            loaded.finishCompactLoad();
+
+            *this = std::move(loaded);
+
+            return ErrorCode::None;
+        }
+
+        /// <summary>
+        /// Loads the strings from a buffer that holds data in the format written by save, for example
+        /// a memory mapped file. The strings are referenced and not copied so the buffer must remain valid
+        /// and unchanged for the lifetime of the pool or until it is cleared or loaded again.
+        /// </summary>
+        Error loadMapped(const void* data, std::size_t size)
+        {
+            if (data == nullptr || size < sizeof(CompactHeader) || size > std::numeric_limits<BlockOffset>::max())
             {
                 return ErrorCode::InvalidParameter;
             }
 
-            // Serialize hash buckets.
-            for (const auto& bucket : _hashBuckets)
-            {
-                const auto bucketSize = static_cast<std::uint32_t>(bucket.size());
-                if (auto len = stream.write(&bucketSize, sizeof(bucketSize)); len == 0)
-                {
-                    return ErrorCode::InvalidParameter;
-                }
-
-                for (const auto& id : bucket)
-                {
-                    if (auto len = stream.write(id); len == 0)
-                    {
-                        return ErrorCode::InvalidParameter;
-                    }
-                }
-            }
+            const auto* bytes = static_cast<const char*>(data);
 
-            // Serialize blocks.
-            const auto blockCount = static_cast<std::uint32_t>(_blocks.size());
-            if (auto len = stream.write(&blockCount, sizeof(blockCount)); len == 0)
+            CompactHeader header{};
+            std::memcpy(&header, bytes, sizeof(header));
+            if (header.signature != kCompactSignature || header.stringCount > header.entryCount)
             {
                 return ErrorCode::InvalidParameter;
             }
 
-            for (const auto& block : _blocks)
+            StringPool loaded;
+            loaded._entries.resize(header.entryCount);
+
+            auto block = std::make_unique<Block>();
+            block->data = bytes;
+            loaded._blocks.push_back(std::move(block));
+
+            std::size_t offset = sizeof(header);
+            std::uint32_t minId = 0;
+            for (std::uint32_t i = 0; i < header.stringCount; ++i)
             {
-                if (auto len = stream.write(block->index); len == 0)
+                if (size - offset < sizeof(CompactString))
                 {
                     return ErrorCode::InvalidParameter;
                 }
-                if (auto len = stream.write(block->used); len == 0)
+
+                CompactString str{};
+                std::memcpy(&str, bytes + offset, sizeof(str));
+                offset += sizeof(str);
+
+                if (!isValidCompactString(str, minId, header.entryCount))
                 {
                     return ErrorCode::InvalidParameter;
                 }
-                if (auto len = stream.write(block->data.data(), block->used); len == 0)
+                if (size - offset < str.len + 1 || bytes[offset + str.len] != '\0')
                 {
                     return ErrorCode::InvalidParameter;
                 }
+                minId = str.id + 1;
+
+                // Capacity stays zero, the entry gets its own storage when the id is reused.
+                auto& entry = loaded._entries[str.id];
+                entry.blockIndex = 0;
+                entry.offsetInBlock = static_cast<BlockOffset>(offset);
+                entry.len = static_cast<StringSize>(str.len);
+                entry.refCount = str.refCount;
+
+                offset += str.len + 1;
             }
 
+            loaded.finishCompactLoad();
+
+            *this = std::move(loaded);
+
             return ErrorCode::None;
         }
 
-        Error load(IStream& stream)
+    private:
+        template<typename TSelf>
+        static auto getEntry(TSelf&& self, Id stringId) noexcept
+            -> std::conditional_t<std::is_const_v<std::remove_reference_t<TSelf>>, const Entry*, Entry*>
         {
-            // Deserialize entries.
-            std::uint32_t entryCount{};
-            if (auto len = stream.read(&entryCount, sizeof(entryCount)); len == 0)
+            const auto idx = static_cast<std::size_t>(stringId);
+            if (idx >= self._entries.size())
             {
-                return ErrorCode::InvalidParameter;
+                return nullptr;
             }
 
+            const auto refCount = self._entries[idx].refCount;
+#ifndef IN_TESTS
+            assert(refCount > 0);
+#endif
+
+            if (refCount <= 0)
+            {
+                return nullptr;
+            }
+
+            return &self._entries[idx];
+        }
+
+        const char* getString(const Entry& entry) const noexcept
+        {
+            return _blocks[entry.blockIndex]->data + entry.offsetInBlock;
+        }
+
+        static bool isValidCompactString(const CompactString& str, std::uint32_t minId, std::uint32_t entryCount) noexcept
+        {
+            return str.id >= minId && str.id < entryCount && str.refCount > 0 && str.len < kMaxStringSize;
+        }
+
+        Error loadLegacy(IStream& stream, std::uint32_t entryCount)
+        {
+            // Deserialize entries.
             std::vector<Entry> loadedEntries;
             loadedEntries.resize(entryCount);
             for (auto& entry : loadedEntries)
@@ -332,10 +504,8 @@ namespace zasm
                 return ErrorCode::InvalidParameter;
             }
 
-            // Deserialize hash buckets.
-            auto hashBuckets = std::vector<std::vector<Id>>();
-            hashBuckets.resize(kMaxHashBuckets);
-            for (auto& bucket : hashBuckets)
+            // Skip the hash buckets, the hash table is rebuilt from the entries.
+            for (std::size_t bucketIndex = 0; bucketIndex < kSavedHashBuckets; ++bucketIndex)
             {
                 std::uint32_t bucketSize{};
                 if (auto len = stream.read(&bucketSize, sizeof(bucketSize)); len == 0)
@@ -343,9 +513,9 @@ namespace zasm
                     return ErrorCode::InvalidParameter;
                 }
 
-                bucket.resize(bucketSize);
-                for (auto& id : bucket)
+                for (std::uint32_t i = 0; i < bucketSize; ++i)
                 {
+                    Id id{};
                     if (auto len = stream.read(id); len == 0)
                     {
                         return ErrorCode::InvalidParameter;
@@ -364,17 +534,17 @@ namespace zasm
             blocks.resize(blockCount);
             for (auto& block : blocks)
             {
-                block = std::make_unique<Block>();
+                block = createBlock(0);
 
                 if (auto len = stream.read(block->index); len == 0)
                 {
                     return ErrorCode::InvalidParameter;
                 }
-                if (auto len = stream.read(block->used); len == 0)
+                if (auto len = stream.read(block->used); len == 0 || block->used > kBlockSize)
                 {
                     return ErrorCode::InvalidParameter;
                 }
-                if (auto len = stream.read(block->data.data(), block->used); len == 0)
+                if (auto len = stream.read(block->storage.get(), block->used); len == 0)
                 {
                     return ErrorCode::InvalidParameter;
                 }
@@ -382,7 +552,6 @@ namespace zasm
 
             // Swap state.
             _entries = std::move(loadedEntries);
-            _hashBuckets = std::move(hashBuckets);
             _blocks = std::move(blocks);
             _nextFreeId = nextFreeEntry;
 
@@ -394,66 +563,201 @@ namespace zasm
                 _numFree++;
             }
 
+            rebuildHashSlots();
+
             return ErrorCode::None;
         }
 
-    private:
-        template<typename TSelf>
-        static auto getEntry(TSelf&& self, Id stringId) noexcept
-            -> std::conditional_t<std::is_const_v<std::remove_reference_t<TSelf>>, const Entry*, Entry*>
+        void finishCompactLoad()
         {
-            const auto idx = static_cast<std::size_t>(stringId);
-            if (idx >= self._entries.size())
+            // Chain the unused ids into the free list, lowest id first.
+            _nextFreeId = Id::Invalid;
+            _numFree = 0;
+            for (auto i = _entries.size(); i-- > 0;)
             {
-                return nullptr;
+                auto& entry = _entries[i];
+                if (entry.refCount == 0)
+                {
+                    entry.nextFreeId = _nextFreeId;
+                    _nextFreeId = static_cast<Id>(i);
+                    _numFree++;
+                }
             }
 
-            const auto refCount = self._entries[idx].refCount;
-#ifndef IN_TESTS
-            assert(refCount > 0);
-#endif
+            rebuildHashSlots();
+        }
 
-            if (refCount <= 0)
+        // Rebuilds the hash table sized for the live strings, the hashes are recomputed
+        // as the data may have been saved with a different hash function.
+        void rebuildHashSlots()
+        {
+            _hashSlots.clear();
+            rehash(getHashSlotCount(size()));
+            for (std::size_t i = 0; i < _entries.size(); ++i)
             {
-                return nullptr;
+                auto& entry = _entries[i];
+                if (entry.refCount > 0)
+                {
+                    entry.hash = getHash(getString(entry), entry.len);
+                    insertHashSlot(getHashFragment(entry.hash), static_cast<Id>(i));
+                }
             }
-
-            return &self._entries[idx];
         }
 
         Id find_(const char* buf, std::size_t len, std::uint64_t hash) const noexcept
         {
-            const auto bucketIndex = hash % kMaxHashBuckets;
-            const auto& bucket = _hashBuckets[bucketIndex];
+            if (_hashSlots.empty())
+            {
+                return Id::Invalid;
+            }
 
-            // Find the lowest hash.
-            auto itLowest = std::lower_bound(bucket.begin(), bucket.end(), Id::Invalid, [&](Id id, Id) {
-                return _entries[static_cast<std::size_t>(id)].hash < hash;
-            });
+            const auto fragment = getHashFragment(hash);
+            const auto mask = _hashSlots.size() - 1;
 
-            // Iterate all matching hashes and compare the string.
-            for (auto it = itLowest; it != bucket.end(); ++it)
+            auto index = getHashSlotIndex(fragment);
+            for (std::size_t distance = 0;; ++distance)
             {
-                const auto id = *it;
-                const auto& entry = _entries[static_cast<std::size_t>(id)];
-                if (entry.hash != hash)
+                const auto& slot = _hashSlots[index];
+
+                // Robin hood invariant, the string would have been placed here if it exists.
+                if (slot.id == Id::Invalid || getProbeDistance(slot, index) < distance)
                 {
                     break;
                 }
 
-                if (entry.len != len)
+                if (slot.fragment == fragment)
                 {
-                    continue;
+                    const auto& entry = _entries[static_cast<std::size_t>(slot.id)];
+                    if (entry.hash == hash && entry.len == len)
+                    {
+                        if (isEqual(getString(entry), buf, len))
+                        {
+                            return slot.id;
+                        }
+                    }
+                }
+
+                index = (index + 1) & mask;
+            }
+
+            return Id::Invalid;
+        }
+
+        static constexpr std::uint32_t getHashFragment(std::uint64_t hash) noexcept
+        {
+            return static_cast<std::uint32_t>(hash ^ (hash >> 32));
+        }
+
+        std::size_t getHashSlotIndex(std::uint32_t fragment) const noexcept
+        {
+            // Fibonacci hashing, spreads the fragment over the upper bits to select the slot.
+            return static_cast<std::uint32_t>(fragment * 0x9E3779B9U) >> _hashShift;
+        }
+
+        std::size_t getProbeDistance(const HashSlot& slot, std::size_t index) const noexcept
+        {
+            return (index - getHashSlotIndex(slot.fragment)) & (_hashSlots.size() - 1);
+        }
+
+        // Maximum amount of strings the table can hold before it has to grow, 75% load factor.
+        static constexpr std::size_t getHashCapacity(std::size_t slotCount) noexcept
+        {
+            return slotCount - (slotCount / 4);
+        }
+
+        // Returns the power of two slot count to hold the specified amount of strings.
+        static constexpr std::size_t getHashSlotCount(std::size_t count) noexcept
+        {
+            std::size_t slotCount = kMinHashSlots;
+            while (getHashCapacity(slotCount) < count)
+            {
+                slotCount <<= 1;
+            }
+            return slotCount;
+        }
+
+        void rehash(std::size_t slotCount)
+        {
+            assert((slotCount & (slotCount - 1)) == 0);
+
+            auto oldSlots = std::move(_hashSlots);
+
+            _hashSlots.clear();
+            _hashSlots.resize(slotCount);
+
+            _hashShift = 32;
+            for (auto n = slotCount; n > 1; n >>= 1)
+            {
+                _hashShift--;
+            }
+
+            for (const auto& slot : oldSlots)
+            {
+                if (slot.id != Id::Invalid)
+                {
+                    insertHashSlot(slot.fragment, slot.id);
+                }
+            }
+        }
+
+        void insertHashSlot(std::uint32_t fragment, Id id) noexcept
+        {
+            const auto mask = _hashSlots.size() - 1;
+
+            HashSlot newSlot{ fragment, id };
+
+            auto index = getHashSlotIndex(fragment);
+            for (std::size_t distance = 0;; ++distance)
+            {
+                auto& slot = _hashSlots[index];
+                if (slot.id == Id::Invalid)
+                {
+                    slot = newSlot;
+                    return;
                 }
 
-                const auto* str = _blocks[entry.blockIndex]->data.data() + entry.offsetInBlock;
-                if (std::memcmp(str, buf, len) == 0)
+                // Take the slot from entries that are closer to their ideal slot.
+                const auto slotDistance = getProbeDistance(slot, index);
+                if (slotDistance < distance)
                 {
-                    return id;
+                    std::swap(slot, newSlot);
+                    distance = slotDistance;
                 }
+
+                index = (index + 1) & mask;
             }
+        }
 
-            return Id::Invalid;
+        void eraseHashSlot(std::uint32_t fragment, Id id) noexcept
+        {
+            const auto mask = _hashSlots.size() - 1;
+
+            auto index = getHashSlotIndex(fragment);
+            while (_hashSlots[index].id != id)
+            {
+                assert(_hashSlots[index].id != Id::Invalid);
+                index = (index + 1) & mask;
+            }
+
+            // Backward shift deletion, keeps the table free of tombstones.
+            auto nextIndex = (index + 1) & mask;
+            while (_hashSlots[nextIndex].id != Id::Invalid && getProbeDistance(_hashSlots[nextIndex], nextIndex) != 0)
+            {
+                _hashSlots[index] = _hashSlots[nextIndex];
+                index = nextIndex;
+                nextIndex = (nextIndex + 1) & mask;
+            }
+
+            _hashSlots[index] = HashSlot{};
+        }
+
+        static std::unique_ptr<Block> createBlock(BlockIndex index)
+        {
+            auto block = std::make_unique<Block>();
+            block->index = index;
+            block->storage = std::make_unique<char[]>(kBlockSize);
+            block->data = block->storage.get();
+            return block;
         }
 
         Block& getBlock(std::size_t len)
@@ -461,25 +765,40 @@ namespace zasm
             // If there are no blocks create a new one.
             if (_blocks.empty())
             {
-                _blocks.emplace_back(std::make_unique<Block>());
+                _blocks.emplace_back(createBlock(0));
                 return *_blocks.back();
             }
 
-            // See if the last block has enough space.
+            // See if the last block has enough space, blocks referencing external memory are never written.
             auto& lastBlock = *_blocks.back();
-            if (lastBlock.used + len < kBlockSize)
+            if (lastBlock.storage != nullptr && lastBlock.used + len < kBlockSize)
             {
                 return lastBlock;
             }
 
             // Create a new block.
-            auto newBlock = std::make_unique<Block>();
-            newBlock->index = static_cast<BlockIndex>(_blocks.size());
-            _blocks.emplace_back(std::move(newBlock));
+            _blocks.emplace_back(createBlock(static_cast<BlockIndex>(_blocks.size())));
 
             return *_blocks.back();
         }
 
+        // Assigns new storage to the entry and returns the pointer to write the string to.
+        char* allocateString(Entry& entry, std::size_t requiredLength)
+        {
+            // We align the capacity to 8 bytes.
+            const auto capacity = std::max<std::size_t>(kMinStringCapacity, (requiredLength + 7) & ~std::size_t{ 7 });
+
+            auto& block = getBlock(capacity);
+
+            entry.blockIndex = block.index;
+            entry.offsetInBlock = block.used;
+            entry.capacity = static_cast<StringSize>(capacity);
+
+            block.used += static_cast<std::uint32_t>(capacity);
+
+            return block.storage.get() + entry.offsetInBlock;
+        }
+
         Id getFreeEntry(std::size_t requiredLength)
         {
             if (_nextFreeId == Id::Invalid)
@@ -493,7 +812,8 @@ namespace zasm
             while (nextFreeId != Id::Invalid)
             {
                 const auto& entry = _entries[static_cast<std::size_t>(nextFreeId)];
-                if (entry.capacity >= requiredLength)
+                // Entries without capacity have no storage, they are given new storage when used.
+                if (entry.capacity >= requiredLength || entry.capacity == 0)
                 {
                     if (parentId != Id::Invalid)
                     {
@@ -543,21 +863,16 @@ namespace zasm
             const auto actualLength = static_cast<std::int32_t>(len);
             const auto requiredLength = static_cast<std::int32_t>(len) + 1;
 
-            const auto insertToHashBucket = [&](Entry& entry, Id id) {
-                const auto bucketIndex = entry.hash % kMaxHashBuckets;
-                auto& bucket = _hashBuckets[bucketIndex];
-
-                auto sortedIt = std::lower_bound(bucket.begin(), bucket.end(), id, [&](Id id, Id id2) {
-                    return _entries[static_cast<std::size_t>(id)].hash < _entries[static_cast<std::size_t>(id2)].hash;
-                });
-
-                bucket.insert(sortedIt, id);
-            };
+            // Grow the hash table before adding the new string.
+            if (size() + 1 > getHashCapacity(_hashSlots.size()))
+            {
+                rehash(getHashSlotCount(size() + 1));
+            }
 
-            const auto writeStringToBlock = [&](std::size_t blockOffset, Block& block) {
-                std::memcpy(block.data.data() + blockOffset, inputStr, actualLength);
+            const auto writeString = [&](char* dst) {
+                std::memcpy(dst, inputStr, actualLength);
                 // Ensure null termination.
-                block.data[blockOffset + actualLength] = '\0';
+                dst[actualLength] = '\0';
             };
 
             // Use empty entry if any exist.
@@ -568,46 +883,97 @@ namespace zasm
                 auto& entry = _entries[static_cast<std::size_t>(stringId)];
                 assert(entry.refCount == 0);
 
-                auto& block = _blocks[entry.blockIndex];
-                writeStringToBlock(entry.offsetInBlock, *block);
+                if (entry.capacity == 0)
+                {
+                    writeString(allocateString(entry, requiredLength));
+                }
+                else
+                {
+                    writeString(_blocks[entry.blockIndex]->storage.get() + entry.offsetInBlock);
+                }
 
                 entry.hash = hash;
                 entry.len = actualLength;
                 entry.refCount = 1;
                 entry.nextFreeId = Id::Invalid;
 
-                insertToHashBucket(entry, stringId);
+                insertHashSlot(getHashFragment(hash), stringId);
 
                 return stringId;
             }
 
             // New entry.
-
-            // We align the capacity to 8 bytes.
-            const auto capacity = std::max<std::int32_t>(kMinStringCapacity, (requiredLength + 7) & ~7);
-
-            auto& block = getBlock(capacity);
-            const auto offset = static_cast<std::int32_t>(block.used);
-
-            writeStringToBlock(offset, block);
-            block.used += capacity;
-
             stringId = static_cast<Id>(_entries.size());
 
             auto& entry = _entries.emplace_back();
+            writeString(allocateString(entry, requiredLength));
+
             entry.hash = hash;
-            entry.blockIndex = block.index;
-            entry.offsetInBlock = offset;
             entry.len = actualLength;
-            entry.capacity = capacity;
             entry.refCount = 1;
 
-            insertToHashBucket(entry, stringId);
+            insertHashSlot(getHashFragment(hash), stringId);
 
             return stringId;
         }
 
-        static constexpr std::uint64_t getHash(const char* buf, size_t len) noexcept
+        static std::uint64_t read64(const char* buf) noexcept
+        {
+            std::uint64_t res;
+            std::memcpy(&res, buf, sizeof(res));
+            return res;
+        }
+
+        static std::uint64_t read32(const char* buf) noexcept
+        {
+            std::uint32_t res;
+            std::memcpy(&res, buf, sizeof(res));
+            return res;
+        }
+
+        // Compares the strings in 16 byte chunks, the length is already known to be equal.
+        static bool isEqual(const char* a, const char* b, std::size_t len) noexcept
+        {
+            if (len >= 16)
+            {
+                std::size_t i = 0;
+                for (; i + 16 <= len; i += 16)
+                {
+                    const auto diff = (read64(a + i) ^ read64(b + i)) | (read64(a + i + 8) ^ read64(b + i + 8));
+                    if (diff != 0)
+                    {
+                        return false;
+                    }
+                }
+                if (i == len)
+                {
+                    return true;
+                }
+
+                // Overlapping compare of the last chunk.
+                const auto tail = len - 16;
+                return ((read64(a + tail) ^ read64(b + tail)) | (read64(a + tail + 8) ^ read64(b + tail + 8))) == 0;
+            }
+            if (len >= 8)
+            {
+                return ((read64(a) ^ read64(b)) | (read64(a + len - 8) ^ read64(b + len - 8))) == 0;
+            }
+            if (len >= 4)
+            {
+                return ((read32(a) ^ read32(b)) | (read32(a + len - 4) ^ read32(b + len - 4))) == 0;
+            }
+            for (std::size_t i = 0; i < len; ++i)
+            {
+                if (a[i] != b[i])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+#if ZASM_STRINGPOOL_LEGACY_HASH
+        static std::uint64_t getHash(const char* buf, size_t len) noexcept
         {
             assert(buf != nullptr);
             assert(len > 0);
@@ -629,6 +995,78 @@ namespace zasm
 
             return result;
         }
+#else
+        // 64x64 to 128 bit multiply, folds the high and low half.
+        static std::uint64_t hashMix(std::uint64_t a, std::uint64_t b) noexcept
+        {
+#    if defined(__SIZEOF_INT128__)
+            const auto res = static_cast<unsigned __int128>(a) * b;
+            return static_cast<std::uint64_t>(res) ^ static_cast<std::uint64_t>(res >> 64);
+#    else
+            const auto aLo = a & 0xFFFFFFFFULL;
+            const auto aHi = a >> 32;
+            const auto bLo = b & 0xFFFFFFFFULL;
+            const auto bHi = b >> 32;
+
+            const auto lolo = aLo * bLo;
+            const auto hilo = aHi * bLo;
+            const auto lohi = aLo * bHi;
+            const auto hihi = aHi * bHi;
+
+            const auto cross = (lolo >> 32) + (hilo & 0xFFFFFFFFULL) + lohi;
+            const auto hi = hihi + (hilo >> 32) + (cross >> 32);
+            const auto lo = (cross << 32) | (lolo & 0xFFFFFFFFULL);
+            return lo ^ hi;
+#    endif
+        }
+
+        // Word at a time hash in the style of wyhash, consumes 16 bytes per round.
+        static std::uint64_t getHash(const char* buf, size_t len) noexcept
+        {
+            assert(buf != nullptr);
+            assert(len > 0);
+
+            if (buf == nullptr || len == 0)
+            {
+                return 0;
+            }
+
+            constexpr std::uint64_t kSecret0 = 0xa0761d6478bd642fULL;
+            constexpr std::uint64_t kSecret1 = 0xe7037ed1a0b428dbULL;
+            constexpr std::uint64_t kSecret2 = 0x8ebc6af09c88c6e3ULL;
+
+            std::uint64_t seed = kSecret2;
+            std::uint64_t a;
+            std::uint64_t b;
+            if (len <= 16)
+            {
+                if (len >= 4)
+                {
+                    const auto mid = (len >> 3) << 2;
+                    a = (read32(buf) << 32) | read32(buf + mid);
+                    b = (read32(buf + len - 4) << 32) | read32(buf + len - 4 - mid);
+                }
+                else
+                {
+                    const auto* bytes = reinterpret_cast<const unsigned char*>(buf);
+                    a = (std::uint64_t{ bytes[0] } << 16) | (std::uint64_t{ bytes[len >> 1] } << 8) | bytes[len - 1];
+                    b = 0;
+                }
+            }
+            else
+            {
+                std::size_t i = 0;
+                for (; len - i > 16; i += 16)
+                {
+                    seed = hashMix(read64(buf + i) ^ kSecret1, read64(buf + i + 8) ^ seed);
+                }
+                a = read64(buf + len - 16);
+                b = read64(buf + len - 8);
+            }
+
+            return hashMix(kSecret1 ^ len, hashMix(a ^ kSecret1, b ^ seed) ^ kSecret0);
+        }
+#endif
     };
 
 } // namespace zasm
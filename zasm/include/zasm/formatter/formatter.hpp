@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <zasm/core/enumflags.hpp>
+#include <zasm/core/errors.hpp>
 
 namespace zasm
 {
@@ -10,7 +12,9 @@ namespace zasm
     class Node;
     class Instruction;
     class Reg;
-    
+    class IStream;
+    class Serializer;
+
 } // namespace zasm
 
 namespace zasm::formatter
@@ -70,9 +74,141 @@ namespace zasm::formatter
     /// <param name="options">Format options</param>
     std::string toString(const Instruction* instr, Options options = kDefaultOptions);
 
+    /// <summary>
+    /// Formats the range that was serialized by the serializer as a listing and results the text.
+    /// </summary>
+    /// <param name="program">The program that was serialized</param>
+    /// <param name="serializer">Serializer holding the result of the last serialize call</param>
+    /// <param name="options">Format options</param>
+    std::string toString(const Program& program, const Serializer& serializer, Options options = kDefaultOptions);
+
     /// <summary>
     /// Returns a formatted register name.
     /// </summary>
     std::string toString(const Reg& reg, Options options = kDefaultOptions);
 
+    /// <summary>
+    /// Formats the entire program and appends the text to the buffer. Reusing the
+    /// buffer across calls avoids allocating a new string each time.
+    /// </summary>
+    /// <param name="buffer">The buffer to append the text to</param>
+    /// <param name="program">The program to print as text</param>
+    /// <param name="options">Format options</param>
+    void format(std::string& buffer, const Program& program, Options options = kDefaultOptions);
+
+    /// <summary>
+    /// Formats a single node and appends the text to the buffer.
+    /// </summary>
+    /// <param name="buffer">The buffer to append the text to</param>
+    /// <param name="program">The program to print as text</param>
+    /// <param name="node">Formats only the specified node</param>
+    /// <param name="options">Format options</param>
+    void format(std::string& buffer, const Program& program, const Node* node, Options options = kDefaultOptions);
+
+    /// <summary>
+    /// Formats the specified range and appends the text to the buffer, 'to' is not inclusive.
+    /// </summary>
+    /// <param name="buffer">The buffer to append the text to</param>
+    /// <param name="program">The program to print as text</param>
+    /// <param name="nodeFrom">First node</param>
+    /// <param name="nodeTo">Last node</param>
+    /// <param name="options">Format options</param>
+    void format(
+        std::string& buffer, const Program& program, const Node* nodeFrom, const Node* nodeTo,
+        Options options = kDefaultOptions);
+
+    /// <summary>
+    /// Formats a single instruction and appends the text to the buffer.
+    /// </summary>
+    /// <param name="buffer">The buffer to append the text to</param>
+    /// <param name="program">The program to print as text</param>
+    /// <param name="instr">Instruction to format</param>
+    /// <param name="options">Format options</param>
+    void format(std::string& buffer, const Program& program, const Instruction* instr, Options options = kDefaultOptions);
+
+    /// <summary>
+    /// Formats the range that was serialized by the serializer as a listing and appends the text to the buffer.
+    /// Each line is prefixed with the address and the encoded bytes of the node, both are taken from the
+    /// serializer so nothing is encoded again. The program must not be modified after serialization.
+    /// </summary>
+    /// <param name="buffer">The buffer to append the text to</param>
+    /// <param name="program">The program that was serialized</param>
+    /// <param name="serializer">Serializer holding the result of the last serialize call</param>
+    /// <param name="options">Format options</param>
+    void format(std::string& buffer, const Program& program, const Serializer& serializer, Options options = kDefaultOptions);
+
+    /// <summary>
+    /// Formats the entire program and writes the text to the stream in chunks.
+    /// </summary>
+    /// <param name="stream">The stream to write the text to</param>
+    /// <param name="program">The program to print as text</param>
+    /// <param name="options">Format options</param>
+    /// <returns>ErrorCode::None on success, ErrorCode::InvalidParameter if the stream failed to write</returns>
+    Error format(IStream& stream, const Program& program, Options options = kDefaultOptions);
+
+    /// <summary>
+    /// Formats the specified range and writes the text to the stream in chunks, 'to' is not inclusive.
+    /// </summary>
+    /// <param name="stream">The stream to write the text to</param>
+    /// <param name="program">The program to print as text</param>
+    /// <param name="nodeFrom">First node</param>
+    /// <param name="nodeTo">Last node</param>
+    /// <param name="options">Format options</param>
+    /// <returns>ErrorCode::None on success, ErrorCode::InvalidParameter if the stream failed to write</returns>
+    Error format(
+        IStream& stream, const Program& program, const Node* nodeFrom, const Node* nodeTo, Options options = kDefaultOptions);
+
+    /// <summary>
+    /// Formats the entire program using multiple threads and appends the text to the buffer.
+    /// The output is identical to format, the program must not be modified while formatting.
+    /// </summary>
+    /// <param name="buffer">The buffer to append the text to</param>
+    /// <param name="program">The program to print as text</param>
+    /// <param name="options">Format options</param>
+    /// <param name="numThreads">Number of threads to use, 0 uses the number of hardware threads</param>
+    void formatParallel(
+        std::string& buffer, const Program& program, Options options = kDefaultOptions, std::size_t numThreads = 0);
+
+    /// <summary>
+    /// Formats the specified range using multiple threads and appends the text to the buffer, 'to' is not inclusive.
+    /// The range is split into chunks of nodes, each chunk is formatted on a worker and the results are
+    /// concatenated in order.
+    /// </summary>
+    /// <param name="buffer">The buffer to append the text to</param>
+    /// <param name="program">The program to print as text</param>
+    /// <param name="nodeFrom">First node</param>
+    /// <param name="nodeTo">Last node</param>
+    /// <param name="options">Format options</param>
+    /// <param name="numThreads">Number of threads to use, 0 uses the number of hardware threads</param>
+    void formatParallel(
+        std::string& buffer, const Program& program, const Node* nodeFrom, const Node* nodeTo,
+        Options options = kDefaultOptions, std::size_t numThreads = 0);
+
+    /// <summary>
+    /// Formats the entire program using multiple threads and writes the text to the stream in order.
+    /// Only a bounded amount of chunks is kept in memory at once.
+    /// </summary>
+    /// <param name="stream">The stream to write the text to, ex.: FileStream</param>
+    /// <param name="program">The program to print as text</param>
+    /// <param name="options">Format options</param>
+    /// <param name="numThreads">Number of threads to use, 0 uses the number of hardware threads</param>
+    /// <returns>ErrorCode::None on success, ErrorCode::InvalidParameter if the stream failed to write</returns>
+    Error formatParallel(
+        IStream& stream, const Program& program, Options options = kDefaultOptions, std::size_t numThreads = 0);
+
+    /// <summary>
+    /// Formats the specified range using multiple threads and writes the text to the stream in order,
+    /// 'to' is not inclusive.
+    /// </summary>
+    /// <param name="stream">The stream to write the text to, ex.: FileStream</param>
+    /// <param name="program">The program to print as text</param>
+    /// <param name="nodeFrom">First node</param>
+    /// <param name="nodeTo">Last node</param>
+    /// <param name="options">Format options</param>
+    /// <param name="numThreads">Number of threads to use, 0 uses the number of hardware threads</param>
+    /// <returns>ErrorCode::None on success, ErrorCode::InvalidParameter if the stream failed to write</returns>
+    Error formatParallel(
+        IStream& stream, const Program& program, const Node* nodeFrom, const Node* nodeTo, Options options = kDefaultOptions,
+        std::size_t numThreads = 0);
+
 } // namespace zasm::formatter
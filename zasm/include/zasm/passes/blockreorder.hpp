@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <zasm/base/label.hpp>
+#include <zasm/core/errors.hpp>
+
+namespace zasm
+{
+    class Program;
+
+    namespace detail
+    {
+        struct BlockReorderState;
+    }
+
+    struct BlockReorderStats
+    {
+        std::size_t blocks{};
+        // Blocks that are placed at a different position relative to the block before them.
+        std::size_t blocksMoved{};
+        std::size_t coldBlocks{};
+        std::size_t branchesInverted{};
+        std::size_t jumpsInserted{};
+        std::size_t jumpsRemoved{};
+        // Sum of the weights of the edges that fall through before and after the reordering.
+        std::uint64_t fallthroughWeightBefore{};
+        std::uint64_t fallthroughWeightAfter{};
+    };
+
+    /// <summary>
+    /// Reorders the basic blocks of a program so the frequently taken edges fall through. The weights
+    /// are execution counts of the blocks that start with a label, blocks without a weight inherit it
+    /// from the block that falls into them. Chains are formed greedily from the heaviest edges in the
+    /// style of Pettis-Hansen, the first block of the program stays in place.
+    /// Conditional branches are inverted and jumps are inserted or removed to keep the control flow,
+    /// the result is verified against the control flow graph of the original program.
+    /// Only the nodes before the first section node are reordered. Programs using loop or jcxz style
+    /// branches are left unchanged since those only have an 8 bit displacement.
+    /// </summary>
+    class BlockReordering
+    {
+        detail::BlockReorderState* _state{};
+
+    public:
+        explicit BlockReordering(Program& program);
+        BlockReordering(const BlockReordering&) = delete;
+        BlockReordering(BlockReordering&&) = delete;
+        ~BlockReordering();
+
+        BlockReordering& operator=(const BlockReordering&) = delete;
+        BlockReordering& operator=(BlockReordering&&) = delete;
+
+        /// <summary>
+        /// Sets the execution count of the block that starts with the label.
+        /// </summary>
+        void setWeight(const Label& label, std::uint64_t weight);
+
+        /// <summary>
+        /// Removes all weights.
+        /// </summary>
+        void clearWeights() noexcept;
+
+        /// <summary>
+        /// Enables moving the blocks with a weight less or equal to the threshold into a new section named
+        /// ".text.cold" at the end of the program. This is disabled by default.
+        /// </summary>
+        void setSplitColdBlocks(bool enable, std::uint64_t threshold = 0) noexcept;
+
+        /// <summary>
+        /// Reorders the blocks. The successors of every block are verified after the program was modified,
+        /// a failed verification indicates a bug in the pass and the program is left in the reordered state
+        /// including the inserted jumps and the cold section, it should be discarded.
+        /// </summary>
+        /// <returns>ErrorCode::None on success, ErrorCode::InvalidOperation if the verification failed</returns>
+        Error run();
+
+        /// <summary>
+        /// Returns the statistics of the last run.
+        /// </summary>
+        const BlockReorderStats& getStats() const noexcept;
+    };
+
+} // namespace zasm
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <zasm/base/label.hpp>
+#include <zasm/core/errors.hpp>
+
+namespace zasm
+{
+    class Program;
+
+    namespace detail
+    {
+        struct DeadCodeState;
+    }
+
+    struct DeadCodeStats
+    {
+        // Total amount of destroyed nodes.
+        std::size_t nodesRemoved{};
+        std::size_t instructionsRemoved{};
+        // Data and embedded label nodes.
+        std::size_t dataRemoved{};
+        std::size_t labelsRemoved{};
+        // Amount of entries removed from the label table by the compaction.
+        std::size_t labelsCompacted{};
+    };
+
+    /// <summary>
+    /// Removes the nodes that can not be reached from the roots and the label nodes that are not
+    /// referenced. The roots are the entry point, the labels added with addRoot and by default all named
+    /// labels, without an entry point the first node of the program is a root as well.
+    /// A node is reachable if control flow falls into it from a reachable node or a reachable node
+    /// references a label bound before it, references by embedded labels and memory operands count.
+    /// Control flow does not fall into a section node, a section at the head of the program is walked
+    /// when the head is a root.
+    /// Section and sentinel nodes are always kept. The unreachable nodes are destroyed in ranges so
+    /// observers are notified once per range.
+    /// </summary>
+    class DeadCodeElimination
+    {
+        detail::DeadCodeState* _state{};
+
+    public:
+        explicit DeadCodeElimination(Program& program);
+        DeadCodeElimination(const DeadCodeElimination&) = delete;
+        DeadCodeElimination(DeadCodeElimination&&) = delete;
+        ~DeadCodeElimination();
+
+        DeadCodeElimination& operator=(const DeadCodeElimination&) = delete;
+        DeadCodeElimination& operator=(DeadCodeElimination&&) = delete;
+
+        /// <summary>
+        /// Adds a label that is used from outside of the program, such as an exported function.
+        /// </summary>
+        void addRoot(const Label& label);
+
+        /// <summary>
+        /// Removes all labels added with addRoot.
+        /// </summary>
+        void clearRoots() noexcept;
+
+        /// <summary>
+        /// Sets if named labels are roots, this is enabled by default.
+        /// </summary>
+        void setKeepNamedLabels(bool enable) noexcept;
+
+        /// <summary>
+        /// Sets if reachable label nodes without references are removed, this is enabled by default.
+        /// </summary>
+        void setRemoveUnreferencedLabels(bool enable) noexcept;
+
+        /// <summary>
+        /// Sets if the label table of the program is compacted after the removal, this is disabled by
+        /// default. Labels without a node and without references are removed and the remaining labels
+        /// get new ids, all references within the program and the roots are updated.
+        /// Label objects held outside of the program become invalid.
+        /// </summary>
+        void setCompactLabels(bool enable) noexcept;
+
+        /// <summary>
+        /// Runs the pass over the program.
+        /// </summary>
+        /// <returns>ErrorCode::None on success</returns>
+        Error run();
+
+        /// <summary>
+        /// Returns the statistics of the last run.
+        /// </summary>
+        const DeadCodeStats& getStats() const noexcept;
+    };
+
+} // namespace zasm
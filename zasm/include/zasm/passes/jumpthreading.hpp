@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <zasm/core/errors.hpp>
+
+namespace zasm
+{
+    class Program;
+
+    namespace detail
+    {
+        struct JumpThreadingState;
+    }
+
+    struct JumpThreadingStats
+    {
+        // Amount of jumps and conditional branches that now target the final destination of a chain.
+        std::size_t branchesRetargeted{};
+        // Amount of unreachable unconditional jumps that were removed.
+        std::size_t trampolinesRemoved{};
+    };
+
+    /// <summary>
+    /// Retargets jumps and conditional branches whose target label is directly followed by an
+    /// unconditional jump to a label, so the branch goes to the final destination in one step.
+    /// Jumps that become unreachable are removed, the label nodes are kept in place.
+    /// Running this before the serializer shortens the branch distances so more of them are encoded
+    /// with 8 bit displacements.
+    /// </summary>
+    class JumpThreading
+    {
+        detail::JumpThreadingState* _state{};
+
+    public:
+        explicit JumpThreading(Program& program);
+        JumpThreading(const JumpThreading&) = delete;
+        JumpThreading(JumpThreading&&) = delete;
+        ~JumpThreading();
+
+        JumpThreading& operator=(const JumpThreading&) = delete;
+        JumpThreading& operator=(JumpThreading&&) = delete;
+
+        /// <summary>
+        /// Sets if unreachable jumps are removed, this is enabled by default. A jump is unreachable when
+        /// it follows an instruction that does not fall through and all labels in between are not
+        /// referenced, not named and not the entry point.
+        /// </summary>
+        void setRemoveTrampolines(bool enable) noexcept;
+
+        /// <summary>
+        /// Runs the pass over the program.
+        /// </summary>
+        /// <returns>ErrorCode::None on success</returns>
+        Error run();
+
+        /// <summary>
+        /// Returns the statistics of the last run.
+        /// </summary>
+        const JumpThreadingStats& getStats() const noexcept;
+    };
+
+} // namespace zasm
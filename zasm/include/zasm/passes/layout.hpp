@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <zasm/core/errors.hpp>
+
+namespace zasm
+{
+    class Program;
+    class Serializer;
+
+    namespace detail
+    {
+        struct LayoutState;
+    }
+
+    struct LayoutStats
+    {
+        // Labels that are the target of a backward branch.
+        std::size_t loopHeads{};
+        // Loop heads that received a new or larger alignment.
+        std::size_t loopsAligned{};
+        // Loop heads not aligned because the padding would lie between a loop or jcxz branch and its target.
+        std::size_t loopsSkipped{};
+        // Branches moved to the next 32 byte boundary to avoid the JCC erratum.
+        std::size_t branchesPadded{};
+        // Branches that would have needed padding but exceeded the budget or the padding would lie
+        // between a loop or jcxz branch and its target.
+        std::size_t branchesSkipped{};
+        std::size_t codeSizeBefore{};
+        std::size_t codeSizeAfter{};
+    };
+
+    /// <summary>
+    /// Inserts code alignment into the program based on the node addresses of the serializer.
+    /// Loop heads, labels that are targeted by a branch located after them, are aligned so the loop
+    /// body starts at the beginning of a fetch block. Optionally branches that cross or end on a
+    /// 32 byte boundary are moved to the next boundary, this avoids the penalty of the microcode
+    /// update for the JCC erratum on Intel CPUs. The padding uses the NOP style of the serializer.
+    /// No padding is inserted between a branch that only has a rel8 form, such as loop or jcxz, and its
+    /// target.
+    /// </summary>
+    class LayoutOptimizer
+    {
+        detail::LayoutState* _state{};
+
+    public:
+        explicit LayoutOptimizer(Program& program);
+        LayoutOptimizer(const LayoutOptimizer&) = delete;
+        LayoutOptimizer(LayoutOptimizer&&) = delete;
+        ~LayoutOptimizer();
+
+        LayoutOptimizer& operator=(const LayoutOptimizer&) = delete;
+        LayoutOptimizer& operator=(LayoutOptimizer&&) = delete;
+
+        /// <summary>
+        /// Sets the alignment of loop heads in bytes, must be a power of two. The default is 32, passing 0
+        /// disables the loop alignment.
+        /// </summary>
+        /// <returns>ErrorCode::InvalidParameter if the alignment is not a power of two</returns>
+        Error setLoopAlignment(std::uint32_t align) noexcept;
+
+        /// <summary>
+        /// Loop heads that require more padding than this are not aligned, by default there is no limit.
+        /// </summary>
+        void setMaxLoopPadding(std::uint32_t maxPadding) noexcept;
+
+        /// <summary>
+        /// Enables moving branches, calls and returns that cross or end on a 32 byte boundary, a compare
+        /// or test directly before a conditional branch is moved together with it since the pair is
+        /// macro-fused. This is disabled by default.
+        /// </summary>
+        void setAvoidJccErratum(bool enable) noexcept;
+
+        /// <summary>
+        /// Limits the amount of padding in bytes inserted for the JCC erratum, by default there is no limit.
+        /// </summary>
+        void setPaddingBudget(std::size_t budget) noexcept;
+
+        /// <summary>
+        /// Serializes the program with the given serializer, inserts the alignment and serializes it again.
+        /// On success the serializer holds the final code.
+        /// </summary>
+        /// <param name="serializer">The serializer used for the node addresses</param>
+        /// <param name="newBase">Virtual base address at where the code starts</param>
+        /// <returns>ErrorCode::None on success, otherwise the error of the serializer</returns>
+        Error run(Serializer& serializer, std::int64_t newBase);
+
+        /// <summary>
+        /// Returns the statistics of the last run.
+        /// </summary>
+        const LayoutStats& getStats() const noexcept;
+    };
+
+} // namespace zasm
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <zasm/base/meta.hpp>
+#include <zasm/base/mode.hpp>
+#include <zasm/core/errors.hpp>
+#include <zasm/program/instruction.hpp>
+
+namespace zasm
+{
+    class Node;
+    class Program;
+
+    namespace detail
+    {
+        struct PeepholeState;
+    }
+
+    class PeepholeContext;
+
+    /// <summary>
+    /// Function of a peephole rule, called for every instruction with the mnemonic of the rule.
+    /// The rule must only modify the program through the context.
+    /// </summary>
+    /// <returns>True if the program was modified</returns>
+    using PeepholeRuleFn = bool (*)(PeepholeContext& ctx, Node* node);
+
+    struct PeepholeRule
+    {
+        const char* name{};
+        InstrMnemonic mnemonic{};
+        PeepholeRuleFn apply{};
+    };
+
+    struct PeepholeStats
+    {
+        // Amount of scans over the program, the last round made no changes unless the limit was reached.
+        std::size_t rounds{};
+        std::size_t instructionsRemoved{};
+        std::size_t instructionsInserted{};
+        // Estimated from the encoded size of the removed and inserted instructions.
+        std::int64_t bytesSaved{};
+        // Amount of times each rule was applied, in the order the rules were added.
+        std::vector<std::size_t> ruleHits;
+    };
+
+    /// <summary>
+    /// Passed to the rules, provides the flag liveness and keeps the statistics and the scan position
+    /// valid when nodes are removed.
+    /// </summary>
+    class PeepholeContext
+    {
+        friend class PeepholeOptimizer;
+
+        detail::PeepholeState* _state{};
+
+        explicit PeepholeContext(detail::PeepholeState* state) noexcept
+            : _state{ state }
+        {
+        }
+
+    public:
+        Program& getProgram() const noexcept;
+
+        MachineMode getMode() const noexcept;
+
+        /// <summary>
+        /// Returns the flags that may be read after the node executes. The liveness is computed at the
+        /// start of each round, all flags are live for nodes inserted during the round.
+        /// </summary>
+        InstrCPUFlags getLiveFlags(const Node* node) const noexcept;
+
+        /// <summary>
+        /// Destroys the instruction node.
+        /// </summary>
+        void remove(Node* node);
+
+        /// <summary>
+        /// Replaces the instruction node with a new instruction.
+        /// </summary>
+        /// <returns>The new node</returns>
+        Node* replace(Node* node, const Instruction& instr);
+    };
+
+    /// <summary>
+    /// Peephole optimizer over the instructions of a Program. Rules are looked up by the mnemonic of
+    /// each instruction, every round is a single scan over the program and rounds are repeated until
+    /// no rule applies or the round limit is reached.
+    /// </summary>
+    class PeepholeOptimizer
+    {
+        detail::PeepholeState* _state{};
+
+    public:
+        explicit PeepholeOptimizer(Program& program);
+        PeepholeOptimizer(const PeepholeOptimizer&) = delete;
+        PeepholeOptimizer(PeepholeOptimizer&&) = delete;
+        ~PeepholeOptimizer();
+
+        PeepholeOptimizer& operator=(const PeepholeOptimizer&) = delete;
+        PeepholeOptimizer& operator=(PeepholeOptimizer&&) = delete;
+
+        /// <summary>
+        /// Adds the rule, rules for the same mnemonic are tried in the order they were added.
+        /// </summary>
+        void addRule(const PeepholeRule& rule);
+
+        /// <summary>
+        /// Adds the built-in rules:
+        /// - mov reg, reg with the same register, except 32 bit registers in 64 bit mode.
+        /// - add/sub reg, 0 when none of the flags are live, except 32 bit registers in 64 bit mode. Flags are
+        ///   considered live when control leaves the program other than by a return.
+        /// - push reg directly followed by pop of the same register.
+        /// - jmp to a label that directly follows the jump.
+        /// </summary>
+        void addDefaultRules();
+
+        void clearRules() noexcept;
+
+        std::size_t getRuleCount() const noexcept;
+
+        const PeepholeRule& getRule(std::size_t index) const noexcept;
+
+        /// <summary>
+        /// Sets the maximum amount of rounds, the default is 16.
+        /// </summary>
+        void setMaxRounds(std::size_t maxRounds) noexcept;
+
+        /// <summary>
+        /// Runs the rules over the program until no rule applies.
+        /// </summary>
+        /// <returns>ErrorCode::None on success</returns>
+        Error run();
+
+        /// <summary>
+        /// Returns the statistics of the last run.
+        /// </summary>
+        const PeepholeStats& getStats() const noexcept;
+    };
+
+} // namespace zasm
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <zasm/base/meta.hpp>
+#include <zasm/core/errors.hpp>
+
+namespace zasm
+{
+    class Program;
+
+    namespace detail
+    {
+        struct SchedulerState;
+    }
+
+    struct SchedulerStats
+    {
+        // Straight-line instruction sequences that were considered.
+        std::size_t regions{};
+        // Regions that got a new order.
+        std::size_t regionsScheduled{};
+        std::size_t instructionsMoved{};
+        // Estimated cycles of all regions using the latency model.
+        std::uint64_t cyclesBefore{};
+        std::uint64_t cyclesAfter{};
+    };
+
+    /// <summary>
+    /// List scheduler for the straight-line instruction sequences within basic blocks. The dependencies
+    /// are built from the register and flag access of each instruction, memory accesses are never
+    /// reordered against stores. Instructions are picked by their critical path length using a simple
+    /// latency model per instruction category, ties keep the original order so the result is deterministic.
+    /// A region only gets a new order if the estimated cycles are lower.
+    /// Labels, non-instruction nodes, branches, traps and serializing instructions are never moved and end
+    /// the region. Nodes are moved with Program::moveBefore and Program::moveAfter so observers are not notified.
+    /// </summary>
+    class InstructionScheduler
+    {
+        detail::SchedulerState* _state{};
+
+    public:
+        explicit InstructionScheduler(Program& program);
+        InstructionScheduler(const InstructionScheduler&) = delete;
+        InstructionScheduler(InstructionScheduler&&) = delete;
+        ~InstructionScheduler();
+
+        InstructionScheduler& operator=(const InstructionScheduler&) = delete;
+        InstructionScheduler& operator=(InstructionScheduler&&) = delete;
+
+        /// <summary>
+        /// Sets the latency in cycles of the instructions of the category. By default integer instructions
+        /// take 1 cycle and vector and floating point instructions 4 cycles, multiplications take 3 cycles and
+        /// divisions 20 cycles.
+        /// </summary>
+        void setLatency(InstrCategory category, std::uint32_t latency) noexcept;
+
+        /// <summary>
+        /// Sets the additional latency of instructions that read memory, the default is 4 cycles.
+        /// </summary>
+        void setLoadLatency(std::uint32_t latency) noexcept;
+
+        /// <summary>
+        /// Sets the maximum amount of instructions scheduled at once, longer sequences are split.
+        /// The default is 128.
+        /// </summary>
+        void setMaxRegionSize(std::size_t size) noexcept;
+
+        /// <summary>
+        /// Runs the pass over the program.
+        /// </summary>
+        /// <returns>ErrorCode::None on success</returns>
+        Error run();
+
+        /// <summary>
+        /// Returns the statistics of the last run.
+        /// </summary>
+        const SchedulerStats& getStats() const noexcept;
+    };
+
+} // namespace zasm
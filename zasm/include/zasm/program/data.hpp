@@ -5,6 +5,8 @@
 #include <cstdint>
 #include <cstring>
 #include <limits>
+#include <zasm/core/errors.hpp>
+#include <zasm/core/expected.hpp>
 
 namespace zasm
 {
@@ -13,10 +15,13 @@ namespace zasm
     {
         static constexpr std::size_t kInlineStorageSize = 32;
         static constexpr std::size_t kInlineDataFlag = std::size_t{ 1U } << (std::numeric_limits<std::size_t>::digits - 1);
+        static constexpr std::size_t kExternalDataFlag = std::size_t{ 1U } << (std::numeric_limits<std::size_t>::digits - 2);
+        static constexpr std::size_t kSharedDataFlag = std::size_t{ 1U } << (std::numeric_limits<std::size_t>::digits - 3);
+        static constexpr std::size_t kStorageMask = kInlineDataFlag | kExternalDataFlag | kSharedDataFlag;
 
     private:
-        // NOTE: The highest bit is used to determine if we have inline data or
-        // use the heap, getSize() will mask this out.
+        // NOTE: The highest bits are used to determine where the data is stored, inline, on the heap,
+        // external memory or a shared buffer, getSize() will mask this out.
         std::size_t _size{};
         std::size_t _repeatCount{ 1 };
 
@@ -24,6 +29,7 @@ namespace zasm
         union
         {
             void* ptr;
+            const void* externalPtr;
             std::uint8_t u8;
             std::uint16_t u16;
             std::uint32_t u32;
@@ -37,6 +43,8 @@ namespace zasm
             return (_size & kInlineDataFlag) != 0;
         }
 
+        void release() noexcept;
+
     public:
         constexpr Data() noexcept = default;
 
@@ -73,6 +81,40 @@ namespace zasm
         Data(Data&& other) noexcept;
         ~Data();
 
+        /// <summary>
+        /// Creates data that references the memory without copying it. The memory is owned by the
+        /// caller and must stay valid for as long as this data or any copy of it is in use.
+        /// </summary>
+        /// <param name="ptr">Pointer to the data</param>
+        /// <param name="len">Size in bytes of the data</param>
+        static Data external(const void* ptr, std::size_t len) noexcept;
+
+        /// <summary>
+        /// Creates data that holds a single copy of the memory in a reference counted buffer, copies
+        /// of the data share the buffer instead of duplicating it. This allows to embed the same large
+        /// blob in multiple nodes or programs, small data is stored inline.
+        /// </summary>
+        /// <param name="ptr">Pointer to the data</param>
+        /// <param name="len">Size in bytes of the data</param>
+        /// <returns>The data or ErrorCode::OutOfMemory if the buffer could not be allocated</returns>
+        static Expected<Data, Error> shared(const void* ptr, std::size_t len) noexcept;
+
+        /// <summary>
+        /// Returns true if the data references memory owned by someone else, see external.
+        /// </summary>
+        constexpr bool isExternal() const noexcept
+        {
+            return (_size & kExternalDataFlag) != 0;
+        }
+
+        /// <summary>
+        /// Returns true if the data is held by a reference counted buffer, see shared.
+        /// </summary>
+        constexpr bool isShared() const noexcept
+        {
+            return (_size & kSharedDataFlag) != 0;
+        }
+
         /// <summary>
         /// Returns a pointer to the current data held.
         /// </summary>
@@ -109,7 +151,8 @@ namespace zasm
 
         constexpr bool operator==(const Data& other) const noexcept
         {
-            if (_size != other._size)
+            // Compares the contents regardless of where the data is stored.
+            if ((_size & ~kStorageMask) != (other._size & ~kStorageMask))
             {
                 return false;
             }
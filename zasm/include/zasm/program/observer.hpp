@@ -1,9 +1,9 @@
 #pragma once
 
+#include "node.hpp"
+
 namespace zasm
 {
-    class Node;
-
     /// <summary>
     /// Observer interface to be implemented by classes that want to be notified of changes in the Program.
     /// </summary>
@@ -28,6 +28,24 @@ namespace zasm
         {
         }
 
+        /// <summary>
+        /// This is called before a range of nodes is destroyed with Program::destroy, the nodes are still
+        /// linked. The default implementation calls onNodeDestroy for each node.
+        /// </summary>
+        /// <param name="first">First node of the range</param>
+        /// <param name="last">Last node of the range, inclusive</param>
+        virtual void onNodesDestroy(Node* first, Node* last)
+        {
+            for (auto* node = first;; node = node->getNext())
+            {
+                onNodeDestroy(node);
+                if (node == last)
+                {
+                    break;
+                }
+            }
+        }
+
         /// <summary>
         /// This is called before a node is detached.
         /// </summary>
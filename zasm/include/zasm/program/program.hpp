@@ -22,6 +22,7 @@ namespace zasm
     }
 
     class Observer;
+    class ConcurrentStringPool;
 
     class Program
     {
@@ -153,6 +154,14 @@ namespace zasm
         /// <param name="node">The node to destroy</param>
         void destroy(Node* node);
 
+        /// <summary>
+        /// Destroys all nodes from first to last, the range is unlinked at once and observers are notified
+        /// once with Observer::onNodesDestroy instead of once per node.
+        /// </summary>
+        /// <param name="first">First node of the range</param>
+        /// <param name="last">Last node of the range, inclusive, must follow or be equal to first</param>
+        void destroy(Node* first, Node* last);
+
         /// <summary>
         /// Returns the current amount of nodes in the list.
         /// </summary>
@@ -177,6 +186,21 @@ namespace zasm
         /// <returns>Label</returns>
         Label getEntryPoint() const noexcept;
 
+        /// <summary>
+        /// Uses the specified pool to store the names of labels and sections, this allows many programs
+        /// to share the same names across threads. The pool must outlive the program. The pool can only
+        /// be changed while the program has no labels and sections. Passing nullptr switches back to the
+        /// own pool of the program. Loading a saved program always uses the own pool.
+        /// </summary>
+        /// <param name="pool">Shared pool or nullptr</param>
+        /// <returns>ErrorCode::InvalidOperation if the program already has labels or sections</returns>
+        Error setSymbolPool(ConcurrentStringPool* pool);
+
+        /// <summary>
+        /// Returns the shared pool set with setSymbolPool or nullptr if the program uses its own pool.
+        /// </summary>
+        ConcurrentStringPool* getSymbolPool() const noexcept;
+
         /// <summary>
         /// Looks for a node with the specified id in the program and returns it.
         /// </summary>
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <zasm/base/mode.hpp>
+#include <zasm/base/regset.hpp>
+#include <zasm/program/instruction.hpp>
+
+namespace zasm
+{
+    /// <summary>
+    /// Registers and flags accessed by a single instruction, registers are normalized to their root.
+    /// </summary>
+    struct RegAccess
+    {
+        // Registers that may be read, this includes registers used for memory addressing.
+        RegSet read;
+        // Registers that may be written.
+        RegSet write;
+        // Registers that are always overwritten as a whole, partial and conditional writes are not included.
+        RegSet kill;
+        // Flags that are tested by the instruction.
+        InstrCPUFlags flagsRead{};
+        // Flags that are modified, set, cleared or left undefined by the instruction.
+        InstrCPUFlags flagsWrite{};
+    };
+
+    namespace detail
+    {
+        inline bool isFullRegWrite(const Reg& reg, MachineMode mode) noexcept
+        {
+            // Writing a 32 bit general purpose register zero extends into the 64 bit register.
+            if (mode == MachineMode::AMD64 && reg.isGp32())
+            {
+                return true;
+            }
+            const auto root = reg.getRoot(mode);
+            return !root.isValid() || root.getBitSize(mode) == reg.getBitSize(mode);
+        }
+
+        inline void addMemRegs(RegSet& regs, const Mem& mem, MachineMode mode) noexcept
+        {
+            regs.add(mem.getSegment(), mode);
+            regs.add(mem.getBase(), mode);
+            regs.add(mem.getIndex(), mode);
+        }
+
+    } // namespace detail
+
+    /// <summary>
+    /// Builds the register and flag access sets from the operand access and CPU flags of the instruction.
+    /// </summary>
+    /// <param name="instr">Instruction detail</param>
+    /// <param name="mode">Machine mode used to normalize the registers</param>
+    /// <returns>RegAccess</returns>
+    inline RegAccess getRegAccess(const InstructionDetail& instr, MachineMode mode) noexcept
+    {
+        RegAccess res{};
+
+        const auto& access = instr.getOperandsAccess();
+        for (std::size_t i = 0; i < instr.getOperandCount(); ++i)
+        {
+            const auto& op = instr.getOperand(i);
+            const auto opAccess = access.get(i);
+
+            if (const auto* reg = op.getIf<Reg>(); reg != nullptr)
+            {
+                if ((opAccess & Operand::Access::MaskRead) != Operand::Access::None)
+                {
+                    res.read.add(*reg, mode);
+                }
+                if ((opAccess & Operand::Access::MaskWrite) != Operand::Access::None)
+                {
+                    res.write.add(*reg, mode);
+                }
+                if ((opAccess & Operand::Access::Write) != Operand::Access::None && detail::isFullRegWrite(*reg, mode))
+                {
+                    res.kill.add(*reg, mode);
+                }
+            }
+            else if (const auto* mem = op.getIf<Mem>(); mem != nullptr)
+            {
+                // Address computation always reads the registers regardless of the operand access.
+                detail::addMemRegs(res.read, *mem, mode);
+            }
+        }
+
+        const auto& flags = instr.getCPUFlags();
+        res.flagsRead = flags.tested;
+        res.flagsWrite = flags.modified | flags.set0 | flags.set1 | flags.undefined;
+
+        return res;
+    }
+
+    /// <summary>
+    /// Returns the registers that may be read by the instruction.
+    /// </summary>
+    inline RegSet getRegsRead(const InstructionDetail& instr, MachineMode mode) noexcept
+    {
+        return getRegAccess(instr, mode).read;
+    }
+
+    /// <summary>
+    /// Returns the registers that may be written by the instruction.
+    /// </summary>
+    inline RegSet getRegsWritten(const InstructionDetail& instr, MachineMode mode) noexcept
+    {
+        return getRegAccess(instr, mode).write;
+    }
+
+} // namespace zasm
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "serializer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <zasm/base/label.hpp>
+#include <zasm/core/errors.hpp>
+#include <zasm/core/expected.hpp>
+
+namespace zasm
+{
+    namespace detail
+    {
+        struct SerializedImageData;
+    }
+
+    /// <summary>
+    /// Immutable snapshot of a serialization result. All data is stored in a single allocation
+    /// which is shared between copies by reference counting, copying a SerializedImage is cheap.
+    /// As the data never changes after creation it is safe to access the same image from any number
+    /// of threads, each thread can use relocateTo to instantiate the code at its own base address.
+    /// </summary>
+    class SerializedImage
+    {
+        detail::SerializedImageData* _data{};
+
+    public:
+        SerializedImage() noexcept = default;
+        SerializedImage(const SerializedImage& other) noexcept;
+        SerializedImage(SerializedImage&& other) noexcept;
+        ~SerializedImage() noexcept;
+
+        SerializedImage& operator=(const SerializedImage& other) noexcept;
+        SerializedImage& operator=(SerializedImage&& other) noexcept;
+
+        /// <summary>
+        /// Creates a new image from the current state of the serializer. The serializer
+        /// can be reused or destroyed afterwards without affecting the image.
+        /// </summary>
+        /// <param name="serializer">Serializer with a successful serialization</param>
+        /// <returns>The image or ErrorCode::EmptyState if the serializer holds no code</returns>
+        static Expected<SerializedImage, Error> create(const Serializer& serializer);
+
+        /// <summary>
+        /// Returns true if the image holds data.
+        /// </summary>
+        bool isValid() const noexcept;
+
+        /// <summary>
+        /// Returns the base address the image was serialized at.
+        /// </summary>
+        std::int64_t getBase() const noexcept;
+
+        /// <summary>
+        /// Returns the size of the flat code buffer, see Serializer::getCodeSize.
+        /// </summary>
+        std::size_t getCodeSize() const noexcept;
+
+        /// <summary>
+        /// Returns the code as it was serialized at the base address of the image.
+        /// </summary>
+        /// <returns>Pointer to the code or nullptr if the image is not valid</returns>
+        const std::uint8_t* getCode() const noexcept;
+
+        /// <summary>
+        /// Returns the amount of sections.
+        /// </summary>
+        std::size_t getSectionCount() const noexcept;
+
+        /// <summary>
+        /// Returns the information about the section, the addresses correspond to the image base.
+        /// </summary>
+        /// <returns>Pointer to the section info, nullptr if the index is invalid</returns>
+        const SectionInfo* getSectionInfo(std::size_t sectionIndex) const noexcept;
+
+        /// <summary>
+        /// Returns the offset of the label in the code buffer.
+        /// </summary>
+        /// <returns>Offset of label or -1 if the label is not bound or found</returns>
+        std::int32_t getLabelOffset(Label::Id labelId) const noexcept;
+
+        /// <summary>
+        /// Returns the address of the label at the specified base address.
+        /// </summary>
+        /// <returns>Address of label or -1 if the label is not bound or found</returns>
+        std::int64_t getLabelAddress(Label::Id labelId, std::int64_t base) const noexcept;
+
+        /// <summary>
+        /// Returns the amount of relocation items.
+        /// </summary>
+        std::size_t getRelocationCount() const noexcept;
+
+        /// <summary>
+        /// Returns the relocation info of the specified index, the addresses correspond to the image base.
+        /// </summary>
+        /// <returns>Pointer to relocation info or null in case the index does not exist</returns>
+        const RelocationInfo* getRelocation(std::size_t index) const noexcept;
+
+        /// <summary>
+        /// Returns the amount of external relocation items.
+        /// </summary>
+        std::size_t getExternalRelocationCount() const noexcept;
+
+        /// <summary>
+        /// Returns the external relocation info of the specified index, the addresses correspond
+        /// to the image base.
+        /// </summary>
+        /// <returns>Pointer to relocation info or null in case the index does not exist</returns>
+        const RelocationInfo* getExternalRelocation(std::size_t index) const noexcept;
+
+        /// <summary>
+        /// Copies the code into the specified buffer and applies the relocations for the new base address.
+        /// This does not modify the image and can be called concurrently.
+        /// </summary>
+        /// <param name="newBase">Virtual base address at where the code starts</param>
+        /// <param name="buffer">Destination buffer, must be at least getCodeSize() bytes</param>
+        /// <param name="bufferSize">Size of the destination buffer in bytes</param>
+        /// <returns>If successful returns Error::None otherwise check Error value.</returns>
+        Error relocateTo(std::int64_t newBase, std::uint8_t* buffer, std::size_t bufferSize) const;
+
+    private:
+        void release() noexcept;
+    };
+
+} // namespace zasm
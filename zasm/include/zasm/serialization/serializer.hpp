@@ -34,10 +34,44 @@ namespace zasm
         Label::Id label{ Label::Id::Invalid };
     };
 
+    /// <summary>
+    /// The kind of multi-byte NOPs used to fill gaps created by code alignment.
+    /// </summary>
+    enum class NopStyle : std::uint8_t
+    {
+        // NOPs of up to 8 bytes, supported by every CPU since the Pentium Pro.
+        Generic = 0,
+        // NOPs of up to 9 bytes as recommended by the Intel optimization manual.
+        Intel,
+        // NOPs of up to 11 bytes as recommended by the AMD optimization guides.
+        AMD,
+        // Single byte NOPs only, for CPUs without support for multi-byte NOPs.
+        Legacy,
+    };
+
+    struct NodeInfo
+    {
+        std::int32_t offset{};
+        std::int64_t address{};
+        std::int32_t length{};
+    };
+
+    struct PassInfo
+    {
+        std::int32_t pass{};
+        std::size_t labelLookups{};
+        std::size_t unresolvedLabelLookups{};
+        std::int32_t codeSize{};
+    };
+
+    class SerializedImage;
+
     class Serializer
     {
         detail::SerializerState* _state{};
 
+        friend class SerializedImage;
+
     public:
         Serializer();
         Serializer(const Serializer&) = delete;
@@ -73,6 +107,48 @@ namespace zasm
         /// <returns>If successful returns Error::None otherwise check Error value.</returns>
         Error relocate(std::int64_t newBase);
 
+        /// <summary>
+        /// Copies the current serialized code into the specified buffer and applies the relocations
+        /// for the new base address. The state of the serializer is not modified, this allows to
+        /// instantiate the same serialized code at multiple base addresses. Label and section addresses
+        /// can be obtained by adding the difference of newBase and getBase().
+        /// </summary>
+        /// <param name="newBase">Virtual base address at where the code starts</param>
+        /// <param name="buffer">Destination buffer, must be at least getCodeSize() bytes</param>
+        /// <param name="bufferSize">Size of the destination buffer in bytes</param>
+        /// <returns>If successful returns Error::None otherwise check Error value.</returns>
+        Error relocateTo(std::int64_t newBase, std::uint8_t* buffer, std::size_t bufferSize) const;
+
+        /// <summary>
+        /// Sets the kind of NOPs used to fill the gaps of code alignment, this should match the
+        /// target CPU. The default is NopStyle::Generic.
+        /// </summary>
+        /// <param name="style">NOP style</param>
+        void setNopStyle(NopStyle style) noexcept;
+
+        /// <summary>
+        /// Returns the kind of NOPs used to fill the gaps of code alignment.
+        /// </summary>
+        NopStyle getNopStyle() const noexcept;
+
+        /// <summary>
+        /// Enables replacing instructions with a shorter form that has the same effect on registers and
+        /// flags, for example mov rax, 1 is encoded as mov eax, 1. The Program is not modified. This is
+        /// disabled by default, every instruction is encoded exactly as specified.
+        /// </summary>
+        /// <param name="enable">True to encode the shortest form</param>
+        void setShrinkInstructions(bool enable) noexcept;
+
+        /// <summary>
+        /// Returns if instructions are replaced with a shorter form.
+        /// </summary>
+        bool getShrinkInstructions() const noexcept;
+
+        /// <summary>
+        /// Returns the amount of bytes saved by the shorter instruction forms in the last serialize call.
+        /// </summary>
+        std::size_t getBytesSaved() const noexcept;
+
         /// <summary>
         /// Returns the last base address used in a successful serialize call.
         /// </summary>
@@ -122,6 +198,45 @@ namespace zasm
         /// <returns>Address of label or -1 if the label is not bound or found.</returns>
         std::int64_t getLabelAddress(Label::Id labelId) const noexcept;
 
+        /// <summary>
+        /// Returns the first node of the range that was serialized by the last successful serialize call.
+        /// </summary>
+        /// <returns>First serialized node or nullptr if nothing was serialized</returns>
+        const Node* getFirstNode() const noexcept;
+
+        /// <summary>
+        /// Returns the node after the last node of the serialized range, this is nullptr if the range
+        /// ends at the tail of the program.
+        /// </summary>
+        const Node* getEndNode() const noexcept;
+
+        /// <summary>
+        /// Returns the amount of nodes in the serialized range.
+        /// </summary>
+        std::size_t getNodeCount() const noexcept;
+
+        /// <summary>
+        /// Returns the offset, address and encoded length of the node at the given position of the
+        /// serialized range, the position is counted from getFirstNode. Nodes without any data such as
+        /// labels and sections have a length of 0. The address follows relocate calls.
+        /// </summary>
+        /// <param name="index">Position of the node in the serialized range</param>
+        /// <returns>Node info, offset and address are -1 in case the index does not exist</returns>
+        NodeInfo getNodeInfo(std::size_t index) const noexcept;
+
+        /// <summary>
+        /// Returns the amount of passes the last serialization required to resolve all labels.
+        /// </summary>
+        std::size_t getPassCount() const noexcept;
+
+        /// <summary>
+        /// Returns the statistics of the specified pass, this includes how many label addresses
+        /// were looked up and how many of them were not yet resolved at the time.
+        /// </summary>
+        /// <param name="index">Index of the pass</param>
+        /// <returns>Pointer to pass info or null in case the index does not exist</returns>
+        const PassInfo* getPassInfo(std::size_t index) const noexcept;
+
         /// <summary>
         /// Returns the amount of relocation items.
         /// </summary>
@@ -150,6 +265,13 @@ namespace zasm
         /// Clears the current serialized state.
         /// </summary>
         void clear() noexcept;
+
+        /// <summary>
+        /// The serializer keeps its internal buffers between calls to serialize to avoid
+        /// allocations when it is reused, this releases the memory that is not required to
+        /// hold the current serialized state.
+        /// </summary>
+        void shrink() noexcept;
     };
 
 } // namespace zasm
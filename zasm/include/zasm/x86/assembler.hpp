@@ -85,6 +85,14 @@ namespace zasm::x86
         /// <returns>Error</returns>
         Error embed(const void* ptr, std::size_t len);
 
+        /// <summary>
+        /// Creates a data node from existing data. Large blobs created with Data::external or
+        /// Data::shared are not copied, this allows to embed them in multiple programs.
+        /// </summary>
+        /// <param name="data">The data to embed</param>
+        /// <returns>Error</returns>
+        Error embed(Data data);
+
         /// <summary>
         /// Creates a new alignment node that will align the next node to the specified alignment when
         /// serialized.
@@ -194,6 +202,7 @@ namespace zasm::x86
         /// <param name="node"></param>
         void onNodeDetach(Node* node) noexcept override;
         void onNodeDestroy(Node* node) noexcept override;
+        void onNodesDestroy(Node* first, Node* last) noexcept override;
     };
 
 } // namespace zasm::x86
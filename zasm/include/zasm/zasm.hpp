@@ -1,8 +1,19 @@
 #pragma once
 
+#include <zasm/analysis/cfg.hpp>
+#include <zasm/analysis/liveness.hpp>
+#include <zasm/core/concurrentstringpool.hpp>
 #include <zasm/core/errors.hpp>
 #include <zasm/decoder/decoder.hpp>
 #include <zasm/encoder/encoder.hpp>
+#include <zasm/passes/blockreorder.hpp>
+#include <zasm/passes/deadcode.hpp>
+#include <zasm/passes/jumpthreading.hpp>
+#include <zasm/passes/layout.hpp>
+#include <zasm/passes/peephole.hpp>
+#include <zasm/passes/scheduler.hpp>
 #include <zasm/program/program.hpp>
+#include <zasm/program/regaccess.hpp>
+#include <zasm/serialization/image.hpp>
 #include <zasm/serialization/serializer.hpp>
 #include <zasm/x86/x86.hpp>
@@ -0,0 +1,873 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <zasm/analysis/cfg.hpp>
+#include <zasm/program/program.hpp>
+#include <zasm/x86/mnemonic.hpp>
+
+namespace zasm
+{
+    namespace detail
+    {
+        // Per block bits of ControlFlowGraphState::blockFlags.
+        static constexpr std::uint8_t kBlockDirty = 1U << 0;
+        static constexpr std::uint8_t kBlockUnresolved = 1U << 1;
+
+        struct ControlFlowGraphState
+        {
+            Program* program{};
+            bool wholeProgram{};
+            Node* first{};
+            Node* last{};
+
+            std::vector<BasicBlock> blocks;
+            std::vector<BlockId> freeBlocks;
+            std::vector<std::uint8_t> blockFlags;
+            std::size_t validBlockCount{};
+
+            std::vector<CFGEdge> edges;
+            std::vector<EdgeId> freeEdges;
+
+            // Block of each node indexed by the node id.
+            std::vector<BlockId> nodeBlocks;
+
+            // Blocks of which the outgoing edges have to be recomputed.
+            std::vector<BlockId> dirtyBlocks;
+            // Blocks with a branch to a label that is not part of the graph, those are recomputed
+            // when new labels are inserted.
+            std::vector<BlockId> unresolvedBlocks;
+            bool labelsInserted{};
+        };
+
+        enum class BlockExit : std::uint8_t
+        {
+            Fallthrough,
+            Jump,
+            Branch,
+            Stop,
+        };
+
+        static constexpr std::size_t toIndex(BlockId id) noexcept
+        {
+            return static_cast<std::size_t>(id);
+        }
+
+        static constexpr std::size_t toIndex(EdgeId id) noexcept
+        {
+            return static_cast<std::size_t>(id);
+        }
+
+        static constexpr std::size_t toIndex(const Node* node) noexcept
+        {
+            return static_cast<std::size_t>(node->getId());
+        }
+
+        static BlockExit getBlockExit(const Node* node) noexcept
+        {
+            const auto* instr = node->getIf<Instruction>();
+            if (instr == nullptr)
+            {
+                return BlockExit::Fallthrough;
+            }
+
+            const auto mnemonic = instr->getMnemonic();
+            if (x86::isJmp(mnemonic))
+            {
+                return BlockExit::Jump;
+            }
+            if (x86::isCondBranching(mnemonic) || mnemonic == x86::Mnemonic::Loop || mnemonic == x86::Mnemonic::Loope
+                || mnemonic == x86::Mnemonic::Loopne)
+            {
+                return BlockExit::Branch;
+            }
+            if (x86::isRet(mnemonic) || mnemonic == x86::Mnemonic::Iret || mnemonic == x86::Mnemonic::Iretd
+                || mnemonic == x86::Mnemonic::Iretq || mnemonic == x86::Mnemonic::Ud2)
+            {
+                return BlockExit::Stop;
+            }
+
+            return BlockExit::Fallthrough;
+        }
+
+        static BlockId getNodeBlock(const ControlFlowGraphState& state, const Node* node) noexcept
+        {
+            if (node == nullptr)
+            {
+                return BlockId::Invalid;
+            }
+            const auto idx = toIndex(node);
+            if (idx >= state.nodeBlocks.size())
+            {
+                return BlockId::Invalid;
+            }
+            return state.nodeBlocks[idx];
+        }
+
+        static bool isInGraph(const ControlFlowGraphState& state, const Node* node) noexcept
+        {
+            return getNodeBlock(state, node) != BlockId::Invalid;
+        }
+
+        static void setNodeBlock(ControlFlowGraphState& state, const Node* node, BlockId id)
+        {
+            const auto idx = toIndex(node);
+            if (idx >= state.nodeBlocks.size())
+            {
+                if (id == BlockId::Invalid)
+                {
+                    return;
+                }
+                state.nodeBlocks.resize(idx + 1, BlockId::Invalid);
+            }
+            state.nodeBlocks[idx] = id;
+        }
+
+        // Returns true if the node has to be the first node of a block when it follows prev.
+        static bool startsBlock(const ControlFlowGraphState& state, const Node* prev, const Node* node) noexcept
+        {
+            if (prev == nullptr || !isInGraph(state, prev))
+            {
+                return true;
+            }
+            if (node->holds<Section>())
+            {
+                return true;
+            }
+            // Consecutive labels share the block.
+            if (node->holds<Label>() && !prev->holds<Label>())
+            {
+                return true;
+            }
+            return getBlockExit(prev) != BlockExit::Fallthrough;
+        }
+
+        static void markDirty(ControlFlowGraphState& state, BlockId id)
+        {
+            auto& flags = state.blockFlags[toIndex(id)];
+            if ((flags & kBlockDirty) != 0)
+            {
+                return;
+            }
+            flags |= kBlockDirty;
+            state.dirtyBlocks.push_back(id);
+        }
+
+        static void markPredecessorsDirty(ControlFlowGraphState& state, BlockId id, bool onlyBranches)
+        {
+            for (auto edgeId = state.blocks[toIndex(id)].firstPred; edgeId != EdgeId::Invalid;)
+            {
+                const auto& edge = state.edges[toIndex(edgeId)];
+                if (!onlyBranches || edge.kind != EdgeKind::Fallthrough)
+                {
+                    markDirty(state, edge.from);
+                }
+                edgeId = edge.nextPred;
+            }
+        }
+
+        static void addEdge(ControlFlowGraphState& state, BlockId from, BlockId to, EdgeKind kind)
+        {
+            EdgeId edgeId{};
+            if (!state.freeEdges.empty())
+            {
+                edgeId = state.freeEdges.back();
+                state.freeEdges.pop_back();
+            }
+            else
+            {
+                edgeId = static_cast<EdgeId>(state.edges.size());
+                state.edges.emplace_back();
+            }
+
+            auto& fromBlock = state.blocks[toIndex(from)];
+            auto& toBlock = state.blocks[toIndex(to)];
+
+            auto& edge = state.edges[toIndex(edgeId)];
+            edge.from = from;
+            edge.to = to;
+            edge.kind = kind;
+            edge.prevSucc = EdgeId::Invalid;
+            edge.nextSucc = fromBlock.firstSucc;
+            edge.prevPred = EdgeId::Invalid;
+            edge.nextPred = toBlock.firstPred;
+
+            if (fromBlock.firstSucc != EdgeId::Invalid)
+            {
+                state.edges[toIndex(fromBlock.firstSucc)].prevSucc = edgeId;
+            }
+            fromBlock.firstSucc = edgeId;
+            fromBlock.succCount++;
+
+            if (toBlock.firstPred != EdgeId::Invalid)
+            {
+                state.edges[toIndex(toBlock.firstPred)].prevPred = edgeId;
+            }
+            toBlock.firstPred = edgeId;
+            toBlock.predCount++;
+        }
+
+        static void removeEdge(ControlFlowGraphState& state, EdgeId edgeId)
+        {
+            auto& edge = state.edges[toIndex(edgeId)];
+            auto& fromBlock = state.blocks[toIndex(edge.from)];
+            auto& toBlock = state.blocks[toIndex(edge.to)];
+
+            if (edge.prevSucc != EdgeId::Invalid)
+            {
+                state.edges[toIndex(edge.prevSucc)].nextSucc = edge.nextSucc;
+            }
+            else
+            {
+                fromBlock.firstSucc = edge.nextSucc;
+            }
+            if (edge.nextSucc != EdgeId::Invalid)
+            {
+                state.edges[toIndex(edge.nextSucc)].prevSucc = edge.prevSucc;
+            }
+            fromBlock.succCount--;
+
+            if (edge.prevPred != EdgeId::Invalid)
+            {
+                state.edges[toIndex(edge.prevPred)].nextPred = edge.nextPred;
+            }
+            else
+            {
+                toBlock.firstPred = edge.nextPred;
+            }
+            if (edge.nextPred != EdgeId::Invalid)
+            {
+                state.edges[toIndex(edge.nextPred)].prevPred = edge.prevPred;
+            }
+            toBlock.predCount--;
+
+            edge = {};
+            state.freeEdges.push_back(edgeId);
+        }
+
+        static void removeSuccessors(ControlFlowGraphState& state, BlockId id)
+        {
+            while (state.blocks[toIndex(id)].firstSucc != EdgeId::Invalid)
+            {
+                removeEdge(state, state.blocks[toIndex(id)].firstSucc);
+            }
+        }
+
+        static BlockId allocBlock(ControlFlowGraphState& state, Node* head, Node* tail)
+        {
+            BlockId id{};
+            if (!state.freeBlocks.empty())
+            {
+                id = state.freeBlocks.back();
+                state.freeBlocks.pop_back();
+            }
+            else
+            {
+                id = static_cast<BlockId>(state.blocks.size());
+                state.blocks.emplace_back();
+                state.blockFlags.push_back(0);
+            }
+
+            auto& block = state.blocks[toIndex(id)];
+            block = {};
+            block.head = head;
+            block.tail = tail;
+
+            state.validBlockCount++;
+
+            return id;
+        }
+
+        static void freeBlock(ControlFlowGraphState& state, BlockId id)
+        {
+            // The sources of the incoming edges have to find their new target.
+            markPredecessorsDirty(state, id, false);
+
+            removeSuccessors(state, id);
+            while (state.blocks[toIndex(id)].firstPred != EdgeId::Invalid)
+            {
+                removeEdge(state, state.blocks[toIndex(id)].firstPred);
+            }
+
+            state.blocks[toIndex(id)] = {};
+            state.blockFlags[toIndex(id)] = 0;
+            state.freeBlocks.push_back(id);
+            state.validBlockCount--;
+        }
+
+        static void assignNodes(ControlFlowGraphState& state, Node* from, const Node* to, BlockId id)
+        {
+            for (auto* node = from;; node = node->getNext())
+            {
+                setNodeBlock(state, node, id);
+                if (node == to)
+                {
+                    break;
+                }
+            }
+        }
+
+        // Splits the block so that node becomes the head of a new block, prev is the node before it.
+        static void splitBlock(ControlFlowGraphState& state, BlockId id, Node* node, Node* prev)
+        {
+            auto* tail = state.blocks[toIndex(id)].tail;
+
+            const auto newId = allocBlock(state, node, tail);
+            assignNodes(state, node, tail, newId);
+
+            state.blocks[toIndex(id)].tail = prev;
+
+            // Branches to labels that moved to the new block have to be redirected.
+            markPredecessorsDirty(state, id, true);
+            markDirty(state, id);
+            markDirty(state, newId);
+        }
+
+        // Appends all nodes of the block 'id' to the block 'intoId' which directly precedes it.
+        static void mergeBlock(ControlFlowGraphState& state, BlockId intoId, BlockId id)
+        {
+            const auto block = state.blocks[toIndex(id)];
+            assignNodes(state, block.head, block.tail, intoId);
+
+            state.blocks[toIndex(intoId)].tail = block.tail;
+
+            freeBlock(state, id);
+            markDirty(state, intoId);
+        }
+
+        // Ensures that the boundary between prev and node is correct, prev directly precedes node.
+        static void fixBoundary(ControlFlowGraphState& state, Node* prev, Node* node)
+        {
+            if (node == nullptr || !isInGraph(state, node))
+            {
+                return;
+            }
+
+            const auto id = getNodeBlock(state, node);
+            const bool isHead = state.blocks[toIndex(id)].head == node;
+            const bool shouldStart = startsBlock(state, prev, node);
+
+            if (shouldStart && !isHead)
+            {
+                splitBlock(state, id, node, prev);
+            }
+            else if (!shouldStart && isHead)
+            {
+                mergeBlock(state, getNodeBlock(state, prev), id);
+            }
+        }
+
+        static void computeSuccessors(ControlFlowGraphState& state, BlockId id)
+        {
+            const auto* tail = state.blocks[toIndex(id)].tail;
+            const auto exit = getBlockExit(tail);
+
+            if (exit == BlockExit::Jump || exit == BlockExit::Branch)
+            {
+                const auto& instr = tail->get<Instruction>();
+                if (instr.getOperandCount() > 0 && instr.getOperand(0).holds<Label>())
+                {
+                    const auto& label = instr.getOperand(0).get<Label>();
+
+                    const auto targetId = getNodeBlock(state, state.program->getNodeForLabel(label));
+                    if (targetId != BlockId::Invalid)
+                    {
+                        addEdge(state, id, targetId, exit == BlockExit::Jump ? EdgeKind::Jump : EdgeKind::Branch);
+                    }
+                    else if ((state.blockFlags[toIndex(id)] & kBlockUnresolved) == 0)
+                    {
+                        state.blockFlags[toIndex(id)] |= kBlockUnresolved;
+                        state.unresolvedBlocks.push_back(id);
+                    }
+                }
+            }
+
+            if (exit == BlockExit::Fallthrough || exit == BlockExit::Branch)
+            {
+                auto* next = tail != state.last ? tail->getNext() : nullptr;
+                if (next != nullptr && isInGraph(state, next) && !next->holds<Section>())
+                {
+                    addEdge(state, id, getNodeBlock(state, next), EdgeKind::Fallthrough);
+                }
+            }
+        }
+
+        static void sync(ControlFlowGraphState& state)
+        {
+            if (state.labelsInserted)
+            {
+                state.labelsInserted = false;
+
+                for (const auto id : state.unresolvedBlocks)
+                {
+                    state.blockFlags[toIndex(id)] &= ~kBlockUnresolved;
+                    if (state.blocks[toIndex(id)].isValid())
+                    {
+                        markDirty(state, id);
+                    }
+                }
+                state.unresolvedBlocks.clear();
+            }
+
+            // Recomputing can not mark other blocks dirty, only the edges of the block itself change.
+            for (const auto id : state.dirtyBlocks)
+            {
+                state.blockFlags[toIndex(id)] &= ~kBlockDirty;
+                if (!state.blocks[toIndex(id)].isValid())
+                {
+                    continue;
+                }
+                removeSuccessors(state, id);
+                computeSuccessors(state, id);
+            }
+            state.dirtyBlocks.clear();
+        }
+
+        static void resetState(ControlFlowGraphState& state)
+        {
+            state.blocks.clear();
+            state.freeBlocks.clear();
+            state.blockFlags.clear();
+            state.validBlockCount = 0;
+            state.edges.clear();
+            state.freeEdges.clear();
+            state.nodeBlocks.clear();
+            state.dirtyBlocks.clear();
+            state.unresolvedBlocks.clear();
+            state.labelsInserted = false;
+        }
+
+        static void removeNode(ControlFlowGraphState& state, Node* node)
+        {
+            const auto id = getNodeBlock(state, node);
+            if (id == BlockId::Invalid)
+            {
+                return;
+            }
+
+            // When the program is cleared the previous node may already be destroyed.
+            auto* prev = node != state.first ? node->getPrev() : nullptr;
+            auto* next = node != state.last ? node->getNext() : nullptr;
+
+            setNodeBlock(state, node, BlockId::Invalid);
+
+            auto& block = state.blocks[toIndex(id)];
+            if (block.head == node && block.tail == node)
+            {
+                freeBlock(state, id);
+            }
+            else
+            {
+                if (block.head == node)
+                {
+                    block.head = next;
+                }
+                else if (block.tail == node)
+                {
+                    block.tail = prev;
+                    markDirty(state, id);
+                }
+                if (node->holds<Label>())
+                {
+                    // Branches to the removed label have no target anymore.
+                    markPredecessorsDirty(state, id, true);
+                }
+            }
+
+            if (node == state.first)
+            {
+                state.first = next;
+            }
+            if (node == state.last)
+            {
+                state.last = prev;
+            }
+
+            fixBoundary(state, prev, next);
+        }
+
+        // Removes the nodes from first to last at once, the nodes are still linked.
+        static void removeRange(ControlFlowGraphState& state, Node* first, Node* last)
+        {
+            // The nodes of the graph are contiguous, find the part of the range that is in the graph.
+            Node* rangeFirst = nullptr;
+            Node* rangeLast = nullptr;
+            for (auto* node = first;; node = node->getNext())
+            {
+                if (isInGraph(state, node))
+                {
+                    if (rangeFirst == nullptr)
+                    {
+                        rangeFirst = node;
+                    }
+                    rangeLast = node;
+                }
+                if (node == last)
+                {
+                    break;
+                }
+            }
+            if (rangeFirst == nullptr)
+            {
+                return;
+            }
+
+            auto* prev = rangeFirst != state.first ? rangeFirst->getPrev() : nullptr;
+            auto* next = rangeLast != state.last ? rangeLast->getNext() : nullptr;
+
+            const auto firstId = getNodeBlock(state, rangeFirst);
+            const auto lastId = getNodeBlock(state, rangeLast);
+
+            // Blocks in between are removed entirely.
+            for (auto* node = rangeFirst;; node = node->getNext())
+            {
+                const auto id = getNodeBlock(state, node);
+                if (node->holds<Label>())
+                {
+                    // Branches to the removed label have no target anymore.
+                    markPredecessorsDirty(state, id, true);
+                }
+
+                setNodeBlock(state, node, BlockId::Invalid);
+
+                if (id != firstId && id != lastId && state.blocks[toIndex(id)].tail == node)
+                {
+                    freeBlock(state, id);
+                }
+                if (node == rangeLast)
+                {
+                    break;
+                }
+            }
+
+            if (firstId == lastId)
+            {
+                auto& block = state.blocks[toIndex(firstId)];
+                if (block.head == rangeFirst && block.tail == rangeLast)
+                {
+                    freeBlock(state, firstId);
+                }
+                else if (block.head == rangeFirst)
+                {
+                    block.head = next;
+                }
+                else
+                {
+                    if (block.tail == rangeLast)
+                    {
+                        block.tail = prev;
+                    }
+                    markDirty(state, firstId);
+                }
+            }
+            else
+            {
+                if (state.blocks[toIndex(firstId)].head == rangeFirst)
+                {
+                    freeBlock(state, firstId);
+                }
+                else
+                {
+                    state.blocks[toIndex(firstId)].tail = prev;
+                    markDirty(state, firstId);
+                }
+
+                if (state.blocks[toIndex(lastId)].tail == rangeLast)
+                {
+                    freeBlock(state, lastId);
+                }
+                else
+                {
+                    state.blocks[toIndex(lastId)].head = next;
+                }
+            }
+
+            if (rangeFirst == state.first)
+            {
+                state.first = next;
+            }
+            if (rangeLast == state.last)
+            {
+                state.last = prev;
+            }
+
+            fixBoundary(state, prev, next);
+        }
+
+        static void insertNode(ControlFlowGraphState& state, Node* node)
+        {
+            auto* prev = node->getPrev();
+            auto* next = node->getNext();
+
+            const bool prevInGraph = isInGraph(state, prev);
+            if (!state.wholeProgram && (!prevInGraph || prev == state.last))
+            {
+                return;
+            }
+
+            if (node->holds<Label>())
+            {
+                state.labelsInserted = true;
+            }
+
+            if (state.first == nullptr)
+            {
+                const auto id = allocBlock(state, node, node);
+                setNodeBlock(state, node, id);
+                state.first = state.last = node;
+                markDirty(state, id);
+                return;
+            }
+
+            if (prevInGraph)
+            {
+                const auto id = getNodeBlock(state, prev);
+                setNodeBlock(state, node, id);
+
+                auto& block = state.blocks[toIndex(id)];
+                if (block.tail == prev)
+                {
+                    block.tail = node;
+                    markDirty(state, id);
+                }
+                if (state.last == prev)
+                {
+                    state.last = node;
+                }
+            }
+            else
+            {
+                // New first node of the program.
+                assert(next == state.first);
+
+                const auto id = getNodeBlock(state, next);
+                setNodeBlock(state, node, id);
+
+                state.blocks[toIndex(id)].head = node;
+                state.first = node;
+            }
+
+            fixBoundary(state, prev, node);
+            fixBoundary(state, node, next);
+        }
+
+    } // namespace detail
+
+    ControlFlowGraph::ControlFlowGraph(Program& program)
+        : _state(new detail::ControlFlowGraphState())
+    {
+        _state->program = &program;
+        _state->wholeProgram = true;
+
+        program.addObserver(*this);
+
+        build();
+    }
+
+    ControlFlowGraph::ControlFlowGraph(Program& program, Node* first, Node* last)
+        : _state(new detail::ControlFlowGraphState())
+    {
+        _state->program = &program;
+        _state->first = first;
+        _state->last = last;
+
+        program.addObserver(*this);
+
+        build();
+    }
+
+    ControlFlowGraph::~ControlFlowGraph()
+    {
+        _state->program->removeObserver(*this);
+
+        delete _state;
+        _state = nullptr;
+    }
+
+    Error ControlFlowGraph::build()
+    {
+        auto& state = *_state;
+
+        if (state.wholeProgram)
+        {
+            state.first = state.program->getHead();
+            state.last = state.program->getTail();
+        }
+
+        detail::resetState(state);
+
+        if (state.first == nullptr || state.last == nullptr)
+        {
+            if (state.wholeProgram)
+            {
+                return ErrorCode::None;
+            }
+            state.first = state.last = nullptr;
+            return ErrorCode::InvalidParameter;
+        }
+
+        BlockId curId = BlockId::Invalid;
+        Node* prev = nullptr;
+        for (auto* node = state.first; node != nullptr; node = node->getNext())
+        {
+            if (curId == BlockId::Invalid || detail::startsBlock(state, prev, node))
+            {
+                if (curId != BlockId::Invalid)
+                {
+                    state.blocks[detail::toIndex(curId)].tail = prev;
+                }
+                curId = detail::allocBlock(state, node, node);
+            }
+
+            detail::setNodeBlock(state, node, curId);
+            prev = node;
+
+            if (node == state.last)
+            {
+                break;
+            }
+        }
+
+        if (prev != state.last)
+        {
+            // The last node does not follow the first node.
+            detail::resetState(state);
+            state.first = state.last = nullptr;
+            return ErrorCode::InvalidParameter;
+        }
+
+        state.blocks[detail::toIndex(curId)].tail = prev;
+
+        for (std::size_t i = 0; i < state.blocks.size(); ++i)
+        {
+            detail::computeSuccessors(state, static_cast<BlockId>(i));
+        }
+
+        return ErrorCode::None;
+    }
+
+    void ControlFlowGraph::update()
+    {
+        detail::sync(*_state);
+    }
+
+    std::size_t ControlFlowGraph::getBlockCount() const noexcept
+    {
+        return _state->blocks.size();
+    }
+
+    std::size_t ControlFlowGraph::getValidBlockCount() const noexcept
+    {
+        return _state->validBlockCount;
+    }
+
+    const BasicBlock* ControlFlowGraph::getBlock(BlockId id) const
+    {
+        detail::sync(*_state);
+
+        const auto idx = detail::toIndex(id);
+        if (idx >= _state->blocks.size() || !_state->blocks[idx].isValid())
+        {
+            return nullptr;
+        }
+        return &_state->blocks[idx];
+    }
+
+    std::size_t ControlFlowGraph::getEdgeCount() const
+    {
+        detail::sync(*_state);
+
+        return _state->edges.size();
+    }
+
+    const CFGEdge* ControlFlowGraph::getEdge(EdgeId id) const
+    {
+        detail::sync(*_state);
+
+        const auto idx = detail::toIndex(id);
+        if (idx >= _state->edges.size() || !_state->edges[idx].isValid())
+        {
+            return nullptr;
+        }
+        return &_state->edges[idx];
+    }
+
+    BlockId ControlFlowGraph::getEntryBlock() const noexcept
+    {
+        return detail::getNodeBlock(*_state, _state->first);
+    }
+
+    BlockId ControlFlowGraph::getBlockOf(const Node* node) const noexcept
+    {
+        return detail::getNodeBlock(*_state, node);
+    }
+
+    BlockId ControlFlowGraph::getBlockOf(const Label& label) const noexcept
+    {
+        return detail::getNodeBlock(*_state, _state->program->getNodeForLabel(label));
+    }
+
+    BlockId ControlFlowGraph::getNextBlock(BlockId id) const noexcept
+    {
+        const auto idx = detail::toIndex(id);
+        if (idx >= _state->blocks.size() || !_state->blocks[idx].isValid())
+        {
+            return BlockId::Invalid;
+        }
+
+        const auto* tail = _state->blocks[idx].tail;
+        if (tail == _state->last)
+        {
+            return BlockId::Invalid;
+        }
+        return detail::getNodeBlock(*_state, tail->getNext());
+    }
+
+    bool ControlFlowGraph::leavesGraph(BlockId id) const
+    {
+        const auto* block = getBlock(id);
+        if (block == nullptr)
+        {
+            return false;
+        }
+
+        const auto* tail = block->tail;
+        switch (detail::getBlockExit(tail))
+        {
+            case detail::BlockExit::Jump:
+                return block->succCount == 0;
+            case detail::BlockExit::Branch:
+                return block->succCount < 2;
+            case detail::BlockExit::Fallthrough:
+                return block->succCount == 0;
+            default:
+                break;
+        }
+
+        // Returns leave, ud2 does not continue.
+        const auto mnemonic = tail->get<Instruction>().getMnemonic();
+        return mnemonic != x86::Mnemonic::Ud2;
+    }
+
+    void ControlFlowGraph::onNodeDestroy(Node* node)
+    {
+        // Destroying an attached node does not report the detach.
+        detail::removeNode(*_state, node);
+    }
+
+    void ControlFlowGraph::onNodesDestroy(Node* first, Node* last)
+    {
+        detail::removeRange(*_state, first, last);
+    }
+
+    void ControlFlowGraph::onNodeDetach(Node* node)
+    {
+        detail::removeNode(*_state, node);
+    }
+
+    void ControlFlowGraph::onNodeInserted(Node* node)
+    {
+        detail::insertNode(*_state, node);
+    }
+
+} // namespace zasm
@@ -0,0 +1,497 @@
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <zasm/analysis/liveness.hpp>
+#include <zasm/program/program.hpp>
+#include <zasm/program/regaccess.hpp>
+#include <zasm/x86/mnemonic.hpp>
+
+namespace zasm
+{
+    namespace detail
+    {
+        // Effect of a single node, nodes other than instructions have no effect.
+        struct NodeAccess
+        {
+            LiveSet use;
+            LiveSet def;
+            // Calls and syscalls additionally read the exit set.
+            bool readsExit{};
+
+            bool operator==(const NodeAccess& other) const noexcept
+            {
+                return use == other.use && def == other.def && readsExit == other.readsExit;
+            }
+        };
+
+        struct NodeAccessHash
+        {
+            static void combine(std::size_t& seed, std::size_t value) noexcept
+            {
+                seed ^= value + 0x9E3779B9U + (seed << 6) + (seed >> 2);
+            }
+
+            std::size_t operator()(const NodeAccess& access) const noexcept
+            {
+                std::size_t res = access.readsExit ? 1U : 0U;
+                for (const auto reg : access.use.regs)
+                {
+                    combine(res, static_cast<std::size_t>(reg.getId()));
+                }
+                combine(res, access.use.flags.value());
+                for (const auto reg : access.def.regs)
+                {
+                    combine(res, static_cast<std::size_t>(reg.getId()) << 16U);
+                }
+                combine(res, access.def.flags.value());
+                return res;
+            }
+        };
+
+        enum class BlockExitKind : std::uint8_t
+        {
+            None,
+            Exit,
+            Return,
+        };
+
+        struct LivenessState
+        {
+            Program* program{};
+            const ControlFlowGraph* cfg{};
+            MachineMode mode{};
+
+            LiveSet exitLive;
+            LiveSet returnLive;
+            bool hasReturnLive{};
+            // Used for instructions that can not be analyzed.
+            LiveSet unknownUse;
+            LiveSet emptySet;
+
+            // Index + 1 into the access table indexed by node id, 0 if not yet computed.
+            std::vector<std::uint32_t> nodeAccess;
+            // Most instructions share the same access, each distinct access is stored once.
+            std::vector<NodeAccess> accessTable;
+            std::unordered_map<NodeAccess, std::uint32_t, NodeAccessHash> accessLookup;
+
+            // Block summaries and results indexed by block id.
+            std::vector<LiveSet> blockUse;
+            std::vector<LiveSet> blockDef;
+            std::vector<LiveSet> liveIn;
+            std::vector<LiveSet> liveOut;
+            // How control leaves the graph at the end of the block indexed by block id.
+            std::vector<BlockExitKind> blockLeaves;
+
+            // Per node results of the most recently queried block.
+            BlockId cachedBlock{ BlockId::Invalid };
+            std::vector<const Node*> cachedNodes;
+            std::vector<LiveSet> cachedLiveIn;
+            std::size_t cachedHint{};
+
+            std::size_t visitCount{};
+            std::size_t decodeCount{};
+        };
+
+        // Shifts and rotates by a register leave the flags untouched when the count is zero.
+        static bool hasConditionalFlagsWrite(const InstructionDetail& instr) noexcept
+        {
+            switch (instr.getMnemonic())
+            {
+                case x86::Mnemonic::Shl:
+                case x86::Mnemonic::Shr:
+                case x86::Mnemonic::Sar:
+                case x86::Mnemonic::Rol:
+                case x86::Mnemonic::Ror:
+                case x86::Mnemonic::Rcl:
+                case x86::Mnemonic::Rcr:
+                case x86::Mnemonic::Shld:
+                case x86::Mnemonic::Shrd:
+                    break;
+                default:
+                    return false;
+            }
+
+            const auto count = instr.getVisibleOperandCount();
+            return count > 0 && !instr.getOperand(count - 1).holds<Imm>();
+        }
+
+        static NodeAccess computeAccess(const LivenessState& state, const Instruction& instr)
+        {
+            NodeAccess res{};
+
+            const auto mnemonic = instr.getMnemonic();
+            res.readsExit = x86::isCall(mnemonic) || x86::isSyscall(mnemonic);
+
+            const auto detail = instr.getDetail(state.mode);
+            if (!detail)
+            {
+                res.use = state.unknownUse;
+                return res;
+            }
+
+            const auto access = getRegAccess(*detail, state.mode);
+            res.use.regs = access.read;
+            res.use.flags = access.flagsRead;
+            res.def.regs = access.kill;
+            if (!hasConditionalFlagsWrite(*detail))
+            {
+                res.def.flags = access.flagsWrite;
+            }
+
+            return res;
+        }
+
+        static const NodeAccess* getAccess(LivenessState& state, const Node* node)
+        {
+            const auto* instr = node->getIf<Instruction>();
+            if (instr == nullptr)
+            {
+                return nullptr;
+            }
+
+            const auto idx = static_cast<std::size_t>(node->getId());
+            if (idx >= state.nodeAccess.size())
+            {
+                state.nodeAccess.resize(idx + 1, 0);
+            }
+
+            auto& entry = state.nodeAccess[idx];
+            if (entry == 0)
+            {
+                auto access = computeAccess(state, *instr);
+                state.decodeCount++;
+
+                auto [it, inserted] = state.accessLookup.try_emplace(
+                    access, static_cast<std::uint32_t>(state.accessTable.size()));
+                if (inserted)
+                {
+                    state.accessTable.push_back(access);
+                }
+                entry = it->second + 1;
+            }
+
+            return &state.accessTable[entry - 1];
+        }
+
+        // Computes the live set before the node from the live set after the node.
+        static void transfer(LivenessState& state, const Node* node, LiveSet& live)
+        {
+            const auto* access = getAccess(state, node);
+            if (access == nullptr)
+            {
+                return;
+            }
+
+            live -= access->def;
+            live |= access->use;
+            if (access->readsExit)
+            {
+                live |= state.exitLive;
+            }
+        }
+
+        static void cacheBlock(LivenessState& state, BlockId id)
+        {
+            if (state.cachedBlock == id)
+            {
+                return;
+            }
+
+            state.cachedBlock = id;
+            state.cachedNodes.clear();
+            state.cachedHint = 0;
+
+            const auto* block = state.cfg->getBlock(id);
+            for (const auto* node = block->head;; node = node->getNext())
+            {
+                state.cachedNodes.push_back(node);
+                if (node == block->tail)
+                {
+                    break;
+                }
+            }
+
+            state.cachedLiveIn.resize(state.cachedNodes.size());
+
+            auto live = state.liveOut[static_cast<std::size_t>(id)];
+            for (std::size_t i = state.cachedNodes.size(); i-- > 0;)
+            {
+                transfer(state, state.cachedNodes[i], live);
+                state.cachedLiveIn[i] = live;
+            }
+        }
+
+        // Returns the index of the node in the cached block, callers usually walk the nodes in order.
+        static std::size_t findCachedNode(LivenessState& state, const Node* node) noexcept
+        {
+            const auto& nodes = state.cachedNodes;
+            for (auto idx = state.cachedHint; idx < nodes.size() && idx <= state.cachedHint + 1; idx++)
+            {
+                if (nodes[idx] == node)
+                {
+                    state.cachedHint = idx;
+                    return idx;
+                }
+            }
+            for (std::size_t idx = 0; idx < nodes.size(); idx++)
+            {
+                if (nodes[idx] == node)
+                {
+                    state.cachedHint = idx;
+                    return idx;
+                }
+            }
+            return nodes.size();
+        }
+
+        static bool hasResult(const LivenessState& state, BlockId id)
+        {
+            return static_cast<std::size_t>(id) < state.liveIn.size() && state.cfg->getBlock(id) != nullptr;
+        }
+
+    } // namespace detail
+
+    LivenessAnalysis::LivenessAnalysis(Program& program, const ControlFlowGraph& cfg)
+        : _state(new detail::LivenessState())
+    {
+        _state->program = &program;
+        _state->cfg = &cfg;
+        _state->mode = program.getMode();
+
+        for (std::size_t i = 0; i < detail::kRegInfoCount; ++i)
+        {
+            const auto reg = Reg{ static_cast<Reg::Id>(i) };
+            _state->exitLive.regs.add(reg, _state->mode);
+        }
+
+        _state->unknownUse.regs = _state->exitLive.regs;
+        _state->unknownUse.flags = ~InstrCPUFlags{};
+
+        program.addObserver(*this);
+    }
+
+    LivenessAnalysis::~LivenessAnalysis()
+    {
+        _state->program->removeObserver(*this);
+
+        delete _state;
+        _state = nullptr;
+    }
+
+    void LivenessAnalysis::setExitLiveSet(const LiveSet& live) noexcept
+    {
+        _state->exitLive = live;
+    }
+
+    const LiveSet& LivenessAnalysis::getExitLiveSet() const noexcept
+    {
+        return _state->exitLive;
+    }
+
+    void LivenessAnalysis::setReturnLiveSet(const LiveSet& live) noexcept
+    {
+        _state->returnLive = live;
+        _state->hasReturnLive = true;
+    }
+
+    const LiveSet& LivenessAnalysis::getReturnLiveSet() const noexcept
+    {
+        return _state->hasReturnLive ? _state->returnLive : _state->exitLive;
+    }
+
+    void LivenessAnalysis::run()
+    {
+        auto& state = *_state;
+        const auto& cfg = *state.cfg;
+
+        state.cachedBlock = BlockId::Invalid;
+        state.visitCount = 0;
+        state.decodeCount = 0;
+
+        const auto blockCount = cfg.getBlockCount();
+        state.blockUse.assign(blockCount, {});
+        state.blockDef.assign(blockCount, {});
+        state.liveIn.assign(blockCount, {});
+        state.liveOut.assign(blockCount, {});
+        state.blockLeaves.assign(blockCount, detail::BlockExitKind::None);
+
+        std::vector<BlockId> worklist;
+        worklist.reserve(blockCount);
+        std::vector<std::uint8_t> inWorklist(blockCount, 0);
+
+        for (std::size_t i = 0; i < blockCount; ++i)
+        {
+            const auto id = static_cast<BlockId>(i);
+            const auto* block = cfg.getBlock(id);
+            if (block == nullptr)
+            {
+                continue;
+            }
+
+            // Compose the transfer functions of the nodes from the last to the first.
+            auto& use = state.blockUse[i];
+            auto& def = state.blockDef[i];
+            for (const auto* node = block->tail;; node = node->getPrev())
+            {
+                if (const auto* access = detail::getAccess(state, node); access != nullptr)
+                {
+                    use -= access->def;
+                    use |= access->use;
+                    if (access->readsExit)
+                    {
+                        use |= state.exitLive;
+                    }
+                    def |= access->def;
+                }
+                if (node == block->head)
+                {
+                    break;
+                }
+            }
+
+            // Queried here while walking the blocks in order, the worklist visits them in random order.
+            if (cfg.leavesGraph(id))
+            {
+                const auto* tail = block->tail->getIf<Instruction>();
+                const bool isReturn = tail != nullptr && x86::isRet(tail->getMnemonic());
+                state.blockLeaves[i] = isReturn ? detail::BlockExitKind::Return : detail::BlockExitKind::Exit;
+            }
+
+            worklist.push_back(id);
+            inWorklist[i] = 1;
+        }
+
+        // Blocks are pushed in layout order so the last block is processed first, for code without
+        // loops this reaches the fixed point in a single pass.
+        while (!worklist.empty())
+        {
+            const auto id = worklist.back();
+            worklist.pop_back();
+
+            const auto idx = static_cast<std::size_t>(id);
+            inWorklist[idx] = 0;
+            state.visitCount++;
+
+            LiveSet out{};
+            if (state.blockLeaves[idx] == detail::BlockExitKind::Exit)
+            {
+                out = state.exitLive;
+            }
+            else if (state.blockLeaves[idx] == detail::BlockExitKind::Return)
+            {
+                out = getReturnLiveSet();
+            }
+            cfg.forEachSuccessor(id, [&](const CFGEdge& edge) { out |= state.liveIn[static_cast<std::size_t>(edge.to)]; });
+            state.liveOut[idx] = out;
+
+            auto in = out;
+            in -= state.blockDef[idx];
+            in |= state.blockUse[idx];
+            if (in == state.liveIn[idx])
+            {
+                continue;
+            }
+            state.liveIn[idx] = in;
+
+            cfg.forEachPredecessor(id, [&](const CFGEdge& edge) {
+                const auto predIdx = static_cast<std::size_t>(edge.from);
+                if (inWorklist[predIdx] == 0)
+                {
+                    inWorklist[predIdx] = 1;
+                    worklist.push_back(edge.from);
+                }
+            });
+        }
+    }
+
+    void LivenessAnalysis::invalidate(const Node* node) noexcept
+    {
+        auto& state = *_state;
+
+        const auto idx = static_cast<std::size_t>(node->getId());
+        if (idx < state.nodeAccess.size())
+        {
+            state.nodeAccess[idx] = 0;
+        }
+        state.cachedBlock = BlockId::Invalid;
+    }
+
+    const LiveSet& LivenessAnalysis::getLiveIn(BlockId id) const
+    {
+        if (!detail::hasResult(*_state, id))
+        {
+            return _state->emptySet;
+        }
+        return _state->liveIn[static_cast<std::size_t>(id)];
+    }
+
+    const LiveSet& LivenessAnalysis::getLiveOut(BlockId id) const
+    {
+        if (!detail::hasResult(*_state, id))
+        {
+            return _state->emptySet;
+        }
+        return _state->liveOut[static_cast<std::size_t>(id)];
+    }
+
+    const LiveSet& LivenessAnalysis::getLiveIn(const Node* node) const
+    {
+        auto& state = *_state;
+
+        const auto id = state.cfg->getBlockOf(node);
+        if (!detail::hasResult(state, id))
+        {
+            return state.emptySet;
+        }
+
+        detail::cacheBlock(state, id);
+
+        const auto idx = detail::findCachedNode(state, node);
+        if (idx >= state.cachedNodes.size())
+        {
+            return state.emptySet;
+        }
+        return state.cachedLiveIn[idx];
+    }
+
+    const LiveSet& LivenessAnalysis::getLiveOut(const Node* node) const
+    {
+        auto& state = *_state;
+
+        const auto id = state.cfg->getBlockOf(node);
+        if (!detail::hasResult(state, id))
+        {
+            return state.emptySet;
+        }
+
+        detail::cacheBlock(state, id);
+
+        const auto idx = detail::findCachedNode(state, node);
+        if (idx >= state.cachedNodes.size())
+        {
+            return state.emptySet;
+        }
+        if (idx + 1 < state.cachedNodes.size())
+        {
+            return state.cachedLiveIn[idx + 1];
+        }
+        return state.liveOut[static_cast<std::size_t>(id)];
+    }
+
+    std::size_t LivenessAnalysis::getBlockVisitCount() const noexcept
+    {
+        return _state->visitCount;
+    }
+
+    std::size_t LivenessAnalysis::getDecodeCount() const noexcept
+    {
+        return _state->decodeCount;
+    }
+
+    void LivenessAnalysis::onNodeDestroy(Node* node)
+    {
+        invalidate(node);
+    }
+
+} // namespace zasm
@@ -4,58 +4,28 @@
 
 namespace zasm
 {
-    static constexpr std::uint64_t kErrorExtBit = 0x8000000000000000ULL;
-
     struct ErrorExt
     {
         ErrorCode code;
         std::string message;
     };
-	static bool isExtError(std::uint64_t data) noexcept
-    {
-        return (data & kErrorExtBit) != 0;
-    }
 
     // TODO: This is not fully portable so we should check for systems where
     // we have to use a different approach.
-    static ErrorExt* toErrorExt(std::uint64_t data) noexcept
+    static ErrorExt* toErrorExt(std::uintptr_t data, std::uintptr_t extBit) noexcept
     {
-        assert(isExtError(data));
+        assert((data & extBit) != 0);
 
-        auto* ext = reinterpret_cast<ErrorExt*>(data & ~kErrorExtBit);
+        auto* ext = reinterpret_cast<ErrorExt*>(data & ~extBit);
         return ext;
     }
 
-    static std::uint64_t toInternalErrorData(const ErrorExt* ext) noexcept
-    {
-        return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(ext)) | kErrorExtBit;
-    }
-
-    Error::Error(const Error& other)
-    {
-        if (isExtError(other._data))
-        {
-            const auto* ext = toErrorExt(other._data);
-
-            auto* newExt = new ErrorExt(*ext);
-            _data = toInternalErrorData(newExt);
-        }
-        else
-        {
-            _data = other._data;
-        }
-    }
-
-    Error::Error(Error&& other) noexcept
+    static std::uintptr_t toInternalErrorData(const ErrorExt* ext, std::uintptr_t extBit) noexcept
     {
-        _data = other._data;
-        other._data = 0;
-    }
+        // The top bit of user space pointers is clear on the supported platforms.
+        assert((reinterpret_cast<std::uintptr_t>(ext) & extBit) == 0);
 
-    Error::Error(ErrorCode code) noexcept
-    {
-        std::uint64_t data = static_cast<std::uint64_t>(code);
-        _data = data;
+        return reinterpret_cast<std::uintptr_t>(ext) | extBit;
     }
 
     Error::Error(ErrorCode code, const char* message)
@@ -66,89 +36,29 @@ namespace zasm
         ext->code = code;
         ext->message = message;
 
-        _data = toInternalErrorData(ext);
+        _data = toInternalErrorData(ext, kExtBit);
     }
 
-    Error::~Error() noexcept
+    void Error::copyExt(const Error& other)
     {
-        clear();
-    }
-
-    void Error::clear()
-    {
-        if (isExtError(_data))
-        {
-            const auto* ext = toErrorExt(_data);
-            delete ext;
-        }
-        _data = 0;
-    }
+        const auto* ext = toErrorExt(other._data, kExtBit);
 
-    bool Error::empty() const noexcept
-    {
-        return _data == 0;
+        auto* newExt = new ErrorExt(*ext);
+        _data = toInternalErrorData(newExt, kExtBit);
     }
 
-    bool Error::operator==(ErrorCode code) const noexcept
+    void Error::destroyExt() noexcept
     {
-        return getCode() == code;
-    }
+        const auto* ext = toErrorExt(_data, kExtBit);
+        delete ext;
 
-    bool Error::operator!=(ErrorCode code) const noexcept
-    {
-        return !(*this == code);
-    }
-
-    Error& Error::operator=(Error&& other) noexcept
-    {
-        clear();
-
-        _data = other._data;
-        other._data = 0;
-
-        return *this;
-    }
-
-    Error& Error::operator=(const Error& other) noexcept
-    {
-        clear();
-
-        if (isExtError(other._data))
-        {
-            const auto* ext = toErrorExt(other._data);
-
-            auto* newExt = new ErrorExt(*ext);
-            _data = toInternalErrorData(newExt);
-        }
-        else
-        {
-            _data = other._data;
-        }
-
-        return *this;
-    }
-
-    static ErrorCode getErrorCode(std::uint64_t data) noexcept
-    {
-        if (data == 0)
-        {
-            return ErrorCode::None;
-        }
-
-        if (isExtError(data))
-        {
-            const auto* ext = toErrorExt(data);
-            return ext->code;
-        }
-        else
-        {
-            return static_cast<ErrorCode>(data);
-        }
+        _data = 0;
     }
 
-    ErrorCode Error::getCode() const noexcept
+    ErrorCode Error::getExtCode() const noexcept
     {
-        return getErrorCode(_data);
+        const auto* ext = toErrorExt(_data, kExtBit);
+        return ext->code;
     }
 
     static constexpr const char* getErrorCodeName(ErrorCode err) noexcept
@@ -254,9 +164,9 @@ namespace zasm
 
     const char* Error::getErrorMessage() const noexcept
     {
-        if (isExtError(_data))
+        if (isExt())
         {
-            const auto* ext = toErrorExt(_data);
+            const auto* ext = toErrorExt(_data, kExtBit);
             return ext->message.c_str();
         }
         else
@@ -56,6 +56,8 @@ namespace zasm
             Label::Id id{ Label::Id::Invalid };
             std::int32_t boundOffset{ kUnboundOffset };
             std::int64_t boundVA{ kUnboundVA };
+            // Set when the address was requested while the label was unbound.
+            bool referenced{};
 
             constexpr bool isBound() const noexcept
             {
@@ -63,6 +65,12 @@ namespace zasm
             }
         };
 
+        struct LabelStats
+        {
+            std::size_t lookups{};
+            std::size_t unresolvedLookups{};
+        };
+
         struct Node
         {
         public:
@@ -76,7 +84,24 @@ namespace zasm
 
         std::vector<EncoderSection> sections;
         std::vector<LabelLink> labelLinks;
+        // Dense copy of LabelLink::boundVA, used for the lookups during encoding.
+        std::vector<std::int64_t> labelVAs;
         std::vector<Node> nodes;
+        LabelStats labelStats;
+
+        // Sizes the link table for the given amount of labels, this avoids growing the table
+        // while encoding.
+        void initLabelLinks(std::size_t numLabels)
+        {
+            labelLinks.resize(numLabels);
+            labelVAs.resize(numLabels);
+
+            for (std::size_t i = 0; i < numLabels; i++)
+            {
+                labelLinks[i] = LabelLink{ static_cast<Label::Id>(i) };
+                labelVAs[i] = LabelLink::kUnboundVA;
+            }
+        }
 
         LabelLink& getOrCreateLabelLink(Label::Id id)
         {
@@ -87,31 +112,48 @@ namespace zasm
             {
                 const auto resizeStartIndex = labelLinks.size();
                 labelLinks.resize(labelIdx + 1);
+                labelVAs.resize(labelIdx + 1, LabelLink::kUnboundVA);
 
                 // Ensure each entry has a valid id assigned.
                 for (std::size_t i = resizeStartIndex; i < labelLinks.size(); i++)
                 {
                     labelLinks[i].id = static_cast<Label::Id>(i);
                 }
-
-                auto& entry = labelLinks[labelIdx];
-                return entry;
             }
 
             return labelLinks[labelIdx];
         }
 
+        void bindLabelLink(Label::Id id, std::int32_t offset, std::int64_t va)
+        {
+            auto& entry = getOrCreateLabelLink(id);
+            entry.boundOffset = offset;
+            entry.boundVA = va;
+
+            labelVAs[static_cast<std::size_t>(id)] = va;
+        }
+
         std::optional<std::int64_t> getLabelAddress(Label::Id id)
         {
             assert(id != Label::Id::Invalid);
 
-            const auto& entry = getOrCreateLabelLink(id);
-            if (entry.boundVA == -1)
+            labelStats.lookups++;
+
+            const auto labelIdx = static_cast<std::size_t>(id);
+            if (labelIdx >= labelVAs.size())
+            {
+                getOrCreateLabelLink(id);
+            }
+
+            const auto va = labelVAs[labelIdx];
+            if (va == LabelLink::kUnboundVA)
             {
+                labelLinks[labelIdx].referenced = true;
+                labelStats.unresolvedLookups++;
                 return std::nullopt;
             }
 
-            return entry.boundVA;
+            return va;
         }
     };
 } // namespace zasm
@@ -8,9 +8,16 @@
 #include <Zydis/Decoder.h>
 #include <Zydis/Encoder.h>
 #include <cstddef>
+#include <cstdio>
 #include <limits>
 #include <optional>
 
+#if defined(_MSC_VER)
+#    define ZASM_COLD_NOINLINE __declspec(noinline)
+#else
+#    define ZASM_COLD_NOINLINE __attribute__((noinline, cold))
+#endif
+
 namespace zasm
 {
     // Ensure size is correct.
@@ -33,6 +40,16 @@ namespace zasm
 
     static constexpr std::int32_t kHintRequiresSize = -1;
 
+    // Errors with a message are rare, keeping their construction out of line keeps the
+    // encoding functions small.
+    ZASM_COLD_NOINLINE static Error makeOperandError(ErrorCode code, const char* what, std::size_t operandIndex)
+    {
+        char msg[128];
+        std::snprintf(msg, sizeof(msg), "%s for operand %zu", what, operandIndex);
+
+        return Error(code, msg);
+    }
+
     static constexpr auto kAllowedEncodingX86 = static_cast<ZydisEncodableEncoding>(
         ZYDIS_ENCODABLE_ENCODING_LEGACY | ZYDIS_ENCODABLE_ENCODING_3DNOW);
 
@@ -247,10 +264,7 @@ namespace zasm
             const auto [addrRel, branchType] = processRelAddress(encodeInfo, ctx, targetAddress);
             if (branchType == ZydisBranchType::ZYDIS_BRANCH_TYPE_NONE)
             {
-                char msg[128];
-                std::snprintf(msg, sizeof(msg), "Label out of range for operand %zu", state.operandIndex);
-
-                return Error(ErrorCode::AddressOutOfRange, msg);
+                return makeOperandError(ErrorCode::AddressOutOfRange, "Label out of range", state.operandIndex);
             }
 
             immValue = addrRel;
@@ -400,10 +414,8 @@ namespace zasm
                     displacement = displacement - (address + instrSize);
                     if (std::abs(displacement) > std::numeric_limits<std::int32_t>::max())
                     {
-                        char msg[128];
-                        std::snprintf(msg, sizeof(msg), "Displacement out of range for operand %zu", state.operandIndex);
-
-                        return Error(ErrorCode::AddressOutOfRange, msg);
+                        return makeOperandError(
+                            ErrorCode::AddressOutOfRange, "Displacement out of range", state.operandIndex);
                     }
                 }
             }
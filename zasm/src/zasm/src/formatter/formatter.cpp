@@ -1,16 +1,22 @@
 #include <Zydis/Register.h>
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
-#include <cinttypes>
 #include <cmath>
 #include <cstddef>
-#include <cstdlib>
 #include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
 #include <zasm/base/register.hpp>
+#include <zasm/core/errors.hpp>
+#include <zasm/core/stream.hpp>
 #include <zasm/formatter/formatter.hpp>
 #include <zasm/program/instruction.hpp>
 #include <zasm/program/node.hpp>
 #include <zasm/program/program.hpp>
+#include <zasm/serialization/serializer.hpp>
 #include <zasm/x86/meta.hpp>
 #include <zasm/x86/mnemonic.hpp>
 #include <zasm/x86/register.hpp>
@@ -22,43 +28,30 @@ namespace zasm::formatter
         struct Context
         {
         public:
-            static constexpr std::size_t kInlineCapacity = 64;
-
             const Program* program{};
             Options options{};
+            std::string& out;
+            std::size_t start{};
+            std::size_t flushed{};
 
-            union
-            {
-                char* ptr;
-                std::array<char, kInlineCapacity> buf;
-            } _data{};
-
-            std::size_t size{};
-            std::size_t capacity{ kInlineCapacity };
-
-            constexpr Context() = delete;
-            constexpr Context(Options opts)
+            Context() = delete;
+            Context(std::string& buffer, Options opts)
                 : program(nullptr)
                 , options(opts)
+                , out(buffer)
+                , start(buffer.size())
             {
             }
-            constexpr Context(const Program& prog, Options opts)
+            Context(std::string& buffer, const Program& prog, Options opts)
                 : program(&prog)
                 , options(opts)
+                , out(buffer)
+                , start(buffer.size())
             {
             }
             Context(const Context&) = delete;
             Context(Context&&) = delete;
 
-            ~Context()
-            {
-                if (capacity > kInlineCapacity)
-                {
-                    // NOLINTNEXTLINE
-                    std::free(_data.ptr);
-                }
-            }
-
             Context& operator=(const Context&) = delete;
             Context& operator=(Context&&) = delete;
 
@@ -80,35 +73,83 @@ namespace zasm::formatter
 
             void append(const char* str, std::size_t len)
             {
-                const std::size_t spaceLeft = capacity - size;
-                if (len > spaceLeft)
+                out.append(str, len);
+            }
+
+            void appendChar(char chr)
+            {
+                out.push_back(chr);
+            }
+
+            void appendDec(std::uint64_t value)
+            {
+                // Two digits at a time.
+                static constexpr char kDigitPairs[] = "00010203040506070809"
+                                                      "10111213141516171819"
+                                                      "20212223242526272829"
+                                                      "30313233343536373839"
+                                                      "40414243444546474849"
+                                                      "50515253545556575859"
+                                                      "60616263646566676869"
+                                                      "70717273747576777879"
+                                                      "80818283848586878889"
+                                                      "90919293949596979899";
+
+                std::array<char, 20> buf{};
+                std::size_t pos = buf.size();
+                while (value >= 100)
+                {
+                    const auto pair = static_cast<std::size_t>(value % 100) * 2;
+                    value /= 100;
+                    buf[--pos] = kDigitPairs[pair + 1];
+                    buf[--pos] = kDigitPairs[pair];
+                }
+                if (value >= 10)
+                {
+                    const auto pair = static_cast<std::size_t>(value) * 2;
+                    buf[--pos] = kDigitPairs[pair + 1];
+                    buf[--pos] = kDigitPairs[pair];
+                }
+                else
                 {
-                    growBuffer(len);
+                    buf[--pos] = static_cast<char>('0' + value);
                 }
-                std::memcpy(data() + size, str, len);
-                size += len;
+                append(buf.data() + pos, buf.size() - pos);
             }
 
-            template<typename TFmt, typename... TArgs> void format(TFmt&& fmt, TArgs&&... args)
+            void appendSignedDec(std::int64_t value)
             {
-                std::size_t spaceLeft = capacity - size;
-                // NOLINTNEXTLINE
-                int len = snprintf(data() + size, spaceLeft, std::forward<TFmt>(fmt), std::forward<TArgs>(args)...);
-                if (len >= spaceLeft)
+                if (value < 0)
                 {
-                    growBuffer(len);
-
-                    spaceLeft = capacity - size;
-                    // NOLINTNEXTLINE
-                    len = snprintf(data() + size, spaceLeft, std::forward<TFmt>(fmt), std::forward<TArgs>(args)...);
+                    appendChar('-');
+                    // Negate as unsigned to handle the minimum value.
+                    return appendDec(0 - static_cast<std::uint64_t>(value));
                 }
+                return appendDec(static_cast<std::uint64_t>(value));
+            }
 
-                size += len;
+            void appendHex(std::uint64_t value, std::size_t minDigits)
+            {
+                static constexpr char kHexDigits[] = "0123456789abcdef";
+
+                std::array<char, 16> buf{};
+                std::size_t pos = buf.size();
+                do
+                {
+                    buf[--pos] = kHexDigits[value & 0xF];
+                    value >>= 4;
+                } while (value != 0);
+
+                while (pos > 0 && buf.size() - pos < minDigits)
+                {
+                    buf[--pos] = '0';
+                }
+                append(buf.data() + pos, buf.size() - pos);
             }
 
             bool empty() const noexcept
             {
-                return size == 0;
+                return flushed == 0 && out.size() == start;
             }
 
             bool hasOption(Options opt) const noexcept
@@ -116,45 +157,23 @@ namespace zasm::formatter
                 return (options & opt) != Options::None;
             }
 
-            char* data() noexcept
+            /// <summary>
+            /// Writes the buffered text to the stream and clears the buffer.
+            /// </summary>
+            Error flush(IStream& stream)
             {
-                if (capacity <= kInlineCapacity)
+                const auto len = out.size() - start;
+                if (len == 0)
                 {
-                    return _data.buf.data();
+                    return ErrorCode::None;
                 }
-                return _data.ptr;
-            }
-
-            void growBuffer(std::size_t extraLen) noexcept
-            {
-                assert(extraLen > 0);
-
-                const std::size_t newCapacity = (capacity + extraLen) << 2;
-
-                char* ptr = nullptr;
-                if (capacity > kInlineCapacity)
+                if (stream.write(out.data() + start, len) != len)
                 {
-                    // NOLINTNEXTLINE
-                    ptr = static_cast<char*>(std::realloc(_data.ptr, newCapacity));
+                    return ErrorCode::InvalidParameter;
                 }
-                else
-                {
-                    // NOLINTNEXTLINE
-                    ptr = static_cast<char*>(std::malloc(newCapacity));
-                    if (ptr != nullptr)
-                    {
-                        std::memcpy(ptr, _data.buf.data(), size);
-                    }
-                }
-
-                if (ptr == nullptr)
-                {
-                    assert(ptr != nullptr);
-                    return;
-                }
-
-                _data.ptr = ptr;
-                capacity = newCapacity;
+                out.resize(start);
+                flushed += len;
+                return ErrorCode::None;
             }
         };
 
@@ -181,16 +200,18 @@ namespace zasm::formatter
             {
                 if (val < 0)
                 {
-                    ctx.format("-0x%08" PRIx64, -val);
+                    ctx.appendLiteral("-0x");
+                    ctx.appendHex(0 - static_cast<std::uint64_t>(val), 8);
                 }
                 else
                 {
-                    ctx.format("0x%08" PRIx64, val);
+                    ctx.appendLiteral("0x");
+                    ctx.appendHex(static_cast<std::uint64_t>(val), 8);
                 }
             }
             else
             {
-                ctx.format("%" PRId64, val);
+                ctx.appendSignedDec(val);
             }
         }
 
@@ -201,12 +222,13 @@ namespace zasm::formatter
                 auto labelData = ctx.program->getLabelData(label);
                 if (labelData.hasValue() && labelData->name != nullptr)
                 {
-                    ctx.format("%s", labelData->name);
+                    ctx.appendString(labelData->name);
                     return;
                 }
             }
 
-            ctx.format("L%u", label.getId());
+            ctx.appendChar('L');
+            ctx.appendDec(static_cast<std::uint32_t>(label.getId()));
         }
 
         static void opToString(Context& ctx, const Label& label)
@@ -301,7 +323,8 @@ namespace zasm::formatter
 
                 if (opMem.getScale() > 1)
                 {
-                    ctx.format("*%d", opMem.getScale());
+                    ctx.appendChar('*');
+                    ctx.appendDec(static_cast<std::uint64_t>(opMem.getScale()));
                 }
             }
 
@@ -334,27 +357,15 @@ namespace zasm::formatter
                 {
                     ctx.appendLiteral("rel ");
                 }
+                const auto absDisp = disp < 0 ? 0 - static_cast<std::uint64_t>(disp) : static_cast<std::uint64_t>(disp);
                 if (ctx.hasOption(Options::HexOffsets))
                 {
-                    if (disp < 0)
-                    {
-                        ctx.format("0x%02" PRIx64, -disp);
-                    }
-                    else
-                    {
-                        ctx.format("0x%02" PRIx64, disp);
-                    }
+                    ctx.appendLiteral("0x");
+                    ctx.appendHex(absDisp, 2);
                 }
                 else
                 {
-                    if (disp < 0)
-                    {
-                        ctx.format("%" PRId64, -disp);
-                    }
-                    else
-                    {
-                        ctx.format("%" PRId64, disp);
-                    }
+                    ctx.appendDec(absDisp);
                 }
             }
             else
@@ -374,10 +385,10 @@ namespace zasm::formatter
 
         static void nodeToString(Context& ctx, const Align& node) noexcept
         {
+            ctx.appendLiteral(".align ");
+            ctx.appendDec(node.getAlign());
             if (node.getType() == Align::Type::Code)
-                ctx.format(".align %u, nop", node.getAlign());
-            else
-                ctx.format(".align %u", node.getAlign());
+                ctx.appendLiteral(", nop");
         }
 
         static void dataPrefix(Context& ctx, BitSize size)
@@ -412,37 +423,49 @@ namespace zasm::formatter
             {
                 if (node.getRepeatCount() > 1)
                 {
-                    ctx.format("times %zu ", node.getRepeatCount());
+                    ctx.appendLiteral("times ");
+                    ctx.appendDec(node.getRepeatCount());
+                    ctx.appendChar(' ');
                 }
                 dataPrefix(ctx, BitSize::_8);
-                ctx.format("0x%02" PRIx8, node.valueAsU8());
+                ctx.appendLiteral("0x");
+                ctx.appendHex(node.valueAsU8(), 2);
             }
             else if (node.isU16())
             {
                 if (node.getRepeatCount() > 1)
                 {
-                    ctx.format("times %zu ", node.getRepeatCount());
+                    ctx.appendLiteral("times ");
+                    ctx.appendDec(node.getRepeatCount());
+                    ctx.appendChar(' ');
                 }
                 dataPrefix(ctx, BitSize::_16);
-                ctx.format("0x%04" PRIx16, node.valueAsU16());
+                ctx.appendLiteral("0x");
+                ctx.appendHex(node.valueAsU16(), 4);
             }
             else if (node.isU32())
             {
                 if (node.getRepeatCount() > 1)
                 {
-                    ctx.format("times %zu ", node.getRepeatCount());
+                    ctx.appendLiteral("times ");
+                    ctx.appendDec(node.getRepeatCount());
+                    ctx.appendChar(' ');
                 }
                 dataPrefix(ctx, BitSize::_32);
-                ctx.format("0x%08" PRIx32, node.valueAsU32());
+                ctx.appendLiteral("0x");
+                ctx.appendHex(node.valueAsU32(), 8);
             }
             else if (node.isU64())
             {
                 if (node.getRepeatCount() > 1)
                 {
-                    ctx.format("times %zu ", node.getRepeatCount());
+                    ctx.appendLiteral("times ");
+                    ctx.appendDec(node.getRepeatCount());
+                    ctx.appendChar(' ');
                 }
                 dataPrefix(ctx, BitSize::_64);
-                ctx.format("0x%016" PRIx64, node.valueAsU64());
+                ctx.appendLiteral("0x");
+                ctx.appendHex(node.valueAsU64(), 16);
             }
             else
             {
@@ -468,7 +491,8 @@ namespace zasm::formatter
                         ctx.appendLiteral(", ");
                     }
 
-                    ctx.format("0x%02" PRIx8, data[i]);
+                    ctx.appendLiteral("0x");
+                    ctx.appendHex(data[i], 2);
                     bytesOnLine++;
                 }
             }
@@ -485,7 +509,8 @@ namespace zasm::formatter
             if (ctx.program != nullptr)
             {
                 const char* str = ctx.program->getSectionName(node);
-                ctx.format(".section %s", str);
+                ctx.appendLiteral(".section ");
+                ctx.appendString(str);
             }
             else
             {
@@ -547,60 +572,397 @@ namespace zasm::formatter
             }
         }
 
-    } // namespace detail
+        static void formatNode(Context& ctx, const Node* node)
+        {
+            if (node == nullptr)
+            {
+                ctx.appendLiteral("<nullptr>");
+                return;
+            }
 
-    std::string toString(const Program& program, const Node* node, Options options /*= kDefaultOptions*/)
-    {
-        if (node == nullptr)
+            node->visit([&](auto&& n) { nodeToString(ctx, n); });
+        }
+
+        template<typename TOnNode>
+        static Error formatRange(Context& ctx, const Node* nodeFrom, const Node* nodeTo, TOnNode&& onNode)
         {
-            return "<nullptr>";
+            const auto* node = nodeFrom;
+            while (node != nullptr && node != nodeTo)
+            {
+                if (!ctx.empty())
+                {
+                    ctx.appendLiteral("\n");
+                }
+
+                node->visit([&](auto&& n) { nodeToString(ctx, n); });
+
+                if (auto err = onNode(); err != ErrorCode::None)
+                {
+                    return err;
+                }
+
+                node = node->getNext();
+            }
+
+            return ErrorCode::None;
         }
 
-        auto ctx = detail::Context(program, options);
+        // Maximum amount of encoded bytes shown per line of a listing, longer nodes are truncated.
+        static constexpr std::size_t kListingMaxBytes = 10;
 
-        node->visit([&](auto&& n) { detail::nodeToString(ctx, n); });
+        static void listingPrefix(Context& ctx, const Serializer& serializer, const NodeInfo& info, std::size_t addrDigits)
+        {
+            ctx.appendHex(static_cast<std::uint64_t>(info.address), addrDigits);
+            ctx.appendLiteral("  ");
 
-        return { ctx.data(), ctx.size };
-    }
+            const auto length = static_cast<std::size_t>(info.length);
+            const bool truncated = length > kListingMaxBytes;
+            const auto numBytes = truncated ? kListingMaxBytes - 1 : length;
 
-    std::string toString(const Program& program, Options options /*= {}*/)
-    {
-        return toString(program, program.getHead(), nullptr, options);
-    }
+            const auto* code = serializer.getCode();
+            for (std::size_t i = 0; i < numBytes; ++i)
+            {
+                ctx.appendHex(code[static_cast<std::size_t>(info.offset) + i], 2);
+                ctx.appendChar(' ');
+            }
 
-    std::string toString(
-        const Program& program, const Node* nodeFrom, const Node* nodeTo, Options options /*= kDefaultOptions*/)
-    {
-        auto ctx = detail::Context(program, options);
+            std::size_t column = numBytes;
+            if (truncated)
+            {
+                ctx.appendLiteral(".. ");
+                column++;
+            }
+            for (; column < kListingMaxBytes; ++column)
+            {
+                ctx.appendLiteral("   ");
+            }
+            ctx.appendChar(' ');
+        }
 
-        const auto* node = nodeFrom;
-        while (node != nullptr && node != nodeTo)
+        static void indentContinuation(std::string& out, std::size_t textStart, std::size_t indent)
         {
-            if (!ctx.empty())
+            // Only nodes such as large data blocks span multiple lines.
+            if (out.find('\n', textStart) == std::string::npos)
+            {
+                return;
+            }
+
+            const std::string text = out.substr(textStart);
+            out.resize(textStart);
+            for (const char chr : text)
+            {
+                out.push_back(chr);
+                if (chr == '\n')
+                {
+                    out.append(indent, ' ');
+                }
+            }
+        }
+
+        static void formatListing(Context& ctx, const Serializer& serializer)
+        {
+            const auto addrDigits = ctx.program->getMode() == MachineMode::AMD64 ? 16U : 8U;
+            // Address, two spaces, the byte column and a trailing space.
+            const auto indent = addrDigits + 2 + kListingMaxBytes * 3 + 1;
+
+            const auto* node = serializer.getFirstNode();
+            for (std::size_t index = 0; index < serializer.getNodeCount() && node != nullptr; ++index)
+            {
+                if (!ctx.empty())
+                {
+                    ctx.appendLiteral("\n");
+                }
+
+                listingPrefix(ctx, serializer, serializer.getNodeInfo(index), addrDigits);
+
+                const auto textStart = ctx.out.size();
+                node->visit([&](auto&& n) { nodeToString(ctx, n); });
+                indentContinuation(ctx.out, textStart, indent);
+
+                node = node->getNext();
+            }
+        }
+
+        struct Chunk
+        {
+            const Node* nodeFrom{};
+            const Node* nodeTo{};
+            std::string text;
+            // Length of the leading separators up to the first node with output, those
+            // are dropped when nothing was written before this chunk.
+            std::size_t leadLen{};
+        };
+
+        static constexpr std::size_t kNodesPerChunk = 8192;
+        static constexpr std::size_t kChunksPerThread = 4;
+
+        static void formatChunk(const Program& program, Options options, Chunk& chunk)
+        {
+            auto ctx = Context(chunk.text, program, options);
+
+            bool hasOutput = false;
+            for (const auto* node = chunk.nodeFrom; node != nullptr && node != chunk.nodeTo; node = node->getNext())
             {
                 ctx.appendLiteral("\n");
+
+                const auto prevSize = chunk.text.size();
+                node->visit([&](auto&& n) { nodeToString(ctx, n); });
+
+                if (!hasOutput && chunk.text.size() != prevSize)
+                {
+                    chunk.leadLen = prevSize;
+                    hasOutput = true;
+                }
+            }
+
+            if (!hasOutput)
+            {
+                chunk.leadLen = chunk.text.size();
+            }
+        }
+
+        static std::size_t getNumThreads(std::size_t numThreads) noexcept
+        {
+            if (numThreads == 0)
+            {
+                numThreads = std::thread::hardware_concurrency();
             }
+            return std::max<std::size_t>(numThreads, 1);
+        }
+
+        /// <summary>
+        /// Splits the range into chunks which are formatted by multiple threads, the chunks are handed
+        /// to the sink in order. The program is only read so label and section names resolve the
+        /// same on every thread.
+        /// </summary>
+        template<typename TSink>
+        static Error formatParallel(
+            const Program& program, const Node* nodeFrom, const Node* nodeTo, Options options, std::size_t numThreads,
+            TSink&& sink)
+        {
+            numThreads = getNumThreads(numThreads);
+
+            // Precompute the chunk boundaries, walking the list is cheap compared to formatting.
+            std::vector<Chunk> chunks;
+            {
+                std::size_t nodeCount = 0;
+                for (const auto* node = nodeFrom; node != nullptr && node != nodeTo; node = node->getNext())
+                {
+                    if (nodeCount % kNodesPerChunk == 0)
+                    {
+                        if (!chunks.empty())
+                        {
+                            chunks.back().nodeTo = node;
+                        }
+                        chunks.emplace_back().nodeFrom = node;
+                    }
+                    nodeCount++;
+                }
+                if (!chunks.empty())
+                {
+                    chunks.back().nodeTo = nodeTo;
+                }
+            }
+
+            // Chunks are processed in windows to bound the memory held by formatted text.
+            const auto windowSize = numThreads * kChunksPerThread;
+            for (std::size_t windowStart = 0; windowStart < chunks.size(); windowStart += windowSize)
+            {
+                const auto windowEnd = std::min(windowStart + windowSize, chunks.size());
 
-            node->visit([&](auto&& n) { detail::nodeToString(ctx, n); });
+                std::atomic<std::size_t> nextChunk{ windowStart };
+                const auto worker = [&]() {
+                    for (auto idx = nextChunk++; idx < windowEnd; idx = nextChunk++)
+                    {
+                        formatChunk(program, options, chunks[idx]);
+                    }
+                };
+
+                std::vector<std::thread> threads;
+                const auto numWorkers = std::min(numThreads, windowEnd - windowStart);
+                for (std::size_t i = 1; i < numWorkers; ++i)
+                {
+                    threads.emplace_back(worker);
+                }
+                worker();
+                for (auto& thread : threads)
+                {
+                    thread.join();
+                }
 
-            node = node->getNext();
+                for (std::size_t idx = windowStart; idx < windowEnd; ++idx)
+                {
+                    if (auto err = sink(chunks[idx]); err != ErrorCode::None)
+                    {
+                        return err;
+                    }
+                    chunks[idx].text = {};
+                }
+            }
+
+            return ErrorCode::None;
         }
 
-        return { ctx.data(), ctx.size };
+    } // namespace detail
+
+    void format(std::string& buffer, const Program& program, Options options /*= kDefaultOptions*/)
+    {
+        format(buffer, program, program.getHead(), nullptr, options);
     }
 
-    std::string toString(const Program& program, const Instruction* instr, Options options /*= kDefaultOptions*/)
+    void format(std::string& buffer, const Program& program, const Node* node, Options options /*= kDefaultOptions*/)
+    {
+        auto ctx = detail::Context(buffer, program, options);
+
+        detail::formatNode(ctx, node);
+    }
+
+    void format(
+        std::string& buffer, const Program& program, const Node* nodeFrom, const Node* nodeTo,
+        Options options /*= kDefaultOptions*/)
+    {
+        auto ctx = detail::Context(buffer, program, options);
+
+        detail::formatRange(ctx, nodeFrom, nodeTo, []() -> Error { return ErrorCode::None; });
+    }
+
+    void format(std::string& buffer, const Program& program, const Instruction* instr, Options options /*= kDefaultOptions*/)
     {
         if (instr == nullptr)
         {
-            return "<nullptr>";
+            buffer.append("<nullptr>");
+            return;
         }
 
-        auto ctx = detail::Context(program, options);
+        auto ctx = detail::Context(buffer, program, options);
 
         detail::nodeToString(ctx, *instr);
+    }
+
+    void format(
+        std::string& buffer, const Program& program, const Serializer& serializer, Options options /*= kDefaultOptions*/)
+    {
+        auto ctx = detail::Context(buffer, program, options);
 
-        return { ctx.data(), ctx.size };
+        detail::formatListing(ctx, serializer);
+    }
+
+    Error format(IStream& stream, const Program& program, Options options /*= kDefaultOptions*/)
+    {
+        return format(stream, program, program.getHead(), nullptr, options);
+    }
+
+    Error format(
+        IStream& stream, const Program& program, const Node* nodeFrom, const Node* nodeTo,
+        Options options /*= kDefaultOptions*/)
+    {
+        constexpr std::size_t kStreamChunkSize = 64 * 1024;
+
+        std::string buffer;
+        buffer.reserve(kStreamChunkSize + 256);
+
+        auto ctx = detail::Context(buffer, program, options);
+
+        auto err = detail::formatRange(ctx, nodeFrom, nodeTo, [&]() -> Error {
+            if (buffer.size() < kStreamChunkSize)
+            {
+                return ErrorCode::None;
+            }
+            return ctx.flush(stream);
+        });
+        if (err != ErrorCode::None)
+        {
+            return err;
+        }
+
+        return ctx.flush(stream);
+    }
+
+    void formatParallel(
+        std::string& buffer, const Program& program, Options options /*= kDefaultOptions*/, std::size_t numThreads /*= 0*/)
+    {
+        formatParallel(buffer, program, program.getHead(), nullptr, options, numThreads);
+    }
+
+    void formatParallel(
+        std::string& buffer, const Program& program, const Node* nodeFrom, const Node* nodeTo,
+        Options options /*= kDefaultOptions*/, std::size_t numThreads /*= 0*/)
+    {
+        const auto start = buffer.size();
+
+        detail::formatParallel(program, nodeFrom, nodeTo, options, numThreads, [&](const detail::Chunk& chunk) -> Error {
+            if (buffer.size() == start)
+            {
+                buffer.append(chunk.text, chunk.leadLen);
+            }
+            else
+            {
+                buffer.append(chunk.text);
+            }
+            return ErrorCode::None;
+        });
+    }
+
+    Error formatParallel(
+        IStream& stream, const Program& program, Options options /*= kDefaultOptions*/, std::size_t numThreads /*= 0*/)
+    {
+        return formatParallel(stream, program, program.getHead(), nullptr, options, numThreads);
+    }
+
+    Error formatParallel(
+        IStream& stream, const Program& program, const Node* nodeFrom, const Node* nodeTo,
+        Options options /*= kDefaultOptions*/, std::size_t numThreads /*= 0*/)
+    {
+        bool hasOutput = false;
+
+        return detail::formatParallel(program, nodeFrom, nodeTo, options, numThreads, [&](const detail::Chunk& chunk) -> Error {
+            const auto offset = hasOutput ? 0 : chunk.leadLen;
+            const auto len = chunk.text.size() - offset;
+            if (len == 0)
+            {
+                return ErrorCode::None;
+            }
+            if (stream.write(chunk.text.data() + offset, len) != len)
+            {
+                return ErrorCode::InvalidParameter;
+            }
+            hasOutput = true;
+            return ErrorCode::None;
+        });
+    }
+
+    std::string toString(const Program& program, const Node* node, Options options /*= kDefaultOptions*/)
+    {
+        std::string res;
+        format(res, program, node, options);
+        return res;
+    }
+
+    std::string toString(const Program& program, Options options /*= {}*/)
+    {
+        return toString(program, program.getHead(), nullptr, options);
+    }
+
+    std::string toString(
+        const Program& program, const Node* nodeFrom, const Node* nodeTo, Options options /*= kDefaultOptions*/)
+    {
+        std::string res;
+        format(res, program, nodeFrom, nodeTo, options);
+        return res;
+    }
+
+    std::string toString(const Program& program, const Instruction* instr, Options options /*= kDefaultOptions*/)
+    {
+        std::string res;
+        format(res, program, instr, options);
+        return res;
+    }
+
+    std::string toString(const Program& program, const Serializer& serializer, Options options /*= kDefaultOptions*/)
+    {
+        std::string res;
+        format(res, program, serializer, options);
+        return res;
     }
 
     std::string toString(const Instruction* instr, Options options /*= kDefaultOptions*/)
@@ -610,20 +972,22 @@ namespace zasm::formatter
             return "<nullptr>";
         }
 
-        auto ctx = detail::Context(options);
+        std::string res;
+        auto ctx = detail::Context(res, options);
 
         detail::nodeToString(ctx, *instr);
 
-        return { ctx.data(), ctx.size };
+        return res;
     }
 
     std::string toString(const Reg& reg, Options options /*= kDefaultOptions*/)
     {
-        auto ctx = detail::Context(options);
+        std::string res;
+        auto ctx = detail::Context(res, options);
 
         detail::opToString(ctx, reg);
 
-        return { ctx.data(), ctx.size };
+        return res;
     }
 
 } // namespace zasm::formatter
@@ -0,0 +1,680 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <vector>
+#include <zasm/analysis/cfg.hpp>
+#include <zasm/passes/blockreorder.hpp>
+#include <zasm/program/program.hpp>
+#include <zasm/x86/x86.hpp>
+
+namespace zasm
+{
+    namespace detail
+    {
+        static constexpr std::uint32_t kNoBlock = std::numeric_limits<std::uint32_t>::max();
+        static constexpr const char* kColdSectionName = ".text.cold";
+
+        enum class BlockEnd : std::uint8_t
+        {
+            Fallthrough,
+            Jump,
+            Branch,
+            Stop,
+        };
+
+        struct ReorderBlock
+        {
+            Node* head{};
+            Node* tail{};
+            BlockEnd end{};
+            std::uint64_t weight{};
+            bool hasWeight{};
+            // Indices of the successor blocks in the original order.
+            std::uint32_t fallthrough{ kNoBlock };
+            std::uint32_t target{ kNoBlock };
+            std::uint32_t chain{};
+            bool cold{};
+        };
+
+        struct ReorderEdge
+        {
+            std::uint64_t weight{};
+            std::uint32_t from{};
+            std::uint32_t to{};
+            bool isFallthrough{};
+        };
+
+        struct BlockReorderState
+        {
+            Program* program{};
+
+            std::vector<std::uint64_t> labelWeights;
+            std::vector<std::uint8_t> hasLabelWeight;
+
+            bool splitCold{};
+            std::uint64_t coldThreshold{};
+
+            std::vector<ReorderBlock> blocks;
+            std::vector<ReorderEdge> edges;
+            std::vector<std::vector<std::uint32_t>> chains;
+            std::vector<std::uint32_t> hotOrder;
+            std::vector<std::uint32_t> coldOrder;
+
+            BlockReorderStats stats;
+        };
+
+        static BlockEnd getBlockEnd(const Node* tail) noexcept
+        {
+            const auto* instr = tail->getIf<Instruction>();
+            if (instr == nullptr)
+            {
+                return BlockEnd::Fallthrough;
+            }
+
+            const auto mnemonic = instr->getMnemonic();
+            if (x86::isJmp(mnemonic))
+            {
+                return BlockEnd::Jump;
+            }
+            if (x86::isCondBranching(mnemonic) || mnemonic == x86::Mnemonic::Loop || mnemonic == x86::Mnemonic::Loope
+                || mnemonic == x86::Mnemonic::Loopne)
+            {
+                return BlockEnd::Branch;
+            }
+            if (x86::isRet(mnemonic) || mnemonic == x86::Mnemonic::Iret || mnemonic == x86::Mnemonic::Iretd
+                || mnemonic == x86::Mnemonic::Iretq || mnemonic == x86::Mnemonic::Ud2)
+            {
+                return BlockEnd::Stop;
+            }
+            return BlockEnd::Fallthrough;
+        }
+
+        static bool hasOnlyShortForm(InstrMnemonic mnemonic) noexcept
+        {
+            switch (mnemonic)
+            {
+                case x86::Mnemonic::Loop:
+                case x86::Mnemonic::Loope:
+                case x86::Mnemonic::Loopne:
+                case x86::Mnemonic::Jcxz:
+                case x86::Mnemonic::Jecxz:
+                case x86::Mnemonic::Jrcxz:
+                    return true;
+                default:
+                    break;
+            }
+            return false;
+        }
+
+        static InstrMnemonic getInvertedBranch(InstrMnemonic mnemonic) noexcept
+        {
+            switch (mnemonic)
+            {
+                case x86::Mnemonic::Jb:
+                    return x86::Mnemonic::Jnb;
+                case x86::Mnemonic::Jnb:
+                    return x86::Mnemonic::Jb;
+                case x86::Mnemonic::Jbe:
+                    return x86::Mnemonic::Jnbe;
+                case x86::Mnemonic::Jnbe:
+                    return x86::Mnemonic::Jbe;
+                case x86::Mnemonic::Jl:
+                    return x86::Mnemonic::Jnl;
+                case x86::Mnemonic::Jnl:
+                    return x86::Mnemonic::Jl;
+                case x86::Mnemonic::Jle:
+                    return x86::Mnemonic::Jnle;
+                case x86::Mnemonic::Jnle:
+                    return x86::Mnemonic::Jle;
+                case x86::Mnemonic::Jo:
+                    return x86::Mnemonic::Jno;
+                case x86::Mnemonic::Jno:
+                    return x86::Mnemonic::Jo;
+                case x86::Mnemonic::Jp:
+                    return x86::Mnemonic::Jnp;
+                case x86::Mnemonic::Jnp:
+                    return x86::Mnemonic::Jp;
+                case x86::Mnemonic::Js:
+                    return x86::Mnemonic::Jns;
+                case x86::Mnemonic::Jns:
+                    return x86::Mnemonic::Js;
+                case x86::Mnemonic::Jz:
+                    return x86::Mnemonic::Jnz;
+                case x86::Mnemonic::Jnz:
+                    return x86::Mnemonic::Jz;
+                default:
+                    break;
+            }
+            return x86::Mnemonic::Invalid;
+        }
+
+        static Label getBlockLabel(const ReorderBlock& block) noexcept
+        {
+            return block.head->get<Label>();
+        }
+
+        // Returns false if the blocks can not be reordered.
+        static bool collectBlocks(BlockReorderState& state, Node* first, Node* last)
+        {
+            auto& program = *state.program;
+            auto& blocks = state.blocks;
+
+            ControlFlowGraph cfg(program, first, last);
+            if (cfg.build() != ErrorCode::None)
+            {
+                return false;
+            }
+
+            std::vector<std::uint32_t> blockIndex(cfg.getBlockCount(), kNoBlock);
+            for (auto id = cfg.getEntryBlock(); id != BlockId::Invalid; id = cfg.getNextBlock(id))
+            {
+                const auto* block = cfg.getBlock(id);
+
+                auto& entry = blocks.emplace_back();
+                entry.head = block->head;
+                entry.tail = block->tail;
+                entry.end = getBlockEnd(block->tail);
+
+                if (const auto* instr = block->tail->getIf<Instruction>();
+                    instr != nullptr && hasOnlyShortForm(instr->getMnemonic()))
+                {
+                    return false;
+                }
+
+                blockIndex[static_cast<std::size_t>(id)] = static_cast<std::uint32_t>(blocks.size() - 1);
+            }
+
+            for (auto id = cfg.getEntryBlock(); id != BlockId::Invalid; id = cfg.getNextBlock(id))
+            {
+                auto& entry = blocks[blockIndex[static_cast<std::size_t>(id)]];
+                cfg.forEachSuccessor(id, [&](const CFGEdge& edge) {
+                    const auto to = blockIndex[static_cast<std::size_t>(edge.to)];
+                    if (edge.kind == EdgeKind::Fallthrough)
+                    {
+                        entry.fallthrough = to;
+                    }
+                    else
+                    {
+                        entry.target = to;
+                    }
+                });
+            }
+
+            return true;
+        }
+
+        // Every block except the first one must start with a label so it can be the target of a jump.
+        static void ensureLabels(BlockReorderState& state)
+        {
+            auto& program = *state.program;
+
+            for (std::size_t i = 1; i < state.blocks.size(); i++)
+            {
+                auto& block = state.blocks[i];
+                if (block.head->holds<Label>())
+                {
+                    continue;
+                }
+
+                const auto label = program.createLabel();
+                auto* labelNode = program.bindLabel(label).value();
+                program.insertBefore(block.head, labelNode);
+                block.head = labelNode;
+            }
+        }
+
+        static void assignWeights(BlockReorderState& state)
+        {
+            auto& blocks = state.blocks;
+
+            for (auto& block : blocks)
+            {
+                for (const auto* node = block.head; node != nullptr && node->holds<Label>(); node = node->getNext())
+                {
+                    const auto idx = static_cast<std::size_t>(node->get<Label>().getId());
+                    if (idx < state.hasLabelWeight.size() && state.hasLabelWeight[idx] != 0)
+                    {
+                        block.weight = std::max(block.weight, state.labelWeights[idx]);
+                        block.hasWeight = true;
+                    }
+                    if (node == block.tail)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            // Blocks without a weight get what remains of the block falling into them.
+            for (std::size_t i = 1; i < blocks.size(); i++)
+            {
+                auto& block = blocks[i];
+                auto& prev = blocks[i - 1];
+                if (block.hasWeight || prev.fallthrough != i)
+                {
+                    continue;
+                }
+
+                block.weight = prev.weight;
+                if (prev.target != kNoBlock && blocks[prev.target].hasWeight)
+                {
+                    const auto taken = blocks[prev.target].weight;
+                    block.weight = prev.weight > taken ? prev.weight - taken : 0;
+                }
+            }
+        }
+
+        static void collectEdges(BlockReorderState& state)
+        {
+            auto& blocks = state.blocks;
+            auto& edges = state.edges;
+
+            for (std::uint32_t i = 0; i < blocks.size(); i++)
+            {
+                const auto& block = blocks[i];
+                for (const auto to : { block.fallthrough, block.target })
+                {
+                    // The first block has to stay the first one.
+                    if (to == kNoBlock || to == 0 || to == i)
+                    {
+                        continue;
+                    }
+
+                    const auto weight = std::min(block.weight, blocks[to].weight);
+                    edges.push_back({ weight, i, to, to == block.fallthrough });
+
+                    if (to == block.fallthrough && to == i + 1)
+                    {
+                        state.stats.fallthroughWeightBefore += weight;
+                    }
+                }
+            }
+
+            // Heaviest first, the original fall through wins a tie to keep the layout of code without weights.
+            std::stable_sort(edges.begin(), edges.end(), [](const ReorderEdge& a, const ReorderEdge& b) {
+                return std::make_tuple(a.weight, a.isFallthrough) > std::make_tuple(b.weight, b.isFallthrough);
+            });
+        }
+
+        static void buildChains(BlockReorderState& state, std::uint32_t pinnedLast)
+        {
+            auto& blocks = state.blocks;
+            auto& chains = state.chains;
+
+            chains.resize(blocks.size());
+            for (std::uint32_t i = 0; i < blocks.size(); i++)
+            {
+                chains[i].push_back(i);
+                blocks[i].chain = i;
+            }
+
+            for (const auto& edge : state.edges)
+            {
+                const auto fromChain = blocks[edge.from].chain;
+                const auto toChain = blocks[edge.to].chain;
+                if (fromChain == toChain || edge.from == pinnedLast)
+                {
+                    continue;
+                }
+                // The chain of the first block is placed first and the one of the pinned block last.
+                if (pinnedLast != kNoBlock && chains[fromChain].front() == 0 && blocks[pinnedLast].chain == toChain)
+                {
+                    continue;
+                }
+                if (chains[fromChain].back() != edge.from || chains[toChain].front() != edge.to)
+                {
+                    continue;
+                }
+
+                for (const auto idx : chains[toChain])
+                {
+                    blocks[idx].chain = fromChain;
+                }
+                chains[fromChain].insert(chains[fromChain].end(), chains[toChain].begin(), chains[toChain].end());
+                chains[toChain].clear();
+            }
+        }
+
+        static void orderChains(BlockReorderState& state, std::uint32_t pinnedLast)
+        {
+            auto& blocks = state.blocks;
+            auto& chains = state.chains;
+
+            std::vector<std::uint32_t> order;
+            for (std::uint32_t i = 0; i < chains.size(); i++)
+            {
+                if (!chains[i].empty())
+                {
+                    order.push_back(i);
+                }
+            }
+
+            const auto getChainWeight = [&](std::uint32_t chain) {
+                std::uint64_t weight = 0;
+                for (const auto idx : chains[chain])
+                {
+                    weight = std::max(weight, blocks[idx].weight);
+                }
+                return weight;
+            };
+
+            const auto getRank = [&](std::uint32_t chain) {
+                const bool isFirst = chains[chain].front() == 0;
+                const bool isLast = pinnedLast != kNoBlock && blocks[pinnedLast].chain == chain;
+                return std::make_tuple(!isFirst, isLast, ~getChainWeight(chain), chains[chain].front());
+            };
+            std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) { return getRank(a) < getRank(b); });
+
+            for (const auto chain : order)
+            {
+                for (const auto idx : chains[chain])
+                {
+                    auto& block = blocks[idx];
+                    block.cold = state.splitCold && idx != 0 && idx != pinnedLast && block.weight <= state.coldThreshold;
+                    (block.cold ? state.coldOrder : state.hotOrder).push_back(idx);
+                }
+            }
+
+            // Cold blocks keep their original order.
+            std::sort(state.coldOrder.begin(), state.coldOrder.end());
+        }
+
+        static void moveBlocks(
+            BlockReorderState& state, Node* cursor, const std::vector<std::uint32_t>& order, std::size_t start)
+        {
+            auto& program = *state.program;
+
+            for (std::size_t pos = start; pos < order.size(); pos++)
+            {
+                const auto& block = state.blocks[order[pos]];
+
+                Node* next = nullptr;
+                for (auto* node = block.head;; node = next)
+                {
+                    next = node->getNext();
+                    const bool isTail = node == block.tail;
+                    program.moveAfter(cursor, node);
+                    cursor = node;
+                    if (isTail)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Removing the jump of a block made of only labels and the jump would merge the labels into the next block.
+        static bool hasBodyBeforeTail(const ReorderBlock& block) noexcept
+        {
+            for (const auto* node = block.head; node != block.tail; node = node->getNext())
+            {
+                if (!node->holds<Label>())
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static void fixControlFlow(BlockReorderState& state, const std::vector<std::uint32_t>& order)
+        {
+            auto& program = *state.program;
+            auto& blocks = state.blocks;
+
+            for (std::size_t pos = 0; pos < order.size(); pos++)
+            {
+                auto& block = blocks[order[pos]];
+                const auto next = pos + 1 < order.size() ? order[pos + 1] : kNoBlock;
+
+                if (block.fallthrough != kNoBlock && block.fallthrough == next)
+                {
+                    state.stats.fallthroughWeightAfter += std::min(block.weight, blocks[next].weight);
+                }
+
+                if (block.end == BlockEnd::Jump && block.target != kNoBlock && block.target == next
+                    && hasBodyBeforeTail(block))
+                {
+                    state.stats.fallthroughWeightAfter += std::min(block.weight, blocks[next].weight);
+
+                    auto* tail = block.tail;
+                    block.tail = tail->getPrev();
+                    program.destroy(tail);
+                    state.stats.jumpsRemoved++;
+                    continue;
+                }
+
+                if (block.fallthrough == kNoBlock || block.fallthrough == next)
+                {
+                    continue;
+                }
+
+                const auto fallthroughLabel = getBlockLabel(blocks[block.fallthrough]);
+
+                if (block.end == BlockEnd::Branch && block.target != kNoBlock && block.target == next)
+                {
+                    auto& instr = block.tail->get<Instruction>();
+                    const auto inverted = getInvertedBranch(instr.getMnemonic());
+                    if (inverted != x86::Mnemonic::Invalid)
+                    {
+                        state.stats.fallthroughWeightAfter += std::min(block.weight, blocks[next].weight);
+
+                        instr.setMnemonic(inverted);
+                        instr.setOperand(0, fallthroughLabel);
+                        std::swap(block.fallthrough, block.target);
+                        state.stats.branchesInverted++;
+                        continue;
+                    }
+                }
+
+                const auto jmp = Instruction().setMnemonic(x86::Mnemonic::Jmp).addOperand(fallthroughLabel);
+                block.tail = program.insertAfter(block.tail, program.createNode(jmp));
+                state.stats.jumpsInserted++;
+            }
+        }
+
+        static std::vector<std::uint32_t> getSuccessors(const ReorderBlock& block)
+        {
+            std::vector<std::uint32_t> res;
+            for (const auto to : { block.fallthrough, block.target })
+            {
+                if (to != kNoBlock)
+                {
+                    res.push_back(to);
+                }
+            }
+            std::sort(res.begin(), res.end());
+            res.erase(std::unique(res.begin(), res.end()), res.end());
+            return res;
+        }
+
+        // Every block must have the same successors as before.
+        static bool verify(BlockReorderState& state)
+        {
+            auto& program = *state.program;
+            const auto& blocks = state.blocks;
+
+            ControlFlowGraph cfg(program);
+            if (cfg.build() != ErrorCode::None)
+            {
+                return false;
+            }
+
+            std::vector<std::uint32_t> blockIndex(cfg.getBlockCount(), kNoBlock);
+            for (std::uint32_t i = 0; i < blocks.size(); i++)
+            {
+                // The first block may share the block with a section node in front of it.
+                const auto id = cfg.getBlockOf(blocks[i].head);
+                if (id == BlockId::Invalid || (i != 0 && cfg.getBlock(id)->head != blocks[i].head))
+                {
+                    return false;
+                }
+                blockIndex[static_cast<std::size_t>(id)] = i;
+            }
+
+            const auto getIndex = [&](BlockId id) {
+                auto res = blockIndex[static_cast<std::size_t>(id)];
+                if (res != kNoBlock)
+                {
+                    return res;
+                }
+                // A jump inserted after a conditional branch is a block of its own.
+                const auto* block = cfg.getBlock(id);
+                if (block->head == block->tail && getBlockEnd(block->head) == BlockEnd::Jump)
+                {
+                    cfg.forEachSuccessor(
+                        id, [&](const CFGEdge& edge) { res = blockIndex[static_cast<std::size_t>(edge.to)]; });
+                }
+                return res;
+            };
+
+            std::vector<std::uint32_t> successors;
+            for (std::uint32_t i = 0; i < blocks.size(); i++)
+            {
+                successors.clear();
+                cfg.forEachSuccessor(cfg.getBlockOf(blocks[i].head), [&](const CFGEdge& edge) {
+                    // Targets outside of the reordered range are not compared.
+                    const auto to = getIndex(edge.to);
+                    if (to != kNoBlock)
+                    {
+                        successors.push_back(to);
+                    }
+                });
+                std::sort(successors.begin(), successors.end());
+                successors.erase(std::unique(successors.begin(), successors.end()), successors.end());
+
+                if (successors != getSuccessors(blocks[i]))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+    } // namespace detail
+
+    BlockReordering::BlockReordering(Program& program)
+        : _state(new detail::BlockReorderState())
+    {
+        _state->program = &program;
+    }
+
+    BlockReordering::~BlockReordering()
+    {
+        delete _state;
+        _state = nullptr;
+    }
+
+    void BlockReordering::setWeight(const Label& label, std::uint64_t weight)
+    {
+        auto& state = *_state;
+
+        const auto idx = static_cast<std::size_t>(label.getId());
+        if (idx >= state.labelWeights.size())
+        {
+            state.labelWeights.resize(idx + 1);
+            state.hasLabelWeight.resize(idx + 1);
+        }
+        state.labelWeights[idx] = weight;
+        state.hasLabelWeight[idx] = 1;
+    }
+
+    void BlockReordering::clearWeights() noexcept
+    {
+        _state->labelWeights.clear();
+        _state->hasLabelWeight.clear();
+    }
+
+    void BlockReordering::setSplitColdBlocks(bool enable, std::uint64_t threshold) noexcept
+    {
+        _state->splitCold = enable;
+        _state->coldThreshold = threshold;
+    }
+
+    Error BlockReordering::run()
+    {
+        auto& state = *_state;
+        auto& program = *state.program;
+
+        state.stats = {};
+        state.blocks.clear();
+        state.edges.clear();
+        state.chains.clear();
+        state.hotOrder.clear();
+        state.coldOrder.clear();
+
+        // The nodes up to the first section.
+        auto* first = program.getHead();
+        if (first != nullptr && first->holds<Section>())
+        {
+            first = first->getNext();
+        }
+        if (first == nullptr)
+        {
+            return ErrorCode::None;
+        }
+        auto* last = first;
+        while (last->getNext() != nullptr && !last->getNext()->holds<Section>())
+        {
+            last = last->getNext();
+        }
+
+        if (!detail::collectBlocks(state, first, last))
+        {
+            state.blocks.clear();
+            return ErrorCode::None;
+        }
+        state.stats.blocks = state.blocks.size();
+
+        // A block falling through the end of the range has to stay last.
+        auto pinnedLast = detail::kNoBlock;
+        if (const auto& lastBlock = state.blocks.back();
+            lastBlock.end == detail::BlockEnd::Fallthrough || lastBlock.end == detail::BlockEnd::Branch)
+        {
+            pinnedLast = static_cast<std::uint32_t>(state.blocks.size() - 1);
+        }
+
+        detail::ensureLabels(state);
+        detail::assignWeights(state);
+        detail::collectEdges(state);
+        detail::buildChains(state, pinnedLast);
+        detail::orderChains(state, pinnedLast);
+
+        for (std::size_t i = 1; i < state.hotOrder.size(); i++)
+        {
+            if (state.hotOrder[i] != state.hotOrder[i - 1] + 1)
+            {
+                state.stats.blocksMoved++;
+            }
+        }
+        state.stats.blocksMoved += state.coldOrder.size();
+        state.stats.coldBlocks = state.coldOrder.size();
+
+        detail::moveBlocks(state, state.blocks[0].tail, state.hotOrder, 1);
+        detail::fixControlFlow(state, state.hotOrder);
+
+        if (!state.coldOrder.empty())
+        {
+            const auto section = program.createSection(
+                detail::kColdSectionName, Section::kDefaultAttribs, Section::kDefaultAlign);
+            auto* sectionNode = program.insertAfter(program.getTail(), program.bindSection(section).value());
+
+            detail::moveBlocks(state, sectionNode, state.coldOrder, 0);
+            detail::fixControlFlow(state, state.coldOrder);
+        }
+
+        if (!detail::verify(state))
+        {
+            return Error(ErrorCode::InvalidOperation, "Control flow changed by the block reordering");
+        }
+
+        return ErrorCode::None;
+    }
+
+    const BlockReorderStats& BlockReordering::getStats() const noexcept
+    {
+        return _state->stats;
+    }
+
+} // namespace zasm
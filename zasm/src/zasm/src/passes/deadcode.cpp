@@ -0,0 +1,412 @@
+#include "../program/program.state.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <zasm/passes/deadcode.hpp>
+#include <zasm/program/program.hpp>
+#include <zasm/x86/x86.hpp>
+
+namespace zasm
+{
+    namespace detail
+    {
+        struct DeadCodeState
+        {
+            Program* program{};
+            bool keepNamedLabels{ true };
+            bool removeUnreferencedLabels{ true };
+            bool compactLabels{};
+
+            std::vector<Label> roots;
+
+            // Reachable nodes indexed by the node id.
+            std::vector<std::uint8_t> live;
+            // References from reachable nodes indexed by the label id.
+            std::vector<std::uint32_t> refCounts;
+            // Start of the node runs that still have to be walked.
+            std::vector<Node*> worklist;
+
+            DeadCodeStats stats;
+        };
+
+        static constexpr std::size_t toIndex(const Node* node) noexcept
+        {
+            return static_cast<std::size_t>(node->getId());
+        }
+
+        static constexpr std::size_t toIndex(Label::Id id) noexcept
+        {
+            return static_cast<std::size_t>(id);
+        }
+
+        static bool isLive(const DeadCodeState& state, const Node* node) noexcept
+        {
+            return state.live[toIndex(node)] != 0;
+        }
+
+        static bool fallsThrough(const Node* node) noexcept
+        {
+            const auto* instr = node->getIf<Instruction>();
+            if (instr == nullptr)
+            {
+                return true;
+            }
+
+            const auto mnemonic = instr->getMnemonic();
+            return !(
+                x86::isJmp(mnemonic) || x86::isRet(mnemonic) || mnemonic == x86::Mnemonic::Iret
+                || mnemonic == x86::Mnemonic::Iretd || mnemonic == x86::Mnemonic::Iretq || mnemonic == x86::Mnemonic::Ud2);
+        }
+
+        // Nodes that are kept regardless of reachability.
+        static bool isPinned(const Node* node) noexcept
+        {
+            return node->holds<Section>() || node->holds<Sentinel>();
+        }
+
+        static void addRoot(DeadCodeState& state, Node* node)
+        {
+            if (node == nullptr || isLive(state, node))
+            {
+                return;
+            }
+
+            // Labels bound to the same position and alignment in front of them belong to the target.
+            while (node->getPrev() != nullptr && !isLive(state, node->getPrev()))
+            {
+                const auto* prev = node->getPrev();
+                if (!prev->holds<Label>() && !prev->holds<Align>())
+                {
+                    break;
+                }
+                node = node->getPrev();
+            }
+
+            state.worklist.push_back(node);
+        }
+
+        static void addRef(DeadCodeState& state, const Label& label)
+        {
+            if (!label.isValid())
+            {
+                return;
+            }
+
+            const auto idx = toIndex(label.getId());
+            if (idx >= state.refCounts.size())
+            {
+                return;
+            }
+
+            if (state.refCounts[idx]++ == 0)
+            {
+                addRoot(state, state.program->getNodeForLabel(label));
+            }
+        }
+
+        static void addReferences(DeadCodeState& state, const Node* node)
+        {
+            if (const auto* instr = node->getIf<Instruction>(); instr != nullptr)
+            {
+                for (std::size_t i = 0; i < instr->getOperandCount(); i++)
+                {
+                    if (const auto* label = instr->getOperandIf<Label>(i); label != nullptr)
+                    {
+                        addRef(state, *label);
+                    }
+                    else if (const auto* mem = instr->getOperandIf<Mem>(i); mem != nullptr)
+                    {
+                        addRef(state, mem->getLabel());
+                    }
+                }
+            }
+            else if (const auto* embedded = node->getIf<EmbeddedLabel>(); embedded != nullptr)
+            {
+                addRef(state, embedded->getLabel());
+                addRef(state, embedded->getRelativeLabel());
+            }
+        }
+
+        static void markReachable(DeadCodeState& state)
+        {
+            auto& program = *state.program;
+            const auto& programState = program.getState();
+
+            state.live.assign(programState.nodeMap.size(), 0);
+            state.refCounts.assign(programState.labels.size(), 0);
+            state.worklist.clear();
+
+            const auto entryPoint = program.getEntryPoint();
+            if (entryPoint.isValid())
+            {
+                addRef(state, entryPoint);
+            }
+            else
+            {
+                addRoot(state, program.getHead());
+            }
+
+            for (const auto& label : state.roots)
+            {
+                addRef(state, label);
+            }
+
+            if (state.keepNamedLabels)
+            {
+                for (const auto& entry : programState.labels)
+                {
+                    if (entry.nameId != StringPool::Id::Invalid)
+                    {
+                        addRef(state, Label{ entry.id });
+                    }
+                }
+            }
+
+            while (!state.worklist.empty())
+            {
+                auto* node = state.worklist.back();
+                state.worklist.pop_back();
+
+                for (const auto* start = node; node != nullptr && !isLive(state, node); node = node->getNext())
+                {
+                    // Sections are not contiguous in memory, only a walk starting at the section enters it.
+                    if (node != start && node->holds<Section>())
+                    {
+                        break;
+                    }
+
+                    state.live[toIndex(node)] = 1;
+
+                    addReferences(state, node);
+
+                    if (!fallsThrough(node))
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        static bool shouldRemove(const DeadCodeState& state, const Node* node) noexcept
+        {
+            if (isPinned(node))
+            {
+                return false;
+            }
+            if (!isLive(state, node))
+            {
+                return true;
+            }
+            if (!state.removeUnreferencedLabels)
+            {
+                return false;
+            }
+
+            // Roots have a reference.
+            const auto* label = node->getIf<Label>();
+            return label != nullptr && state.refCounts[toIndex(label->getId())] == 0;
+        }
+
+        static void countRemoved(DeadCodeState& state, const Node* node) noexcept
+        {
+            state.stats.nodesRemoved++;
+            if (node->holds<Instruction>())
+            {
+                state.stats.instructionsRemoved++;
+            }
+            else if (node->holds<Data>() || node->holds<EmbeddedLabel>())
+            {
+                state.stats.dataRemoved++;
+            }
+            else if (node->holds<Label>())
+            {
+                state.stats.labelsRemoved++;
+            }
+        }
+
+        static void removeNodes(DeadCodeState& state)
+        {
+            auto& program = *state.program;
+
+            auto* node = program.getHead();
+            while (node != nullptr)
+            {
+                if (!shouldRemove(state, node))
+                {
+                    node = node->getNext();
+                    continue;
+                }
+
+                // Destroy the entire run at once.
+                auto* first = node;
+                auto* last = node;
+                countRemoved(state, node);
+                while (last->getNext() != nullptr && shouldRemove(state, last->getNext()))
+                {
+                    last = last->getNext();
+                    countRemoved(state, last);
+                }
+
+                node = last->getNext();
+                program.destroy(first, last);
+            }
+        }
+
+        static void remapLabel(const std::vector<Label::Id>& remap, Label& label) noexcept
+        {
+            if (label.isValid() && toIndex(label.getId()) < remap.size())
+            {
+                label = Label{ remap[toIndex(label.getId())] };
+            }
+        }
+
+        static void compactLabels(DeadCodeState& state)
+        {
+            auto& program = *state.program;
+            auto& programState = program.getState();
+            auto& labels = programState.labels;
+
+            // The reference counts only include reachable nodes which are all that is left.
+            std::vector<Label::Id> remap(labels.size(), Label::Id::Invalid);
+
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < labels.size(); i++)
+            {
+                auto& entry = labels[i];
+
+                const bool keep = entry.node != nullptr || (entry.flags & LabelFlags::External) != LabelFlags::None
+                    || state.refCounts[i] != 0;
+                if (!keep)
+                {
+                    if (entry.nameId != StringPool::Id::Invalid)
+                    {
+                        programState.symbolNames.release(entry.nameId);
+                    }
+                    continue;
+                }
+
+                remap[i] = static_cast<Label::Id>(count);
+                if (count != i)
+                {
+                    labels[count] = entry;
+                }
+                labels[count].id = remap[i];
+                count++;
+            }
+
+            state.stats.labelsCompacted = labels.size() - count;
+            if (count == labels.size())
+            {
+                return;
+            }
+            labels.resize(count);
+
+            for (auto* node = program.getHead(); node != nullptr; node = node->getNext())
+            {
+                if (auto* instr = node->getIf<Instruction>(); instr != nullptr)
+                {
+                    for (std::size_t i = 0; i < instr->getOperandCount(); i++)
+                    {
+                        if (auto* label = instr->getOperandIf<Label>(i); label != nullptr)
+                        {
+                            remapLabel(remap, *label);
+                        }
+                        else if (auto* mem = instr->getOperandIf<Mem>(i); mem != nullptr && mem->hasLabel())
+                        {
+                            auto label = mem->getLabel();
+                            remapLabel(remap, label);
+                            mem->setLabel(label);
+                        }
+                    }
+                }
+                else if (auto* label = node->getIf<Label>(); label != nullptr)
+                {
+                    remapLabel(remap, *label);
+                }
+                else if (auto* embedded = node->getIf<EmbeddedLabel>(); embedded != nullptr)
+                {
+                    auto label = embedded->getLabel();
+                    remapLabel(remap, label);
+                    if (embedded->isRelative())
+                    {
+                        auto relativeLabel = embedded->getRelativeLabel();
+                        remapLabel(remap, relativeLabel);
+                        *embedded = EmbeddedLabel(label, relativeLabel, embedded->getSize());
+                    }
+                    else
+                    {
+                        *embedded = EmbeddedLabel(label, embedded->getSize());
+                    }
+                }
+            }
+
+            remapLabel(remap, programState.entryPoint);
+            for (auto& root : state.roots)
+            {
+                remapLabel(remap, root);
+            }
+        }
+
+    } // namespace detail
+
+    DeadCodeElimination::DeadCodeElimination(Program& program)
+        : _state(new detail::DeadCodeState())
+    {
+        _state->program = &program;
+    }
+
+    DeadCodeElimination::~DeadCodeElimination()
+    {
+        delete _state;
+        _state = nullptr;
+    }
+
+    void DeadCodeElimination::addRoot(const Label& label)
+    {
+        _state->roots.push_back(label);
+    }
+
+    void DeadCodeElimination::clearRoots() noexcept
+    {
+        _state->roots.clear();
+    }
+
+    void DeadCodeElimination::setKeepNamedLabels(bool enable) noexcept
+    {
+        _state->keepNamedLabels = enable;
+    }
+
+    void DeadCodeElimination::setRemoveUnreferencedLabels(bool enable) noexcept
+    {
+        _state->removeUnreferencedLabels = enable;
+    }
+
+    void DeadCodeElimination::setCompactLabels(bool enable) noexcept
+    {
+        _state->compactLabels = enable;
+    }
+
+    Error DeadCodeElimination::run()
+    {
+        auto& state = *_state;
+
+        state.stats = {};
+
+        detail::markReachable(state);
+        detail::removeNodes(state);
+
+        if (state.compactLabels)
+        {
+            detail::compactLabels(state);
+        }
+
+        return ErrorCode::None;
+    }
+
+    const DeadCodeStats& DeadCodeElimination::getStats() const noexcept
+    {
+        return _state->stats;
+    }
+
+} // namespace zasm
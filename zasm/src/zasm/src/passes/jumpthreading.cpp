@@ -0,0 +1,337 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <zasm/passes/jumpthreading.hpp>
+#include <zasm/program/program.hpp>
+#include <zasm/x86/x86.hpp>
+
+namespace zasm
+{
+    namespace detail
+    {
+        struct JumpThreadingState
+        {
+            Program* program{};
+            bool removeTrampolines{ true };
+
+            // Final destination of each label indexed by the label id, Invalid if not yet resolved.
+            std::vector<Label::Id> destinations;
+            std::vector<std::uint8_t> visiting;
+            std::vector<Label::Id> path;
+
+            // Amount of references to each label indexed by the label id.
+            std::vector<std::uint32_t> refCounts;
+            // Labels that lost their last reference.
+            std::vector<Label::Id> worklist;
+
+            JumpThreadingStats stats;
+        };
+
+        static constexpr std::size_t toIndex(Label::Id id) noexcept
+        {
+            return static_cast<std::size_t>(id);
+        }
+
+        // Branches with only a 8 bit displacement form are not retargeted, the new target may be too far.
+        static bool canRetarget(InstrMnemonic mnemonic) noexcept
+        {
+            if (x86::isJmp(mnemonic))
+            {
+                return true;
+            }
+            if (mnemonic == x86::Mnemonic::Jcxz || mnemonic == x86::Mnemonic::Jecxz || mnemonic == x86::Mnemonic::Jrcxz)
+            {
+                return false;
+            }
+            return x86::isCondBranching(mnemonic);
+        }
+
+        static bool fallsThrough(InstrMnemonic mnemonic) noexcept
+        {
+            return !(
+                x86::isJmp(mnemonic) || x86::isRet(mnemonic) || mnemonic == x86::Mnemonic::Iret
+                || mnemonic == x86::Mnemonic::Iretd || mnemonic == x86::Mnemonic::Iretq || mnemonic == x86::Mnemonic::Ud2);
+        }
+
+        static const Label* getJumpLabel(const Node* node) noexcept
+        {
+            const auto* instr = node->getIf<Instruction>();
+            if (instr == nullptr || !x86::isJmp(instr->getMnemonic()) || instr->getOperandCount() != 1)
+            {
+                return nullptr;
+            }
+            return instr->getOperandIf<Label>(0);
+        }
+
+        // Returns the label the code at the label jumps to, Invalid if it does not start with a jump.
+        static Label::Id getTrampolineTarget(const Node* labelNode) noexcept
+        {
+            const auto* node = labelNode;
+            while (node != nullptr && node->holds<Label>())
+            {
+                node = node->getNext();
+            }
+            if (node == nullptr)
+            {
+                return Label::Id::Invalid;
+            }
+
+            const auto* label = getJumpLabel(node);
+            if (label == nullptr)
+            {
+                return Label::Id::Invalid;
+            }
+            return label->getId();
+        }
+
+        static Label::Id resolveDestination(JumpThreadingState& state, Label::Id id)
+        {
+            auto& destinations = state.destinations;
+            auto& visiting = state.visiting;
+            auto& path = state.path;
+
+            path.clear();
+
+            auto cur = id;
+            auto dest = Label::Id::Invalid;
+            while (dest == Label::Id::Invalid)
+            {
+                const auto idx = toIndex(cur);
+                if (idx >= destinations.size())
+                {
+                    destinations.resize(idx + 1, Label::Id::Invalid);
+                    visiting.resize(idx + 1);
+                }
+
+                if (destinations[idx] != Label::Id::Invalid)
+                {
+                    dest = destinations[idx];
+                    break;
+                }
+                if (visiting[idx] != 0)
+                {
+                    // Jumps in a cycle, every label of the chain ends up in the cycle.
+                    dest = cur;
+                    break;
+                }
+
+                visiting[idx] = 1;
+                path.push_back(cur);
+
+                const auto* node = state.program->getNodeForLabel(Label{ cur });
+                const auto next = node != nullptr ? getTrampolineTarget(node) : Label::Id::Invalid;
+                if (next == Label::Id::Invalid)
+                {
+                    dest = cur;
+                    break;
+                }
+                cur = next;
+            }
+
+            for (const auto labelId : path)
+            {
+                destinations[toIndex(labelId)] = dest;
+                visiting[toIndex(labelId)] = 0;
+            }
+
+            return dest;
+        }
+
+        static void retargetBranches(JumpThreadingState& state)
+        {
+            state.destinations.clear();
+            state.visiting.clear();
+
+            for (auto* node = state.program->getHead(); node != nullptr; node = node->getNext())
+            {
+                auto* instr = node->getIf<Instruction>();
+                if (instr == nullptr || instr->getOperandCount() != 1 || !canRetarget(instr->getMnemonic()))
+                {
+                    continue;
+                }
+
+                const auto* label = instr->getOperandIf<Label>(0);
+                if (label == nullptr || !label->isValid())
+                {
+                    continue;
+                }
+
+                const auto dest = resolveDestination(state, label->getId());
+                if (dest != label->getId())
+                {
+                    instr->setOperand(0, Label{ dest });
+                    state.stats.branchesRetargeted++;
+                }
+            }
+        }
+
+        static void addRef(JumpThreadingState& state, const Label& label)
+        {
+            if (!label.isValid())
+            {
+                return;
+            }
+
+            const auto idx = toIndex(label.getId());
+            if (idx >= state.refCounts.size())
+            {
+                state.refCounts.resize(idx + 1);
+            }
+            state.refCounts[idx]++;
+        }
+
+        static void countReferences(JumpThreadingState& state)
+        {
+            auto& program = *state.program;
+
+            state.refCounts.clear();
+
+            // The entry point is always reachable.
+            addRef(state, program.getEntryPoint());
+
+            for (const auto* node = program.getHead(); node != nullptr; node = node->getNext())
+            {
+                if (const auto* instr = node->getIf<Instruction>(); instr != nullptr)
+                {
+                    for (std::size_t i = 0; i < instr->getOperandCount(); i++)
+                    {
+                        if (const auto* label = instr->getOperandIf<Label>(i); label != nullptr)
+                        {
+                            addRef(state, *label);
+                        }
+                        else if (const auto* mem = instr->getOperandIf<Mem>(i); mem != nullptr)
+                        {
+                            addRef(state, mem->getLabel());
+                        }
+                    }
+                }
+                else if (const auto* embedded = node->getIf<EmbeddedLabel>(); embedded != nullptr)
+                {
+                    addRef(state, embedded->getLabel());
+                    addRef(state, embedded->getRelativeLabel());
+                }
+            }
+        }
+
+        static bool isLabelUsed(const JumpThreadingState& state, const Label& label)
+        {
+            const auto idx = toIndex(label.getId());
+            if (idx < state.refCounts.size() && state.refCounts[idx] != 0)
+            {
+                return true;
+            }
+            // Named labels may be looked up by the user.
+            return state.program->getLabelName(label) != nullptr;
+        }
+
+        static bool isUnreachable(const JumpThreadingState& state, const Node* node)
+        {
+            const auto* prev = node->getPrev();
+            while (prev != nullptr && prev->holds<Label>())
+            {
+                if (isLabelUsed(state, prev->get<Label>()))
+                {
+                    return false;
+                }
+                prev = prev->getPrev();
+            }
+
+            const auto* instr = prev != nullptr ? prev->getIf<Instruction>() : nullptr;
+            if (instr == nullptr)
+            {
+                return false;
+            }
+            return !fallsThrough(instr->getMnemonic());
+        }
+
+        static void removeTrampoline(JumpThreadingState& state, Node* node)
+        {
+            const auto target = getJumpLabel(node)->getId();
+
+            state.program->destroy(node);
+            state.stats.trampolinesRemoved++;
+
+            const auto idx = toIndex(target);
+            if (idx < state.refCounts.size() && --state.refCounts[idx] == 0)
+            {
+                state.worklist.push_back(target);
+            }
+        }
+
+        static void removeTrampolines(JumpThreadingState& state)
+        {
+            auto& program = *state.program;
+
+            countReferences(state);
+
+            state.worklist.clear();
+
+            Node* next = nullptr;
+            for (auto* node = program.getHead(); node != nullptr; node = next)
+            {
+                next = node->getNext();
+                if (getJumpLabel(node) != nullptr && isUnreachable(state, node))
+                {
+                    removeTrampoline(state, node);
+                }
+            }
+
+            // Labels that lost their last reference may make earlier jumps unreachable.
+            while (!state.worklist.empty())
+            {
+                const auto labelId = state.worklist.back();
+                state.worklist.pop_back();
+
+                auto* node = program.getNodeForLabel(Label{ labelId });
+                while (node != nullptr && node->holds<Label>())
+                {
+                    node = node->getNext();
+                }
+                if (node != nullptr && getJumpLabel(node) != nullptr && isUnreachable(state, node))
+                {
+                    removeTrampoline(state, node);
+                }
+            }
+        }
+
+    } // namespace detail
+
+    JumpThreading::JumpThreading(Program& program)
+        : _state(new detail::JumpThreadingState())
+    {
+        _state->program = &program;
+    }
+
+    JumpThreading::~JumpThreading()
+    {
+        delete _state;
+        _state = nullptr;
+    }
+
+    void JumpThreading::setRemoveTrampolines(bool enable) noexcept
+    {
+        _state->removeTrampolines = enable;
+    }
+
+    Error JumpThreading::run()
+    {
+        auto& state = *_state;
+
+        state.stats = {};
+
+        detail::retargetBranches(state);
+
+        if (state.removeTrampolines)
+        {
+            detail::removeTrampolines(state);
+        }
+
+        return ErrorCode::None;
+    }
+
+    const JumpThreadingStats& JumpThreading::getStats() const noexcept
+    {
+        return _state->stats;
+    }
+
+} // namespace zasm
@@ -0,0 +1,398 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <zasm/core/math.hpp>
+#include <zasm/passes/layout.hpp>
+#include <zasm/program/program.hpp>
+#include <zasm/serialization/serializer.hpp>
+#include <zasm/x86/x86.hpp>
+
+namespace zasm
+{
+    namespace detail
+    {
+        static constexpr std::uint32_t kDefaultLoopAlignment = 32;
+        static constexpr std::int64_t kJccErratumBoundary = 32;
+
+        // Each round only fixes the branches found in the previous layout, inserted padding can move
+        // other branches onto a boundary.
+        static constexpr std::size_t kMaxErratumRounds = 4;
+
+        struct LayoutState
+        {
+            Program* program{};
+
+            std::uint32_t loopAlignment{ kDefaultLoopAlignment };
+            std::uint32_t maxLoopPadding{ std::numeric_limits<std::uint32_t>::max() };
+            bool avoidJccErratum{};
+            std::size_t paddingBudget{ std::numeric_limits<std::size_t>::max() };
+
+            // Address and node of each loop head label.
+            std::vector<std::pair<std::int64_t, Node*>> loopHeads;
+            // Address of each branch without a rel32 form and the address of its target.
+            std::vector<std::pair<std::int64_t, std::int64_t>> shortBranches;
+
+            LayoutStats stats;
+        };
+
+        static const Label* getBranchLabel(const Instruction& instr) noexcept
+        {
+            const auto mnemonic = instr.getMnemonic();
+            if (!x86::isJmp(mnemonic) && !x86::isCondBranching(mnemonic))
+            {
+                return nullptr;
+            }
+            if (instr.getOperandCount() != 1)
+            {
+                return nullptr;
+            }
+            return instr.getOperandIf<Label>(0);
+        }
+
+        static bool isErratumBranch(InstrMnemonic mnemonic) noexcept
+        {
+            return x86::isJmp(mnemonic) || x86::isCondBranching(mnemonic) || x86::isCall(mnemonic) || x86::isRet(mnemonic);
+        }
+
+        static bool hasOnlyShortForm(InstrMnemonic mnemonic) noexcept
+        {
+            switch (mnemonic)
+            {
+                case x86::Mnemonic::Loop:
+                case x86::Mnemonic::Loope:
+                case x86::Mnemonic::Loopne:
+                case x86::Mnemonic::Jcxz:
+                case x86::Mnemonic::Jecxz:
+                case x86::Mnemonic::Jrcxz:
+                    return true;
+                default:
+                    break;
+            }
+            return false;
+        }
+
+        static bool isMacroFusible(InstrMnemonic mnemonic) noexcept
+        {
+            switch (mnemonic)
+            {
+                case x86::Mnemonic::Cmp:
+                case x86::Mnemonic::Test:
+                case x86::Mnemonic::Add:
+                case x86::Mnemonic::Sub:
+                case x86::Mnemonic::And:
+                case x86::Mnemonic::Inc:
+                case x86::Mnemonic::Dec:
+                    return true;
+                default:
+                    break;
+            }
+            return false;
+        }
+
+        // Padding goes before the labels bound to the node so branches to them skip it.
+        static Node* getInsertionPoint(Node* node) noexcept
+        {
+            while (node->getPrev() != nullptr && node->getPrev()->holds<Label>())
+            {
+                node = node->getPrev();
+            }
+            return node;
+        }
+
+        // Returns false if the node is already preceded by an equal or larger code alignment.
+        static bool alignBefore(Program& program, Node* node, std::uint32_t align)
+        {
+            auto* prev = node->getPrev();
+            if (prev != nullptr)
+            {
+                if (auto* existing = prev->getIf<Align>(); existing != nullptr && existing->getType() == Align::Type::Code)
+                {
+                    if (existing->getAlign() >= align)
+                    {
+                        return false;
+                    }
+                    existing->setAlign(align);
+                    return true;
+                }
+            }
+
+            program.insertBefore(node, program.createNode(Align(Align::Type::Code, align)));
+            return true;
+        }
+
+        static void collectShortBranches(LayoutState& state, const Serializer& serializer)
+        {
+            auto& program = *state.program;
+            auto& shortBranches = state.shortBranches;
+
+            shortBranches.clear();
+
+            std::size_t index = 0;
+            for (const auto* node = program.getHead(); node != nullptr; node = node->getNext(), index++)
+            {
+                const auto* instr = node->getIf<Instruction>();
+                if (instr == nullptr || !hasOnlyShortForm(instr->getMnemonic()) || instr->getOperandCount() == 0)
+                {
+                    continue;
+                }
+
+                const auto* label = instr->getOperandIf<Label>(0);
+                if (label == nullptr)
+                {
+                    continue;
+                }
+
+                const auto targetAddress = serializer.getLabelAddress(label->getId());
+                if (targetAddress == -1)
+                {
+                    continue;
+                }
+
+                shortBranches.emplace_back(serializer.getNodeInfo(index).address, targetAddress);
+            }
+        }
+
+        // Padding at the address moves everything from there on, a rel8 branch and its target must not
+        // end up on different sides as the displacement could go out of range.
+        static bool separatesShortBranch(const LayoutState& state, std::int64_t address) noexcept
+        {
+            for (const auto& [branchAddress, targetAddress] : state.shortBranches)
+            {
+                if ((branchAddress >= address) != (targetAddress >= address))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static void collectLoopHeads(LayoutState& state, const Serializer& serializer)
+        {
+            auto& program = *state.program;
+            auto& loopHeads = state.loopHeads;
+
+            loopHeads.clear();
+
+            std::size_t index = 0;
+            for (const auto* node = program.getHead(); node != nullptr; node = node->getNext(), index++)
+            {
+                const auto* instr = node->getIf<Instruction>();
+                if (instr == nullptr)
+                {
+                    continue;
+                }
+
+                const auto* label = getBranchLabel(*instr);
+                if (label == nullptr)
+                {
+                    continue;
+                }
+
+                // A backward branch, the target address is the same or lower.
+                const auto targetAddress = serializer.getLabelAddress(label->getId());
+                if (targetAddress == -1 || targetAddress > serializer.getNodeInfo(index).address)
+                {
+                    continue;
+                }
+
+                auto* labelNode = program.getNodeForLabel(*label);
+                if (labelNode != nullptr)
+                {
+                    loopHeads.emplace_back(targetAddress, getInsertionPoint(labelNode));
+                }
+            }
+
+            std::sort(loopHeads.begin(), loopHeads.end());
+            loopHeads.erase(std::unique(loopHeads.begin(), loopHeads.end()), loopHeads.end());
+        }
+
+        static void alignLoopHeads(LayoutState& state, const Serializer& serializer)
+        {
+            collectLoopHeads(state, serializer);
+
+            state.stats.loopHeads = state.loopHeads.size();
+
+            // Estimated shift of the following code by the padding inserted so far.
+            std::int64_t shift = 0;
+            for (const auto& [address, node] : state.loopHeads)
+            {
+                const auto cur = address + shift;
+                const auto padding = math::alignTo<std::int64_t>(cur, state.loopAlignment) - cur;
+                if (padding > state.maxLoopPadding)
+                {
+                    continue;
+                }
+                if (separatesShortBranch(state, address))
+                {
+                    state.stats.loopsSkipped++;
+                    continue;
+                }
+
+                if (alignBefore(*state.program, node, state.loopAlignment))
+                {
+                    shift += padding;
+                    state.stats.loopsAligned++;
+                }
+            }
+        }
+
+        // Returns true if any padding was inserted.
+        static bool padErratumBranches(LayoutState& state, const Serializer& serializer, std::size_t& paddingUsed)
+        {
+            auto& program = *state.program;
+
+            bool inserted = false;
+            state.stats.branchesSkipped = 0;
+
+            std::int64_t shift = 0;
+            std::size_t index = 0;
+            for (auto* node = program.getHead(); node != nullptr; node = node->getNext(), index++)
+            {
+                const auto* instr = node->getIf<Instruction>();
+                if (instr == nullptr || !isErratumBranch(instr->getMnemonic()))
+                {
+                    continue;
+                }
+
+                auto* startNode = node;
+                auto startIndex = index;
+                if (x86::isCondBranching(instr->getMnemonic()) && index > 0)
+                {
+                    const auto* prevInstr = node->getPrev()->getIf<Instruction>();
+                    if (prevInstr != nullptr && isMacroFusible(prevInstr->getMnemonic()))
+                    {
+                        startNode = node->getPrev();
+                        startIndex = index - 1;
+                    }
+                }
+
+                const auto nodeInfo = serializer.getNodeInfo(index);
+                const auto start = serializer.getNodeInfo(startIndex).address + shift;
+                const auto end = nodeInfo.address + nodeInfo.length + shift;
+
+                // Crossing or ending on the boundary.
+                if (start / kJccErratumBoundary == end / kJccErratumBoundary)
+                {
+                    continue;
+                }
+
+                const auto padding = math::alignTo<std::int64_t>(start, kJccErratumBoundary) - start;
+                if (separatesShortBranch(state, start - shift))
+                {
+                    state.stats.branchesSkipped++;
+                    continue;
+                }
+                if (paddingUsed + static_cast<std::size_t>(padding) > state.paddingBudget)
+                {
+                    state.stats.branchesSkipped++;
+                    continue;
+                }
+
+                if (alignBefore(program, getInsertionPoint(startNode), static_cast<std::uint32_t>(kJccErratumBoundary)))
+                {
+                    paddingUsed += static_cast<std::size_t>(padding);
+                    shift += padding;
+                    state.stats.branchesPadded++;
+                    inserted = true;
+                }
+            }
+
+            return inserted;
+        }
+
+    } // namespace detail
+
+    LayoutOptimizer::LayoutOptimizer(Program& program)
+        : _state(new detail::LayoutState())
+    {
+        _state->program = &program;
+    }
+
+    LayoutOptimizer::~LayoutOptimizer()
+    {
+        delete _state;
+        _state = nullptr;
+    }
+
+    Error LayoutOptimizer::setLoopAlignment(std::uint32_t align) noexcept
+    {
+        if (align != 0 && math::popCount(align) != 1)
+        {
+            return ErrorCode::InvalidParameter;
+        }
+
+        _state->loopAlignment = align;
+        return ErrorCode::None;
+    }
+
+    void LayoutOptimizer::setMaxLoopPadding(std::uint32_t maxPadding) noexcept
+    {
+        _state->maxLoopPadding = maxPadding;
+    }
+
+    void LayoutOptimizer::setAvoidJccErratum(bool enable) noexcept
+    {
+        _state->avoidJccErratum = enable;
+    }
+
+    void LayoutOptimizer::setPaddingBudget(std::size_t budget) noexcept
+    {
+        _state->paddingBudget = budget;
+    }
+
+    Error LayoutOptimizer::run(Serializer& serializer, std::int64_t newBase)
+    {
+        auto& state = *_state;
+        auto& program = *state.program;
+
+        state.stats = {};
+
+        if (auto err = serializer.serialize(program, newBase); err != ErrorCode::None)
+        {
+            return err;
+        }
+        state.stats.codeSizeBefore = serializer.getCodeSize();
+
+        if (state.loopAlignment != 0)
+        {
+            detail::collectShortBranches(state, serializer);
+            detail::alignLoopHeads(state, serializer);
+
+            if (auto err = serializer.serialize(program, newBase); err != ErrorCode::None)
+            {
+                return err;
+            }
+        }
+
+        if (state.avoidJccErratum)
+        {
+            std::size_t paddingUsed = 0;
+            for (std::size_t round = 0; round < detail::kMaxErratumRounds; round++)
+            {
+                detail::collectShortBranches(state, serializer);
+                if (!detail::padErratumBranches(state, serializer, paddingUsed))
+                {
+                    break;
+                }
+
+                if (auto err = serializer.serialize(program, newBase); err != ErrorCode::None)
+                {
+                    return err;
+                }
+            }
+        }
+
+        state.stats.codeSizeAfter = serializer.getCodeSize();
+
+        return ErrorCode::None;
+    }
+
+    const LayoutStats& LayoutOptimizer::getStats() const noexcept
+    {
+        return _state->stats;
+    }
+
+} // namespace zasm
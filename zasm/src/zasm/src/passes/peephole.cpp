@@ -0,0 +1,365 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <zasm/analysis/cfg.hpp>
+#include <zasm/analysis/liveness.hpp>
+#include <zasm/encoder/encoder.hpp>
+#include <zasm/passes/peephole.hpp>
+#include <zasm/program/program.hpp>
+#include <zasm/x86/x86.hpp>
+
+namespace zasm
+{
+    namespace detail
+    {
+        static constexpr std::size_t kDefaultMaxRounds = 16;
+
+        struct PeepholeState
+        {
+            Program* program{};
+            MachineMode mode{};
+
+            std::vector<PeepholeRule> rules;
+            // Indices of the rules indexed by the mnemonic.
+            std::vector<std::vector<std::size_t>> rulesByMnemonic;
+            std::size_t maxRounds{ kDefaultMaxRounds };
+
+            // Flags live after each instruction indexed by node id, computed at the start of a round.
+            std::vector<InstrCPUFlags> liveFlags;
+
+            // The node the scan continues with.
+            Node* next{};
+            PeepholeStats stats;
+        };
+
+        static std::int64_t getEncodedSize(MachineMode mode, const Instruction& instr)
+        {
+            const auto res = encode(
+                mode, instr.getAttribs(), instr.getMnemonic(), instr.getOperandCount(), instr.getOperands().data());
+            if (!res)
+            {
+                return 0;
+            }
+            return res->buffer.length;
+        }
+
+        static void computeLiveFlags(PeepholeState& state, const LivenessAnalysis& liveness)
+        {
+            const auto* program = state.program;
+
+            state.liveFlags.clear();
+            for (const auto* node = program->getHead(); node != nullptr; node = node->getNext())
+            {
+                if (!node->holds<Instruction>())
+                {
+                    continue;
+                }
+
+                const auto idx = static_cast<std::size_t>(node->getId());
+                if (idx >= state.liveFlags.size())
+                {
+                    state.liveFlags.resize(idx + 1, ~InstrCPUFlags{});
+                }
+                state.liveFlags[idx] = liveness.getLiveOut(node).flags;
+            }
+        }
+
+        // Writing a 32 bit register in 64 bit mode clears the upper half, the instruction is not a no-op.
+        static bool isZeroExtendingWrite(MachineMode mode, const Reg& reg) noexcept
+        {
+            return mode == MachineMode::AMD64 && reg.isGp32();
+        }
+
+        static bool removeMovSelf(PeepholeContext& ctx, Node* node)
+        {
+            const auto& instr = node->get<Instruction>();
+            if (instr.getOperandCount() != 2)
+            {
+                return false;
+            }
+
+            const auto* dst = instr.getOperandIf<Reg>(0);
+            const auto* src = instr.getOperandIf<Reg>(1);
+            if (dst == nullptr || src == nullptr || *dst != *src || !dst->isGp())
+            {
+                return false;
+            }
+            if (isZeroExtendingWrite(ctx.getMode(), *dst))
+            {
+                return false;
+            }
+
+            ctx.remove(node);
+            return true;
+        }
+
+        static bool removeAddZero(PeepholeContext& ctx, Node* node)
+        {
+            const auto& instr = node->get<Instruction>();
+            if (instr.getOperandCount() != 2)
+            {
+                return false;
+            }
+
+            const auto* dst = instr.getOperandIf<Reg>(0);
+            const auto* imm = instr.getOperandIf<Imm>(1);
+            if (dst == nullptr || imm == nullptr || imm->value<std::int64_t>() != 0 || !dst->isGp())
+            {
+                return false;
+            }
+            if (isZeroExtendingWrite(ctx.getMode(), *dst))
+            {
+                return false;
+            }
+
+            // The flags are updated from the result.
+            constexpr auto kStatusFlags = x86::CPUFlags::CF | x86::CPUFlags::PF | x86::CPUFlags::AF | x86::CPUFlags::ZF
+                | x86::CPUFlags::SF | x86::CPUFlags::OF;
+            if ((ctx.getLiveFlags(node) & kStatusFlags) != InstrCPUFlags{})
+            {
+                return false;
+            }
+
+            ctx.remove(node);
+            return true;
+        }
+
+        static bool removePushPop(PeepholeContext& ctx, Node* node)
+        {
+            auto* nextNode = node->getNext();
+            if (nextNode == nullptr)
+            {
+                return false;
+            }
+
+            const auto& push = node->get<Instruction>();
+            const auto* pop = nextNode->getIf<Instruction>();
+            if (pop == nullptr || pop->getMnemonic() != x86::Mnemonic::Pop)
+            {
+                return false;
+            }
+            if (push.getOperandCount() != 1 || pop->getOperandCount() != 1)
+            {
+                return false;
+            }
+
+            const auto* pushReg = push.getOperandIf<Reg>(0);
+            const auto* popReg = pop->getOperandIf<Reg>(0);
+            if (pushReg == nullptr || popReg == nullptr || *pushReg != *popReg || !pushReg->isGp())
+            {
+                return false;
+            }
+
+            ctx.remove(nextNode);
+            ctx.remove(node);
+            return true;
+        }
+
+        static bool removeJmpToNext(PeepholeContext& ctx, Node* node)
+        {
+            const auto& instr = node->get<Instruction>();
+            if (instr.getOperandCount() != 1)
+            {
+                return false;
+            }
+
+            const auto* label = instr.getOperandIf<Label>(0);
+            if (label == nullptr)
+            {
+                return false;
+            }
+
+            // Only labels may be between the jump and its target.
+            for (const auto* cur = node->getNext(); cur != nullptr && cur->holds<Label>(); cur = cur->getNext())
+            {
+                if (cur->get<Label>() == *label)
+                {
+                    ctx.remove(node);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+    } // namespace detail
+
+    Program& PeepholeContext::getProgram() const noexcept
+    {
+        return *_state->program;
+    }
+
+    MachineMode PeepholeContext::getMode() const noexcept
+    {
+        return _state->mode;
+    }
+
+    InstrCPUFlags PeepholeContext::getLiveFlags(const Node* node) const noexcept
+    {
+        const auto idx = static_cast<std::size_t>(node->getId());
+        if (idx >= _state->liveFlags.size())
+        {
+            return ~InstrCPUFlags{};
+        }
+        return _state->liveFlags[idx];
+    }
+
+    void PeepholeContext::remove(Node* node)
+    {
+        auto& state = *_state;
+
+        if (node == state.next)
+        {
+            state.next = node->getNext();
+        }
+
+        if (const auto* instr = node->getIf<Instruction>(); instr != nullptr)
+        {
+            state.stats.bytesSaved += detail::getEncodedSize(state.mode, *instr);
+            state.stats.instructionsRemoved++;
+        }
+
+        state.program->destroy(node);
+    }
+
+    Node* PeepholeContext::replace(Node* node, const Instruction& instr)
+    {
+        auto& state = *_state;
+
+        auto* newNode = state.program->insertAfter(node, state.program->createNode(instr));
+        state.stats.bytesSaved -= detail::getEncodedSize(state.mode, instr);
+        state.stats.instructionsInserted++;
+
+        remove(node);
+
+        return newNode;
+    }
+
+    PeepholeOptimizer::PeepholeOptimizer(Program& program)
+        : _state(new detail::PeepholeState())
+    {
+        _state->program = &program;
+        _state->mode = program.getMode();
+    }
+
+    PeepholeOptimizer::~PeepholeOptimizer()
+    {
+        delete _state;
+        _state = nullptr;
+    }
+
+    void PeepholeOptimizer::addRule(const PeepholeRule& rule)
+    {
+        auto& state = *_state;
+
+        const auto mnemonicIdx = static_cast<std::size_t>(rule.mnemonic.value());
+        if (mnemonicIdx >= state.rulesByMnemonic.size())
+        {
+            state.rulesByMnemonic.resize(mnemonicIdx + 1);
+        }
+        state.rulesByMnemonic[mnemonicIdx].push_back(state.rules.size());
+
+        state.rules.push_back(rule);
+    }
+
+    void PeepholeOptimizer::addDefaultRules()
+    {
+        addRule({ "mov-self", x86::Mnemonic::Mov, &detail::removeMovSelf });
+        addRule({ "add-zero", x86::Mnemonic::Add, &detail::removeAddZero });
+        addRule({ "sub-zero", x86::Mnemonic::Sub, &detail::removeAddZero });
+        addRule({ "push-pop", x86::Mnemonic::Push, &detail::removePushPop });
+        addRule({ "jmp-next", x86::Mnemonic::Jmp, &detail::removeJmpToNext });
+    }
+
+    void PeepholeOptimizer::clearRules() noexcept
+    {
+        _state->rules.clear();
+        _state->rulesByMnemonic.clear();
+    }
+
+    std::size_t PeepholeOptimizer::getRuleCount() const noexcept
+    {
+        return _state->rules.size();
+    }
+
+    const PeepholeRule& PeepholeOptimizer::getRule(std::size_t index) const noexcept
+    {
+        return _state->rules[index];
+    }
+
+    void PeepholeOptimizer::setMaxRounds(std::size_t maxRounds) noexcept
+    {
+        _state->maxRounds = maxRounds;
+    }
+
+    Error PeepholeOptimizer::run()
+    {
+        auto& state = *_state;
+        auto& program = *state.program;
+
+        state.stats = {};
+        state.stats.ruleHits.resize(state.rules.size());
+
+        // Both are kept up to date between the rounds, only new instructions are decoded again.
+        ControlFlowGraph cfg(program);
+        LivenessAnalysis liveness(program, cfg);
+
+        // Flags may be read after calls, indirect branches and branches out of the graph, they are
+        // only assumed to be dead after returns.
+        auto exitLive = liveness.getExitLiveSet();
+        liveness.setReturnLiveSet(exitLive);
+        exitLive.flags = ~InstrCPUFlags{};
+        liveness.setExitLiveSet(exitLive);
+
+        PeepholeContext ctx(_state);
+
+        bool changed = true;
+        while (changed && state.stats.rounds < state.maxRounds)
+        {
+            changed = false;
+            state.stats.rounds++;
+
+            liveness.run();
+            detail::computeLiveFlags(state, liveness);
+
+            for (auto* node = program.getHead(); node != nullptr; node = state.next)
+            {
+                state.next = node->getNext();
+
+                const auto* instr = node->getIf<Instruction>();
+                if (instr == nullptr)
+                {
+                    continue;
+                }
+
+                const auto mnemonicIdx = static_cast<std::size_t>(instr->getMnemonic().value());
+                if (mnemonicIdx >= state.rulesByMnemonic.size())
+                {
+                    continue;
+                }
+
+                for (const auto ruleIdx : state.rulesByMnemonic[mnemonicIdx])
+                {
+                    if (state.rules[ruleIdx].apply(ctx, node))
+                    {
+                        // The node may no longer exist.
+                        state.stats.ruleHits[ruleIdx]++;
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        state.next = nullptr;
+        state.liveFlags.clear();
+
+        return ErrorCode::None;
+    }
+
+    const PeepholeStats& PeepholeOptimizer::getStats() const noexcept
+    {
+        return _state->stats;
+    }
+
+} // namespace zasm
@@ -0,0 +1,507 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <zasm/passes/scheduler.hpp>
+#include <zasm/program/program.hpp>
+#include <zasm/program/regaccess.hpp>
+#include <zasm/x86/meta.hpp>
+#include <zasm/x86/x86.hpp>
+
+namespace zasm
+{
+    namespace detail
+    {
+        static constexpr std::uint32_t kDefaultLatency = 1;
+        static constexpr std::uint32_t kVectorLatency = 4;
+        static constexpr std::uint32_t kMulLatency = 3;
+        static constexpr std::uint32_t kDivLatency = 20;
+        static constexpr std::uint32_t kDefaultLoadLatency = 4;
+        static constexpr std::size_t kDefaultMaxRegionSize = 128;
+
+        struct SchedNode
+        {
+            Node* node{};
+            RegSet regsRead;
+            RegSet regsWrite;
+            InstrCPUFlags flagsRead{};
+            InstrCPUFlags flagsWrite{};
+            bool memRead{};
+            bool memWrite{};
+            std::uint32_t latency{};
+
+            // Length of the longest path to the end of the region including the own latency.
+            std::uint32_t height{};
+            // Earliest cycle the node can issue at given the already scheduled predecessors.
+            std::uint32_t readyCycle{};
+            std::uint32_t pendingPreds{};
+            bool scheduled{};
+        };
+
+        struct SchedEdge
+        {
+            std::uint32_t from{};
+            std::uint32_t to{};
+            std::uint32_t latency{};
+        };
+
+        struct SchedulerState
+        {
+            Program* program{};
+
+            std::array<std::uint32_t, 256> latencies{};
+            std::uint32_t loadLatency{ kDefaultLoadLatency };
+            std::size_t maxRegionSize{ kDefaultMaxRegionSize };
+
+            std::vector<SchedNode> nodes;
+            // Edges sorted by the source node, firstEdge has one extra entry for the end.
+            std::vector<SchedEdge> edges;
+            std::vector<std::uint32_t> firstEdge;
+            std::vector<std::uint32_t> order;
+
+            SchedulerStats stats;
+        };
+
+        static void setDefaultLatencies(SchedulerState& state) noexcept
+        {
+            state.latencies.fill(kDefaultLatency);
+
+            const InstrCategory vectorCategories[] = {
+                x86::Category::SSE,
+                x86::Category::AVX,
+                x86::Category::AVX2,
+                x86::Category::AVX512,
+                x86::Category::AVX512VBMI,
+                x86::Category::VFMA,
+                x86::Category::FMA4,
+                x86::Category::FP16,
+                x86::Category::X86ALU,
+                x86::Category::Aes,
+                x86::Category::SHA,
+                x86::Category::PCLMulqDq,
+                x86::Category::VPCLMulqDq,
+            };
+            for (const auto category : vectorCategories)
+            {
+                state.latencies[category.value()] = kVectorLatency;
+            }
+        }
+
+        // Instructions that have side effects beyond their operands or change the control flow.
+        static bool isBarrier(const InstructionDetail& detail) noexcept
+        {
+            const auto mnemonic = detail.getMnemonic();
+            if (x86::isBranching(mnemonic) || x86::isSyscall(mnemonic))
+            {
+                return true;
+            }
+
+            switch (mnemonic)
+            {
+                case x86::Mnemonic::Lfence:
+                case x86::Mnemonic::Mfence:
+                case x86::Mnemonic::Sfence:
+                case x86::Mnemonic::Pause:
+                case x86::Mnemonic::Cpuid:
+                case x86::Mnemonic::Rdtsc:
+                case x86::Mnemonic::Rdtscp:
+                // Following instructions must not execute before the trap.
+                case x86::Mnemonic::Ud0:
+                case x86::Mnemonic::Ud1:
+                case x86::Mnemonic::Ud2:
+                case x86::Mnemonic::Hlt:
+                case x86::Mnemonic::Int:
+                case x86::Mnemonic::Int1:
+                case x86::Mnemonic::Int3:
+                case x86::Mnemonic::Into:
+                    return true;
+                default:
+                    break;
+            }
+
+            switch (detail.getCategory())
+            {
+                case x86::Category::Call:
+                case x86::Category::CondBr:
+                case x86::Category::UncondBR:
+                case x86::Category::Ret:
+                case x86::Category::Syscall:
+                case x86::Category::Sysret:
+                case x86::Category::System:
+                case x86::Category::Interrupt:
+                case x86::Category::IO:
+                case x86::Category::IOStringOp:
+                case x86::Category::Serialize:
+                case x86::Category::Semaphore:
+                case x86::Category::SegOp:
+                    return true;
+                default:
+                    break;
+            }
+
+            return false;
+        }
+
+        static std::uint32_t getLatency(const SchedulerState& state, const InstructionDetail& detail) noexcept
+        {
+            switch (detail.getMnemonic())
+            {
+                case x86::Mnemonic::Imul:
+                case x86::Mnemonic::Mul:
+                case x86::Mnemonic::Mulx:
+                    return kMulLatency;
+                case x86::Mnemonic::Div:
+                case x86::Mnemonic::Idiv:
+                    return kDivLatency;
+                default:
+                    break;
+            }
+            return state.latencies[detail.getCategory().value()];
+        }
+
+        // Returns false if the instruction can not be moved.
+        static bool initNode(const SchedulerState& state, Node* node, SchedNode& res)
+        {
+            const auto* instr = node->getIf<Instruction>();
+            if (instr == nullptr)
+            {
+                return false;
+            }
+
+            const auto mode = state.program->getMode();
+            const auto detail = instr->getDetail(mode);
+            if (!detail || isBarrier(*detail))
+            {
+                return false;
+            }
+
+            const auto access = getRegAccess(*detail, mode);
+
+            res = {};
+            res.node = node;
+            res.regsRead = access.read;
+            res.regsWrite = access.write;
+            res.flagsRead = access.flagsRead;
+            res.flagsWrite = access.flagsWrite;
+            res.latency = getLatency(state, *detail);
+
+            // The memory operand of lea only computes the address.
+            if (detail->getMnemonic() != x86::Mnemonic::Lea)
+            {
+                const auto& opsAccess = detail->getOperandsAccess();
+                for (std::size_t i = 0; i < detail->getOperandCount(); ++i)
+                {
+                    if (!detail->getOperand(i).holds<Mem>())
+                    {
+                        continue;
+                    }
+                    const auto opAccess = opsAccess.get(i);
+                    res.memRead |= (opAccess & Operand::Access::MaskRead) != Operand::Access::None;
+                    res.memWrite |= (opAccess & Operand::Access::MaskWrite) != Operand::Access::None;
+                }
+            }
+            if (res.memRead)
+            {
+                res.latency += state.loadLatency;
+            }
+
+            return true;
+        }
+
+        // Returns the latency of the dependency from a to b or -1 if b does not depend on a.
+        static std::int64_t getDependency(const SchedNode& a, const SchedNode& b) noexcept
+        {
+            // Read after write.
+            if (a.regsWrite.intersects(b.regsRead) || (a.flagsWrite & b.flagsRead) != InstrCPUFlags{})
+            {
+                return a.latency;
+            }
+            // Conservative memory ordering, only loads may pass each other.
+            if (a.memWrite && b.memRead)
+            {
+                return a.latency;
+            }
+            if ((a.memWrite || a.memRead) && b.memWrite)
+            {
+                return 0;
+            }
+            // Write after read and write after write only order.
+            if (a.regsRead.intersects(b.regsWrite) || a.regsWrite.intersects(b.regsWrite)
+                || (a.flagsRead & b.flagsWrite) != InstrCPUFlags{} || (a.flagsWrite & b.flagsWrite) != InstrCPUFlags{})
+            {
+                return 0;
+            }
+            return -1;
+        }
+
+        static void buildGraph(SchedulerState& state)
+        {
+            auto& nodes = state.nodes;
+            const auto count = static_cast<std::uint32_t>(nodes.size());
+
+            state.edges.clear();
+            state.firstEdge.assign(count + 1, 0);
+
+            for (std::uint32_t i = 0; i < count; i++)
+            {
+                state.firstEdge[i] = static_cast<std::uint32_t>(state.edges.size());
+                for (std::uint32_t j = i + 1; j < count; j++)
+                {
+                    const auto latency = getDependency(nodes[i], nodes[j]);
+                    if (latency < 0)
+                    {
+                        continue;
+                    }
+                    state.edges.push_back({ i, j, static_cast<std::uint32_t>(latency) });
+                    nodes[j].pendingPreds++;
+                }
+            }
+            state.firstEdge[count] = static_cast<std::uint32_t>(state.edges.size());
+
+            // Edges only go forward, the heights are complete when walking backwards.
+            for (auto i = count; i-- > 0;)
+            {
+                auto& node = nodes[i];
+                node.height = node.latency;
+                for (auto e = state.firstEdge[i]; e < state.firstEdge[i + 1]; e++)
+                {
+                    const auto& edge = state.edges[e];
+                    node.height = std::max(node.height, edge.latency + nodes[edge.to].height);
+                }
+            }
+        }
+
+        // Estimated cycles of the order, one instruction issues per cycle.
+        static std::uint64_t getCycles(const SchedulerState& state, const std::vector<std::uint32_t>& order)
+        {
+            const auto& nodes = state.nodes;
+
+            std::vector<std::uint32_t> issue(nodes.size());
+            std::uint32_t cycle = 0;
+            std::uint64_t end = 0;
+            for (std::size_t pos = 0; pos < order.size(); pos++)
+            {
+                const auto i = order[pos];
+                issue[i] = std::max(cycle, issue[i]);
+                cycle = issue[i] + 1;
+                end = std::max<std::uint64_t>(end, issue[i] + nodes[i].latency);
+
+                for (auto e = state.firstEdge[i]; e < state.firstEdge[i + 1]; e++)
+                {
+                    const auto& edge = state.edges[e];
+                    issue[edge.to] = std::max(issue[edge.to], issue[i] + edge.latency);
+                }
+            }
+            return end;
+        }
+
+        static void computeOrder(SchedulerState& state)
+        {
+            auto& nodes = state.nodes;
+            auto& order = state.order;
+
+            order.clear();
+
+            std::uint32_t cycle = 0;
+            while (order.size() < nodes.size())
+            {
+                // Prefer instructions that can issue now, then the longest critical path, then program order.
+                std::uint32_t best = std::numeric_limits<std::uint32_t>::max();
+                for (std::uint32_t i = 0; i < nodes.size(); i++)
+                {
+                    const auto& node = nodes[i];
+                    if (node.scheduled || node.pendingPreds != 0)
+                    {
+                        continue;
+                    }
+                    if (best == std::numeric_limits<std::uint32_t>::max())
+                    {
+                        best = i;
+                        continue;
+                    }
+
+                    const auto& cur = nodes[best];
+                    const bool ready = node.readyCycle <= cycle;
+                    const bool curReady = cur.readyCycle <= cycle;
+                    if (ready != curReady)
+                    {
+                        if (ready)
+                        {
+                            best = i;
+                        }
+                        continue;
+                    }
+                    if (!ready && node.readyCycle != cur.readyCycle)
+                    {
+                        if (node.readyCycle < cur.readyCycle)
+                        {
+                            best = i;
+                        }
+                        continue;
+                    }
+                    if (node.height > cur.height)
+                    {
+                        best = i;
+                    }
+                }
+
+                auto& node = nodes[best];
+                node.scheduled = true;
+                order.push_back(best);
+
+                const auto issue = std::max(cycle, node.readyCycle);
+                cycle = issue + 1;
+
+                for (auto e = state.firstEdge[best]; e < state.firstEdge[best + 1]; e++)
+                {
+                    const auto& edge = state.edges[e];
+                    auto& succ = nodes[edge.to];
+                    succ.readyCycle = std::max(succ.readyCycle, issue + edge.latency);
+                    succ.pendingPreds--;
+                }
+            }
+        }
+
+        static void applyOrder(SchedulerState& state)
+        {
+            auto& program = *state.program;
+
+            auto* next = state.nodes.back().node->getNext();
+            for (const auto i : state.order)
+            {
+                auto* node = state.nodes[i].node;
+                if (next != nullptr)
+                {
+                    program.moveBefore(next, node);
+                }
+                else if (program.getTail() != node)
+                {
+                    program.moveAfter(program.getTail(), node);
+                }
+            }
+        }
+
+        static void scheduleRegion(SchedulerState& state)
+        {
+            auto& nodes = state.nodes;
+            if (nodes.empty())
+            {
+                return;
+            }
+
+            state.stats.regions++;
+
+            buildGraph(state);
+
+            state.order.resize(nodes.size());
+            for (std::uint32_t i = 0; i < nodes.size(); i++)
+            {
+                state.order[i] = i;
+            }
+            const auto cyclesBefore = getCycles(state, state.order);
+            state.stats.cyclesBefore += cyclesBefore;
+
+            if (nodes.size() < 2)
+            {
+                state.stats.cyclesAfter += cyclesBefore;
+                return;
+            }
+
+            computeOrder(state);
+
+            const auto cyclesAfter = getCycles(state, state.order);
+            if (cyclesAfter >= cyclesBefore)
+            {
+                state.stats.cyclesAfter += cyclesBefore;
+                return;
+            }
+            state.stats.cyclesAfter += cyclesAfter;
+            state.stats.regionsScheduled++;
+
+            for (std::uint32_t i = 0; i < nodes.size(); i++)
+            {
+                if (state.order[i] != i)
+                {
+                    state.stats.instructionsMoved++;
+                }
+            }
+
+            applyOrder(state);
+        }
+
+    } // namespace detail
+
+    InstructionScheduler::InstructionScheduler(Program& program)
+        : _state(new detail::SchedulerState())
+    {
+        _state->program = &program;
+        detail::setDefaultLatencies(*_state);
+    }
+
+    InstructionScheduler::~InstructionScheduler()
+    {
+        delete _state;
+        _state = nullptr;
+    }
+
+    void InstructionScheduler::setLatency(InstrCategory category, std::uint32_t latency) noexcept
+    {
+        _state->latencies[category.value()] = latency;
+    }
+
+    void InstructionScheduler::setLoadLatency(std::uint32_t latency) noexcept
+    {
+        _state->loadLatency = latency;
+    }
+
+    void InstructionScheduler::setMaxRegionSize(std::size_t size) noexcept
+    {
+        _state->maxRegionSize = std::max<std::size_t>(size, 1);
+    }
+
+    Error InstructionScheduler::run()
+    {
+        auto& state = *_state;
+        auto& program = *state.program;
+
+        state.stats = {};
+        state.nodes.clear();
+
+        for (auto* node = program.getHead(); node != nullptr;)
+        {
+            // The node may be moved by the scheduling of the region.
+            auto* next = node->getNext();
+
+            detail::SchedNode schedNode;
+            if (!detail::initNode(state, node, schedNode))
+            {
+                detail::scheduleRegion(state);
+                state.nodes.clear();
+            }
+            else
+            {
+                state.nodes.push_back(schedNode);
+                if (state.nodes.size() >= state.maxRegionSize)
+                {
+                    detail::scheduleRegion(state);
+                    state.nodes.clear();
+                }
+            }
+
+            node = next;
+        }
+
+        detail::scheduleRegion(state);
+        state.nodes.clear();
+
+        return ErrorCode::None;
+    }
+
+    const SchedulerStats& InstructionScheduler::getStats() const noexcept
+    {
+        return _state->stats;
+    }
+
+} // namespace zasm
@@ -1,12 +1,62 @@
 #include "zasm/program/data.hpp"
 
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
 #include <limits>
+#include <new>
 #include <utility>
 
 namespace zasm
 {
+    namespace detail
+    {
+        // Header of the buffer used by shared data, the bytes directly follow the header.
+        struct SharedDataBuffer
+        {
+            std::atomic<std::size_t> refCount{ 1 };
+
+            std::uint8_t* bytes() noexcept
+            {
+                return reinterpret_cast<std::uint8_t*>(this + 1);
+            }
+        };
+
+        static SharedDataBuffer* createSharedBuffer(const void* ptr, std::size_t len) noexcept
+        {
+            // NOLINTNEXTLINE
+            void* mem = std::malloc(sizeof(SharedDataBuffer) + len);
+            if (mem == nullptr)
+            {
+                return nullptr;
+            }
+
+            auto* buffer = new (mem) SharedDataBuffer();
+            std::memcpy(buffer->bytes(), ptr, len);
+
+            return buffer;
+        }
+
+        static void acquireSharedBuffer(SharedDataBuffer* buffer) noexcept
+        {
+            buffer->refCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        static void releaseSharedBuffer(SharedDataBuffer* buffer) noexcept
+        {
+            if (buffer->refCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            {
+                return;
+            }
+
+            buffer->~SharedDataBuffer();
+
+            // NOLINTNEXTLINE
+            std::free(buffer);
+        }
+
+    } // namespace detail
+
     Data::Data(const void* ptr, std::size_t len) noexcept
     {
         if (len <= kInlineStorageSize)
@@ -46,20 +96,67 @@ namespace zasm
 
     Data::~Data()
     {
-        if (_size == 0 || isDataInline())
+        release();
+    }
+
+    Data Data::external(const void* ptr, std::size_t len) noexcept
+    {
+        Data res;
+        if (len == 0)
+        {
+            return res;
+        }
+
+        res._storage.externalPtr = ptr;
+        res._size = kExternalDataFlag | len;
+
+        return res;
+    }
+
+    Expected<Data, Error> Data::shared(const void* ptr, std::size_t len) noexcept
+    {
+        if (len <= kInlineStorageSize)
+        {
+            return Data(ptr, len);
+        }
+
+        auto* buffer = detail::createSharedBuffer(ptr, len);
+        if (buffer == nullptr)
+        {
+            return makeUnexpected(Error(ErrorCode::OutOfMemory));
+        }
+
+        Data res;
+        res._storage.ptr = buffer;
+        res._size = kSharedDataFlag | len;
+
+        return res;
+    }
+
+    void Data::release() noexcept
+    {
+        if (getSize() == 0 || isDataInline() || isExternal())
         {
             return;
         }
 
-        // NOLINTNEXTLINE
-        std::free(const_cast<void*>(_storage.ptr));
+        if (isShared())
+        {
+            detail::releaseSharedBuffer(static_cast<detail::SharedDataBuffer*>(_storage.ptr));
+        }
+        else
+        {
+            // NOLINTNEXTLINE
+            std::free(_storage.ptr);
+        }
 
         _storage.ptr = nullptr;
+        _size = 0;
     }
 
     const void* Data::getData() const noexcept
     {
-        if (_size == 0)
+        if (getSize() == 0)
         {
             return nullptr;
         }
@@ -69,12 +166,22 @@ namespace zasm
             return _storage.bytes.data();
         }
 
+        if (isExternal())
+        {
+            return _storage.externalPtr;
+        }
+
+        if (isShared())
+        {
+            return static_cast<detail::SharedDataBuffer*>(_storage.ptr)->bytes();
+        }
+
         return _storage.ptr;
     }
 
     std::size_t Data::getSize() const noexcept
     {
-        return (_size & ~kInlineDataFlag);
+        return (_size & ~kStorageMask);
     }
 
     std::size_t Data::getTotalSize() const noexcept
@@ -84,12 +191,33 @@ namespace zasm
 
     Data& Data::operator=(const Data& other) noexcept
     {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        release();
+
         _size = other._size;
         _repeatCount = other._repeatCount;
         if (isDataInline())
         {
             _storage.bytes = other._storage.bytes;
         }
+        else if (isExternal())
+        {
+            _storage.externalPtr = other._storage.externalPtr;
+        }
+        else if (isShared())
+        {
+            // Shared buffers are never copied, only the reference count changes.
+            _storage.ptr = other._storage.ptr;
+            detail::acquireSharedBuffer(static_cast<detail::SharedDataBuffer*>(_storage.ptr));
+        }
+        else if (other.getSize() == 0)
+        {
+            _storage.ptr = nullptr;
+        }
         else
         {
             // NOLINTNEXTLINE
@@ -111,6 +239,13 @@ namespace zasm
 
     Data& Data::operator=(Data&& other) noexcept
     {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        release();
+
         _size = other._size;
         _repeatCount = other._repeatCount;
         if (isDataInline())
@@ -406,21 +406,24 @@ namespace zasm
         return insertBefore_<false>(pos, node, *_state);
     }
 
-    static void destroyNode(detail::ProgramState& state, Node* node, bool quickDestroy)
+    // Unbind so the label no longer refers to the released node.
+    static void unbindNode(detail::ProgramState& state, const Node* node) noexcept
     {
-        // Keep index before destroying the object.
-        const auto nodeIdx = static_cast<std::size_t>(node->getId());
-
-        notifyObservers<true>(&Observer::onNodeDestroy, state.observer, node);
-
-        // If this is called from clear or from destructor we can skip unlinking.
-        if (!quickDestroy)
+        if (const auto* label = node->getIf<Label>(); label != nullptr)
         {
-            // Ensure node is not in the list anymore.
-            detach_<false>(node, state);
+            const auto entryIdx = static_cast<std::size_t>(label->getId());
+            if (entryIdx < state.labels.size() && state.labels[entryIdx].node == node)
+            {
+                state.labels[entryIdx].node = nullptr;
+            }
         }
+    }
+
+    static void releaseNode(detail::ProgramState& state, Node* node, bool quickDestroy)
+    {
+        // Keep index before destroying the object.
+        const auto nodeIdx = static_cast<std::size_t>(node->getId());
 
-        // Release.
         auto* nodeToDestroy = detail::toInternal(node);
 
         node->visit([&](auto& ptr) {
@@ -443,17 +446,39 @@ namespace zasm
             // Release memory, when quickDestroy is true the entire pool will be cleared at once.
             nodePool.deallocate(nodeToDestroy, 1);
 
-            // Remove mapping.
-            auto& nodeMap = state.nodeMap;
-            assert(nodeIdx < nodeMap.size());
-
             // Null out the slot.
-            nodeMap[nodeIdx] = nullptr;
+            assert(nodeIdx < state.nodeMap.size());
+            state.nodeMap[nodeIdx] = nullptr;
+        }
+    }
 
-            while (!nodeMap.empty() && nodeMap.back() == nullptr)
-            {
-                nodeMap.pop_back();
-            }
+    static void trimNodeMap(detail::ProgramState& state) noexcept
+    {
+        auto& nodeMap = state.nodeMap;
+        while (!nodeMap.empty() && nodeMap.back() == nullptr)
+        {
+            nodeMap.pop_back();
+        }
+    }
+
+    static void destroyNode(detail::ProgramState& state, Node* node, bool quickDestroy)
+    {
+        notifyObservers<true>(&Observer::onNodeDestroy, state.observer, node);
+
+        // If this is called from clear or from destructor we can skip unlinking.
+        if (!quickDestroy)
+        {
+            // Ensure node is not in the list anymore.
+            detach_<false>(node, state);
+
+            unbindNode(state, node);
+        }
+
+        releaseNode(state, node, quickDestroy);
+
+        if (!quickDestroy)
+        {
+            trimNodeMap(state);
         }
     }
 
@@ -462,6 +487,49 @@ namespace zasm
         destroyNode(*_state, node, false);
     }
 
+    void Program::destroy(Node* first, Node* last)
+    {
+        auto& state = *_state;
+
+        notifyObservers<true>(&Observer::onNodesDestroy, state.observer, first, last);
+
+        // Unlink the entire range at once.
+        auto* pre = detail::toInternal(first->getPrev());
+        auto* post = detail::toInternal(last->getNext());
+        if (pre != nullptr)
+        {
+            pre->setNext(post);
+        }
+        else
+        {
+            state.head = post;
+        }
+        if (post != nullptr)
+        {
+            post->setPrev(pre);
+        }
+        else
+        {
+            state.tail = pre;
+        }
+
+        auto* node = first;
+        while (node != nullptr)
+        {
+            auto* next = node != last ? node->getNext() : nullptr;
+
+            detail::toInternal(node)->setAttached(false);
+            state.nodeCount--;
+
+            unbindNode(state, node);
+            releaseNode(state, node, false);
+
+            node = next;
+        }
+
+        trimNodeMap(state);
+    }
+
     std::size_t Program::size() const noexcept
     {
         return _state->nodeCount;
@@ -499,6 +567,24 @@ namespace zasm
         return _state->entryPoint;
     }
 
+    Error Program::setSymbolPool(ConcurrentStringPool* pool)
+    {
+        if (!_state->labels.empty() || !_state->sections.empty())
+        {
+            return ErrorCode::InvalidOperation;
+        }
+
+        _state->symbolNames.clear();
+        _state->symbolNames.setShared(pool);
+
+        return ErrorCode::None;
+    }
+
+    ConcurrentStringPool* Program::getSymbolPool() const noexcept
+    {
+        return _state->symbolNames.getShared();
+    }
+
     template<typename T> Node* createNode_(detail::ProgramState& state, T&& object)
     {
         const auto nextId = state.nextNodeId;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "zasm/core/concurrentstringpool.hpp"
 #include "zasm/core/enumflags.hpp"
 #include "zasm/core/objectpool.hpp"
 #include "zasm/core/stringpool.hpp"
@@ -83,9 +84,78 @@ namespace zasm::detail
         std::size_t nodeCount{};
     };
 
+    // Symbol names of the program, either stored in its own pool or in a shared pool.
+    class SymbolNames
+    {
+        StringPool _local;
+        ConcurrentStringPool* _shared{};
+
+    public:
+        StringPool::Id acquire(const char* str)
+        {
+            if (_shared != nullptr)
+            {
+                return _shared->acquire(str);
+            }
+            return _local.acquire(str);
+        }
+
+        // Strings of the shared pool are never removed, releasing only affects the own pool.
+        std::int32_t release(StringPool::Id stringId) noexcept
+        {
+            if (_shared != nullptr)
+            {
+                return 1;
+            }
+            return _local.release(stringId);
+        }
+
+        const char* get(StringPool::Id stringId) const noexcept
+        {
+            if (_shared != nullptr)
+            {
+                return _shared->get(stringId);
+            }
+            return _local.get(stringId);
+        }
+
+        void clear() noexcept
+        {
+            _local.clear();
+        }
+
+        ConcurrentStringPool* getShared() const noexcept
+        {
+            return _shared;
+        }
+
+        void setShared(ConcurrentStringPool* pool) noexcept
+        {
+            _shared = pool;
+        }
+
+        // Saves the own pool, names of a shared pool have to be copied into a pool of their own first
+        // as the shared pool holds the names of other programs as well.
+        Error save(IStream& stream) const
+        {
+            return _local.save(stream);
+        }
+
+        // Loading always uses the own pool, the ids in the stream do not belong to the shared pool.
+        Error load(IStream& stream)
+        {
+            if (auto err = _local.load(stream); err != ErrorCode::None)
+            {
+                return err;
+            }
+            _shared = nullptr;
+            return ErrorCode::None;
+        }
+    };
+
     struct Symbols
     {
-        StringPool symbolNames;
+        SymbolNames symbolNames;
     };
 
     struct ProgramState : NodeList, Symbols
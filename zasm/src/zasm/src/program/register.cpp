@@ -1,12 +1,11 @@
 #include <Zydis/Zydis.h>
-#include <cstddef>
+#include <cassert>
 #include <zasm/base/register.hpp>
 
-namespace zasm
+namespace zasm::detail
 {
     static_assert(ZYDIS_REGISTER_AL < ZYDIS_REGISTER_AH);
-    static constexpr std::int8_t kGp8HiStartIndex = ZYDIS_REGISTER_AH - ZYDIS_REGISTER_AL;
-    static_assert(kGp8HiStartIndex == 4, "This should be 4, if this triggers the definition probably changed");
+    static_assert(ZYDIS_REGISTER_AH - ZYDIS_REGISTER_AL == 4, "This should be 4, if this triggers the definition probably changed");
 
     static ZydisMachineMode getMode(MachineMode mode) noexcept
     {
@@ -23,180 +22,25 @@ namespace zasm
         return ZYDIS_MACHINE_MODE_MAX_VALUE;
     }
 
-    BitSize Reg::getBitSize(MachineMode mode) const noexcept
+    BitSize getRegBitSizeSlow(std::int16_t regId, MachineMode mode) noexcept
     {
-        const auto regId = static_cast<ZydisRegister>(getId());
-        return toBitSize(ZydisRegisterGetWidth(getMode(mode), regId));
+        return toBitSize(ZydisRegisterGetWidth(getMode(mode), static_cast<ZydisRegister>(regId)));
     }
 
-    Reg::Class Reg::getClass() const noexcept
+    std::uint8_t getRegClassSlow(std::int16_t regId) noexcept
     {
-        const auto regId = static_cast<ZydisRegister>(getId());
-        return static_cast<Reg::Class>(ZydisRegisterGetClass(regId));
+        return static_cast<std::uint8_t>(ZydisRegisterGetClass(static_cast<ZydisRegister>(regId)));
     }
 
-    std::int8_t Reg::getIndex() const noexcept
+    std::int8_t getRegIndexSlow(std::int16_t regId) noexcept
     {
-        const auto regId = static_cast<ZydisRegister>(getId());
-        return ZydisRegisterGetId(regId);
+        return ZydisRegisterGetId(static_cast<ZydisRegister>(regId));
     }
 
-    std::int8_t Reg::getPhysicalIndex() const noexcept
+    std::int16_t getRegRootSlow(std::int16_t regId, MachineMode mode) noexcept
     {
-        const auto regId = static_cast<ZydisRegister>(getId());
-        const auto regIndex = ZydisRegisterGetId(regId);
-        if (regIndex == -1)
-        {
-            return -1;
-        }
-        if (isGp8() && regIndex >= kGp8HiStartIndex)
-        {
-            return static_cast<std::int8_t>(regIndex - kGp8HiStartIndex);
-        }
-        return regIndex;
-    }
-
-    Reg Reg::getRoot(MachineMode mode) const noexcept
-    {
-        const auto regId = static_cast<ZydisRegister>(getId());
-        const auto enclosingId = ZydisRegisterGetLargestEnclosing(getMode(mode), regId);
-        return Reg{ static_cast<Reg::Id>(enclosingId) };
-    }
-
-    std::int8_t Reg::getOffset() const noexcept
-    {
-        const auto regId = static_cast<ZydisRegister>(getId());
-        switch (regId)
-        {
-            case ZYDIS_REGISTER_AH:
-            case ZYDIS_REGISTER_CH:
-            case ZYDIS_REGISTER_BH:
-            case ZYDIS_REGISTER_DH:
-                return 1;
-            default:
-                return 0;
-        }
-        return 0;
-    }
-
-    bool Reg::isIP() const noexcept
-    {
-        return getClass() == static_cast<Reg::Class>(ZYDIS_REGCLASS_IP);
-    }
-
-    bool Reg::isGp8() const noexcept
-    {
-        return static_cast<ZydisRegisterClass>(getClass()) == ZydisRegisterClass::ZYDIS_REGCLASS_GPR8;
-    }
-
-    bool Reg::isGp8Lo() const noexcept
-    {
-        if (!isGp8())
-        {
-            return false;
-        }
-        const auto regId = static_cast<ZydisRegister>(getId());
-        switch (regId)
-        {
-            case ZYDIS_REGISTER_AH:
-            case ZYDIS_REGISTER_CH:
-            case ZYDIS_REGISTER_BH:
-            case ZYDIS_REGISTER_DH:
-                return false;
-            default:
-                return true;
-        }
-        return true;
-    }
-
-    bool Reg::isGp8Hi() const noexcept
-    {
-        if (!isGp8())
-        {
-            return false;
-        }
-        const auto regId = static_cast<ZydisRegister>(getId());
-        switch (regId)
-        {
-            case ZYDIS_REGISTER_AH:
-            case ZYDIS_REGISTER_CH:
-            case ZYDIS_REGISTER_BH:
-            case ZYDIS_REGISTER_DH:
-                return true;
-            default:
-                return false;
-        }
-        return false;
-    }
-
-    bool Reg::isGp16() const noexcept
-    {
-        return static_cast<ZydisRegisterClass>(getClass()) == ZydisRegisterClass::ZYDIS_REGCLASS_GPR16;
-    }
-
-    bool Reg::isGp32() const noexcept
-    {
-        return static_cast<ZydisRegisterClass>(getClass()) == ZydisRegisterClass::ZYDIS_REGCLASS_GPR32;
-    }
-
-    bool Reg::isGp64() const noexcept
-    {
-        return static_cast<ZydisRegisterClass>(getClass()) == ZydisRegisterClass::ZYDIS_REGCLASS_GPR64;
-    }
-
-    bool Reg::isGp() const noexcept
-    {
-        return isGp8() || isGp16() || isGp32() || isGp64();
-    }
-
-    bool Reg::isSeg() const noexcept
-    {
-        return static_cast<ZydisRegisterClass>(getClass()) == ZydisRegisterClass::ZYDIS_REGCLASS_SEGMENT;
-    }
-
-    bool Reg::isXmm() const noexcept
-    {
-        return static_cast<ZydisRegisterClass>(getClass()) == ZydisRegisterClass::ZYDIS_REGCLASS_XMM;
-    }
-
-    bool Reg::isYmm() const noexcept
-    {
-        return static_cast<ZydisRegisterClass>(getClass()) == ZydisRegisterClass::ZYDIS_REGCLASS_YMM;
-    }
-
-    bool Reg::isZmm() const noexcept
-    {
-        return static_cast<ZydisRegisterClass>(getClass()) == ZydisRegisterClass::ZYDIS_REGCLASS_ZMM;
-    }
-
-    bool Reg::isBnd() const noexcept
-    {
-        return static_cast<ZydisRegisterClass>(getClass()) == ZydisRegisterClass::ZYDIS_REGCLASS_BOUND;
-    }
-
-    bool Reg::isControl() const noexcept
-    {
-        return static_cast<ZydisRegisterClass>(getClass()) == ZydisRegisterClass::ZYDIS_REGCLASS_CONTROL;
-    }
-
-    bool Reg::isDebug() const noexcept
-    {
-        return static_cast<ZydisRegisterClass>(getClass()) == ZydisRegisterClass::ZYDIS_REGCLASS_DEBUG;
-    }
-
-    bool Reg::isMask() const noexcept
-    {
-        return static_cast<ZydisRegisterClass>(getClass()) == ZydisRegisterClass::ZYDIS_REGCLASS_MASK;
-    }
-
-    bool Reg::isMmx() const noexcept
-    {
-        return static_cast<ZydisRegisterClass>(getClass()) == ZydisRegisterClass::ZYDIS_REGCLASS_MMX;
-    }
-
-    bool Reg::isTmm() const noexcept
-    {
-        return static_cast<ZydisRegisterClass>(getClass()) == ZydisRegisterClass::ZYDIS_REGCLASS_TMM;
+        const auto enclosingId = ZydisRegisterGetLargestEnclosing(getMode(mode), static_cast<ZydisRegister>(regId));
+        return static_cast<std::int16_t>(enclosingId);
     }
 
-} // namespace zasm
+} // namespace zasm::detail
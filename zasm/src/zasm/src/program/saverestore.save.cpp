@@ -184,7 +184,46 @@ namespace zasm
         return ErrorCode::None;
     }
 
-    static Error saveLabels(SaveRestore& helper, const Program& program)
+    // Maps the symbol ids of the program to the ids written to the stream. Names of a shared pool are
+    // copied into a separate pool so only the names used by this program are saved and the ids match on load.
+    class SymbolWriter
+    {
+        const detail::SymbolNames& _names;
+        StringPool _copied;
+
+    public:
+        explicit SymbolWriter(const detail::SymbolNames& names)
+            : _names(names)
+        {
+        }
+
+        StringPool::Id map(StringPool::Id stringId)
+        {
+            if (_names.getShared() == nullptr || stringId == StringPool::Id::Invalid)
+            {
+                return stringId;
+            }
+
+            const char* str = _names.get(stringId);
+            if (str == nullptr)
+            {
+                return StringPool::Id::Invalid;
+            }
+
+            return _copied.acquire(str);
+        }
+
+        Error save(IStream& stream) const
+        {
+            if (_names.getShared() != nullptr)
+            {
+                return _copied.save(stream);
+            }
+            return _names.save(stream);
+        }
+    };
+
+    static Error saveLabels(SaveRestore& helper, SymbolWriter& symbols, const Program& program)
     {
         const auto& programState = program.getState();
         const auto& labels = programState.labels;
@@ -195,15 +234,15 @@ namespace zasm
         {
             helper << labelData.flags;
             helper << labelData.id;
-            helper << labelData.moduleId;
-            helper << labelData.nameId;
+            helper << symbols.map(labelData.moduleId);
+            helper << symbols.map(labelData.nameId);
             helper << getNodeId(labelData.node);
         }
 
         return ErrorCode::None;
     }
 
-    static Error saveSections(SaveRestore& helper, const Program& program)
+    static Error saveSections(SaveRestore& helper, SymbolWriter& symbols, const Program& program)
     {
         const auto& programState = program.getState();
         const auto& sections = programState.sections;
@@ -215,18 +254,16 @@ namespace zasm
             helper << sectionData.align;
             helper << sectionData.attribs;
             helper << sectionData.id;
-            helper << sectionData.nameId;
+            helper << symbols.map(sectionData.nameId);
             helper << getNodeId(sectionData.node);
         }
 
         return ErrorCode::None;
     }
 
-    static Error saveSymbols(SaveRestore& helper, const Program& program)
+    static Error saveSymbols(SaveRestore& helper, const SymbolWriter& symbols)
     {
         auto& stream = helper.getStream();
-        const auto& programState = program.getState();
-        const auto& symbols = programState.symbolNames;
 
         if (auto err = symbols.save(stream); err != ErrorCode::None)
         {
@@ -251,17 +288,19 @@ namespace zasm
             return err;
         }
 
-        if (auto err = saveSections(helper, program); err != ErrorCode::None)
+        SymbolWriter symbols(programState.symbolNames);
+
+        if (auto err = saveSections(helper, symbols, program); err != ErrorCode::None)
         {
             return err;
         }
 
-        if (auto err = saveLabels(helper, program); err != ErrorCode::None)
+        if (auto err = saveLabels(helper, symbols, program); err != ErrorCode::None)
         {
             return err;
         }
 
-        if (auto err = saveSymbols(helper, program); err != ErrorCode::None)
+        if (auto err = saveSymbols(helper, symbols); err != ErrorCode::None)
         {
             return err;
         }
@@ -0,0 +1,361 @@
+#include "zasm/serialization/image.hpp"
+
+#include "serializer.relocation.hpp"
+#include "serializer.state.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <new>
+
+namespace zasm
+{
+    namespace detail
+    {
+        // Header of the single allocation, all arrays are placed directly after it.
+        struct SerializedImageData
+        {
+            std::atomic<std::uint32_t> refCount{ 1 };
+
+            std::int64_t base{};
+            std::uint32_t min32{};
+            std::uint32_t max32{};
+
+            std::size_t codeSize{};
+            std::size_t sectionCount{};
+            std::size_t relocationCount{};
+            std::size_t externalRelocationCount{};
+            std::size_t labelCount{};
+            std::size_t relocation32Count{};
+            std::size_t relocation64Count{};
+
+            const std::uint8_t* code{};
+            const SectionInfo* sections{};
+            const RelocationInfo* relocations{};
+            const RelocationInfo* externalRelocations{};
+            const std::int32_t* labelOffsets{};
+            const std::int64_t* labelAddresses{};
+            const std::int32_t* relocations32{};
+            const std::int32_t* relocations64{};
+        };
+
+        // Helper to compute the layout of the allocation.
+        class ImageLayout
+        {
+            std::size_t _size{ sizeof(SerializedImageData) };
+
+        public:
+            template<typename T> std::size_t add(std::size_t count) noexcept
+            {
+                _size = (_size + alignof(T) - 1) & ~(alignof(T) - 1);
+                const auto offset = _size;
+                _size += sizeof(T) * count;
+                return offset;
+            }
+
+            std::size_t size() const noexcept
+            {
+                return _size;
+            }
+        };
+
+    } // namespace detail
+
+    SerializedImage::SerializedImage(const SerializedImage& other) noexcept
+        : _data(other._data)
+    {
+        if (_data != nullptr)
+        {
+            _data->refCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    SerializedImage::SerializedImage(SerializedImage&& other) noexcept
+        : _data(other._data)
+    {
+        other._data = nullptr;
+    }
+
+    SerializedImage::~SerializedImage() noexcept
+    {
+        release();
+    }
+
+    SerializedImage& SerializedImage::operator=(const SerializedImage& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            _data = other._data;
+            if (_data != nullptr)
+            {
+                _data->refCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        return *this;
+    }
+
+    SerializedImage& SerializedImage::operator=(SerializedImage&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            _data = other._data;
+            other._data = nullptr;
+        }
+        return *this;
+    }
+
+    void SerializedImage::release() noexcept
+    {
+        if (_data == nullptr)
+        {
+            return;
+        }
+
+        if (_data->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            _data->~SerializedImageData();
+            ::operator delete(static_cast<void*>(_data));
+        }
+        _data = nullptr;
+    }
+
+    Expected<SerializedImage, Error> SerializedImage::create(const Serializer& serializer)
+    {
+        const auto& state = *serializer._state;
+        if (state.code.empty())
+        {
+            return makeUnexpected(Error(ErrorCode::EmptyState));
+        }
+
+        std::size_t namesSize = 0;
+        for (const auto& sect : state.sections)
+        {
+            if (sect.name != nullptr)
+            {
+                namesSize += std::strlen(sect.name) + 1;
+            }
+        }
+
+        const auto& plan = state.relocationPlan;
+
+        detail::ImageLayout layout;
+        const auto sectionsOffset = layout.add<SectionInfo>(state.sections.size());
+        const auto relocationsOffset = layout.add<RelocationInfo>(state.relocations.size());
+        const auto externalRelocationsOffset = layout.add<RelocationInfo>(state.externalRelocations.size());
+        const auto labelAddressesOffset = layout.add<std::int64_t>(state.labels.size());
+        const auto labelOffsetsOffset = layout.add<std::int32_t>(state.labels.size());
+        const auto relocations32Offset = layout.add<std::int32_t>(plan.offsets32.size());
+        const auto relocations64Offset = layout.add<std::int32_t>(plan.offsets64.size());
+        const auto codeOffset = layout.add<std::uint8_t>(state.code.size());
+        const auto namesOffset = layout.add<char>(namesSize);
+
+        auto* memory = static_cast<std::uint8_t*>(::operator new(layout.size(), std::nothrow));
+        if (memory == nullptr)
+        {
+            return makeUnexpected(Error(ErrorCode::OutOfMemory));
+        }
+
+        auto* data = new (memory) detail::SerializedImageData();
+        data->base = state.base;
+        data->min32 = plan.min32;
+        data->max32 = plan.max32;
+        data->codeSize = state.code.size();
+        data->sectionCount = state.sections.size();
+        data->relocationCount = state.relocations.size();
+        data->externalRelocationCount = state.externalRelocations.size();
+        data->labelCount = state.labels.size();
+        data->relocation32Count = plan.offsets32.size();
+        data->relocation64Count = plan.offsets64.size();
+
+        auto* sections = reinterpret_cast<SectionInfo*>(memory + sectionsOffset);
+        auto* names = reinterpret_cast<char*>(memory + namesOffset);
+        for (std::size_t i = 0; i < state.sections.size(); ++i)
+        {
+            new (&sections[i]) SectionInfo(state.sections[i]);
+            if (state.sections[i].name != nullptr)
+            {
+                const auto len = std::strlen(state.sections[i].name) + 1;
+                std::memcpy(names, state.sections[i].name, len);
+                sections[i].name = names;
+                names += len;
+            }
+        }
+        data->sections = sections;
+
+        auto* relocations = reinterpret_cast<RelocationInfo*>(memory + relocationsOffset);
+        std::uninitialized_copy(state.relocations.begin(), state.relocations.end(), relocations);
+        data->relocations = relocations;
+
+        auto* externalRelocations = reinterpret_cast<RelocationInfo*>(memory + externalRelocationsOffset);
+        std::uninitialized_copy(state.externalRelocations.begin(), state.externalRelocations.end(), externalRelocations);
+        data->externalRelocations = externalRelocations;
+
+        auto* labelAddresses = reinterpret_cast<std::int64_t*>(memory + labelAddressesOffset);
+        auto* labelOffsets = reinterpret_cast<std::int32_t*>(memory + labelOffsetsOffset);
+        for (std::size_t i = 0; i < state.labels.size(); ++i)
+        {
+            const auto& label = state.labels[i];
+            labelOffsets[i] = label.boundOffset;
+            labelAddresses[i] = label.boundOffset == detail::LabelInfo::kUnboundOffset ? 0 : label.boundAddress - state.base;
+        }
+        data->labelAddresses = labelAddresses;
+        data->labelOffsets = labelOffsets;
+
+        auto* relocations32 = reinterpret_cast<std::int32_t*>(memory + relocations32Offset);
+        std::copy(plan.offsets32.begin(), plan.offsets32.end(), relocations32);
+        data->relocations32 = relocations32;
+
+        auto* relocations64 = reinterpret_cast<std::int32_t*>(memory + relocations64Offset);
+        std::copy(plan.offsets64.begin(), plan.offsets64.end(), relocations64);
+        data->relocations64 = relocations64;
+
+        auto* code = memory + codeOffset;
+        std::memcpy(code, state.code.data(), state.code.size());
+        data->code = code;
+
+        SerializedImage image;
+        image._data = data;
+
+        return image;
+    }
+
+    bool SerializedImage::isValid() const noexcept
+    {
+        return _data != nullptr;
+    }
+
+    std::int64_t SerializedImage::getBase() const noexcept
+    {
+        if (_data == nullptr)
+        {
+            return 0;
+        }
+        return _data->base;
+    }
+
+    std::size_t SerializedImage::getCodeSize() const noexcept
+    {
+        if (_data == nullptr)
+        {
+            return 0;
+        }
+        return _data->codeSize;
+    }
+
+    const std::uint8_t* SerializedImage::getCode() const noexcept
+    {
+        if (_data == nullptr)
+        {
+            return nullptr;
+        }
+        return _data->code;
+    }
+
+    std::size_t SerializedImage::getSectionCount() const noexcept
+    {
+        if (_data == nullptr)
+        {
+            return 0;
+        }
+        return _data->sectionCount;
+    }
+
+    const SectionInfo* SerializedImage::getSectionInfo(std::size_t sectionIndex) const noexcept
+    {
+        if (_data == nullptr || sectionIndex >= _data->sectionCount)
+        {
+            return nullptr;
+        }
+        return &_data->sections[sectionIndex];
+    }
+
+    std::int32_t SerializedImage::getLabelOffset(Label::Id labelId) const noexcept
+    {
+        const auto idx = static_cast<std::size_t>(labelId);
+        if (_data == nullptr || idx >= _data->labelCount)
+        {
+            return -1;
+        }
+        return _data->labelOffsets[idx];
+    }
+
+    std::int64_t SerializedImage::getLabelAddress(Label::Id labelId, std::int64_t base) const noexcept
+    {
+        const auto idx = static_cast<std::size_t>(labelId);
+        if (_data == nullptr || idx >= _data->labelCount)
+        {
+            return -1;
+        }
+        if (_data->labelOffsets[idx] == detail::LabelInfo::kUnboundOffset)
+        {
+            return -1;
+        }
+        return base + _data->labelAddresses[idx];
+    }
+
+    std::size_t SerializedImage::getRelocationCount() const noexcept
+    {
+        if (_data == nullptr)
+        {
+            return 0;
+        }
+        return _data->relocationCount;
+    }
+
+    const RelocationInfo* SerializedImage::getRelocation(std::size_t index) const noexcept
+    {
+        if (_data == nullptr || index >= _data->relocationCount)
+        {
+            return nullptr;
+        }
+        return &_data->relocations[index];
+    }
+
+    std::size_t SerializedImage::getExternalRelocationCount() const noexcept
+    {
+        if (_data == nullptr)
+        {
+            return 0;
+        }
+        return _data->externalRelocationCount;
+    }
+
+    const RelocationInfo* SerializedImage::getExternalRelocation(std::size_t index) const noexcept
+    {
+        if (_data == nullptr || index >= _data->externalRelocationCount)
+        {
+            return nullptr;
+        }
+        return &_data->externalRelocations[index];
+    }
+
+    Error SerializedImage::relocateTo(std::int64_t newBase, std::uint8_t* buffer, std::size_t bufferSize) const
+    {
+        if (_data == nullptr)
+        {
+            return ErrorCode::EmptyState;
+        }
+
+        if (buffer == nullptr || bufferSize < _data->codeSize)
+        {
+            return ErrorCode::InvalidParameter;
+        }
+
+        const auto delta = newBase - _data->base;
+        if (!detail::canApplyRelocations32(_data->relocation32Count, _data->min32, _data->max32, delta))
+        {
+            return ErrorCode::ImpossibleRelocation;
+        }
+
+        std::memcpy(buffer, _data->code, _data->codeSize);
+
+        detail::applyRelocations32(_data->relocations32, _data->relocation32Count, buffer, delta);
+        detail::applyRelocations64(_data->relocations64, _data->relocation64Count, buffer, delta);
+
+        return ErrorCode::None;
+    }
+
+} // namespace zasm
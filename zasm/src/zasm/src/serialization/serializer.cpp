@@ -2,6 +2,8 @@
 
 #include "../encoder/encoder.context.hpp"
 #include "../program/program.state.hpp"
+#include "serializer.shrink.hpp"
+#include "serializer.state.hpp"
 #include "zasm/core/math.hpp"
 #include "zasm/encoder/encoder.hpp"
 #include "zasm/formatter/formatter.hpp"
@@ -10,39 +12,20 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstring>
 #include <functional>
 #include <iterator>
+#include <utility>
 
 namespace zasm
 {
-    namespace detail
-    {
-        struct LabelInfo
-        {
-            static constexpr std::int32_t kUnboundOffset = -1;
-            static constexpr std::int64_t kUnboundAddress = -1;
-
-            Label::Id labelId{ Label::Id::Invalid };
-            std::int32_t boundOffset{ kUnboundOffset };
-            std::int64_t boundAddress{ kUnboundAddress };
-        };
-
-        struct SerializerState
-        {
-            std::int64_t base{};
-            std::vector<SectionInfo> sections;
-            std::vector<std::uint8_t> code;
-            std::vector<RelocationInfo> relocations;
-            std::vector<RelocationInfo> externalRelocations;
-            std::vector<LabelInfo> labels;
-        };
-
-    } // namespace detail
-
     struct SerializeContext
     {
         EncoderContext& ctx;
-        std::vector<std::uint8_t> buffer;
+        std::vector<std::uint8_t>& buffer;
+        NopStyle nopStyle;
+        bool shrinkInstructions;
+        std::int32_t bytesSaved;
     };
 
     static bool isLabelExternal(const detail::ProgramState& prog, Label::Id labelId) noexcept
@@ -70,29 +53,128 @@ namespace zasm
         return ErrorCode::None;
     }
 
-    static constexpr auto kX86NopTable = std::array<std::array<std::uint8_t, 8>, 9>{ {
-        {},
-        { 0x90 },
-        { 0x66, 0x90 },
-        { 0x0f, 0x1f, 0x00 },
-        { 0x0f, 0x1f, 0x40, 0x00 },
-        { 0x0f, 0x1f, 0x44, 0x00, 0x00 },
-        { 0x66, 0x0f, 0x1f, 0x44, 0x00, 0x00 },
-        { 0x0f, 0x1f, 0x80, 0x00, 0x00, 0x00, 0x00 },
-        { 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
-    } };
-
-    static constexpr auto kX86AlignTable = std::array<std::array<std::uint8_t, 8>, 9>{ {
-        {},
-        { 0xCC },
-        { 0xCC, 0xCC },
-        { 0xCC, 0xCC, 0xCC },
-        { 0xCC, 0xCC, 0xCC, 0xCC },
-        { 0xCC, 0xCC, 0xCC, 0xCC, 0xCC },
-        { 0xCC, 0xCC, 0xCC, 0xCC, 0xCC, 0xCC },
-        { 0xCC, 0xCC, 0xCC, 0xCC, 0xCC, 0xCC, 0xCC },
-        { 0xCC, 0xCC, 0xCC, 0xCC, 0xCC, 0xCC, 0xCC, 0xCC },
-    } };
+    static constexpr std::size_t kMaxNopLength = 11;
+
+    struct NopTable
+    {
+        std::int32_t maxLength;
+        std::array<std::array<std::uint8_t, kMaxNopLength>, kMaxNopLength + 1> entries;
+    };
+
+    static constexpr NopTable kX86NopTableGeneric{ 8,
+                                                   { {
+                                                       {},
+                                                       { 0x90 },
+                                                       { 0x66, 0x90 },
+                                                       { 0x0f, 0x1f, 0x00 },
+                                                       { 0x0f, 0x1f, 0x40, 0x00 },
+                                                       { 0x0f, 0x1f, 0x44, 0x00, 0x00 },
+                                                       { 0x66, 0x0f, 0x1f, 0x44, 0x00, 0x00 },
+                                                       { 0x0f, 0x1f, 0x80, 0x00, 0x00, 0x00, 0x00 },
+                                                       { 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+                                                   } } };
+
+    static constexpr NopTable kX86NopTableIntel{ 9,
+                                                 { {
+                                                     {},
+                                                     { 0x90 },
+                                                     { 0x66, 0x90 },
+                                                     { 0x0f, 0x1f, 0x00 },
+                                                     { 0x0f, 0x1f, 0x40, 0x00 },
+                                                     { 0x0f, 0x1f, 0x44, 0x00, 0x00 },
+                                                     { 0x66, 0x0f, 0x1f, 0x44, 0x00, 0x00 },
+                                                     { 0x0f, 0x1f, 0x80, 0x00, 0x00, 0x00, 0x00 },
+                                                     { 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+                                                     { 0x66, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+                                                 } } };
+
+    static constexpr NopTable kX86NopTableAMD{ 11,
+                                               { {
+                                                   {},
+                                                   { 0x90 },
+                                                   { 0x66, 0x90 },
+                                                   { 0x0f, 0x1f, 0x00 },
+                                                   { 0x0f, 0x1f, 0x40, 0x00 },
+                                                   { 0x0f, 0x1f, 0x44, 0x00, 0x00 },
+                                                   { 0x66, 0x0f, 0x1f, 0x44, 0x00, 0x00 },
+                                                   { 0x0f, 0x1f, 0x80, 0x00, 0x00, 0x00, 0x00 },
+                                                   { 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+                                                   { 0x66, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+                                                   { 0x66, 0x2e, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+                                                   { 0x66, 0x66, 0x2e, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+                                               } } };
+
+    static constexpr NopTable kX86NopTableLegacy{ 1,
+                                                  { {
+                                                      {},
+                                                      { 0x90 },
+                                                  } } };
+
+    // Block of consecutive NOPs with the maximum length of the table, used to fill
+    // large gaps with a few copies instead of inserting each NOP individually.
+    static constexpr std::int32_t kFillBlockSize = 64;
+
+    struct NopFillBlock
+    {
+        std::int32_t size{};
+        std::array<std::uint8_t, kFillBlockSize> data{};
+    };
+
+    static constexpr NopFillBlock makeNopFillBlock(const NopTable& table) noexcept
+    {
+        NopFillBlock block{};
+        block.size = (kFillBlockSize / table.maxLength) * table.maxLength;
+
+        const auto& entry = table.entries[table.maxLength];
+        for (std::int32_t i = 0; i < block.size; ++i)
+        {
+            block.data[i] = entry[i % table.maxLength];
+        }
+
+        return block;
+    }
+
+    static constexpr auto kX86NopBlockGeneric = makeNopFillBlock(kX86NopTableGeneric);
+    static constexpr auto kX86NopBlockIntel = makeNopFillBlock(kX86NopTableIntel);
+    static constexpr auto kX86NopBlockAMD = makeNopFillBlock(kX86NopTableAMD);
+    static constexpr auto kX86NopBlockLegacy = makeNopFillBlock(kX86NopTableLegacy);
+
+    static constexpr std::uint8_t kX86AlignFill = 0xCC;
+
+    static void fillNops(std::uint8_t* dst, std::int32_t size, NopStyle style) noexcept
+    {
+        const auto [table, block] = std::invoke([&]() -> std::pair<const NopTable*, const NopFillBlock*> {
+            switch (style)
+            {
+                case NopStyle::Intel:
+                    return { &kX86NopTableIntel, &kX86NopBlockIntel };
+                case NopStyle::AMD:
+                    return { &kX86NopTableAMD, &kX86NopBlockAMD };
+                case NopStyle::Legacy:
+                    return { &kX86NopTableLegacy, &kX86NopBlockLegacy };
+                default:
+                    return { &kX86NopTableGeneric, &kX86NopBlockGeneric };
+            }
+        });
+
+        // Whole blocks.
+        for (; size >= block->size; size -= block->size, dst += block->size)
+        {
+            std::memcpy(dst, block->data.data(), block->size);
+        }
+
+        // Remaining NOPs of maximum length, the block starts with those.
+        const auto numFull = (size / table->maxLength) * table->maxLength;
+        std::memcpy(dst, block->data.data(), numFull);
+        dst += numFull;
+        size -= numFull;
+
+        // Tail.
+        if (size > 0)
+        {
+            std::memcpy(dst, table->entries[size].data(), size);
+        }
+    }
 
     static Error serializeNode([[maybe_unused]] detail::ProgramState& program, SerializeContext& state, const Align& node)
     {
@@ -104,29 +186,21 @@ namespace zasm
         nodeEntry.offset = ctx.offset;
         nodeEntry.address = ctx.va;
 
-        const auto& table = std::invoke([&]() {
-            // TODO: Add support for different modes one day.
-            if (node.getType() == Align::Type::Code)
-                return kX86NopTable;
-            else
-                return kX86AlignTable;
-        });
-
         const auto alignedVA = math::alignTo<std::int64_t>(ctx.va, node.getAlign());
 
         assert(alignedVA - ctx.va < std::numeric_limits<std::int32_t>::max());
         const auto alignSize = static_cast<std::int32_t>(alignedVA - ctx.va);
 
-        for (auto alignBytesMissing = alignSize; alignBytesMissing > 0;)
+        auto& buffer = state.buffer;
+        if (node.getType() == Align::Type::Code)
         {
-            const auto tableSize = static_cast<std::int32_t>(table.size());
-            const auto dataIndex = std::min<std::int32_t>(tableSize - 1, alignBytesMissing);
-            const auto& dataEntry = table[dataIndex];
-
-            auto& buffer = state.buffer;
-            buffer.insert(buffer.end(), std::begin(dataEntry), std::begin(dataEntry) + dataIndex);
-
-            alignBytesMissing -= dataIndex;
+            const auto oldSize = buffer.size();
+            buffer.resize(oldSize + alignSize);
+            fillNops(buffer.data() + oldSize, alignSize, state.nopStyle);
+        }
+        else
+        {
+            buffer.insert(buffer.end(), alignSize, kX86AlignFill);
         }
 
         if (nodeEntry.length != 0 && nodeEntry.length != alignSize)
@@ -154,6 +228,20 @@ namespace zasm
             return res.error();
         }
 
+        if (state.shrinkInstructions)
+        {
+            Instruction shrunk;
+            if (detail::shrinkInstruction(prog.mode, instr, shrunk))
+            {
+                auto resShrunk = encode(state.ctx, prog.mode, shrunk);
+                if (resShrunk && resShrunk->buffer.length < res->buffer.length)
+                {
+                    state.bytesSaved += res->buffer.length - resShrunk->buffer.length;
+                    res = std::move(resShrunk);
+                }
+            }
+        }
+
         {
             auto& nodeEntry = ctx.nodes[ctx.nodeIndex];
             ctx.nodeIndex++;
@@ -204,9 +292,7 @@ namespace zasm
             return ErrorCode::LabelNotFound;
         }
 
-        auto& linkEntry = state.ctx.getOrCreateLabelLink(label.getId());
-        linkEntry.boundOffset = ctx.offset;
-        linkEntry.boundVA = ctx.va;
+        ctx.bindLabelLink(label.getId(), ctx.offset, ctx.va);
 
         return ErrorCode::None;
     }
@@ -293,13 +379,32 @@ namespace zasm
         auto& sect = ctx.sections[ctx.sectionIndex];
         sect.rawSize += totalSize;
 
+        const auto dataSize = data.getSize();
+        if (totalSize == 0 || dataSize == 0)
+        {
+            return ErrorCode::None;
+        }
+
         auto& buffer = state.buffer;
-        buffer.reserve(buffer.size() + totalSize);
+        const auto start = buffer.size();
+        buffer.resize(start + static_cast<std::size_t>(totalSize));
 
-        const auto dataSize = data.getSize();
-        for (std::size_t i = 0; i < data.getRepeatCount(); ++i)
+        auto* dst = buffer.data() + start;
+        if (dataSize == 1)
         {
-            std::copy_n(ptr, dataSize, std::back_inserter(buffer));
+            std::memset(dst, ptr[0], static_cast<std::size_t>(totalSize));
+            return ErrorCode::None;
+        }
+
+        // Copy the data once, the repeats are filled by doubling the already written bytes.
+        std::memcpy(dst, ptr, dataSize);
+
+        auto filled = dataSize;
+        while (filled < static_cast<std::size_t>(totalSize))
+        {
+            const auto len = std::min(filled, static_cast<std::size_t>(totalSize) - filled);
+            std::memcpy(dst + filled, dst, len);
+            filled += len;
         }
 
         return ErrorCode::None;
@@ -460,12 +565,23 @@ namespace zasm
             return count;
         }();
 
-        EncoderContext encoderCtx{};
+        // The context is kept in the state to reuse the allocations across calls.
+        EncoderContext& encoderCtx = _state->encoderCtx;
         encoderCtx.program = &program.getState();
-        encoderCtx.nodes.resize(nodeCount);
+        encoderCtx.needsExtraPass = false;
+        encoderCtx.pass = 0;
         encoderCtx.baseVA = newBase;
+        encoderCtx.nodes.clear();
+        encoderCtx.nodes.resize(nodeCount);
+        encoderCtx.initLabelLinks(programState.labels.size());
+
+        _state->passes.clear();
+        _state->bytesSaved = 0;
+        _state->firstNode = nullptr;
+        _state->endNode = nullptr;
+        _state->nodeCount = 0;
 
-        SerializeContext state{ encoderCtx, {} };
+        SerializeContext state{ encoderCtx, _state->buffer, _state->nopStyle, _state->shrinkInstructions, 0 };
 
         std::int32_t codeDiff = 0;
         std::int32_t codeSize = 0;
@@ -479,6 +595,7 @@ namespace zasm
 
         const auto serializePass = [&]() -> Error {
             state.buffer.clear();
+            state.bytesSaved = 0;
 
             encoderCtx.needsExtraPass = false;
             encoderCtx.pass++;
@@ -486,6 +603,7 @@ namespace zasm
             encoderCtx.va = newBase;
             encoderCtx.nodeIndex = 0;
             encoderCtx.sectionIndex = 0;
+            encoderCtx.labelStats = {};
 
             // Setup default section.
             encoderCtx.sections.clear();
@@ -512,6 +630,12 @@ namespace zasm
             codeDiff = newSize - codeSize;
             codeSize = newSize;
 
+            auto& passInfo = _state->passes.emplace_back();
+            passInfo.pass = encoderCtx.pass;
+            passInfo.labelLookups = encoderCtx.labelStats.lookups;
+            passInfo.unresolvedLabelLookups = encoderCtx.labelStats.unresolvedLookups;
+            passInfo.codeSize = newSize;
+
             return ErrorCode::None;
         };
 
@@ -523,7 +647,7 @@ namespace zasm
 
         // Check if all labels were bound, a link entry is added when it encounters a label.
         const auto isUnresolvedLabel = [&programState](auto&& link) {
-            return !link.isBound() && !isLabelExternal(programState, link.id);
+            return link.referenced && !link.isBound() && !isLabelExternal(programState, link.id);
         };
         const bool hasUnresolvedLinks = std::any_of(
             std::begin(encoderCtx.labelLinks), std::end(encoderCtx.labelLinks), isUnresolvedLabel);
@@ -582,6 +706,7 @@ namespace zasm
         }
 
         _state->relocations.clear();
+        _state->externalRelocations.clear();
         for (auto& node : encoderCtx.nodes)
         {
             if (node.relocKind == RelocationType::None)
@@ -665,7 +790,10 @@ namespace zasm
             }
         }
 
-        _state->code = std::move(state.buffer);
+        // Swap the buffers so the capacity of the previous code buffer is reused by the next call.
+        std::swap(_state->code, state.buffer);
+
+        buildRelocationPlan(_state->relocationPlan, _state->relocations, _state->code.data());
 
         _state->sections.clear();
         for (auto& sectionLink : encoderCtx.sections)
@@ -683,6 +811,10 @@ namespace zasm
         }
 
         _state->base = newBase;
+        _state->bytesSaved = state.bytesSaved;
+        _state->firstNode = nodeCount > 0 ? first : nullptr;
+        _state->endNode = lastNode;
+        _state->nodeCount = nodeCount;
 
         return ErrorCode::None;
     }
@@ -694,84 +826,100 @@ namespace zasm
             return ErrorCode::EmptyState;
         }
 
-        const auto oldBase = _state->base;
-
-        // Make a copy of the code buffer to avoid corrupting the
-        // state in case one of the relocations fail.
-        std::vector<std::uint8_t> code = _state->code;
+        const auto delta = newBase - _state->base;
 
-        std::vector<RelocationInfo> relocs = _state->relocations;
-        for (auto& reloc : relocs)
+        // Validate before touching anything to avoid corrupting the state in case one
+        // of the relocations would not fit.
+        if (!detail::canApplyRelocationPlan(_state->relocationPlan, delta))
         {
-            if (reloc.size == BitSize::_32)
-            {
-                std::uint32_t value{};
-                std::memcpy(&value, code.data() + reloc.offset, sizeof(value));
-
-                std::uint64_t newValue = value;
-                newValue -= oldBase;
-                newValue += newBase;
-
-                if (newValue > std::numeric_limits<std::uint32_t>::max())
-                {
-                    return ErrorCode::ImpossibleRelocation;
-                }
-
-                value = static_cast<std::uint32_t>(newValue);
-                std::memcpy(code.data() + reloc.offset, &value, sizeof(value));
-            }
-            else if (reloc.size == BitSize::_64)
-            {
-                std::uint64_t value{};
-                std::memcpy(&value, code.data() + reloc.offset, sizeof(value));
-
-                std::uint64_t newValue = value;
-                newValue -= oldBase;
-                newValue += newBase;
+            return ErrorCode::ImpossibleRelocation;
+        }
 
-                value = static_cast<std::uint64_t>(newValue);
-                std::memcpy(code.data() + reloc.offset, &value, sizeof(value));
-            }
+        detail::applyRelocationPlan(_state->relocationPlan, _state->code.data(), delta);
+        detail::rebaseRelocationPlan(_state->relocationPlan, delta);
 
-            reloc.address -= oldBase;
-            reloc.address += newBase;
+        for (auto& reloc : _state->relocations)
+        {
+            reloc.address += delta;
         }
 
         // Adjust external relocations.
-        std::vector<RelocationInfo> externalRelocs = _state->externalRelocations;
-        for (auto& reloc : externalRelocs)
+        for (auto& reloc : _state->externalRelocations)
         {
-            reloc.address -= oldBase;
-            reloc.address += newBase;
+            reloc.address += delta;
         }
 
         // Adjust label addresses.
-        std::vector<detail::LabelInfo> labels = _state->labels;
-        for (auto& label : labels)
+        for (auto& label : _state->labels)
         {
-            label.boundAddress -= oldBase;
-            label.boundAddress += newBase;
+            if (label.boundOffset == detail::LabelInfo::kUnboundOffset)
+            {
+                continue;
+            }
+            label.boundAddress += delta;
         }
 
         // Adjust sections
-        std::vector<SectionInfo> sections = _state->sections;
-        for (auto& sect : sections)
+        for (auto& sect : _state->sections)
         {
-            sect.address -= oldBase;
-            sect.address += newBase;
+            sect.address += delta;
         }
 
-        // Update state.
-        _state->code = std::move(code);
-        _state->labels = std::move(labels);
-        _state->sections = std::move(sections);
-        _state->relocations = std::move(relocs);
-        _state->externalRelocations = std::move(externalRelocs);
         _state->base = newBase;
 
         return ErrorCode::None;
     }
 
+    Error Serializer::relocateTo(std::int64_t newBase, std::uint8_t* buffer, std::size_t bufferSize) const
+    {
+        if (_state->code.empty())
+        {
+            return ErrorCode::EmptyState;
+        }
+
+        if (buffer == nullptr || bufferSize < _state->code.size())
+        {
+            return ErrorCode::InvalidParameter;
+        }
+
+        const auto delta = newBase - _state->base;
+        if (!detail::canApplyRelocationPlan(_state->relocationPlan, delta))
+        {
+            return ErrorCode::ImpossibleRelocation;
+        }
+
+        std::memcpy(buffer, _state->code.data(), _state->code.size());
+
+        detail::applyRelocationPlan(_state->relocationPlan, buffer, delta);
+
+        return ErrorCode::None;
+    }
+
+    void Serializer::setNopStyle(NopStyle style) noexcept
+    {
+        _state->nopStyle = style;
+    }
+
+    NopStyle Serializer::getNopStyle() const noexcept
+    {
+        return _state->nopStyle;
+    }
+
+    void Serializer::setShrinkInstructions(bool enable) noexcept
+    {
+        _state->shrinkInstructions = enable;
+    }
+
+    bool Serializer::getShrinkInstructions() const noexcept
+    {
+        return _state->shrinkInstructions;
+    }
+
+    std::size_t Serializer::getBytesSaved() const noexcept
+    {
+        return static_cast<std::size_t>(_state->bytesSaved);
+    }
+
     std::int64_t Serializer::getBase() const noexcept
     {
         return _state->base;
@@ -830,6 +978,53 @@ namespace zasm
         return _state->labels[idx].boundAddress;
     }
 
+    const Node* Serializer::getFirstNode() const noexcept
+    {
+        return _state->firstNode;
+    }
+
+    const Node* Serializer::getEndNode() const noexcept
+    {
+        return _state->endNode;
+    }
+
+    std::size_t Serializer::getNodeCount() const noexcept
+    {
+        return _state->nodeCount;
+    }
+
+    NodeInfo Serializer::getNodeInfo(std::size_t index) const noexcept
+    {
+        NodeInfo res{ -1, -1, 0 };
+        if (index >= _state->nodeCount)
+        {
+            return res;
+        }
+
+        const auto& ctx = _state->encoderCtx;
+        const auto& node = ctx.nodes[index];
+
+        res.offset = node.offset;
+        res.address = node.address + (_state->base - ctx.baseVA);
+        res.length = node.length;
+
+        return res;
+    }
+
+    std::size_t Serializer::getPassCount() const noexcept
+    {
+        return _state->passes.size();
+    }
+
+    const PassInfo* Serializer::getPassInfo(std::size_t index) const noexcept
+    {
+        if (index >= _state->passes.size())
+        {
+            return nullptr;
+        }
+        return &_state->passes[index];
+    }
+
     std::size_t Serializer::getRelocationCount() const noexcept
     {
         return _state->relocations.size();
@@ -858,12 +1053,46 @@ namespace zasm
         return &_state->externalRelocations[index];
     }
 
+    void Serializer::shrink() noexcept
+    {
+        // The node entries are part of the serialized state, see getNodeInfo.
+        auto& ctx = _state->encoderCtx;
+        ctx.nodes.resize(_state->nodeCount);
+        ctx.nodes.shrink_to_fit();
+        ctx.sections.clear();
+        ctx.sections.shrink_to_fit();
+        ctx.labelLinks.clear();
+        ctx.labelLinks.shrink_to_fit();
+        ctx.labelVAs.clear();
+        ctx.labelVAs.shrink_to_fit();
+
+        _state->buffer.clear();
+        _state->buffer.shrink_to_fit();
+
+        _state->code.shrink_to_fit();
+        _state->sections.shrink_to_fit();
+        _state->relocations.shrink_to_fit();
+        _state->externalRelocations.shrink_to_fit();
+        _state->labels.shrink_to_fit();
+        _state->relocationPlan.offsets32.shrink_to_fit();
+        _state->relocationPlan.offsets64.shrink_to_fit();
+        _state->passes.shrink_to_fit();
+    }
+
     void Serializer::clear() noexcept
     {
         _state->base = 0;
         _state->code.clear();
         _state->sections.clear();
         _state->labels.clear();
+        _state->relocations.clear();
+        _state->externalRelocations.clear();
+        _state->relocationPlan.clear();
+        _state->passes.clear();
+        _state->bytesSaved = 0;
+        _state->firstNode = nullptr;
+        _state->endNode = nullptr;
+        _state->nodeCount = 0;
     }
 
 } // namespace zasm
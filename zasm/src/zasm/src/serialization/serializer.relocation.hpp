@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <zasm/core/bitsize.hpp>
+#include <zasm/serialization/serializer.hpp>
+
+namespace zasm::detail
+{
+    // Precomputed relocation plan, the offsets are grouped by size and sorted so that
+    // patching the code becomes a tight loop of adds per group without having to branch on the
+    // size per entry.
+    struct RelocationPlan
+    {
+        std::vector<std::int32_t> offsets32;
+        std::vector<std::int32_t> offsets64;
+
+        // Range of the 32 bit values currently stored in the code, this allows to validate
+        // a new base address without touching the code.
+        std::uint32_t min32{ std::numeric_limits<std::uint32_t>::max() };
+        std::uint32_t max32{ std::numeric_limits<std::uint32_t>::min() };
+
+        void clear() noexcept
+        {
+            offsets32.clear();
+            offsets64.clear();
+            min32 = std::numeric_limits<std::uint32_t>::max();
+            max32 = std::numeric_limits<std::uint32_t>::min();
+        }
+
+        bool empty() const noexcept
+        {
+            return offsets32.empty() && offsets64.empty();
+        }
+    };
+
+    inline void buildRelocationPlan(
+        RelocationPlan& plan, const std::vector<RelocationInfo>& relocs, const std::uint8_t* code)
+    {
+        plan.clear();
+
+        for (const auto& reloc : relocs)
+        {
+            if (reloc.size == BitSize::_32)
+            {
+                plan.offsets32.push_back(reloc.offset);
+            }
+            else if (reloc.size == BitSize::_64)
+            {
+                plan.offsets64.push_back(reloc.offset);
+            }
+        }
+
+        std::sort(plan.offsets32.begin(), plan.offsets32.end());
+        std::sort(plan.offsets64.begin(), plan.offsets64.end());
+
+        for (const auto offset : plan.offsets32)
+        {
+            std::uint32_t value{};
+            std::memcpy(&value, code + offset, sizeof(value));
+
+            plan.min32 = std::min(plan.min32, value);
+            plan.max32 = std::max(plan.max32, value);
+        }
+    }
+
+    // Checks if all 32 bit values in the range of min32 and max32 still fit when moved by delta.
+    inline bool canApplyRelocations32(
+        std::size_t count, std::uint32_t min32, std::uint32_t max32, std::int64_t delta) noexcept
+    {
+        if (count == 0)
+        {
+            return true;
+        }
+
+        const auto newMin = static_cast<std::int64_t>(min32) + delta;
+        const auto newMax = static_cast<std::int64_t>(max32) + delta;
+
+        return newMin >= 0 && newMax <= static_cast<std::int64_t>(std::numeric_limits<std::uint32_t>::max());
+    }
+
+    inline void applyRelocations32(
+        const std::int32_t* offsets, std::size_t count, std::uint8_t* code, std::int64_t delta) noexcept
+    {
+        const auto delta32 = static_cast<std::uint32_t>(delta);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::uint32_t value;
+            std::memcpy(&value, code + offsets[i], sizeof(value));
+            value += delta32;
+            std::memcpy(code + offsets[i], &value, sizeof(value));
+        }
+    }
+
+    inline void applyRelocations64(
+        const std::int32_t* offsets, std::size_t count, std::uint8_t* code, std::int64_t delta) noexcept
+    {
+        const auto delta64 = static_cast<std::uint64_t>(delta);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::uint64_t value;
+            std::memcpy(&value, code + offsets[i], sizeof(value));
+            value += delta64;
+            std::memcpy(code + offsets[i], &value, sizeof(value));
+        }
+    }
+
+    inline bool canApplyRelocationPlan(const RelocationPlan& plan, std::int64_t delta) noexcept
+    {
+        return canApplyRelocations32(plan.offsets32.size(), plan.min32, plan.max32, delta);
+    }
+
+    // Applies the plan to the code, the caller is responsible to check canApplyRelocationPlan first.
+    inline void applyRelocationPlan(const RelocationPlan& plan, std::uint8_t* code, std::int64_t delta) noexcept
+    {
+        applyRelocations32(plan.offsets32.data(), plan.offsets32.size(), code, delta);
+        applyRelocations64(plan.offsets64.data(), plan.offsets64.size(), code, delta);
+    }
+
+    // Updates the value range after the plan was applied in place.
+    inline void rebaseRelocationPlan(RelocationPlan& plan, std::int64_t delta) noexcept
+    {
+        if (plan.offsets32.empty())
+        {
+            return;
+        }
+
+        plan.min32 = static_cast<std::uint32_t>(plan.min32 + delta);
+        plan.max32 = static_cast<std::uint32_t>(plan.max32 + delta);
+    }
+
+} // namespace zasm::detail
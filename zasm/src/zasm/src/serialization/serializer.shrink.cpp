@@ -0,0 +1,111 @@
+#include "serializer.shrink.hpp"
+
+#include <cstdint>
+#include <zasm/x86/x86.hpp>
+
+namespace zasm::detail
+{
+    static bool isImmInRange(const Imm& imm, std::int64_t minValue, std::int64_t maxValue) noexcept
+    {
+        const auto value = imm.value<std::int64_t>();
+        return value >= minValue && value <= maxValue;
+    }
+
+    // mov r64, imm with an unsigned 32 bit immediate, writing the 32 bit register zero extends.
+    static bool shrinkMovImm(MachineMode mode, const Reg& dst, const Imm& imm, Instruction& res)
+    {
+        if (mode != MachineMode::AMD64 || !dst.isGp64() || !isImmInRange(imm, 0, 0xFFFFFFFF))
+        {
+            return false;
+        }
+
+        res.setOperand(0, x86::Gp{ dst.getId() }.r32());
+        return true;
+    }
+
+    // and r64, imm with a positive 32 bit immediate, the upper half and SF are zero in both forms.
+    static bool shrinkAndImm(MachineMode mode, const Reg& dst, const Imm& imm, Instruction& res)
+    {
+        if (mode != MachineMode::AMD64 || !dst.isGp64() || !isImmInRange(imm, 0, 0x7FFFFFFF))
+        {
+            return false;
+        }
+
+        res.setOperand(0, x86::Gp{ dst.getId() }.r32());
+        return true;
+    }
+
+    // test reg, imm with a positive 8 bit immediate only depends on the low byte, SF is zero in both forms.
+    static bool shrinkTestImm(MachineMode mode, const Reg& dst, const Imm& imm, Instruction& res)
+    {
+        if (!(dst.isGp16() || dst.isGp32() || dst.isGp64()) || !isImmInRange(imm, 0, 0x7F))
+        {
+            return false;
+        }
+
+        // Only al, cl, dl and bl are encodable without REX.
+        if (mode == MachineMode::I386 && dst.getPhysicalIndex() >= 4)
+        {
+            return false;
+        }
+
+        res.setOperand(0, x86::Gp{ dst.getId() }.r8lo());
+        return true;
+    }
+
+    // xor r64, r64 and sub r64, r64 with the same register, both zero the register and set the same flags.
+    static bool shrinkZeroIdiom(MachineMode mode, const Reg& dst, const Reg& src, Instruction& res)
+    {
+        if (mode != MachineMode::AMD64 || !dst.isGp64() || dst != src)
+        {
+            return false;
+        }
+
+        const auto reg = x86::Gp{ dst.getId() }.r32();
+        res.setOperand(0, reg);
+        res.setOperand(1, reg);
+        return true;
+    }
+
+    bool shrinkInstruction(MachineMode mode, const Instruction& instr, Instruction& res)
+    {
+        if (instr.getOperandCount() != 2 || instr.getAttribs() != x86::Attribs::None)
+        {
+            return false;
+        }
+
+        const auto* dst = instr.getOperandIf<Reg>(0);
+        if (dst == nullptr)
+        {
+            return false;
+        }
+
+        res = instr;
+
+        const auto mnemonic = instr.getMnemonic();
+        if (const auto* imm = instr.getOperandIf<Imm>(1); imm != nullptr)
+        {
+            switch (mnemonic)
+            {
+                case x86::Mnemonic::Mov:
+                    return shrinkMovImm(mode, *dst, *imm, res);
+                case x86::Mnemonic::And:
+                    return shrinkAndImm(mode, *dst, *imm, res);
+                case x86::Mnemonic::Test:
+                    return shrinkTestImm(mode, *dst, *imm, res);
+                default:
+                    break;
+            }
+        }
+        else if (const auto* src = instr.getOperandIf<Reg>(1); src != nullptr)
+        {
+            if (mnemonic == x86::Mnemonic::Xor || mnemonic == x86::Mnemonic::Sub)
+            {
+                return shrinkZeroIdiom(mode, *dst, *src, res);
+            }
+        }
+
+        return false;
+    }
+
+} // namespace zasm::detail
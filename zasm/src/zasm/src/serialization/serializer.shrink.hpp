@@ -0,0 +1,13 @@
+#pragma once
+
+#include <zasm/base/mode.hpp>
+#include <zasm/program/instruction.hpp>
+
+namespace zasm::detail
+{
+    // Rewrites the instruction into a form that may have a shorter encoding with the same effect on
+    // registers and flags, returns false if no rewrite applies. The caller has to compare the encoded
+    // sizes as the rewritten form is not guaranteed to be shorter for every register.
+    bool shrinkInstruction(MachineMode mode, const Instruction& instr, Instruction& res);
+
+} // namespace zasm::detail
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../encoder/encoder.context.hpp"
+#include "serializer.relocation.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <zasm/base/label.hpp>
+#include <zasm/serialization/serializer.hpp>
+
+namespace zasm::detail
+{
+    struct LabelInfo
+    {
+        static constexpr std::int32_t kUnboundOffset = -1;
+        static constexpr std::int64_t kUnboundAddress = -1;
+
+        Label::Id labelId{ Label::Id::Invalid };
+        std::int32_t boundOffset{ kUnboundOffset };
+        std::int64_t boundAddress{ kUnboundAddress };
+    };
+
+    struct SerializerState
+    {
+        std::int64_t base{};
+        NopStyle nopStyle{ NopStyle::Generic };
+        bool shrinkInstructions{};
+        std::int32_t bytesSaved{};
+        std::vector<SectionInfo> sections;
+        std::vector<std::uint8_t> code;
+        std::vector<RelocationInfo> relocations;
+        std::vector<RelocationInfo> externalRelocations;
+        std::vector<LabelInfo> labels;
+        RelocationPlan relocationPlan;
+        std::vector<PassInfo> passes;
+
+        // Serialized range, the per node data is kept in encoderCtx.nodes.
+        const Node* firstNode{};
+        const Node* endNode{};
+        std::size_t nodeCount{};
+
+        // Working memory of serialize, kept to reuse the allocations across calls.
+        EncoderContext encoderCtx;
+        std::vector<std::uint8_t> buffer;
+    };
+
+} // namespace zasm::detail
@@ -115,6 +115,14 @@ namespace zasm::x86
         return ErrorCode::None;
     }
 
+    Error Assembler::embed(Data data)
+    {
+        auto* dataNode = _program.createNode(std::move(data));
+        _cursor = _program.insertAfter(_cursor, dataNode);
+
+        return ErrorCode::None;
+    }
+
     Error Assembler::align(Align::Type type, std::uint32_t align)
     {
         Align data(type, align);
@@ -199,4 +207,24 @@ namespace zasm::x86
         _cursor = node->getPrev();
     }
 
+    void Assembler::onNodesDestroy(Node* first, Node* last) noexcept
+    {
+        if (_cursor == nullptr)
+        {
+            return;
+        }
+        for (auto* node = first;; node = node->getNext())
+        {
+            if (node == _cursor)
+            {
+                _cursor = first->getPrev();
+                return;
+            }
+            if (node == last)
+            {
+                break;
+            }
+        }
+    }
+
 } // namespace zasm::x86